@@ -34,6 +34,7 @@ enum nugu_audio_sample_rate {
 	AUDIO_SAMPLE_RATE_32K, /**< 32K */
 	AUDIO_SAMPLE_RATE_22K, /**< 22K */
 	AUDIO_SAMPLE_RATE_44K, /**< 44K */
+	AUDIO_SAMPLE_RATE_48K, /**< 48K */
 	AUDIO_SAMPLE_RATE_MAX
 };
 
@@ -55,6 +56,8 @@ enum nugu_audio_format {
 	AUDIO_FORMAT_S32_BE, /**< Signed 32 bits big endian */
 	AUDIO_FORMAT_U32_LE, /**< Unsigned 32 bits little endian */
 	AUDIO_FORMAT_U32_BE, /**< Unsigned 32 bits big endian */
+	AUDIO_FORMAT_FLOAT_LE, /**< 32 bits float little endian */
+	AUDIO_FORMAT_FLOAT_BE, /**< 32 bits float big endian */
 	AUDIO_FORMAT_MAX
 };
 
@@ -72,6 +75,30 @@ struct nugu_audio_property {
  */
 typedef struct nugu_audio_property NuguAudioProperty;
 
+/**
+ * @brief Get the sample rate in Hz
+ * @param[in] samplerate sample rate
+ * @return sample rate in Hz
+ * @retval 0 unknown sample rate
+ */
+int nugu_audio_get_rate(enum nugu_audio_sample_rate samplerate);
+
+/**
+ * @brief Get the size of a sample in bytes
+ * @param[in] format audio format
+ * @return size of a sample
+ * @retval 0 unknown format
+ */
+int nugu_audio_get_sample_width(enum nugu_audio_format format);
+
+/**
+ * @brief Get the size of audio data per second in bytes
+ * @param[in] property audio property
+ * @return size of audio data per second
+ * @retval 0 unknown sample rate or format
+ */
+int nugu_audio_get_bytes_per_sec(NuguAudioProperty property);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_AUDIO_CONVERT_H__
+#define __NUGU_AUDIO_CONVERT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <core/nugu_audio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_audio_convert.h
+ * @defgroup NuguAudioConvert Audio sample conversion
+ * @ingroup SDKCore
+ * @brief Conversion of sample format, byte order and channel layout
+ *
+ * The kernels convert a count of samples between the common formats.
+ * nugu_audio_convert() converts the frames between any two audio
+ * properties using the kernels, so the recorder and the pcm can work with
+ * a device in another format.
+ *
+ * Float samples are in the range of -1.0 to 1.0. Integer samples are
+ * saturated when they are converted from float.
+ *
+ * @{
+ */
+
+/**
+ * @brief Convert signed 16 bits samples to float
+ * @param[in] src host endian samples
+ * @param[out] dest float samples
+ * @param[in] count count of samples
+ */
+void nugu_audio_s16_to_float(const int16_t *src, float *dest, size_t count);
+
+/**
+ * @brief Convert float samples to signed 16 bits
+ * @param[in] src float samples
+ * @param[out] dest host endian samples
+ * @param[in] count count of samples
+ */
+void nugu_audio_float_to_s16(const float *src, int16_t *dest, size_t count);
+
+/**
+ * @brief Convert packed 24 bits samples to signed 32 bits
+ *
+ * The 24 bits value is stored in the upper 24 bits of the 32 bits sample.
+ *
+ * @param[in] src little endian packed samples (3 bytes per sample)
+ * @param[out] dest host endian samples
+ * @param[in] count count of samples
+ */
+void nugu_audio_s24_to_s32(const unsigned char *src, int32_t *dest,
+			   size_t count);
+
+/**
+ * @brief Convert signed 32 bits samples to packed 24 bits
+ * @param[in] src host endian samples
+ * @param[out] dest little endian packed samples (3 bytes per sample)
+ * @param[in] count count of samples
+ */
+void nugu_audio_s32_to_s24(const int32_t *src, unsigned char *dest,
+			   size_t count);
+
+/**
+ * @brief Swap the byte order of 16 bits samples in place
+ * @param[in,out] data samples
+ * @param[in] count count of samples
+ */
+void nugu_audio_swap16(void *data, size_t count);
+
+/**
+ * @brief Swap the byte order of 32 bits samples in place
+ * @param[in,out] data samples
+ * @param[in] count count of samples
+ */
+void nugu_audio_swap32(void *data, size_t count);
+
+/**
+ * @brief Split interleaved float frames into a buffer for each channel
+ * @param[in] src interleaved samples
+ * @param[out] dest array of 'channel' buffers
+ * @param[in] channel count of channels
+ * @param[in] frames count of frames
+ */
+void nugu_audio_deinterleave(const float *src, float *const *dest,
+			     int channel, size_t frames);
+
+/**
+ * @brief Merge a float buffer of each channel into interleaved frames
+ * @param[in] src array of 'channel' buffers
+ * @param[out] dest interleaved samples
+ * @param[in] channel count of channels
+ * @param[in] frames count of frames
+ */
+void nugu_audio_interleave(const float *const *src, float *dest,
+			   int channel, size_t frames);
+
+/**
+ * @brief Mix interleaved float frames down to mono (average)
+ * @param[in] src interleaved samples
+ * @param[out] dest mono samples. It can be the same as src.
+ * @param[in] channel count of channels
+ * @param[in] frames count of frames
+ */
+void nugu_audio_downmix_float(const float *src, float *dest, int channel,
+			      size_t frames);
+
+/**
+ * @brief Mix interleaved signed 16 bits frames down to mono (average)
+ * @param[in] src host endian interleaved samples
+ * @param[out] dest mono samples. It can be the same as src.
+ * @param[in] channel count of channels
+ * @param[in] frames count of frames
+ */
+void nugu_audio_downmix_s16(const int16_t *src, int16_t *dest, int channel,
+			    size_t frames);
+
+/**
+ * @brief Convert the frames to another format and channel layout
+ *
+ * The sample rate is not converted (see NuguResampler). The channel count
+ * of the output should be the same as the input, or one of them should be
+ * 1 (the input is mixed down to mono, or mono is copied to all channels).
+ *
+ * @param[in] from audio property of the input
+ * @param[in] src input frames
+ * @param[in] to audio property of the output
+ * @param[out] dest output buffer. It must not overlap with src.
+ * @param[in] frames count of frames
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (unsupported format or channel layout)
+ */
+int nugu_audio_convert(NuguAudioProperty from, const void *src,
+		       NuguAudioProperty to, void *dest, size_t frames);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
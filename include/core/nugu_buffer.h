@@ -32,7 +32,13 @@ extern "C" {
  * The Buffer module makes it easy to add, delete, and move data in byte units.
  *
  * The Buffer object allocates and uses a single flat buffer inside, and
- * adjusts its size flexibly as needed.
+ * adjusts its size flexibly as needed. Deleting data from the front only
+ * moves the read position, and the remaining data is moved forward only
+ * when more space is needed to add data. The data is always followed by
+ * a null byte, so the text data can be used as a string.
+ *
+ * By default, the deleted data is not erased from the memory. Use
+ * nugu_buffer_set_secure() to erase it for sensitive data.
  *
  * The Buffer object is not thread safe.
  *
@@ -70,6 +76,20 @@ NuguBuffer *nugu_buffer_new(size_t default_size);
  */
 void *nugu_buffer_free(NuguBuffer *buf, gboolean data_free);
 
+/**
+ * @brief Set the secure mode of the buffer object
+ *
+ * In the secure mode, the memory of deleted data is filled with zero on
+ * clear, shift, resize and destroy.
+ *
+ * @param[in] buf buffer object
+ * @param[in] secure If true, the secure mode is enabled.
+ * @return Result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_buffer_set_secure(NuguBuffer *buf, gboolean secure);
+
 /**
  * @brief Append the data to buffer object
  * @param[in] buf buffer object
@@ -109,9 +129,53 @@ size_t nugu_buffer_get_alloc_size(NuguBuffer *buf);
  * @param[in] want byte data you want to find
  * @return position. if fail, return NOT_FOUND
  * @see NOT_FOUND
+ * @see nugu_buffer_search_byte()
  */
 size_t nugu_buffer_find_byte(NuguBuffer *buf, unsigned char want);
 
+/**
+ * @brief Get the position of the byte sequence you want to find.
+ * @param[in] buf buffer object
+ * @param[in] want byte sequence you want to find
+ * @param[in] want_len length of the byte sequence
+ * @return position. if fail, return NOT_FOUND
+ * @see NOT_FOUND
+ * @see nugu_buffer_search()
+ */
+size_t nugu_buffer_find_bytes(NuguBuffer *buf, const void *want,
+			      size_t want_len);
+
+/**
+ * @brief Get the position of the byte in the memory.
+ *
+ * The search is done by memchr(), which is optimized by SIMD instructions
+ * in most C libraries.
+ *
+ * @param[in] data memory to search
+ * @param[in] length length of the memory
+ * @param[in] want byte data you want to find
+ * @return position. if fail, return NOT_FOUND
+ * @see NOT_FOUND
+ */
+size_t nugu_buffer_search_byte(const void *data, size_t length,
+			       unsigned char want);
+
+/**
+ * @brief Get the position of the byte sequence in the memory.
+ *
+ * The candidates are found by the first byte using memchr(), and filtered
+ * by the last byte before comparing the whole sequence.
+ *
+ * @param[in] data memory to search
+ * @param[in] length length of the memory
+ * @param[in] want byte sequence you want to find
+ * @param[in] want_len length of the byte sequence
+ * @return position. if fail, return NOT_FOUND
+ * @see NOT_FOUND
+ */
+size_t nugu_buffer_search(const void *data, size_t length, const void *want,
+			  size_t want_len);
+
 /**
  * @brief Get data at a specific position.
  * @param[in] buf buffer object
@@ -143,6 +207,10 @@ int nugu_buffer_clear_from(NuguBuffer *buf, size_t pos);
 
 /**
  * @brief Delete a certain amount of data and move the remaining data forward.
+ *
+ * Only the read position is moved, so the cost does not depend on the size
+ * of the remaining data.
+ *
  * @param[in] buf buffer object
  * @param[in] size size to delete.
  * @return Result
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_CHUNK_H__
+#define __NUGU_CHUNK_H__
+
+#include <sys/uio.h>
+#include <glib.h>
+#include <core/nugu_pool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_chunk.h
+ * @defgroup ChunkChain ChunkChain
+ * @ingroup SDKCore
+ * @brief Scatter-gather buffer functions
+ *
+ * The ChunkChain object manages the data as a list of segments, and each
+ * segment refers to a part of a reference counted memory block. The data is
+ * copied only once when it is added to the chain, and the segments can be
+ * passed to other chains without copying by nugu_chunk_chain_append().
+ *
+ * The data of a segment is never changed after it is added, so the chains
+ * sharing the same memory block can be used in different threads. However,
+ * each ChunkChain object is not thread safe.
+ *
+ * @{
+ */
+
+/**
+ * @brief ChunkChain object
+ */
+typedef struct _nugu_chunk_chain NuguChunkChain;
+
+/**
+ * @brief Create new chunk chain object
+ * @return ChunkChain object
+ * @see nugu_chunk_chain_free()
+ */
+NuguChunkChain *nugu_chunk_chain_new(void);
+
+/**
+ * @brief Destroy the chunk chain object
+ *
+ * The memory blocks are freed when they are no longer referred by any chain.
+ *
+ * @param[in] chain chunk chain object
+ * @see nugu_chunk_chain_new()
+ */
+void nugu_chunk_chain_free(NuguChunkChain *chain);
+
+/**
+ * @brief Prepare the memory block to add the data without splitting
+ *
+ * The data added by nugu_chunk_chain_add() after this function is stored
+ * contiguously until the reserved size is exceeded.
+ *
+ * @param[in] chain chunk chain object
+ * @param[in] size size to reserve
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_reserve(NuguChunkChain *chain, size_t size);
+
+/**
+ * @brief Copy the data to the end of the chain
+ * @param[in] chain chunk chain object
+ * @param[in] data data
+ * @param[in] length length of data
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_chunk_chain_add_take()
+ */
+int nugu_chunk_chain_add(NuguChunkChain *chain, const void *data,
+			 size_t length);
+
+/**
+ * @brief Add the data to the end of the chain without copying
+ * @param[in] chain chunk chain object
+ * @param[in] data data allocated by malloc(). The chain takes the ownership
+ * and releases the data with free().
+ * @param[in] length length of data
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_chunk_chain_add()
+ */
+int nugu_chunk_chain_add_take(NuguChunkChain *chain, void *data,
+			      size_t length);
+
+/**
+ * @brief Append all segments of the source chain to the destination chain
+ *
+ * The memory blocks are shared by both chains without copying.
+ *
+ * @param[in] dest destination chunk chain object
+ * @param[in] src source chunk chain object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_append(NuguChunkChain *dest, NuguChunkChain *src);
+
+/**
+ * @brief Get the total size of the data in the chain
+ * @param[in] chain chunk chain object
+ * @return size of data
+ */
+size_t nugu_chunk_chain_get_size(NuguChunkChain *chain);
+
+/**
+ * @brief Get the count of segments in the chain
+ * @param[in] chain chunk chain object
+ * @return result
+ * @retval >=0 success (count of segments)
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_get_count(NuguChunkChain *chain);
+
+/**
+ * @brief Get the data of the segment
+ * @param[in] chain chunk chain object
+ * @param[in] index index of segment
+ * @param[out] length length of the segment
+ * @return address of the segment data. Please do not modify the data.
+ */
+const void *nugu_chunk_chain_peek(NuguChunkChain *chain, int index,
+				  size_t *length);
+
+/**
+ * @brief Fill the iovec array with the segments
+ * @param[in] chain chunk chain object
+ * @param[out] iov iovec array
+ * @param[in] max_count maximum count of iovec array
+ * @return result
+ * @retval >=0 success (count of filled iovec)
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_get_iovec(NuguChunkChain *chain, struct iovec *iov,
+			       int max_count);
+
+/**
+ * @brief Keep the data up to the size and discard the rest
+ * @param[in] chain chunk chain object
+ * @param[in] size size of data to keep
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_truncate(NuguChunkChain *chain, size_t size);
+
+/**
+ * @brief Merge all segments into one segment
+ *
+ * The data is copied only if the chain has more than one segment.
+ *
+ * @param[in] chain chunk chain object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_linearize(NuguChunkChain *chain);
+
+/**
+ * @brief Copy all data to a new flat buffer
+ * @param[in] chain chunk chain object
+ * @param[out] length length of data
+ * @return Null-terminated copy of the data. Developer must free the data
+ * manually. If the chain is empty, return NULL.
+ */
+void *nugu_chunk_chain_flatten(NuguChunkChain *chain, size_t *length);
+
+/**
+ * @brief Remove all segments in the chain
+ * @param[in] chain chunk chain object
+ */
+void nugu_chunk_chain_clear(NuguChunkChain *chain);
+
+/**
+ * @brief Free the object pool of the chains
+ *
+ * The pool is kept if any chain is in use, and a new pool is created by the
+ * next nugu_chunk_chain_new().
+ */
+void nugu_chunk_chain_pool_deinit(void);
+
+/**
+ * @brief Get the statistics of the object pool of the chains
+ * @param[out] stats statistics (all zero if the pool is not created)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_chunk_chain_get_pool_stats(NuguPoolStats *stats);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -50,6 +50,45 @@ extern "C" {
  */
 #define NUGU_CONFIG_KEY_UUID_PHASE "uuid_phase"
 
+/**
+ * @brief Predefined key name for pcm_idle_timeout
+ *
+ * Time in milliseconds to keep the shared output stream of the mixer open
+ * after the last pcm is stopped, so that the next pcm starts without
+ * opening the device. 0 closes the stream when the last pcm is stopped.
+ */
+#define NUGU_CONFIG_KEY_PCM_IDLE_TIMEOUT "pcm_idle_timeout"
+
+/**
+ * @brief Predefined key name for attachment_stream
+ *
+ * "true" sends the attachment of an event in a streaming request, "false"
+ * sends each attachment data in a request. The default is "false".
+ *
+ * The query of the streaming request is sent before the data, with the seq
+ * of the first data and "isEnd=true", which means that the request carries
+ * the whole attachment, not that the data is already sent. Enable it only
+ * for the gateway which accepts the streaming upload.
+ */
+#define NUGU_CONFIG_KEY_ATTACHMENT_STREAM "attachment_stream"
+
+/**
+ * @brief Predefined key name for attachment_coalesce_delay
+ *
+ * Maximum time in milliseconds to hold the attachment data to send it
+ * with the next data of the same event in a request. It is used only if
+ * the attachment stream is disabled. 0 sends each data immediately.
+ */
+#define NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_DELAY "attachment_coalesce_delay"
+
+/**
+ * @brief Predefined key name for attachment_coalesce_size
+ *
+ * Maximum size in bytes of the coalesced attachment data. The data is sent
+ * when the size is reached. 0 means no limit, and the default is 8192.
+ */
+#define NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_SIZE "attachment_coalesce_size"
+
 /**
  * @brief Initialize configuration hash table
  */
@@ -48,6 +48,13 @@ typedef struct _nugu_decoder_driver NuguDecoderDriver;
  * The decoder object decodes the encoded data. It also serves to pass the
  * decoded result to the PCM sink.
  *
+ * The decoding can run in a worker thread of the decoder, so the main loop
+ * only queues the encoded data. nugu_decoder_start() creates the worker,
+ * nugu_decoder_push() queues the data, and the worker decodes it and
+ * pushes the result to the PCM sink in order. While the worker is running,
+ * the worker is the only producer of the PCM sink, and the decoder must
+ * not be used with nugu_decoder_play() or nugu_decoder_decode().
+ *
  * @{
  */
 
@@ -84,6 +91,125 @@ int nugu_decoder_free(NuguDecoder *dec);
  */
 int nugu_decoder_play(NuguDecoder *dec, const void *data, size_t data_len);
 
+/**
+ * @brief Start the worker thread which decodes the queued data
+ * @param[in] dec decoder object. The pcm(sink) object is required.
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_decoder_stop()
+ * @see nugu_decoder_push()
+ */
+int nugu_decoder_start(NuguDecoder *dec);
+
+/**
+ * @brief Stop the worker thread
+ *
+ * The queued data is discarded and the decoder is reset.
+ * nugu_decoder_free() also stops the worker.
+ *
+ * @param[in] dec decoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_decoder_start()
+ */
+int nugu_decoder_stop(NuguDecoder *dec);
+
+/**
+ * @brief Queue the encoded data to the worker
+ *
+ * The data is copied, and decoded by the worker thread. The result is
+ * pushed to the pcm(sink) object. The driver carries a part of frame to the
+ * next data, so the stream can be split at any position.
+ *
+ * @param[in] dec decoder object
+ * @param[in] data encoded data
+ * @param[in] data_len encoded data length
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (the worker is not started)
+ * @see nugu_decoder_push_done()
+ */
+int nugu_decoder_push(NuguDecoder *dec, const void *data, size_t data_len);
+
+/**
+ * @brief Queue the end of data to the worker
+ *
+ * nugu_pcm_push_data_done() is called for the pcm(sink) object after all
+ * queued data is decoded.
+ *
+ * @param[in] dec decoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (the worker is not started)
+ */
+int nugu_decoder_push_done(NuguDecoder *dec);
+
+/**
+ * @brief Discard the queued data
+ *
+ * The data queued before this call is not decoded. When it returns, the
+ * worker does not push the discarded data to the pcm(sink) object any
+ * more, so the pcm can be stopped or cleared safely.
+ *
+ * @param[in] dec decoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_decoder_cancel(NuguDecoder *dec);
+
+/**
+ * @brief Reset the decoder to decode a new stream
+ *
+ * The queued data is discarded like nugu_decoder_cancel(), and the driver
+ * drops the state of the previous stream (e.g. the codec history). The
+ * worker resets the decoder by itself at the end of data.
+ *
+ * @param[in] dec decoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_decoder_reset(NuguDecoder *dec);
+
+/**
+ * @brief Get a decoder from the pool of idle decoders
+ *
+ * An idle decoder of the driver is reused if the sample rate of the sink
+ * is the same, so the codec state is not created again for each stream.
+ * Otherwise a new decoder is created.
+ *
+ * @param[in] driver decoder driver
+ * @param[in] sink pcm object. The property should be set before.
+ * @return decoder object
+ * @see nugu_decoder_pool_put()
+ */
+NuguDecoder *nugu_decoder_pool_get(NuguDecoderDriver *driver, NuguPcm *sink);
+
+/**
+ * @brief Return the decoder to the pool of idle decoders
+ *
+ * The worker is stopped and the decoder is reset. The decoder is destroyed
+ * if the pool is full or the reset is failed, so it must not be used after
+ * the call.
+ *
+ * @param[in] dec decoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (the decoder is destroyed since the reset is failed)
+ * @see nugu_decoder_pool_get()
+ */
+int nugu_decoder_pool_put(NuguDecoder *dec);
+
+/**
+ * @brief Destroy all idle decoders in the pool
+ *
+ * It must be called before the decoder drivers are removed.
+ */
+void nugu_decoder_pool_clear(void);
+
 /**
  * @brief Set private userdata for driver
  * @param[in] dec decoder object
@@ -114,6 +240,29 @@ void *nugu_decoder_get_userdata(NuguDecoder *dec);
 void *nugu_decoder_decode(NuguDecoder *dec, const void *data, size_t data_len,
 			  size_t *output_len);
 
+/**
+ * @brief Decode the encoded data into the buffer of the caller
+ *
+ * The decoder decodes the whole frames which fit in the buffer, and sets the
+ * size of the encoded data used for them to 'consumed'. The rest should be
+ * passed again with another buffer.
+ *
+ * The worker and nugu_decoder_play() use it to decode straight into the
+ * ring buffer of the pcm(sink) object (see nugu_pcm_reserve_data()).
+ *
+ * @param[in] dec decoder object
+ * @param[in] data encoded data
+ * @param[in] data_len encoded data length
+ * @param[out] out buffer for the decoded data
+ * @param[in] out_size size of the buffer
+ * @param[out] consumed size of the encoded data used
+ * @return size of the decoded data
+ * @retval -1 failure (or not supported by the driver)
+ */
+int nugu_decoder_decode_into(NuguDecoder *dec, const void *data,
+			     size_t data_len, void *out, size_t out_size,
+			     size_t *consumed);
+
 /**
  * @brief Get pcm(sink) object
  * @param[in] dec decoder object
@@ -158,10 +307,43 @@ struct nugu_decoder_driver_ops {
 
 	/**
 	 * @brief Called when a decoding request is received from the decoder.
+	 *
+	 * It is called in the worker thread if the worker is started.
+	 *
 	 * @see nugu_decoder_decode()
+	 * @see nugu_decoder_push()
 	 */
 	int (*decode)(NuguDecoderDriver *driver, NuguDecoder *dec,
 		      const void *data, size_t data_len, NuguBuffer *out_buf);
+
+	/**
+	 * @brief Called to decode the data into the buffer of the caller.
+	 *
+	 * Decode the whole frames which fit in the output buffer, set the
+	 * size of the encoded data used for them, and return the size of the
+	 * decoded data (-1 on failure). The output is in the property of the
+	 * pcm(sink) object. It is optional, and the decoder uses decode()
+	 * through a buffer without it.
+	 *
+	 * @see nugu_decoder_decode_into()
+	 */
+	int (*decode_into)(NuguDecoderDriver *driver, NuguDecoder *dec,
+			   const void *data, size_t data_len, void *out,
+			   size_t out_size, size_t *consumed);
+
+	/**
+	 * @brief Called when the stream of encoded data is ended or canceled.
+	 *
+	 * The driver drops the state carried from the previous data (e.g. a
+	 * part of frame split across the chunks, and the codec history). It
+	 * is optional.
+	 *
+	 * @see nugu_decoder_push_done()
+	 * @see nugu_decoder_cancel()
+	 * @see nugu_decoder_reset()
+	 */
+	int (*reset)(NuguDecoderDriver *driver, NuguDecoder *dec);
+
 	/**
 	 * @brief Called when the decoder is destroyed.
 	 * @see nugu_decoder_free()
@@ -17,6 +17,9 @@
 #ifndef __NUGU_DIRECTIVE_H__
 #define __NUGU_DIRECTIVE_H__
 
+#include <core/nugu_chunk.h>
+#include <core/nugu_pool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -148,10 +151,27 @@ int nugu_directive_set_active(NuguDirective *ndir, int flag);
  * @see nugu_directive_remove_data_callback()
  * @see nugu_directive_get_data()
  * @see nugu_directive_get_data_size()
+ * @see nugu_directive_add_chunks()
  */
 int nugu_directive_add_data(NuguDirective *ndir, size_t length,
 			    unsigned char *data);
 
+/**
+ * @brief Add attachment data to directive without copying.
+ *
+ * The segments of the chunks are shared with the directive, so the chunks
+ * can be freed after this function returns.
+ *
+ * @param[in] ndir directive object
+ * @param[in] chunks chunk chain object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_directive_add_data()
+ * @see nugu_directive_get_chunks()
+ */
+int nugu_directive_add_chunks(NuguDirective *ndir, NuguChunkChain *chunks);
+
 /**
  * @brief Set the attachment data status to "Received all data"
  * @param[in] ndir directive object
@@ -199,9 +219,21 @@ const char *nugu_directive_peek_media_type(NuguDirective *ndir);
  * @param[out] length attachment length
  * @return received attachment data. Developer must free the data manually.
  * @see nugu_directive_get_data_size()
+ * @see nugu_directive_get_chunks()
  */
 unsigned char *nugu_directive_get_data(NuguDirective *ndir, size_t *length);
 
+/**
+ * @brief Get the attachment data received so far without copying.
+ * When this function is called, the internal receive buffer is cleared.
+ * Each segment of the chunks keeps the boundary of received attachment.
+ * @param[in] ndir directive object
+ * @return received attachment chunks. Developer must free the chunks by
+ * nugu_chunk_chain_free(). If there is no data, return NULL.
+ * @see nugu_directive_get_data()
+ */
+NuguChunkChain *nugu_directive_get_chunks(NuguDirective *ndir);
+
 /**
  * @brief Get the size of attachment data received so far.
  * @param[in] ndir directive object
@@ -234,6 +266,23 @@ int nugu_directive_set_data_callback(NuguDirective *ndir,
  */
 int nugu_directive_remove_data_callback(NuguDirective *ndir);
 
+/**
+ * @brief Free the object pool of the directives
+ *
+ * The pool is kept if any directive is in use, and a new pool is created by
+ * the next nugu_directive_new().
+ */
+void nugu_directive_pool_deinit(void);
+
+/**
+ * @brief Get the statistics of the object pool of the directives
+ * @param[out] stats statistics (all zero if the pool is not created)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_directive_get_pool_stats(NuguPoolStats *stats);
+
 /**
  * @}
  */
@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_ENCODER_H__
+#define __NUGU_ENCODER_H__
+
+#include <core/nugu_audio.h>
+#include <core/nugu_buffer.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_encoder.h
+ */
+
+/**
+ * @brief encoder object
+ * @ingroup NuguEncoder
+ */
+typedef struct _nugu_encoder NuguEncoder;
+
+/**
+ * @brief encoder driver object
+ * @ingroup NuguEncoderDriver
+ */
+typedef struct _nugu_encoder_driver NuguEncoderDriver;
+
+/**
+ * @defgroup NuguEncoder Encoder
+ * @ingroup SDKCore
+ * @brief Encoder functions
+ *
+ * The encoder object encodes the recorded pcm data (e.g. the speech for
+ * the ASR) to send it to the server.
+ *
+ * The pcm data is passed to the driver in frames of the size given by the
+ * frame time of the option. The part of frame at the end of data is kept
+ * until the next data.
+ *
+ * @{
+ */
+
+/**
+ * @brief Default frame time in milliseconds
+ */
+#define NUGU_ENCODER_DEFAULT_FRAME_TIME 20
+
+/**
+ * @brief Encoder option
+ * @see nugu_encoder_new()
+ */
+struct nugu_encoder_option {
+	int bitrate; /**< bits per second (0: default of the codec) */
+	int complexity; /**< 0(fast) ~ 10(best) (-1: default of the codec) */
+	int frame_time; /**< duration of a frame in milliseconds */
+};
+
+/**
+ * @brief NuguEncoderOption
+ */
+typedef struct nugu_encoder_option NuguEncoderOption;
+
+/**
+ * @brief Create new encoder object
+ * @param[in] driver encoder driver
+ * @param[in] property audio property of the pcm data
+ * @param[in] option encoder option. NULL for the default values.
+ * @return encoder object
+ * @see nugu_encoder_free()
+ */
+NuguEncoder *nugu_encoder_new(NuguEncoderDriver *driver,
+			      NuguAudioProperty property,
+			      const NuguEncoderOption *option);
+
+/**
+ * @brief Destroy the encoder object
+ * @param[in] enc encoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_encoder_new()
+ */
+int nugu_encoder_free(NuguEncoder *enc);
+
+/**
+ * @brief Encode the pcm data
+ *
+ * The whole frames are encoded and appended to the output buffer. The part
+ * of frame at the end of data is kept until the next call.
+ *
+ * @param[in] enc encoder object
+ * @param[in] data pcm data
+ * @param[in] data_len pcm data length
+ * @param[out] out_buf buffer to append the encoded data
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_encode(NuguEncoder *enc, const void *data, size_t data_len,
+			NuguBuffer *out_buf);
+
+/**
+ * @brief Set the lookback time of the held data
+ *
+ * The data passed to nugu_encoder_hold() is kept for the lookback time,
+ * so that the audio before the start of the speech is also encoded.
+ *
+ * @param[in] enc encoder object
+ * @param[in] msec lookback time in milliseconds (0: nothing is held)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_encoder_hold()
+ */
+int nugu_encoder_set_lookback(NuguEncoder *enc, int msec);
+
+/**
+ * @brief Hold the pcm data without encoding
+ *
+ * Only the last data of the lookback time is kept, and it is encoded by
+ * the next nugu_encoder_encode() before the data of that call.
+ *
+ * @param[in] enc encoder object
+ * @param[in] data pcm data
+ * @param[in] data_len pcm data length
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_encoder_set_lookback()
+ */
+int nugu_encoder_hold(NuguEncoder *enc, const void *data, size_t data_len);
+
+/**
+ * @brief Reset the encoder to encode a new stream
+ *
+ * The part of frame kept from the previous data and the held data are
+ * dropped, and the driver drops the state of the previous stream.
+ *
+ * @param[in] enc encoder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_reset(NuguEncoder *enc);
+
+/**
+ * @brief Get the audio property of the pcm data
+ * @param[in] enc encoder object
+ * @param[out] property audio property
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_get_property(NuguEncoder *enc, NuguAudioProperty *property);
+
+/**
+ * @brief Get the encoder option
+ * @param[in] enc encoder object
+ * @param[out] option encoder option
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_get_option(NuguEncoder *enc, NuguEncoderOption *option);
+
+/**
+ * @brief Get the size of pcm data in a frame
+ * @param[in] enc encoder object
+ * @return size of a frame in bytes
+ */
+size_t nugu_encoder_get_frame_size(NuguEncoder *enc);
+
+/**
+ * @brief Set private userdata for driver
+ * @param[in] enc encoder object
+ * @param[in] userdata userdata managed by driver
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_encoder_get_userdata()
+ */
+int nugu_encoder_set_userdata(NuguEncoder *enc, void *userdata);
+
+/**
+ * @brief Get private userdata for driver
+ * @param[in] enc encoder object
+ * @return userdata
+ * @see nugu_encoder_set_userdata()
+ */
+void *nugu_encoder_get_userdata(NuguEncoder *enc);
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup NuguEncoderDriver Encoder driver
+ * @ingroup SDKDriver
+ * @brief Encoder driver
+ *
+ * The encoder driver performs a function of encoding the pcm data.
+ *
+ * @{
+ */
+
+/**
+ * @brief encoder type
+ * @see nugu_encoder_driver_new()
+ */
+enum encoder_type {
+	ENCODER_TYPE_OPUS, /**< OPUS */
+	ENCODER_TYPE_CUSTOM = 99 /**< Custom type */
+};
+
+/**
+ * @brief encoder driver operations
+ * @see nugu_encoder_driver_new()
+ */
+struct nugu_encoder_driver_ops {
+	/**
+	 * @brief Called when creating a new encoder.
+	 *
+	 * The driver can get the property and option of the encoder, and
+	 * returns -1 if they are not supported.
+	 *
+	 * @see nugu_encoder_new()
+	 */
+	int (*create)(NuguEncoderDriver *driver, NuguEncoder *enc);
+
+	/**
+	 * @brief Called to encode a frame of pcm data.
+	 *
+	 * The data_len is always the frame size of the encoder.
+	 *
+	 * @see nugu_encoder_encode()
+	 * @see nugu_encoder_get_frame_size()
+	 */
+	int (*encode)(NuguEncoderDriver *driver, NuguEncoder *enc,
+		      const void *data, size_t data_len, NuguBuffer *out_buf);
+
+	/**
+	 * @brief Called when the encoder is reset. It is optional.
+	 * @see nugu_encoder_reset()
+	 */
+	int (*reset)(NuguEncoderDriver *driver, NuguEncoder *enc);
+
+	/**
+	 * @brief Called when the encoder is destroyed.
+	 * @see nugu_encoder_free()
+	 */
+	int (*destroy)(NuguEncoderDriver *driver, NuguEncoder *enc);
+};
+
+/**
+ * @brief Create new encoder driver
+ * @param[in] name driver name
+ * @param[in] type encoder type
+ * @param[in] ops operation table
+ * @return encoder driver object
+ * @see nugu_encoder_driver_free()
+ */
+NuguEncoderDriver *nugu_encoder_driver_new(const char *name,
+					   enum encoder_type type,
+					   struct nugu_encoder_driver_ops *ops);
+
+/**
+ * @brief Destroy the encoder driver
+ * @param[in] driver encoder driver object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_driver_free(NuguEncoderDriver *driver);
+
+/**
+ * @brief Register the driver to driver list
+ * @param[in] driver encoder driver object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_driver_register(NuguEncoderDriver *driver);
+
+/**
+ * @brief Remove the driver from driver list
+ * @param[in] driver encoder driver object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_encoder_driver_remove(NuguEncoderDriver *driver);
+
+/**
+ * @brief Find a driver by name in the driver list
+ * @param[in] name encoder driver name
+ * @return encoder driver object
+ * @see nugu_encoder_driver_find_bytype()
+ */
+NuguEncoderDriver *nugu_encoder_driver_find(const char *name);
+
+/**
+ * @brief Find a driver by type in the driver list
+ * @param[in] type encoder driver type
+ * @return encoder driver object
+ * @see nugu_encoder_driver_find
+ */
+NuguEncoderDriver *nugu_encoder_driver_find_bytype(enum encoder_type type);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
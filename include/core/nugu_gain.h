@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_GAIN_H__
+#define __NUGU_GAIN_H__
+
+#include <stddef.h>
+#include <core/nugu_audio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_gain.h
+ * @defgroup NuguGain Gain
+ * @ingroup SDKCore
+ * @brief Volume gain stage for PCM samples
+ *
+ * The gain stage scales the samples in the format of the audio property.
+ * Integer formats are scaled with fixed-point arithmetic, and the sample
+ * data is copied without any calculation when the volume is maximum.
+ *
+ * When the volume is changed while the audio is playing, the gain moves
+ * linearly to the new value during the ramp time to avoid zipper noise.
+ *
+ * The Gain object is not thread safe. Only the thread that processes the
+ * samples should use it.
+ *
+ * @{
+ */
+
+/**
+ * @brief Default ramp time in milliseconds
+ * @see nugu_gain_set_ramp_time()
+ */
+#define NUGU_GAIN_DEFAULT_RAMP_TIME 10
+
+/**
+ * @brief Gain object
+ */
+typedef struct _nugu_gain NuguGain;
+
+/**
+ * @brief Create new gain object
+ *
+ * The initial volume is NUGU_SET_VOLUME_MAX and the format is S16_LE.
+ *
+ * @return gain object
+ * @see nugu_gain_free()
+ */
+NuguGain *nugu_gain_new(void);
+
+/**
+ * @brief Destroy the gain object
+ * @param[in] gain gain object
+ * @see nugu_gain_new()
+ */
+void nugu_gain_free(NuguGain *gain);
+
+/**
+ * @brief Set the audio property of samples
+ * @param[in] gain gain object
+ * @param[in] property audio property
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (unsupported format)
+ */
+int nugu_gain_set_property(NuguGain *gain, NuguAudioProperty property);
+
+/**
+ * @brief Set the volume
+ *
+ * The volume is clamped to NUGU_SET_VOLUME_MIN ~ NUGU_SET_VOLUME_MAX.
+ * Setting the same volume again does nothing.
+ *
+ * @param[in] gain gain object
+ * @param[in] volume volume
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_gain_set_volume(NuguGain *gain, int volume);
+
+/**
+ * @brief Get the volume
+ * @param[in] gain gain object
+ * @return volume
+ */
+int nugu_gain_get_volume(NuguGain *gain);
+
+/**
+ * @brief Set the ramp time used when the volume is changed
+ * @param[in] gain gain object
+ * @param[in] msec ramp time in milliseconds. 0 changes the volume at once.
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see NUGU_GAIN_DEFAULT_RAMP_TIME
+ */
+int nugu_gain_set_ramp_time(NuguGain *gain, int msec);
+
+/**
+ * @brief Finish the ramp and wait for new samples
+ *
+ * The gain is changed to the last volume at once, and the volume changes
+ * before the next nugu_gain_apply() are also applied without ramp.
+ *
+ * @param[in] gain gain object
+ */
+void nugu_gain_reset(NuguGain *gain);
+
+/**
+ * @brief Check whether the samples are copied without change
+ * @param[in] gain gain object
+ * @return result
+ * @retval 1 maximum volume and no ramp in progress
+ * @retval 0 samples are scaled
+ */
+int nugu_gain_is_unity(NuguGain *gain);
+
+/**
+ * @brief Apply the gain to the samples
+ *
+ * Only whole samples are scaled, so the size should be a multiple of the
+ * frame size. The remaining bytes of a partial sample are copied as is.
+ *
+ * @param[in] gain gain object
+ * @param[in] src source samples
+ * @param[out] dest destination buffer. It can be the same as src.
+ * @param[in] size size of samples in bytes
+ * @return size of processed data
+ * @retval -1 failure
+ */
+int nugu_gain_apply(NuguGain *gain, const void *src, void *dest,
+		    size_t size);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
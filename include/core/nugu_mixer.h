@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_MIXER_H__
+#define __NUGU_MIXER_H__
+
+#include <stddef.h>
+#include <core/nugu_audio.h>
+#include <core/nugu_pcm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_mixer.h
+ * @defgroup NuguMixer Mixer
+ * @ingroup SDKCore
+ * @brief Software mixer for pcm objects
+ *
+ * The mixer reads the data of several pcm objects and mixes them into one
+ * output, so a driver can play all pcm objects with one device stream.
+ * The volume and duck level of each pcm are applied by nugu_pcm_get_data()
+ * before mixing.
+ *
+ * The device property of all inputs must be the same as the audio property
+ * of the mixer. Only host endian S16 and float formats are supported.
+ *
+ * nugu_mixer_mix() is called by the audio thread of the driver, and the
+ * other functions are called by the main thread. The mixer never waits for
+ * the main thread in nugu_mixer_mix().
+ *
+ * @{
+ */
+
+/**
+ * @brief Maximum count of inputs
+ */
+#define NUGU_MIXER_MAX_INPUTS 8
+
+/**
+ * @brief Mixer object
+ */
+typedef struct _nugu_mixer NuguMixer;
+
+/**
+ * @brief Callback prototype for the end of input data
+ *
+ * The callback is called by the thread of nugu_mixer_mix() when all data
+ * of the input is consumed after the last data is pushed.
+ */
+typedef void (*NuguMixerEndCallback)(NuguMixer *mixer, NuguPcm *pcm,
+				     void *userdata);
+
+/**
+ * @brief Create new mixer object
+ * @param[in] property audio property of the output
+ * @return mixer object
+ * @see nugu_mixer_free()
+ */
+NuguMixer *nugu_mixer_new(NuguAudioProperty property);
+
+/**
+ * @brief Destroy the mixer object
+ * @param[in] mixer mixer object
+ * @see nugu_mixer_new()
+ */
+void nugu_mixer_free(NuguMixer *mixer);
+
+/**
+ * @brief Get the audio property of the output
+ * @param[in] mixer mixer object
+ * @param[out] property audio property
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_mixer_get_property(NuguMixer *mixer, NuguAudioProperty *property);
+
+/**
+ * @brief Set the callback for the end of input data
+ * @param[in] mixer mixer object
+ * @param[in] callback callback function
+ * @param[in] userdata data to pass to the callback
+ */
+void nugu_mixer_set_end_callback(NuguMixer *mixer,
+				 NuguMixerEndCallback callback,
+				 void *userdata);
+
+/**
+ * @brief Set the delay of the output device
+ *
+ * The delay is passed to each input by nugu_mixer_mix() with
+ * nugu_pcm_set_device_delay(), so that the latency of the inputs includes
+ * the delay of the device.
+ *
+ * @param[in] mixer mixer object
+ * @param[in] usec delay in microseconds
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_pcm_set_device_delay()
+ */
+int nugu_mixer_set_device_delay(NuguMixer *mixer, int usec);
+
+/**
+ * @brief Add the pcm to the inputs of the mixer
+ * @param[in] mixer mixer object
+ * @param[in] pcm pcm object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (different property or too many inputs)
+ */
+int nugu_mixer_add_input(NuguMixer *mixer, NuguPcm *pcm);
+
+/**
+ * @brief Remove the pcm from the inputs of the mixer
+ *
+ * If nugu_mixer_mix() is reading the pcm, this function waits until the
+ * mixing is finished, so the pcm can be freed after this function.
+ *
+ * @param[in] mixer mixer object
+ * @param[in] pcm pcm object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (not an input)
+ */
+int nugu_mixer_remove_input(NuguMixer *mixer, NuguPcm *pcm);
+
+/**
+ * @brief Pause or resume the input
+ *
+ * The data of the paused input is kept until the input is resumed.
+ *
+ * @param[in] mixer mixer object
+ * @param[in] pcm pcm object
+ * @param[in] paused pause(1) or resume(0)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (not an input)
+ */
+int nugu_mixer_set_input_paused(NuguMixer *mixer, NuguPcm *pcm, int paused);
+
+/**
+ * @brief Get the count of inputs
+ * @param[in] mixer mixer object
+ * @return count of inputs
+ */
+int nugu_mixer_get_input_count(NuguMixer *mixer);
+
+/**
+ * @brief Mix the data of all inputs
+ *
+ * The output is filled with silence if there is no data.
+ *
+ * @param[in] mixer mixer object
+ * @param[out] data output buffer
+ * @param[in] size size of output buffer. It should be a multiple of the
+ *            frame size.
+ * @return count of inputs mixed
+ * @retval -1 failure
+ */
+int nugu_mixer_mix(NuguMixer *mixer, void *data, size_t size);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -110,6 +110,20 @@ int nugu_network_manager_send_event(NuguEvent *nev);
 int nugu_network_manager_send_event_data(NuguEvent *nev, int is_end,
 					 size_t length, unsigned char *data);
 
+/**
+ * @brief Stop sending the attachment data of event
+ *
+ * The attachment of the event which is abandoned before the last data is
+ * closed, and the data held for coalescing is dropped.
+ *
+ * @param[in] nev event object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_network_manager_send_event_data()
+ */
+int nugu_network_manager_close_event_data(NuguEvent *nev);
+
 /**
  * @brief Initialize the network manager
  * @return result
@@ -161,12 +175,32 @@ int nugu_network_manager_recv_directive(NuguDirective *ndir);
  * @return result
  * @retval 0 success
  * @retval -1 failure
+ * @see nugu_network_manager_recv_directive_chunks()
  */
 int nugu_network_manager_recv_directive_data(char *parent_msg_id,
 					     char *media_type, int is_end,
 					     size_t length,
 					     unsigned char *data);
 
+/**
+ * @brief Append the attachment chunks to directive object by message-id
+ *
+ * The segments of the chunks are passed to the directive without copying.
+ * The network manager takes the ownership of all arguments.
+ *
+ * @param[in] parent_msg_id ID indicating the owner of the data.
+ * @param[in] media_type mime info
+ * @param[in] is_end data is last(is_end=1) or not(is_end=0)
+ * @param[in] chunks chunk chain object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_network_manager_recv_directive_data()
+ */
+int nugu_network_manager_recv_directive_chunks(char *parent_msg_id,
+					       char *media_type, int is_end,
+					       NuguChunkChain *chunks);
+
 /**
  * @}
  */
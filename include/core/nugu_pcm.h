@@ -19,6 +19,7 @@
 
 #include <core/nugu_audio.h>
 #include <core/nugu_media.h>
+#include <core/nugu_resampler.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,12 +41,86 @@ typedef struct _nugu_pcm NuguPcm;
  */
 typedef struct _nugu_pcm_driver NuguPcmDriver;
 
+/**
+ * @brief Playback statistics
+ * @ingroup NuguPcm
+ * @see nugu_pcm_get_stats()
+ */
+struct nugu_pcm_stats {
+	unsigned int frames; /**< count of played frames */
+	unsigned int silence_frames; /**< count of silence frames inserted */
+	unsigned int underruns; /**< count of data run-outs while playing */
+	int buffered_ms; /**< current buffered time */
+	int is_buffering; /**< waiting for the prebuffer time (1) or not (0) */
+};
+
+/**
+ * @brief NuguPcmStats
+ * @ingroup NuguPcm
+ */
+typedef struct nugu_pcm_stats NuguPcmStats;
+
+/**
+ * @brief Count of the latency histogram buckets
+ * @ingroup NuguPcm
+ * @see nugu_pcm_get_latency()
+ */
+#define NUGU_PCM_LATENCY_BUCKETS 9
+
+/**
+ * @brief Playback latency of the recent pushed blocks
+ *
+ * The queue latency is the time from nugu_pcm_push_data() to the
+ * nugu_pcm_get_data() which reads the first byte of the block. The device
+ * latency is the delay reported by nugu_pcm_set_device_delay() at that
+ * time. The times are in microseconds.
+ *
+ * The histogram counts the total latency (queue + device). The bucket 0
+ * is under 10 msec, the bucket i is under 10 * 2^i msec, and the last
+ * bucket has the rest (1280 msec or more).
+ *
+ * @ingroup NuguPcm
+ * @see nugu_pcm_get_latency()
+ */
+struct nugu_pcm_latency {
+	unsigned int count; /**< count of the measured blocks */
+	int queue_avg; /**< average queue latency */
+	int queue_max; /**< maximum queue latency */
+	int device_avg; /**< average device latency */
+	int device_max; /**< maximum device latency */
+	unsigned int histogram[NUGU_PCM_LATENCY_BUCKETS]; /**< total latency */
+};
+
+/**
+ * @brief NuguPcmLatency
+ * @ingroup NuguPcm
+ */
+typedef struct nugu_pcm_latency NuguPcmLatency;
+
 /**
  * @defgroup NuguPcm PCM manipulation
  * @ingroup SDKCore
  * @brief PCM manipulation functions
  *
- * PCM data is managed by pushing it in the nugu buffer.
+ * PCM data is passed from one producer (nugu_pcm_push_data()) to one
+ * consumer (nugu_pcm_get_data(), usually the audio callback of the driver)
+ * through a lock-free ring buffer. The consumer never waits for a lock,
+ * so nugu_pcm_get_data() can be called in the realtime audio thread.
+ *
+ * The capacity of the ring is fixed by nugu_pcm_start() according to the
+ * audio property. The data that does not fit in the ring is kept in an
+ * overflow buffer, and moved to the ring as the consumer reads the data.
+ *
+ * If the device property is different from the property of the pushed
+ * data, the data is converted (format, channel layout and sample rate) by
+ * nugu_pcm_push_data() before it goes into the ring, so the consumer gets
+ * the data in the device property.
+ *
+ * The playback can wait until the prebuffer time is buffered, so a slow
+ * network does not make the playback choppy. nugu_pcm_get_data() returns
+ * no data until the prebuffer time is buffered or the last data is pushed.
+ * When the data runs out before the last data (underrun), the playback
+ * waits for the prebuffer time again.
  *
  * @{
  */
@@ -109,8 +184,67 @@ NuguPcm *nugu_pcm_find(const char *name);
  */
 int nugu_pcm_set_property(NuguPcm *pcm, NuguAudioProperty property);
 
+/**
+ * @brief Get property of pcm
+ * @param[in] pcm pcm object
+ * @param[out] property property
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_pcm_set_property()
+ */
+int nugu_pcm_get_property(NuguPcm *pcm, NuguAudioProperty *property);
+
+/**
+ * @brief Set the property of the device
+ *
+ * The device property is the property of the data passed to the driver.
+ * The channel count should be the same as the property of pcm, or one of
+ * them should be 1. If the device property is not set, it is the same as
+ * the property of pcm. The change is applied by the next nugu_pcm_start().
+ *
+ * @param[in] pcm pcm object
+ * @param[in] property property of the device
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_pcm_set_resampler_quality()
+ */
+int nugu_pcm_set_device_property(NuguPcm *pcm, NuguAudioProperty property);
+
+/**
+ * @brief Get the property of the device
+ * @param[in] pcm pcm object
+ * @param[out] property property of the device
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_pcm_set_device_property()
+ */
+int nugu_pcm_get_device_property(NuguPcm *pcm, NuguAudioProperty *property);
+
+/**
+ * @brief Set the quality of the resampler
+ *
+ * The default is NUGU_RESAMPLER_QUALITY_MEDIUM. The change is applied by
+ * the next nugu_pcm_start().
+ *
+ * @param[in] pcm pcm object
+ * @param[in] quality quality of the resampler
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_pcm_set_resampler_quality(NuguPcm *pcm,
+				   enum nugu_resampler_quality quality);
+
 /**
  * @brief Start pcm playback
+ *
+ * The ring buffer is prepared for the device property, so the driver must
+ * not get the data while this function is called. The driver is started
+ * with the device property.
+ *
  * @param[in] pcm pcm object
  * @return result
  * @retval 0 success
@@ -151,6 +285,9 @@ int nugu_pcm_resume(NuguPcm *pcm);
 
 /**
  * @brief Set volume of pcm
+ *
+ * The new volume is applied to the playing data with a short ramp.
+ *
  * @param[in] pcm pcm object
  * @param[in] volume volume
  * @return result
@@ -170,6 +307,30 @@ int nugu_pcm_set_volume(NuguPcm *pcm, int volume);
  */
 int nugu_pcm_get_volume(NuguPcm *pcm);
 
+/**
+ * @brief Set duck level of pcm
+ *
+ * The output volume is scaled by the duck level without changing the
+ * volume of pcm, e.g. to attenuate the pcm while another sound is played.
+ * NUGU_SET_VOLUME_MAX means no ducking.
+ *
+ * @param[in] pcm pcm object
+ * @param[in] level duck level (NUGU_SET_VOLUME_MIN ~ NUGU_SET_VOLUME_MAX)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_pcm_get_duck_level()
+ */
+int nugu_pcm_set_duck_level(NuguPcm *pcm, int level);
+
+/**
+ * @brief Get duck level of pcm
+ * @param[in] pcm pcm object
+ * @return duck level
+ * @see nugu_pcm_set_duck_level()
+ */
+int nugu_pcm_get_duck_level(NuguPcm *pcm);
+
 /**
  * @brief Get status of pcm
  * @param[in] pcm pcm object
@@ -227,12 +388,20 @@ void *nugu_pcm_get_userdata(NuguPcm *pcm);
 
 /**
  * @brief Clear pcm buffer
+ *
+ * The data in the ring buffer is discarded by the consumer at the next
+ * nugu_pcm_get_data(), so this function can be called while playing.
+ *
  * @param[in] pcm pcm object
  */
 void nugu_pcm_clear_buffer(NuguPcm *pcm);
 
 /**
  * @brief Push playback pcm data
+ *
+ * The data is converted to the device property. If it is resampled, the
+ * output of the last samples is delayed until the last data is pushed.
+ *
  * @param[in] pcm pcm object
  * @param[in] data pcm data
  * @param[in] size length of pcm data
@@ -254,8 +423,50 @@ int nugu_pcm_push_data(NuguPcm *pcm, const char *data, size_t size,
  */
 int nugu_pcm_push_data_done(NuguPcm *pcm);
 
+/**
+ * @brief Reserve the space of ring buffer to write the data directly
+ *
+ * A producer (e.g. decoder) can write the data into the returned space
+ * without an intermediate buffer, and publish it with
+ * nugu_pcm_commit_data(). The data must be in the device property.
+ *
+ * The space is not available (returns NULL) when the pushed data should be
+ * converted to the device property, the ring is full, or the data remained
+ * in the overflow buffer. Then the data should be pushed with
+ * nugu_pcm_push_data().
+ *
+ * The other producer functions are blocked until the commit, so the
+ * reserved space must be committed as soon as possible.
+ *
+ * @param[in] pcm pcm object
+ * @param[out] size size of the contiguous space
+ * @return writable space. NULL if it is not available.
+ * @see nugu_pcm_commit_data()
+ */
+void *nugu_pcm_reserve_data(NuguPcm *pcm, size_t *size);
+
+/**
+ * @brief Publish the data written in the reserved space
+ *
+ * It must be called only after nugu_pcm_reserve_data() returns the space.
+ *
+ * @param[in] pcm pcm object
+ * @param[in] size size of the written data (0 to cancel the reservation)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure (the size is larger than the reserved space)
+ * @see nugu_pcm_reserve_data()
+ */
+int nugu_pcm_commit_data(NuguPcm *pcm, size_t size);
+
 /**
  * @brief Get all data
+ *
+ * The volume is applied to the data according to the format of the device
+ * property. The size should be a multiple of the frame size. The caller
+ * should fill the rest of the buffer with silence, and the silence is
+ * counted in the statistics.
+ *
  * @param[in] pcm pcm object
  * @param[out] data buffer to get pcm data
  * @param[in] size size of buffer
@@ -282,6 +493,73 @@ size_t nugu_pcm_get_data_size(NuguPcm *pcm);
  */
 int nugu_pcm_receive_is_last_data(NuguPcm *pcm);
 
+/**
+ * @brief Set the prebuffer time
+ *
+ * The playback starts when the data of the prebuffer time is buffered or
+ * the last data is pushed, and restarts in the same way after an underrun.
+ * The change is applied by the next nugu_pcm_start().
+ *
+ * @param[in] pcm pcm object
+ * @param[in] msec prebuffer time in milliseconds (0: no prebuffering)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_pcm_set_prebuffer_time(NuguPcm *pcm, int msec);
+
+/**
+ * @brief Get the prebuffer time
+ * @param[in] pcm pcm object
+ * @return prebuffer time in milliseconds
+ * @retval -1 failure
+ * @see nugu_pcm_set_prebuffer_time()
+ */
+int nugu_pcm_get_prebuffer_time(NuguPcm *pcm);
+
+/**
+ * @brief Get the playback statistics
+ *
+ * The counters are accumulated from the last nugu_pcm_start().
+ *
+ * @param[in] pcm pcm object
+ * @param[out] stats statistics
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_pcm_get_stats(NuguPcm *pcm, NuguPcmStats *stats);
+
+/**
+ * @brief Set the delay of the device
+ *
+ * The driver reports the time until the data read by the next
+ * nugu_pcm_get_data() is output by the device (e.g. the DAC time of the
+ * audio callback). It is added to the latency measurement.
+ *
+ * @param[in] pcm pcm object
+ * @param[in] usec delay in microseconds
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_pcm_set_device_delay(NuguPcm *pcm, int usec);
+
+/**
+ * @brief Get the playback latency
+ *
+ * The latency of the recent 256 pushed blocks since the last
+ * nugu_pcm_start() is returned. A block is not measured if it is cleared
+ * before it is read, or if the consumer is behind by 64 blocks.
+ *
+ * @param[in] pcm pcm object
+ * @param[out] latency latency
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_pcm_get_latency(NuguPcm *pcm, NuguPcmLatency *latency);
+
 /**
  * @}
  */
@@ -310,6 +588,9 @@ struct nugu_pcm_driver_ops {
 
 	/**
 	 * @brief Called when a pcm data is pushed to pcm object
+	 *
+	 * The data is passed as pushed (before the conversion).
+	 *
 	 * @see nugu_pcm_push_data()
 	 */
 	int (*push_data)(NuguPcmDriver *driver, NuguPcm *pcm, const char *data,
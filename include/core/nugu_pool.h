@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_POOL_H__
+#define __NUGU_POOL_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_pool.h
+ * @defgroup NuguPool Pool
+ * @ingroup SDKCore
+ * @brief Fixed-size object pool functions
+ *
+ * The pool allocates memory in slabs of several objects of the same size,
+ * and keeps the released objects in a free list to reuse them. The memory
+ * of slabs is returned to the system only when the pool is destroyed, so
+ * repeated alloc and release do not call malloc() and free() once the pool
+ * has enough objects.
+ *
+ * The Pool object is thread safe.
+ *
+ * @{
+ */
+
+/**
+ * @brief Pool object
+ */
+typedef struct _nugu_pool NuguPool;
+
+/**
+ * @brief Pool statistics
+ * @see nugu_pool_get_stats()
+ */
+struct nugu_pool_stats {
+	unsigned int allocs; /**< count of allocated objects */
+	unsigned int releases; /**< count of released objects */
+	unsigned int slabs; /**< count of slabs allocated from the system */
+	int in_use; /**< count of objects currently in use */
+	int available; /**< count of objects in the free list */
+	int high_watermark; /**< highest count of objects in use */
+};
+
+/**
+ * @brief NuguPoolStats
+ */
+typedef struct nugu_pool_stats NuguPoolStats;
+
+/**
+ * @brief Create new pool object
+ * @param[in] item_size size of an object
+ * @param[in] items_per_slab count of objects allocated at once
+ * @return pool object
+ * @see nugu_pool_free()
+ */
+NuguPool *nugu_pool_new(size_t item_size, int items_per_slab);
+
+/**
+ * @brief Destroy the pool object
+ *
+ * All memory of the pool is freed, including the objects in use.
+ *
+ * @param[in] pool pool object
+ * @see nugu_pool_new()
+ */
+void nugu_pool_free(NuguPool *pool);
+
+/**
+ * @brief Allocate an object from the pool
+ * @param[in] pool pool object
+ * @return zero-filled object
+ * @see nugu_pool_release()
+ */
+void *nugu_pool_alloc(NuguPool *pool);
+
+/**
+ * @brief Return the object to the pool
+ * @param[in] pool pool object
+ * @param[in] item object allocated by nugu_pool_alloc()
+ * @see nugu_pool_alloc()
+ */
+void nugu_pool_release(NuguPool *pool, void *item);
+
+/**
+ * @brief Get the statistics of the pool
+ * @param[in] pool pool object
+ * @param[out] stats statistics
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_pool_get_stats(NuguPool *pool, NuguPoolStats *stats);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
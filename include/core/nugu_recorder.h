@@ -49,12 +49,39 @@ extern "C" {
  */
 typedef struct _nugu_recorder NuguRecorder;
 
+/**
+ * @brief recorder reader object
+ * @ingroup NuguRecorder
+ */
+typedef struct _nugu_recorder_reader NuguRecorderReader;
+
 /**
  * @brief recorder driver object
  * @ingroup NuguRecorderDriver
  */
 typedef struct _nugu_recorder_driver NuguRecorderDriver;
 
+/**
+ * @brief Recorder statistics
+ * @ingroup NuguRecorder
+ * @see nugu_recorder_get_stats()
+ */
+struct nugu_recorder_stats {
+	unsigned int frames; /**< count of recorded frames */
+	unsigned int dropped; /**< count of frames overwritten before read */
+	unsigned int overwrites; /**< count of overflows which dropped frames */
+	unsigned int underruns; /**< count of gaps after the frames are read */
+	int high_watermark; /**< highest count of unread frames */
+	int fill_level; /**< current count of unread frames */
+	int max_frames; /**< maximum count of frames */
+};
+
+/**
+ * @brief NuguRecorderStats
+ * @ingroup NuguRecorder
+ */
+typedef struct nugu_recorder_stats NuguRecorderStats;
+
 /**
  * @defgroup NuguRecorder Voice recorder
  * @ingroup SDKCore
@@ -62,6 +89,22 @@ typedef struct _nugu_recorder_driver NuguRecorderDriver;
  *
  * The recorder manages the recorded audio data by pushing it to the ringbuffer.
  *
+ * The ringbuffer works in the lock-free single producer/single consumer mode,
+ * so the frames must be pushed by only one thread (e.g. audio callback of
+ * the driver) and read by only one thread.
+ *
+ * Several consumers can share one recording stream by using the recorder
+ * reader. Each reader has its own read position, and the recording stream
+ * is opened by the first started reader and closed by the last stopped
+ * reader. A recorder shared by readers must not be started or stopped with
+ * nugu_recorder_start() and nugu_recorder_stop() directly.
+ *
+ * A reader can have a pre-roll time. When the reader is started while the
+ * stream is already opened by another reader, the recently recorded frames
+ * within the pre-roll time are replayed first, so the audio right before
+ * the handoff (e.g. from the wakeup detector to the speech recognizer) is
+ * not lost.
+ *
  * @{
  */
 
@@ -120,6 +163,48 @@ NuguRecorder *nugu_recorder_find(const char *name);
  */
 int nugu_recorder_set_property(NuguRecorder *rec, NuguAudioProperty property);
 
+/**
+ * @brief Get property of recorder object
+ * @param[in] rec recorder object
+ * @param[out] property property
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_recorder_get_property(NuguRecorder *rec, NuguAudioProperty *property);
+
+/**
+ * @brief Set the property of the device
+ *
+ * The device property is the property of the data pushed by the driver.
+ * The data is converted to the property of recorder in
+ * nugu_recorder_push_frame(). The sample rate should be the same as the
+ * property of recorder, and the channel count should be the same or one of
+ * them should be 1. If the device property is not set, it is the same as
+ * the property of recorder. The change is applied by the next
+ * nugu_recorder_start().
+ *
+ * @param[in] rec recorder object
+ * @param[in] property property of the device
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_recorder_set_device_property(NuguRecorder *rec,
+				      NuguAudioProperty property);
+
+/**
+ * @brief Get the property of the device
+ * @param[in] rec recorder object
+ * @param[out] property property of the device
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_set_device_property()
+ */
+int nugu_recorder_get_device_property(NuguRecorder *rec,
+				      NuguAudioProperty *property);
+
 /**
  * @brief Start recording
  * @param[in] rec recorder object
@@ -192,6 +277,10 @@ int nugu_recorder_set_frame_size(NuguRecorder *rec, int size, int max);
 
 /**
  * @brief Push recorded data
+ *
+ * If the device property is set, the data is converted from the device
+ * property to the property of recorder without memory allocation.
+ *
  * @param[in] rec recorder object
  * @param[in] data recorded data
  * @param[in] size size of recorded data
@@ -217,7 +306,7 @@ int nugu_recorder_get_frame(NuguRecorder *rec, char *data, int *size);
  * @param[in] rec recorder object
  * @param[out] data data
  * @param[out] size size of data
- * @param[in] timeout timeout milliseconds
+ * @param[in] timeout timeout milliseconds (0 means infinite)
  * @return result
  * @retval 0 success
  * @retval -1 failure
@@ -225,6 +314,75 @@ int nugu_recorder_get_frame(NuguRecorder *rec, char *data, int *size);
 int nugu_recorder_get_frame_timeout(NuguRecorder *rec, char *data, int *size,
 				    int timeout);
 
+/**
+ * @brief Get the file descriptor notified when frames are recorded
+ *
+ * The file descriptor is an eventfd which becomes readable when frames are
+ * pushed or the recording is stopped, so it can be added to a main loop or
+ * poll(). Read 8 bytes from it to clear the notification before reading the
+ * frames. The file descriptor is closed by nugu_recorder_free().
+ *
+ * @param[in] rec recorder object
+ * @return file descriptor
+ * @retval -1 failure
+ */
+int nugu_recorder_get_fd(NuguRecorder *rec);
+
+/**
+ * @brief Peek recorded frame without copying
+ *
+ * The frame is lent in place and is valid until it is released by
+ * nugu_recorder_release_frame(). The size is 0 if there is no frame.
+ *
+ * @param[in] rec recorder object
+ * @param[out] data address of the frame
+ * @param[out] size frame size
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_release_frame()
+ */
+int nugu_recorder_peek_frame(NuguRecorder *rec, const char **data, int *size);
+
+/**
+ * @brief Peek several contiguous recorded frames without copying
+ *
+ * The frames are stored back to back, so the data of the n-th frame is
+ * located at (data + n * frame size). The count can be smaller than the
+ * count of recorded frames when the frames wrap around the ringbuffer.
+ *
+ * @param[in] rec recorder object
+ * @param[out] data address of the first frame
+ * @param[in] max_count maximum count of frames to peek
+ * @return result
+ * @retval >=0 success (count of peeked frames)
+ * @retval -1 failure
+ * @see nugu_recorder_release_frames()
+ */
+int nugu_recorder_peek_frames(NuguRecorder *rec, const char **data,
+			      int max_count);
+
+/**
+ * @brief Release the frame lent by nugu_recorder_peek_frame()
+ * @param[in] rec recorder object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure or the frame was overwritten while it was lent
+ * @see nugu_recorder_peek_frame()
+ */
+int nugu_recorder_release_frame(NuguRecorder *rec);
+
+/**
+ * @brief Release the frames lent by nugu_recorder_peek_frames()
+ * @param[in] rec recorder object
+ * @param[in] count count of frames to release
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure or the frames were overwritten while they were lent
+ * @see nugu_recorder_peek_frames()
+ */
+int nugu_recorder_release_frames(NuguRecorder *rec, int count);
+
 /**
  * @brief Get frame count
  * @param[in] rec recorder object
@@ -234,6 +392,220 @@ int nugu_recorder_get_frame_timeout(NuguRecorder *rec, char *data, int *size,
  */
 int nugu_recorder_get_frame_count(NuguRecorder *rec);
 
+/**
+ * @brief Get the statistics of the recorder
+ *
+ * The statistics tell whether the consumers keep up with the recording.
+ * If the recorder has readers, the counters of all readers are summed, and
+ * the watermark and the fill level are the highest of them. Otherwise, the
+ * statistics of nugu_recorder_get_frame() and its variants are returned.
+ * The counters are accumulated from the creation of the recorder or the
+ * last nugu_recorder_set_frame_size().
+ *
+ * @param[in] rec recorder object
+ * @param[out] stats statistics
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_reader_get_stats()
+ */
+int nugu_recorder_get_stats(NuguRecorder *rec, NuguRecorderStats *stats);
+
+/**
+ * @brief Create new reader for the recorder
+ * @param[in] rec recorder object
+ * @return reader object
+ * @see nugu_recorder_reader_free()
+ */
+NuguRecorderReader *nugu_recorder_reader_new(NuguRecorder *rec);
+
+/**
+ * @brief Destroy the reader object. The reader is stopped if it is started.
+ * @param[in] reader reader object
+ * @see nugu_recorder_reader_new()
+ */
+void nugu_recorder_reader_free(NuguRecorderReader *reader);
+
+/**
+ * @brief Get the recorder of the reader
+ * @param[in] reader reader object
+ * @return recorder object
+ */
+NuguRecorder *nugu_recorder_reader_get_recorder(NuguRecorderReader *reader);
+
+/**
+ * @brief Set the pre-roll time replayed when the reader is started
+ * @param[in] reader reader object
+ * @param[in] msec pre-roll time in milliseconds (0: no pre-roll)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_reader_get_preroll()
+ */
+int nugu_recorder_reader_set_preroll(NuguRecorderReader *reader, int msec);
+
+/**
+ * @brief Get the pre-roll time of the reader
+ * @param[in] reader reader object
+ * @return pre-roll time in milliseconds
+ * @retval -1 failure
+ * @see nugu_recorder_reader_set_preroll()
+ */
+int nugu_recorder_reader_get_preroll(NuguRecorderReader *reader);
+
+/**
+ * @brief Start reading. The recording is started if it is the first reader.
+ *
+ * The reader reads the frames recorded after this call. If the pre-roll
+ * time is set, the frames recorded within that time are read first.
+ *
+ * @param[in] reader reader object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_reader_stop()
+ */
+int nugu_recorder_reader_start(NuguRecorderReader *reader);
+
+/**
+ * @brief Stop reading. The recording is stopped if it is the last reader.
+ * @param[in] reader reader object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_reader_start()
+ */
+int nugu_recorder_reader_stop(NuguRecorderReader *reader);
+
+/**
+ * @brief Get the status of recording for the reader
+ * @param[in] reader reader object
+ * @return result
+ * @retval 0 idle
+ * @retval 1 recording
+ * @retval -1 failure
+ */
+int nugu_recorder_reader_is_recording(NuguRecorderReader *reader);
+
+/**
+ * @brief Get recorded data at the position of the reader
+ * @param[in] reader reader object
+ * @param[out] data data
+ * @param[out] size size of data
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_recorder_reader_get_frame(NuguRecorderReader *reader, char *data,
+				   int *size);
+
+/**
+ * @brief Get recorded data at the position of the reader with timeout
+ * @param[in] reader reader object
+ * @param[out] data data
+ * @param[out] size size of data
+ * @param[in] timeout timeout milliseconds (0 means infinite)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_recorder_reader_get_frame_timeout(NuguRecorderReader *reader,
+					   char *data, int *size, int timeout);
+
+/**
+ * @brief Peek frame at the position of the reader without copying
+ * @param[in] reader reader object
+ * @param[out] data address of the frame
+ * @param[out] size frame size
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_peek_frame()
+ * @see nugu_recorder_reader_release_frame()
+ */
+int nugu_recorder_reader_peek_frame(NuguRecorderReader *reader,
+				    const char **data, int *size);
+
+/**
+ * @brief Peek frame at the position of the reader with timeout
+ * @param[in] reader reader object
+ * @param[out] data address of the frame
+ * @param[out] size frame size
+ * @param[in] timeout timeout milliseconds (0 means infinite)
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_reader_release_frame()
+ */
+int nugu_recorder_reader_peek_frame_timeout(NuguRecorderReader *reader,
+					    const char **data, int *size,
+					    int timeout);
+
+/**
+ * @brief Peek several contiguous frames at the position of the reader
+ * @param[in] reader reader object
+ * @param[out] data address of the first frame
+ * @param[in] max_count maximum count of frames to peek
+ * @return result
+ * @retval >=0 success (count of peeked frames)
+ * @retval -1 failure
+ * @see nugu_recorder_peek_frames()
+ * @see nugu_recorder_reader_release_frames()
+ */
+int nugu_recorder_reader_peek_frames(NuguRecorderReader *reader,
+				     const char **data, int max_count);
+
+/**
+ * @brief Release the frame lent to the reader
+ * @param[in] reader reader object
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure or the frame was overwritten while it was lent
+ * @see nugu_recorder_reader_peek_frame()
+ */
+int nugu_recorder_reader_release_frame(NuguRecorderReader *reader);
+
+/**
+ * @brief Release the frames lent to the reader
+ * @param[in] reader reader object
+ * @param[in] count count of frames to release
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure or the frames were overwritten while they were lent
+ * @see nugu_recorder_reader_peek_frames()
+ */
+int nugu_recorder_reader_release_frames(NuguRecorderReader *reader, int count);
+
+/**
+ * @brief Get the file descriptor notified when frames are recorded
+ * @param[in] reader reader object
+ * @return file descriptor
+ * @retval -1 failure
+ * @see nugu_recorder_get_fd()
+ */
+int nugu_recorder_reader_get_fd(NuguRecorderReader *reader);
+
+/**
+ * @brief Get the statistics of the reader
+ * @param[in] reader reader object
+ * @param[out] stats statistics
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_recorder_get_stats()
+ */
+int nugu_recorder_reader_get_stats(NuguRecorderReader *reader,
+				   NuguRecorderStats *stats);
+
+/**
+ * @brief Get frame count that the reader can read
+ * @param[in] reader reader object
+ * @return result
+ * @retval >0 success (frame count)
+ * @retval -1 failure
+ */
+int nugu_recorder_reader_get_frame_count(NuguRecorderReader *reader);
+
 /**
  * @}
  */
@@ -251,7 +623,11 @@ int nugu_recorder_get_frame_count(NuguRecorder *rec);
 struct nugu_recorder_driver_ops {
 	/**
 	 * @brief Called when recording is started
+	 *
+	 * The property is the device property of recorder.
+	 *
 	 * @see nugu_recorder_start()
+	 * @see nugu_recorder_set_device_property()
 	 */
 	int (*start)(NuguRecorderDriver *driver, NuguRecorder *rec,
 		     NuguAudioProperty property);
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_RESAMPLER_H__
+#define __NUGU_RESAMPLER_H__
+
+#include <stddef.h>
+#include <core/nugu_audio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nugu_resampler.h
+ * @defgroup NuguResampler Resampler
+ * @ingroup SDKCore
+ * @brief Sample rate converter for PCM samples
+ *
+ * The resampler converts the sample rate with a polyphase windowed-sinc
+ * filter. The filter table is calculated once when the object is created,
+ * and the filter state is kept between the calls of
+ * nugu_resampler_process(), so the input can be pushed in chunks of any
+ * size (even a part of frame).
+ *
+ * Only host endian S16 and float formats are supported. The output has the
+ * same format and channel count as the input.
+ *
+ * The resampler object is not thread safe.
+ *
+ * @{
+ */
+
+/**
+ * @brief Quality of the resampler
+ */
+enum nugu_resampler_quality {
+	NUGU_RESAMPLER_QUALITY_LOW, /**< 8 taps per phase */
+	NUGU_RESAMPLER_QUALITY_MEDIUM, /**< 16 taps per phase */
+	NUGU_RESAMPLER_QUALITY_HIGH /**< 32 taps per phase */
+};
+
+/**
+ * @brief Resampler object
+ */
+typedef struct _nugu_resampler NuguResampler;
+
+/**
+ * @brief Create new resampler object
+ * @param[in] property audio property of the input
+ * @param[in] samplerate sample rate of the output
+ * @param[in] quality quality of the filter
+ * @return resampler object
+ * @retval NULL unsupported format or sample rate
+ * @see nugu_resampler_free()
+ */
+NuguResampler *nugu_resampler_new(NuguAudioProperty property,
+				  enum nugu_audio_sample_rate samplerate,
+				  enum nugu_resampler_quality quality);
+
+/**
+ * @brief Destroy the resampler object
+ * @param[in] rs resampler object
+ * @see nugu_resampler_new()
+ */
+void nugu_resampler_free(NuguResampler *rs);
+
+/**
+ * @brief Discard the filter state and the remaining input
+ * @param[in] rs resampler object
+ */
+void nugu_resampler_reset(NuguResampler *rs);
+
+/**
+ * @brief Get the maximum size of output for the input size
+ * @param[in] rs resampler object
+ * @param[in] size size of input data
+ * @return maximum size of output data
+ * @see nugu_resampler_process()
+ */
+size_t nugu_resampler_get_output_size(NuguResampler *rs, size_t size);
+
+/**
+ * @brief Convert the input data
+ *
+ * The filter needs some samples after the current position, so the output
+ * of the last input samples is delayed until the next input or
+ * nugu_resampler_flush().
+ *
+ * @param[in] rs resampler object
+ * @param[in] data input data
+ * @param[in] size size of input data
+ * @param[out] out output buffer
+ * @param[in] out_size size of output buffer. It should not be less than
+ *            nugu_resampler_get_output_size().
+ * @return size of output data
+ * @retval -1 failure
+ */
+int nugu_resampler_process(NuguResampler *rs, const void *data, size_t size,
+			   void *out, size_t out_size);
+
+/**
+ * @brief Get the maximum size of output of nugu_resampler_flush()
+ * @param[in] rs resampler object
+ * @return maximum size of output data
+ */
+size_t nugu_resampler_get_flush_size(NuguResampler *rs);
+
+/**
+ * @brief Convert the remaining input at the end of the stream
+ *
+ * The state is reset after the flush.
+ *
+ * @param[in] rs resampler object
+ * @param[out] out output buffer
+ * @param[in] out_size size of output buffer. It should not be less than
+ *            nugu_resampler_get_flush_size().
+ * @return size of output data
+ * @retval -1 failure
+ */
+int nugu_resampler_flush(NuguResampler *rs, void *out, size_t out_size);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -30,6 +30,16 @@ extern "C" {
  * The ring buffer manages items by setting the size and
  * number of items as a basic unit.
  *
+ * In the default mode, the ring buffer is protected by a mutex. In the
+ * NUGU_RING_BUFFER_MODE_SPSC mode, the ring buffer is lock-free and can
+ * be used by exactly one producer thread (push) and one consumer thread
+ * (read, clear). When the buffer is full, the oldest items are overwritten
+ * in both modes.
+ *
+ * In the NUGU_RING_BUFFER_MODE_SPSC mode, additional readers can be attached
+ * to broadcast the same items to several consumers. Each reader has its own
+ * read position, and the producer never waits for any of them.
+ *
  * @{
  */
 
@@ -38,6 +48,39 @@ extern "C" {
  */
 typedef struct _nugu_ring_buffer NuguRingBuffer;
 
+/**
+ * @brief RingBuffer reader object
+ */
+typedef struct _nugu_ring_buffer_reader NuguRingBufferReader;
+
+/**
+ * @brief RingBuffer synchronization mode
+ * @see nugu_ring_buffer_new_full()
+ */
+enum nugu_ring_buffer_mode {
+	NUGU_RING_BUFFER_MODE_LOCK, /**< Mutex protected (default) */
+	NUGU_RING_BUFFER_MODE_SPSC /**< Lock-free single producer/consumer */
+};
+
+/**
+ * @brief RingBuffer statistics
+ * @see nugu_ring_buffer_get_stats()
+ */
+struct nugu_ring_buffer_stats {
+	unsigned int pushed; /**< count of pushed items */
+	unsigned int dropped; /**< count of items overwritten before read */
+	unsigned int overwrites; /**< count of overflows which dropped items */
+	unsigned int underruns; /**< count of gaps after the data is received */
+	int high_watermark; /**< highest count of unread items */
+	int count; /**< current count of unread items */
+	int max_items; /**< maximum count of items */
+};
+
+/**
+ * @brief NuguRingBufferStats
+ */
+typedef struct nugu_ring_buffer_stats NuguRingBufferStats;
+
 /**
  * @brief Create new ringbuffer object
  * @param[in] item_size default item size
@@ -46,6 +89,17 @@ typedef struct _nugu_ring_buffer NuguRingBuffer;
  */
 NuguRingBuffer *nugu_ring_buffer_new(int item_size, int max_items);
 
+/**
+ * @brief Create new ringbuffer object with synchronization mode
+ * @param[in] item_size default item size
+ * @param[in] max_items count of itmes
+ * @param[in] mode synchronization mode
+ * @return ringbuffer object
+ * @see nugu_ring_buffer_new()
+ */
+NuguRingBuffer *nugu_ring_buffer_new_full(int item_size, int max_items,
+					  enum nugu_ring_buffer_mode mode);
+
 /**
  * @brief Destroy the ringbuffer object
  * @param[in] buf ringbuffer object
@@ -54,6 +108,10 @@ void nugu_ring_buffer_free(NuguRingBuffer *buf);
 
 /**
  * @brief Resize the ringbuffer
+ *
+ * In the NUGU_RING_BUFFER_MODE_SPSC mode, both the producer and the consumer
+ * must be stopped while resizing.
+ *
  * @param[in] buf ringbuffer object
  * @param[in] item_size default item size
  * @param[in] max_items count of itmes
@@ -85,6 +143,41 @@ int nugu_ring_buffer_push_data(NuguRingBuffer *buf, const char *data, int size);
  */
 int nugu_ring_buffer_read_item(NuguRingBuffer *buf, char *item, int *size);
 
+/**
+ * @brief Peek items from ringbuffer without copying
+ *
+ * The items are lent in place, so the data is valid until the items are
+ * released by nugu_ring_buffer_release_items(). Only the items stored
+ * contiguously are returned, so the count can be smaller than the count of
+ * readable items. Supported only in the NUGU_RING_BUFFER_MODE_SPSC mode.
+ *
+ * @param[in] buf ringbuffer object
+ * @param[out] items address of the first item
+ * @param[in] max_count maximum count of items to peek
+ * @return result
+ * @retval >=0 success (count of peeked items)
+ * @retval -1 failure
+ * @see nugu_ring_buffer_release_items()
+ */
+int nugu_ring_buffer_peek_items(NuguRingBuffer *buf, const char **items,
+				int max_count);
+
+/**
+ * @brief Release the items lent by nugu_ring_buffer_peek_items()
+ *
+ * The producer is never blocked by the lent items. If the producer has
+ * overwritten the lent items in the meantime, -1 is returned and the data
+ * read from them should be discarded.
+ *
+ * @param[in] buf ringbuffer object
+ * @param[in] count count of items to release
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure or the lent items were overwritten
+ * @see nugu_ring_buffer_peek_items()
+ */
+int nugu_ring_buffer_release_items(NuguRingBuffer *buf, int count);
+
 /**
  * @brief Get count
  * @param[in] buf ringbuffer object
@@ -112,12 +205,140 @@ int nugu_ring_buffer_get_item_size(NuguRingBuffer *buf);
  */
 int nugu_ring_buffer_get_maxcount(NuguRingBuffer *buf);
 
+/**
+ * @brief Get the synchronization mode
+ * @param[in] buf ringbuffer object
+ * @return synchronization mode
+ */
+enum nugu_ring_buffer_mode nugu_ring_buffer_get_mode(NuguRingBuffer *buf);
+
+/**
+ * @brief Get the statistics of the ringbuffer
+ *
+ * The counters are accumulated from the creation or the last resize of the
+ * ringbuffer. In the NUGU_RING_BUFFER_MODE_SPSC mode, the producer does not
+ * track the readers, so the dropped items and the high watermark are
+ * calculated from the read position when the consumer reads or this
+ * function is called.
+ *
+ * @param[in] buf ringbuffer object
+ * @param[out] stats statistics
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_ring_buffer_reader_get_stats()
+ */
+int nugu_ring_buffer_get_stats(NuguRingBuffer *buf, NuguRingBufferStats *stats);
+
 /**
  * @brief Clear the ringbuffer
+ *
+ * In the NUGU_RING_BUFFER_MODE_SPSC mode, this function discards all
+ * readable items and must be called from the consumer side.
+ *
  * @param[in] buf ringbuffer object
  */
 void nugu_ring_buffer_clear_items(NuguRingBuffer *buf);
 
+/**
+ * @brief Create new reader attached to the ringbuffer
+ *
+ * The reader starts at the current write position, so only items pushed
+ * after the creation can be read. Only supported in the
+ * NUGU_RING_BUFFER_MODE_SPSC mode.
+ *
+ * @param[in] buf ringbuffer object
+ * @return reader object
+ * @see nugu_ring_buffer_reader_free()
+ */
+NuguRingBufferReader *nugu_ring_buffer_reader_new(NuguRingBuffer *buf);
+
+/**
+ * @brief Destroy the reader object
+ * @param[in] reader reader object
+ * @see nugu_ring_buffer_reader_new()
+ */
+void nugu_ring_buffer_reader_free(NuguRingBufferReader *reader);
+
+/**
+ * @brief Read item from ringbuffer at the position of the reader
+ * @param[in] reader reader object
+ * @param[out] item item
+ * @param[out] size size of item
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ */
+int nugu_ring_buffer_reader_read_item(NuguRingBufferReader *reader,
+				      char *item, int *size);
+
+/**
+ * @brief Peek items at the position of the reader without copying
+ * @param[in] reader reader object
+ * @param[out] items address of the first item
+ * @param[in] max_count maximum count of items to peek
+ * @return result
+ * @retval >=0 success (count of peeked items)
+ * @retval -1 failure
+ * @see nugu_ring_buffer_peek_items()
+ * @see nugu_ring_buffer_reader_release_items()
+ */
+int nugu_ring_buffer_reader_peek_items(NuguRingBufferReader *reader,
+				       const char **items, int max_count);
+
+/**
+ * @brief Release the items lent by nugu_ring_buffer_reader_peek_items()
+ * @param[in] reader reader object
+ * @param[in] count count of items to release
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure or the lent items were overwritten
+ * @see nugu_ring_buffer_release_items()
+ */
+int nugu_ring_buffer_reader_release_items(NuguRingBufferReader *reader,
+					  int count);
+
+/**
+ * @brief Get count of items that the reader can read
+ * @param[in] reader reader object
+ * @return result
+ * @retval >0 success (count)
+ * @retval -1 failure
+ */
+int nugu_ring_buffer_reader_get_count(NuguRingBufferReader *reader);
+
+/**
+ * @brief Get the statistics at the position of the reader
+ * @param[in] reader reader object
+ * @param[out] stats statistics
+ * @return result
+ * @retval 0 success
+ * @retval -1 failure
+ * @see nugu_ring_buffer_get_stats()
+ */
+int nugu_ring_buffer_reader_get_stats(NuguRingBufferReader *reader,
+				      NuguRingBufferStats *stats);
+
+/**
+ * @brief Discard all items that the reader can read
+ * @param[in] reader reader object
+ */
+void nugu_ring_buffer_reader_clear_items(NuguRingBufferReader *reader);
+
+/**
+ * @brief Move the reader back to replay recently pushed items
+ *
+ * The reader is placed 'count' items before the current write position.
+ * The count is limited to the items kept in the ringbuffer, and items
+ * pushed before the last nugu_ring_buffer_clear_items() are not replayed.
+ *
+ * @param[in] reader reader object
+ * @param[in] count count of items to replay
+ * @return count of items placed in front of the reader
+ * @retval -1 failure
+ */
+int nugu_ring_buffer_reader_rewind(NuguRingBufferReader *reader, int count);
+
 /**
  * @}
  */
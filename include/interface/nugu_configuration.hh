@@ -36,11 +36,21 @@ namespace NuguConfig {
         const std::string WAKEUP_WORD = "wakeup_word";
         const std::string ASR_EPD_TYPE = "asr_epd_type";
         const std::string ASR_ENCODING = "asr_encoding";
+        const std::string ASR_PREROLL = "asr_preroll";
+        const std::string ASR_CODEC = "asr_codec";
+        const std::string ASR_CODEC_BITRATE = "asr_codec_bitrate";
+        const std::string TTS_DEVICE_SAMPLERATE = "tts_device_samplerate";
+        const std::string TTS_PREBUFFER_TIME = "tts_prebuffer_time";
+        const std::string FOCUS_DUCK_LEVEL = "focus_duck_level";
         const std::string MODEL_PATH = "model_path";
         const std::string SERVER_TYPE = "server_type";
         const std::string USER_AGENT = NUGU_CONFIG_KEY_USER_AGENT;
         const std::string GATEWAY_REGISTRY_DNS = NUGU_CONFIG_KEY_GATEWAY_REGISTRY_DNS;
         const std::string UUID_PHASE = NUGU_CONFIG_KEY_UUID_PHASE;
+        const std::string PCM_IDLE_TIMEOUT = NUGU_CONFIG_KEY_PCM_IDLE_TIMEOUT;
+        const std::string ATTACHMENT_STREAM = NUGU_CONFIG_KEY_ATTACHMENT_STREAM;
+        const std::string ATTACHMENT_COALESCE_DELAY = NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_DELAY;
+        const std::string ATTACHMENT_COALESCE_SIZE = NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_SIZE;
     }
 
     const NuguConfigType getDefaultValues();
@@ -19,10 +19,12 @@
 #include <interface/capability/system_interface.hh>
 #include <interface/nugu_configuration.hh>
 
+#include "audio_recorder_manager.hh"
 #include "capability_creator.hh"
 #include "capability_manager_helper.hh"
 #include "nugu_client_impl.hh"
 #include "nugu_config.h"
+#include "nugu_decoder.h"
 #include "nugu_log.h"
 #include "nugu_plugin.h"
 
@@ -199,7 +201,10 @@ void NuguClientImpl::deInitialize(void)
     if (wakeup_handler)
         delete wakeup_handler;
 
+    AudioRecorderManager::destroyInstance();
+
     // deinitialize core component
+    nugu_decoder_pool_clear();
     nugu_plugin_deinitialize();
     nugu_config_deinitialize();
 
@@ -27,9 +27,19 @@ namespace NuguConfig {
             { Key::WAKEUP_WORD, "1" },
             { Key::ASR_EPD_TYPE, "CLIENT" },
             { Key::ASR_ENCODING, "COMPLETE" },
+            { Key::ASR_PREROLL, "0" },
+            { Key::ASR_CODEC, "SPEEX" },
+            { Key::ASR_CODEC_BITRATE, "0" },
+            { Key::TTS_DEVICE_SAMPLERATE, "0" },
+            { Key::TTS_PREBUFFER_TIME, "0" },
+            { Key::FOCUS_DUCK_LEVEL, "0" },
             { Key::MODEL_PATH, "./" },
             { Key::SERVER_TYPE, "PRD" },
             { Key::UUID_PHASE, "0" },
+            { Key::PCM_IDLE_TIMEOUT, "0" },
+            { Key::ATTACHMENT_STREAM, "false" },
+            { Key::ATTACHMENT_COALESCE_DELAY, "0" },
+            { Key::ATTACHMENT_COALESCE_SIZE, "8192" },
             { Key::USER_AGENT, NUGU_USERAGENT },
             { Key::GATEWAY_REGISTRY_DNS, "reg-http.sktnugu.com" }
         };
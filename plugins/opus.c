@@ -16,23 +16,50 @@
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <glib.h>
 #include <opus.h>
 
 #include "nugu_log.h"
 #include "nugu_plugin.h"
 #include "nugu_decoder.h"
+#include "nugu_encoder.h"
 #include "nugu_pcm.h"
+#include "nugu_audio_convert.h"
 
 #define SAMPLING_RATES 24000
 #define CHANNELS 1
 #define PCM_SAMPLES 480
+#define FRAME_BYTES (PCM_SAMPLES * CHANNELS * sizeof(opus_int16))
+
+/* record := 4 bytes[len] + 4 bytes[range] + payload */
+#define RECORD_LEN_SIZE 4
+#define RECORD_HEADER_SIZE 8
+#define MAX_PAYLOAD 160
 
 #define READINT(v)                                                             \
 	(((unsigned int)v[0] << 24) | ((unsigned int)v[1] << 16) |             \
 	 ((unsigned int)v[2] << 8) | (unsigned int)v[3])
 
+#define WRITEINT(v, n)                                                         \
+	do {                                                                   \
+		(v)[0] = ((n) >> 24) & 0xFF;                                   \
+		(v)[1] = ((n) >> 16) & 0xFF;                                   \
+		(v)[2] = ((n) >> 8) & 0xFF;                                    \
+		(v)[3] = (n)&0xFF;                                             \
+	} while (0)
+
 static NuguDecoderDriver *driver;
+static NuguEncoderDriver *enc_driver;
+
+struct opus_stream {
+	OpusDecoder *handle;
+
+	/* part of record carried to the next decoding */
+	unsigned char record[RECORD_HEADER_SIZE + MAX_PAYLOAD];
+	size_t record_size;
+};
 
 #ifdef DECODER_FILE_DUMP
 static Pcm *_tmp_filedump;
@@ -57,16 +84,23 @@ static void dump_opus_error(int error_code)
 
 static int _decoder_create(NuguDecoderDriver *driver, NuguDecoder *dec)
 {
-	OpusDecoder *handle;
+	struct opus_stream *st;
 	int err = 0;
 
-	handle = opus_decoder_create(SAMPLING_RATES, CHANNELS, &err);
+	st = calloc(1, sizeof(struct opus_stream));
+	if (!st) {
+		error_nomem();
+		return -1;
+	}
+
+	st->handle = opus_decoder_create(SAMPLING_RATES, CHANNELS, &err);
 	if (err != OPUS_OK) {
 		nugu_error("opus_decoder_create() failed. (%d)", err);
+		free(st);
 		return -1;
 	}
 
-	nugu_decoder_set_userdata(dec, handle);
+	nugu_decoder_set_userdata(dec, st);
 
 	nugu_dbg("new opus 22K decoder (16bit mono pcm) created");
 
@@ -80,21 +114,88 @@ static int _decoder_create(NuguDecoderDriver *driver, NuguDecoder *dec)
 	return 0;
 }
 
-static int _decoder_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
-			   const void *data, size_t data_len,
-			   NuguBuffer *out_buf)
+/**
+ * Size of the record which starts with the data. An invalid payload length
+ * is skipped as a record of the length field only.
+ */
+static size_t _record_size(const unsigned char *data, size_t size)
+{
+	unsigned int len;
+
+	if (size < RECORD_LEN_SIZE)
+		return RECORD_LEN_SIZE;
+
+	len = READINT(data);
+	if (len == 0 || len > MAX_PAYLOAD)
+		return RECORD_LEN_SIZE;
+
+	return RECORD_HEADER_SIZE + len;
+}
+
+/**
+ * Get the next whole record from the data. The part of record at the end
+ * of data is carried to the next call, so a record can be split across the
+ * attachment chunks.
+ */
+static const unsigned char *_next_record(struct opus_stream *st,
+					 const unsigned char **pos,
+					 const unsigned char *end,
+					 size_t *size)
+{
+	const unsigned char *packet = *pos;
+	size_t need;
+	size_t length;
+
+	if (st->record_size == 0) {
+		need = _record_size(packet, end - packet);
+		if ((size_t)(end - packet) >= need) {
+			*pos = packet + need;
+			*size = need;
+			return packet;
+		}
+	}
+
+	while ((need = _record_size(st->record, st->record_size)) >
+	       st->record_size) {
+		if (packet == end) {
+			*pos = end;
+			return NULL;
+		}
+
+		length = MIN(need - st->record_size, (size_t)(end - packet));
+		memcpy(st->record + st->record_size, packet, length);
+		st->record_size += length;
+		packet += length;
+	}
+
+	*pos = packet;
+	*size = st->record_size;
+	st->record_size = 0;
+
+	return st->record;
+}
+
+/**
+ * Decode the whole frames which fit in the output. The samples are written
+ * in host endian, and the misaligned output is written through a frame
+ * buffer.
+ */
+static int _decode_frames(struct opus_stream *st, const unsigned char *data,
+			  size_t data_len, unsigned char *out, size_t out_size,
+			  size_t *consumed)
 {
-	OpusDecoder *handle;
 	const unsigned char *packet = data;
+	const unsigned char *end = data + data_len;
+	const unsigned char *record;
+	opus_int16 sample[PCM_SAMPLES * CHANNELS];
+	opus_int16 *target;
+	int aligned = ((uintptr_t)out % sizeof(opus_int16)) == 0;
+	size_t written = 0;
+	size_t size;
+	size_t length;
 	int nsamples;
-	int len;
 	uint32_t enc_final_range;
 	uint32_t dec_final_range;
-	opus_int16 sample[PCM_SAMPLES * CHANNELS];
-	char plain_pcm[PCM_SAMPLES * CHANNELS * 2];
-	int i;
-
-	handle = nugu_decoder_get_userdata(dec);
 
 	/**
 	 * opus 1 frame
@@ -102,27 +203,29 @@ static int _decoder_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
 	 * decoding result
 	 *   := 480 samples (16bit) == 960 bytes
 	 */
-	while (packet < (unsigned char *)data + data_len) {
-		len = READINT(packet);
-		packet += 4;
+	while (out_size - written >= FRAME_BYTES) {
+		record = _next_record(st, &packet, end, &size);
+		if (!record)
+			break;
 
-		if (len > 160 || len == 0) {
-			nugu_error("invalid payload length(%d)", len);
+		if (size == RECORD_LEN_SIZE) {
+			nugu_error("invalid payload length(%u)",
+				   READINT(record));
 			continue;
 		}
-		enc_final_range = READINT(packet);
-		packet += 4;
 
-		nsamples = opus_decode(handle, packet, len, sample, PCM_SAMPLES,
-				       0);
+		enc_final_range = READINT((record + RECORD_LEN_SIZE));
+		target = aligned ? (opus_int16 *)(out + written) : sample;
+
+		nsamples = opus_decode(st->handle, record + RECORD_HEADER_SIZE,
+				       size - RECORD_HEADER_SIZE, target,
+				       PCM_SAMPLES, 0);
 		if (nsamples <= 0) {
 			dump_opus_error(nsamples);
-			break;
+			continue;
 		}
 
-		packet += len;
-
-		opus_decoder_ctl(handle,
+		opus_decoder_ctl(st->handle,
 				 OPUS_GET_FINAL_RANGE(&dec_final_range));
 		if (enc_final_range != dec_final_range) {
 			nugu_error("range coder status mismatch (0x%x != 0x%X)",
@@ -130,18 +233,78 @@ static int _decoder_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
 			continue;
 		}
 
-		for (i = 0; i < nsamples; i++) {
-			plain_pcm[2 * i] = sample[i] & 0xFF;
-			plain_pcm[2 * i + 1] = (sample[i] & 0xFF00) >> 8;
-		}
+		length = nsamples * CHANNELS * sizeof(opus_int16);
+		if (!aligned)
+			memcpy(out + written, sample, length);
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+		/* The pcm of tts is signed 16 bits little endian */
+		nugu_audio_swap16(out + written, nsamples * CHANNELS);
+#endif
 
 #ifdef DECODER_FILE_DUMP
 		if (_tmp_filedump)
-			nugu_pcm_push_data(_tmp_filedump, plain_pcm,
-					   nsamples * 2, 0);
+			nugu_pcm_push_data(_tmp_filedump,
+					   (const char *)out + written, length,
+					   0);
 #endif
 
-		nugu_buffer_add(out_buf, plain_pcm, nsamples * 2);
+		written += length;
+	}
+
+	*consumed = packet - data;
+
+	return written;
+}
+
+static int _decoder_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
+			   const void *data, size_t data_len,
+			   NuguBuffer *out_buf)
+{
+	struct opus_stream *st;
+	const unsigned char *packet = data;
+	opus_int16 sample[PCM_SAMPLES * CHANNELS];
+	size_t consumed;
+	int length;
+
+	st = nugu_decoder_get_userdata(dec);
+
+	while (data_len > 0) {
+		length = _decode_frames(st, packet, data_len,
+					(unsigned char *)sample, sizeof(sample),
+					&consumed);
+		if (length > 0)
+			nugu_buffer_add(out_buf, sample, length);
+
+		packet += consumed;
+		data_len -= consumed;
+	}
+
+	return 0;
+}
+
+static int _decoder_decode_into(NuguDecoderDriver *driver, NuguDecoder *dec,
+				const void *data, size_t data_len, void *out,
+				size_t out_size, size_t *consumed)
+{
+	return _decode_frames(nugu_decoder_get_userdata(dec), data, data_len,
+			      out, out_size, consumed);
+}
+
+static int _decoder_reset(NuguDecoderDriver *driver, NuguDecoder *dec)
+{
+	struct opus_stream *st = nugu_decoder_get_userdata(dec);
+
+	if (st->record_size > 0)
+		nugu_dbg("drop the part of record (%zd bytes)",
+			 st->record_size);
+
+	st->record_size = 0;
+
+	/* The next stream starts with a fresh codec state */
+	if (opus_decoder_ctl(st->handle, OPUS_RESET_STATE) != OPUS_OK) {
+		nugu_error("opus_decoder_ctl(OPUS_RESET_STATE) failed");
+		return -1;
 	}
 
 	return 0;
@@ -149,11 +312,12 @@ static int _decoder_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
 
 static int _decoder_destroy(NuguDecoderDriver *driver, NuguDecoder *dec)
 {
-	OpusDecoder *handle;
+	struct opus_stream *st;
 
-	handle = nugu_decoder_get_userdata(dec);
+	st = nugu_decoder_get_userdata(dec);
 
-	opus_decoder_destroy(handle);
+	opus_decoder_destroy(st->handle);
+	free(st);
 
 	nugu_dbg("opus decoder destroyed");
 
@@ -170,9 +334,140 @@ static int _decoder_destroy(NuguDecoderDriver *driver, NuguDecoder *dec)
 static struct nugu_decoder_driver_ops decoder_ops = {
 	.create = _decoder_create,
 	.decode = _decoder_decode,
+	.decode_into = _decoder_decode_into,
+	.reset = _decoder_reset,
 	.destroy = _decoder_destroy
 };
 
+static int _encoder_create(NuguEncoderDriver *driver, NuguEncoder *enc)
+{
+	OpusEncoder *handle;
+	NuguAudioProperty property;
+	NuguEncoderOption option;
+	int rate;
+	int err = 0;
+
+	nugu_encoder_get_property(enc, &property);
+	nugu_encoder_get_option(enc, &option);
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	if (property.format != AUDIO_FORMAT_S16_LE) {
+#else
+	if (property.format != AUDIO_FORMAT_S16_BE) {
+#endif
+		nugu_error("not supported format(%d)", property.format);
+		return -1;
+	}
+
+	/* 2.5 ms frame is not supported by the integer frame time */
+	switch (option.frame_time) {
+	case 5:
+	case 10:
+	case 20:
+	case 40:
+	case 60:
+		break;
+	default:
+		nugu_error("not supported frame time(%d)", option.frame_time);
+		return -1;
+	}
+
+	rate = nugu_audio_get_rate(property.samplerate);
+
+	handle = opus_encoder_create(rate, property.channel,
+				     OPUS_APPLICATION_VOIP, &err);
+	if (err != OPUS_OK) {
+		nugu_error("opus_encoder_create() failed. (%d)", err);
+		return -1;
+	}
+
+	if (option.bitrate > 0 &&
+	    opus_encoder_ctl(handle, OPUS_SET_BITRATE(option.bitrate)) !=
+		    OPUS_OK)
+		nugu_error("not supported bitrate(%d)", option.bitrate);
+
+	if (option.complexity >= 0 &&
+	    opus_encoder_ctl(handle, OPUS_SET_COMPLEXITY(option.complexity)) !=
+		    OPUS_OK)
+		nugu_error("not supported complexity(%d)", option.complexity);
+
+	nugu_encoder_set_userdata(enc, handle);
+
+	nugu_dbg("new opus encoder (%d Hz, %d ch, %d ms) created", rate,
+		 property.channel, option.frame_time);
+
+	return 0;
+}
+
+/**
+ * The encoded frame is written in the same record as the decoder reads
+ *   := 4 bytes[len] + 4 bytes[range] + payload
+ * The payload is limited to MAX_PAYLOAD, which lowers the bitrate of the
+ * frame if the option asks for more.
+ */
+static int _encoder_encode(NuguEncoderDriver *driver, NuguEncoder *enc,
+			   const void *data, size_t data_len,
+			   NuguBuffer *out_buf)
+{
+	OpusEncoder *handle;
+	NuguAudioProperty property;
+	unsigned char record[RECORD_HEADER_SIZE + MAX_PAYLOAD];
+	opus_uint32 final_range = 0;
+	int samples;
+	int len;
+
+	handle = nugu_encoder_get_userdata(enc);
+	nugu_encoder_get_property(enc, &property);
+
+	samples = data_len / (sizeof(opus_int16) * property.channel);
+
+	len = opus_encode(handle, data, samples, record + RECORD_HEADER_SIZE,
+			  MAX_PAYLOAD);
+	if (len < 0) {
+		dump_opus_error(len);
+		return -1;
+	}
+
+	opus_encoder_ctl(handle, OPUS_GET_FINAL_RANGE(&final_range));
+
+	WRITEINT(record, len);
+	WRITEINT(record + RECORD_LEN_SIZE, final_range);
+
+	if (nugu_buffer_add(out_buf, record, RECORD_HEADER_SIZE + len) ==
+	    (size_t)-1)
+		return -1;
+
+	return 0;
+}
+
+static int _encoder_reset(NuguEncoderDriver *driver, NuguEncoder *enc)
+{
+	OpusEncoder *handle = nugu_encoder_get_userdata(enc);
+
+	if (opus_encoder_ctl(handle, OPUS_RESET_STATE) != OPUS_OK) {
+		nugu_error("opus_encoder_ctl(OPUS_RESET_STATE) failed");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int _encoder_destroy(NuguEncoderDriver *driver, NuguEncoder *enc)
+{
+	opus_encoder_destroy(nugu_encoder_get_userdata(enc));
+
+	nugu_dbg("opus encoder destroyed");
+
+	return 0;
+}
+
+static struct nugu_encoder_driver_ops encoder_ops = {
+	.create = _encoder_create,
+	.encode = _encoder_encode,
+	.reset = _encoder_reset,
+	.destroy = _encoder_destroy
+};
+
 static int init(NuguPlugin *p)
 {
 	nugu_dbg("plugin-init '%s'", nugu_plugin_get_description(p)->name);
@@ -184,10 +479,29 @@ static int init(NuguPlugin *p)
 
 	if (nugu_decoder_driver_register(driver) < 0) {
 		nugu_decoder_driver_free(driver);
+		driver = NULL;
 		return -1;
 	}
 
+	enc_driver = nugu_encoder_driver_new("opus", ENCODER_TYPE_OPUS,
+					     &encoder_ops);
+	if (!enc_driver)
+		goto error_encoder;
+
+	if (nugu_encoder_driver_register(enc_driver) < 0) {
+		nugu_encoder_driver_free(enc_driver);
+		enc_driver = NULL;
+		goto error_encoder;
+	}
+
 	return 0;
+
+error_encoder:
+	nugu_decoder_driver_remove(driver);
+	nugu_decoder_driver_free(driver);
+	driver = NULL;
+
+	return -1;
 }
 
 static int load(void)
@@ -201,11 +515,20 @@ static void unload(NuguPlugin *p)
 {
 	nugu_dbg("plugin-unload '%s'", nugu_plugin_get_description(p)->name);
 
+	/* The idle decoders hold the driver */
+	nugu_decoder_pool_clear();
+
 	if (driver) {
 		nugu_decoder_driver_remove(driver);
 		nugu_decoder_driver_free(driver);
 		driver = NULL;
 	}
+
+	if (enc_driver) {
+		nugu_encoder_driver_remove(enc_driver);
+		nugu_encoder_driver_free(enc_driver);
+		enc_driver = NULL;
+	}
 }
 
 NUGU_PLUGIN_DEFINE("opus",
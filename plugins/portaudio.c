@@ -18,17 +18,24 @@
 #include <stdio.h>
 #include <glib.h>
 #include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include <alsa/error.h>
 #include <portaudio.h>
 
 #include "nugu_log.h"
+#include "nugu_config.h"
 #include "nugu_plugin.h"
 #include "nugu_recorder.h"
 #include "nugu_pcm.h"
+#include "nugu_mixer.h"
 
 #define PLUGIN_DRIVER_NAME "portaudio"
+#define MIXER_DRIVER_NAME "portaudio_mixer"
 #define SAMPLE_SILENCE (0.0f)
 #define FRAME_PER_BUFFER 512
+#define EOS_GUARD_TIME 500
 
 struct pa_audio_param {
 	PaStream *stream;
@@ -44,6 +51,28 @@ struct pa_audio_param {
 
 static NuguRecorderDriver *rec_driver;
 static NuguPcmDriver *pcm_driver;
+static NuguPcmDriver *mixer_driver;
+
+/* output stream shared by all pcm objects of the mixer driver */
+static struct pa_audio_param *mixer_param;
+
+/* closes the mixer stream after the idle timeout without inputs */
+static guint mixer_timer;
+
+/*
+ * End of stream of the mixer inputs. The slots are managed in the main
+ * loop, and the audio thread only sets the ended flag and wakes up the
+ * main loop.
+ */
+struct mixer_eos {
+	gpointer pcm; /* NuguPcm, NULL if the slot is empty */
+	gint ended;
+	guint timer;
+};
+
+static struct mixer_eos mixer_eos[NUGU_MIXER_MAX_INPUTS];
+static int mixer_efd = -1;
+static guint mixer_efd_source;
 
 static int _set_property_to_param(struct pa_audio_param *param,
 				  NuguAudioProperty prop)
@@ -66,11 +95,18 @@ static int _set_property_to_param(struct pa_audio_param *param,
 	case AUDIO_SAMPLE_RATE_44K:
 		param->samplerate = 44100;
 		break;
+	case AUDIO_SAMPLE_RATE_48K:
+		param->samplerate = 48000;
+		break;
 	default:
 		param->samplerate = 16000;
 		break;
 	}
 
+	/**
+	 * PortAudio only handles the host byte order. The recorder and the
+	 * pcm convert the other formats by the device property.
+	 */
 	switch (prop.format) {
 	case AUDIO_FORMAT_S8:
 		param->format = paInt8;
@@ -80,18 +116,35 @@ static int _set_property_to_param(struct pa_audio_param *param,
 		param->format = paUInt8;
 		param->samplebyte = 1;
 		break;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
 	case AUDIO_FORMAT_S16_LE:
+#else
 	case AUDIO_FORMAT_S16_BE:
+#endif
 		param->format = paInt16;
 		param->samplebyte = 2;
 		break;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
 	case AUDIO_FORMAT_S24_LE:
+#else
 	case AUDIO_FORMAT_S24_BE:
+#endif
 		param->format = paInt24;
 		param->samplebyte = 3;
 		break;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
 	case AUDIO_FORMAT_S32_LE:
+#else
 	case AUDIO_FORMAT_S32_BE:
+#endif
+		param->format = paInt32;
+		param->samplebyte = 4;
+		break;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	case AUDIO_FORMAT_FLOAT_LE:
+#else
+	case AUDIO_FORMAT_FLOAT_BE:
+#endif
 		param->format = paFloat32;
 		param->samplebyte = 4;
 		break;
@@ -117,7 +170,7 @@ static int _recordCallback(const void *inputBuffer, void *outputBuffer,
 	NuguRecorder *rec = (NuguRecorder *)param->data;
 	char *buf = (char *)inputBuffer;
 	int finished = paContinue;
-	int buf_size = framesPerBuffer * param->samplebyte;
+	int buf_size = framesPerBuffer * param->samplebyte * param->channel;
 
 	(void)outputBuffer; /* Prevent unused variable warnings. */
 	(void)timeInfo;
@@ -150,6 +203,17 @@ static gboolean _playerEndOfStream(void *userdata)
 	return FALSE;
 }
 
+/* The buffer is output at the DAC time (0 if the host does not support) */
+static int _get_device_delay(const PaStreamCallbackTimeInfo *timeInfo)
+{
+	if (timeInfo && timeInfo->outputBufferDacTime > timeInfo->currentTime)
+		return (int)((timeInfo->outputBufferDacTime -
+			      timeInfo->currentTime) *
+			     1000000);
+
+	return 0;
+}
+
 /* This routine will be called by the PortAudio engine when audio is needed.
  * It may be called at interrupt level on some machines so don't do anything
  * that could mess up the system like calling malloc() or free().
@@ -163,23 +227,22 @@ static int _playbackCallback(const void *inputBuffer, void *outputBuffer,
 	NuguPcm *pcm = (NuguPcm *)param->data;
 	char *buf = (char *)outputBuffer;
 	int finished = paContinue;
-	int buf_size = framesPerBuffer * param->samplebyte;
+	int buf_size = framesPerBuffer * param->samplebyte * param->channel;
 	int guard_time = 500;
 
 	(void)inputBuffer; /* Prevent unused variable warnings. */
-	(void)timeInfo;
 	(void)statusFlags;
 
 	memset(buf, SAMPLE_SILENCE, buf_size);
 
-	if (param->pause)
-		return finished;
+	if (!param->pause) {
+		nugu_pcm_set_device_delay(pcm, _get_device_delay(timeInfo));
 
-	if (nugu_pcm_get_data_size(pcm) > 0) {
-		nugu_pcm_get_data(pcm, buf, buf_size);
-	} else if (nugu_pcm_receive_is_last_data(pcm)) {
-		// send event to the main loop thread
-		if (!param->done) {
+		/* The short read is counted as an underrun by the pcm */
+		if (nugu_pcm_get_data(pcm, buf, buf_size) <= 0 &&
+		    nugu_pcm_receive_is_last_data(pcm) &&
+		    nugu_pcm_get_data_size(pcm) == 0 && !param->done) {
+			// send event to the main loop thread
 			g_timeout_add(guard_time, _playerEndOfStream,
 				      (gpointer)pcm);
 			param->done = 1;
@@ -199,6 +262,8 @@ static int _rec_start(NuguRecorderDriver *driver, NuguRecorder *rec,
 	PaError err = paNoError;
 	struct pa_audio_param *rec_param =
 		(struct pa_audio_param *)nugu_recorder_get_userdata(rec);
+	NuguAudioProperty rec_prop;
+	unsigned long frames_100ms;
 	int rec_5sec;
 	int rec_100ms;
 
@@ -216,9 +281,16 @@ static int _rec_start(NuguRecorderDriver *driver, NuguRecorder *rec,
 	}
 
 	rec_param->data = (void *)rec;
-	rec_100ms = rec_param->samplerate * rec_param->samplebyte / 10;
-	rec_5sec =
-		rec_param->samplerate * rec_param->samplebyte * 5 / rec_100ms;
+
+	/* The ring keeps the frames converted to the recorder property */
+	nugu_recorder_get_property(rec, &rec_prop);
+	frames_100ms = rec_param->samplerate / 10;
+	rec_100ms = nugu_audio_get_bytes_per_sec(rec_prop) / 10;
+	if (rec_100ms <= 0) {
+		g_free(rec_param);
+		return -1;
+	}
+	rec_5sec = 50;
 	nugu_dbg("rec - %d, %d", rec_100ms, rec_5sec);
 	nugu_recorder_set_frame_size(rec, rec_100ms, rec_5sec);
 
@@ -237,7 +309,7 @@ static int _rec_start(NuguRecorderDriver *driver, NuguRecorder *rec,
 
 	err = Pa_OpenStream(&rec_param->stream, &input_param,
 			    NULL, /* &outputParameters, */
-			    rec_param->samplerate, rec_100ms,
+			    rec_param->samplerate, frames_100ms,
 			    paClipOff, /* don't bother clipping them */
 			    _recordCallback, rec_param);
 	if (err != paNoError) {
@@ -287,10 +359,65 @@ static int _rec_stop(NuguRecorderDriver *driver, NuguRecorder *rec)
 	return 0;
 }
 
+static int _open_output_stream(struct pa_audio_param *param,
+			       PaStreamCallback *callback)
+{
+	PaStreamParameters output_param;
+	PaError err = paNoError;
+
+	/* default output device */
+	output_param.device = Pa_GetDefaultOutputDevice();
+	if (output_param.device == paNoDevice) {
+		nugu_error("no default output device");
+		return -1;
+	}
+	output_param.channelCount = param->channel;
+	output_param.sampleFormat = param->format;
+	output_param.suggestedLatency =
+		Pa_GetDeviceInfo(output_param.device)->defaultLowOutputLatency;
+	output_param.hostApiSpecificStreamInfo = NULL;
+
+	err = Pa_OpenStream(&param->stream, NULL, /* no input */
+			    &output_param, param->samplerate, FRAME_PER_BUFFER,
+			    paClipOff, /* don't bother clipping them */
+			    callback, param);
+	if (err != paNoError) {
+		nugu_error("Pa_OpenStream return fail");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void _close_output_stream(struct pa_audio_param *param)
+{
+	param->stop = 1;
+	while (Pa_IsStreamActive(param->stream) == 1)
+		Pa_Sleep(10);
+
+	if (Pa_CloseStream(param->stream) != paNoError)
+		nugu_error("Pa_CloseStream return fail");
+
+	g_free(param);
+}
+
+static int _get_idle_timeout(void)
+{
+	char *value;
+	int timeout = 0;
+
+	value = nugu_config_get(NUGU_CONFIG_KEY_PCM_IDLE_TIMEOUT);
+	if (value) {
+		timeout = atoi(value);
+		free(value);
+	}
+
+	return timeout;
+}
+
 static int _pcm_start(NuguPcmDriver *driver, NuguPcm *pcm,
 		      NuguAudioProperty prop)
 {
-	PaStreamParameters output_param;
 	PaError err = paNoError;
 	struct pa_audio_param *pcm_param =
 		(struct pa_audio_param *)nugu_pcm_get_userdata(pcm);
@@ -312,26 +439,7 @@ static int _pcm_start(NuguPcmDriver *driver, NuguPcm *pcm,
 
 	pcm_param->data = (void *)pcm;
 
-	/* default output device */
-	output_param.device = Pa_GetDefaultOutputDevice();
-	if (output_param.device == paNoDevice) {
-		nugu_error("no default output device");
-		g_free(pcm_param);
-		return -1;
-	}
-	output_param.channelCount = pcm_param->channel;
-	output_param.sampleFormat = pcm_param->format;
-	output_param.suggestedLatency =
-		Pa_GetDeviceInfo(output_param.device)->defaultLowOutputLatency;
-	output_param.hostApiSpecificStreamInfo = NULL;
-
-	err = Pa_OpenStream(&pcm_param->stream, NULL, /* no input */
-			    &output_param, pcm_param->samplerate,
-			    FRAME_PER_BUFFER,
-			    paClipOff, /* don't bother clipping them */
-			    _playbackCallback, pcm_param);
-	if (err != paNoError) {
-		nugu_error("Pa_OpenStream return fail");
+	if (_open_output_stream(pcm_param, _playbackCallback) != 0) {
 		g_free(pcm_param);
 		return -1;
 	}
@@ -357,7 +465,6 @@ static int _pcm_start(NuguPcmDriver *driver, NuguPcm *pcm,
 
 static int _pcm_stop(NuguPcmDriver *driver, NuguPcm *pcm)
 {
-	PaError err = paNoError;
 	struct pa_audio_param *pcm_param =
 		(struct pa_audio_param *)nugu_pcm_get_userdata(pcm);
 
@@ -369,17 +476,10 @@ static int _pcm_stop(NuguPcmDriver *driver, NuguPcm *pcm)
 	}
 
 	pcm_param->pause = 0;
-	pcm_param->stop = 1;
-	while (Pa_IsStreamActive(pcm_param->stream) == 1)
-		Pa_Sleep(10);
-
-	err = Pa_CloseStream(pcm_param->stream);
-	if (err != paNoError)
-		nugu_error("Pa_CloseStream return fail");
+	_close_output_stream(pcm_param);
 
 	nugu_pcm_emit_status(pcm, MEDIA_STATUS_STOPPED);
 
-	free(pcm_param);
 	nugu_pcm_set_userdata(pcm, NULL);
 
 	nugu_dbg("stop done");
@@ -437,6 +537,356 @@ static int _pcm_resume(NuguPcmDriver *driver, NuguPcm *pcm)
 	return 0;
 }
 
+static int _mixerCallback(const void *inputBuffer, void *outputBuffer,
+			  unsigned long framesPerBuffer,
+			  const PaStreamCallbackTimeInfo *timeInfo,
+			  PaStreamCallbackFlags statusFlags, void *userData)
+{
+	struct pa_audio_param *param = (struct pa_audio_param *)userData;
+	NuguMixer *mixer = (NuguMixer *)param->data;
+
+	(void)inputBuffer; /* Prevent unused variable warnings. */
+	(void)statusFlags;
+
+	/* Passed to all inputs read by the next mixing */
+	nugu_mixer_set_device_delay(mixer, _get_device_delay(timeInfo));
+
+	/* Silence is played while there is no input */
+	nugu_mixer_mix(mixer, outputBuffer,
+		       framesPerBuffer * param->samplebyte * param->channel);
+
+	return paContinue;
+}
+
+/* Called by the audio thread */
+static void _mixer_end_callback(NuguMixer *mixer, NuguPcm *pcm,
+				void *userdata)
+{
+	uint64_t value = 1;
+	int i;
+
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		if (g_atomic_pointer_get(&mixer_eos[i].pcm) == pcm) {
+			g_atomic_int_set(&mixer_eos[i].ended, 1);
+			break;
+		}
+	}
+
+	/* send event to the main loop thread */
+	if (write(mixer_efd, &value, sizeof(value)) != sizeof(value))
+		nugu_error("write failed");
+}
+
+static gboolean _mixerEndOfStream(void *userdata)
+{
+	struct mixer_eos *eos = (struct mixer_eos *)userdata;
+
+	eos->timer = 0;
+	nugu_pcm_emit_event((NuguPcm *)eos->pcm, MEDIA_EVENT_END_OF_STREAM);
+
+	return FALSE;
+}
+
+static gboolean _on_mixer_event(GIOChannel *channel, GIOCondition cond,
+				gpointer userdata)
+{
+	uint64_t value = 0;
+	int i;
+
+	if (read(mixer_efd, &value, sizeof(value)) != sizeof(value)) {
+		nugu_error("read failed");
+		return TRUE;
+	}
+
+	/* The pcm is removed from the slot before it is stopped */
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		struct mixer_eos *eos = mixer_eos + i;
+
+		if (!eos->pcm || !g_atomic_int_get(&eos->ended))
+			continue;
+
+		g_atomic_int_set(&eos->ended, 0);
+		if (!eos->timer)
+			eos->timer = g_timeout_add(EOS_GUARD_TIME,
+						   _mixerEndOfStream, eos);
+	}
+
+	return TRUE;
+}
+
+static struct mixer_eos *_mixer_eos_find(NuguPcm *pcm)
+{
+	int i;
+
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		if (mixer_eos[i].pcm == pcm)
+			return mixer_eos + i;
+	}
+
+	return NULL;
+}
+
+/* Removes the pending end of stream event of the pcm */
+static void _mixer_eos_remove(NuguPcm *pcm)
+{
+	struct mixer_eos *eos = _mixer_eos_find(pcm);
+
+	if (!eos)
+		return;
+
+	if (eos->timer) {
+		g_source_remove(eos->timer);
+		eos->timer = 0;
+	}
+
+	g_atomic_pointer_set(&eos->pcm, NULL);
+	g_atomic_int_set(&eos->ended, 0);
+}
+
+/* Assigns a slot before the pcm is added to the mixer */
+static int _mixer_eos_add(NuguPcm *pcm)
+{
+	struct mixer_eos *eos;
+
+	_mixer_eos_remove(pcm);
+
+	eos = _mixer_eos_find(NULL);
+	if (!eos) {
+		nugu_error("no more slot");
+		return -1;
+	}
+
+	g_atomic_pointer_set(&eos->pcm, pcm);
+
+	return 0;
+}
+
+static int _mixer_efd_open(void)
+{
+	GIOChannel *channel;
+
+	mixer_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (mixer_efd < 0) {
+		nugu_error("eventfd() failed");
+		return -1;
+	}
+
+	channel = g_io_channel_unix_new(mixer_efd);
+	mixer_efd_source = g_io_add_watch(channel, G_IO_IN, _on_mixer_event,
+					  NULL);
+	g_io_channel_unref(channel);
+
+	return 0;
+}
+
+/* Must be called after the stream is closed */
+static void _mixer_efd_close(void)
+{
+	if (mixer_efd_source) {
+		g_source_remove(mixer_efd_source);
+		mixer_efd_source = 0;
+	}
+
+	if (mixer_efd != -1) {
+		close(mixer_efd);
+		mixer_efd = -1;
+	}
+}
+
+static void _mixer_close(void)
+{
+	if (mixer_timer) {
+		g_source_remove(mixer_timer);
+		mixer_timer = 0;
+	}
+
+	if (!mixer_param)
+		return;
+
+	if (Pa_CloseStream(mixer_param->stream) != paNoError)
+		nugu_error("Pa_CloseStream return fail");
+
+	nugu_mixer_free((NuguMixer *)mixer_param->data);
+	g_free(mixer_param);
+	mixer_param = NULL;
+
+	_mixer_efd_close();
+}
+
+static int _mixer_open(NuguAudioProperty prop)
+{
+	NuguMixer *mixer;
+
+	mixer = nugu_mixer_new(prop);
+	if (!mixer)
+		return -1;
+
+	nugu_mixer_set_end_callback(mixer, _mixer_end_callback, NULL);
+
+	if (_mixer_efd_open() < 0) {
+		nugu_mixer_free(mixer);
+		return -1;
+	}
+
+	mixer_param = (struct pa_audio_param *)g_malloc0(
+		sizeof(struct pa_audio_param));
+	mixer_param->data = mixer;
+
+	if (_set_property_to_param(mixer_param, prop) != 0 ||
+	    _open_output_stream(mixer_param, _mixerCallback) != 0) {
+		nugu_mixer_free(mixer);
+		g_free(mixer_param);
+		mixer_param = NULL;
+		_mixer_efd_close();
+		return -1;
+	}
+
+	if (Pa_StartStream(mixer_param->stream) != paNoError) {
+		nugu_error("Pa_StartStream return fail");
+		_mixer_close();
+		return -1;
+	}
+
+	nugu_dbg("mixer stream opened");
+
+	return 0;
+}
+
+static gboolean _mixer_timeout(void *userdata)
+{
+	mixer_timer = 0;
+	_mixer_close();
+
+	nugu_dbg("mixer stream closed by the idle timeout");
+
+	return FALSE;
+}
+
+static int _mixer_pcm_start(NuguPcmDriver *driver, NuguPcm *pcm,
+			    NuguAudioProperty prop)
+{
+	NuguAudioProperty mixer_prop;
+
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	if (mixer_timer) {
+		g_source_remove(mixer_timer);
+		mixer_timer = 0;
+	}
+
+	if (mixer_param) {
+		NuguMixer *mixer = (NuguMixer *)mixer_param->data;
+
+		nugu_mixer_get_property(mixer, &mixer_prop);
+
+		/* Reopen the stream only if no other pcm is playing */
+		if (memcmp(&mixer_prop, &prop, sizeof(NuguAudioProperty)) &&
+		    nugu_mixer_get_input_count(mixer) == 0)
+			_mixer_close();
+	}
+
+	if (!mixer_param && _mixer_open(prop) != 0)
+		return -1;
+
+	if (_mixer_eos_add(pcm) != 0)
+		return -1;
+
+	/* It fails if the property is not same with the other inputs */
+	if (nugu_mixer_add_input((NuguMixer *)mixer_param->data, pcm) != 0) {
+		_mixer_eos_remove(pcm);
+		return -1;
+	}
+
+	nugu_pcm_set_userdata(pcm, mixer_param);
+
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_READY);
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_PLAYING);
+
+	nugu_dbg("start done");
+	return 0;
+}
+
+static int _mixer_pcm_stop(NuguPcmDriver *driver, NuguPcm *pcm)
+{
+	NuguMixer *mixer;
+	int timeout;
+
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	if (nugu_pcm_get_userdata(pcm) == NULL) {
+		nugu_dbg("already stop");
+		return 0;
+	}
+
+	mixer = (NuguMixer *)mixer_param->data;
+	nugu_mixer_remove_input(mixer, pcm);
+
+	/* The audio thread does not refer to the pcm anymore */
+	_mixer_eos_remove(pcm);
+
+	/* Keep the stream playing silence for the next pcm until the timeout */
+	if (nugu_mixer_get_input_count(mixer) == 0) {
+		timeout = _get_idle_timeout();
+		if (timeout <= 0)
+			_mixer_close();
+		else if (!mixer_timer)
+			mixer_timer = g_timeout_add(timeout, _mixer_timeout,
+						    NULL);
+	}
+
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_STOPPED);
+
+	nugu_pcm_set_userdata(pcm, NULL);
+
+	nugu_dbg("stop done");
+
+	return 0;
+}
+
+static int _mixer_pcm_pause(NuguPcmDriver *driver, NuguPcm *pcm)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	if (nugu_pcm_get_userdata(pcm) == NULL) {
+		nugu_dbg("pcm is already stopped");
+		return 0;
+	}
+
+	if (nugu_pcm_get_status(pcm) == MEDIA_STATUS_PAUSED) {
+		nugu_dbg("pcm is already paused");
+		return 0;
+	}
+
+	nugu_mixer_set_input_paused((NuguMixer *)mixer_param->data, pcm, 1);
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_PAUSED);
+
+	nugu_dbg("pause done");
+
+	return 0;
+}
+
+static int _mixer_pcm_resume(NuguPcmDriver *driver, NuguPcm *pcm)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	if (nugu_pcm_get_userdata(pcm) == NULL) {
+		nugu_dbg("pcm is already stopped");
+		return 0;
+	}
+
+	if (nugu_pcm_get_status(pcm) != MEDIA_STATUS_PAUSED) {
+		nugu_dbg("pcm is not paused");
+		return 0;
+	}
+
+	nugu_mixer_set_input_paused((NuguMixer *)mixer_param->data, pcm, 0);
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_PLAYING);
+
+	nugu_dbg("resume done");
+
+	return 0;
+}
+
 static void snd_error_log(const char *file, int line, const char *function,
 			  int err, const char *fmt, ...)
 {
@@ -465,6 +915,11 @@ static struct nugu_pcm_driver_ops pcm_ops = { .start = _pcm_start,
 					      .pause = _pcm_pause,
 					      .resume = _pcm_resume };
 
+static struct nugu_pcm_driver_ops mixer_ops = { .start = _mixer_pcm_start,
+						.stop = _mixer_pcm_stop,
+						.pause = _mixer_pcm_pause,
+						.resume = _mixer_pcm_resume };
+
 static int init(NuguPlugin *p)
 {
 	nugu_dbg("'%s' plugin initialized",
@@ -493,6 +948,19 @@ static int init(NuguPlugin *p)
 		return -1;
 	}
 
+	/*
+	 * Use the mixer by default, so that the pcms share one output stream
+	 * and a ducked pcm keeps playing under the others.
+	 */
+	mixer_driver = nugu_pcm_driver_new(MIXER_DRIVER_NAME, &mixer_ops);
+	if (mixer_driver && nugu_pcm_driver_register(mixer_driver) != 0) {
+		nugu_pcm_driver_free(mixer_driver);
+		mixer_driver = NULL;
+	}
+
+	if (mixer_driver)
+		nugu_pcm_driver_set_default(mixer_driver);
+
 	nugu_dbg("'%s' plugin initialized done",
 		 nugu_plugin_get_description(p)->name);
 	return 0;
@@ -508,8 +976,17 @@ static int load(void)
 
 static void unload(NuguPlugin *p)
 {
+	int i;
+
 	nugu_dbg("'%s' plugin unloaded", nugu_plugin_get_description(p)->name);
 
+	_mixer_close();
+
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		if (mixer_eos[i].pcm)
+			_mixer_eos_remove((NuguPcm *)mixer_eos[i].pcm);
+	}
+
 	Pa_Terminate();
 
 	if (rec_driver) {
@@ -522,6 +999,11 @@ static void unload(NuguPlugin *p)
 		nugu_pcm_driver_free(pcm_driver);
 		pcm_driver = NULL;
 	}
+	if (mixer_driver) {
+		nugu_pcm_driver_remove(mixer_driver);
+		nugu_pcm_driver_free(mixer_driver);
+		mixer_driver = NULL;
+	}
 
 	snd_lib_error_set_handler(NULL);
 
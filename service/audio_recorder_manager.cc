@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "audio_recorder_manager.hh"
+#include "nugu_log.h"
+
+namespace NuguCore {
+AudioRecorderManager* AudioRecorderManager::instance = NULL;
+
+AudioRecorderManager::~AudioRecorderManager()
+{
+    if (reader_count)
+        nugu_error("%d readers are not destroyed", reader_count);
+
+    if (rec)
+        nugu_recorder_free(rec);
+}
+
+AudioRecorderManager* AudioRecorderManager::getInstance()
+{
+    if (!instance) {
+        instance = new AudioRecorderManager();
+    }
+    return instance;
+}
+
+void AudioRecorderManager::destroyInstance()
+{
+    if (instance) {
+        delete instance;
+        instance = NULL;
+    }
+}
+
+NuguRecorderReader* AudioRecorderManager::createReader(void)
+{
+    NuguRecorderReader* reader;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!rec) {
+        NuguRecorderDriver* driver = nugu_recorder_driver_get_default();
+
+        if (!driver) {
+            nugu_error("there is no recorder driver");
+            return nullptr;
+        }
+
+        rec = nugu_recorder_new("rec_mic", driver);
+        if (!rec)
+            return nullptr;
+
+        nugu_recorder_set_property(rec, (NuguAudioProperty) { AUDIO_SAMPLE_RATE_16K, AUDIO_FORMAT_S16_LE, 1 });
+    }
+
+    reader = nugu_recorder_reader_new(rec);
+    if (!reader) {
+        if (reader_count == 0) {
+            nugu_recorder_free(rec);
+            rec = nullptr;
+        }
+        return nullptr;
+    }
+
+    reader_count++;
+
+    return reader;
+}
+
+void AudioRecorderManager::destroyReader(NuguRecorderReader* reader)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!reader)
+        return;
+
+    nugu_recorder_reader_free(reader);
+
+    if (--reader_count > 0)
+        return;
+
+    nugu_recorder_free(rec);
+    rec = nullptr;
+}
+
+} // NuguCore
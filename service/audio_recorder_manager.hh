@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NUGU_AUDIO_RECORDER_MANAGER_H__
+#define __NUGU_AUDIO_RECORDER_MANAGER_H__
+
+#include <mutex>
+
+#include <core/nugu_recorder.h>
+
+namespace NuguCore {
+
+/*
+ * Owns the single microphone recorder and hands out readers of it, so that
+ * the wakeup detector and the speech recognizer share one capture stream.
+ * The recorder is created with the first reader and freed with the last.
+ */
+class AudioRecorderManager {
+private:
+    AudioRecorderManager() = default;
+    virtual ~AudioRecorderManager();
+
+public:
+    static AudioRecorderManager* getInstance();
+    static void destroyInstance();
+
+    NuguRecorderReader* createReader(void);
+    void destroyReader(NuguRecorderReader* reader);
+
+private:
+    static AudioRecorderManager* instance;
+    std::mutex mutex;
+    NuguRecorder* rec = nullptr;
+    int reader_count = 0;
+};
+
+} // NuguCore
+
+#endif /* __NUGU_AUDIO_RECORDER_MANAGER_H__ */
@@ -157,10 +157,7 @@ ASRAgent::~ASRAgent()
         timer = nullptr;
     }
 
-    if (rec_event) {
-        nugu_event_free(rec_event);
-        rec_event = nullptr;
-    }
+    closeRecognizeEvent();
 
     delete asr_focus_listener;
     delete expect_focus_listener;
@@ -333,7 +330,7 @@ void ASRAgent::sendEventRecognize(unsigned char* data,
 
     nugu_event_set_context(rec_event, all_context_info.c_str());
 
-    root["codec"] = "SPEEX";
+    root["codec"] = speech_recognizer->getCodec();
     root["property"] = "NORMAL";
     root["language"] = "KOR";
     root["endpointing"] = epd_type;
@@ -525,8 +522,7 @@ void ASRAgent::onListeningState(ListeningState state)
 
         clearResponseTimeout();
 
-        if (rec_event)
-            nugu_event_free(rec_event);
+        closeRecognizeEvent();
 
         rec_event = nugu_event_new(getName().c_str(), "Recognize", getVersion().c_str());
 
@@ -570,6 +566,7 @@ void ASRAgent::onListeningState(ListeningState state)
         nugu_info("time out");
 
         stopRecognition();
+        closeRecognizeEvent();
         sendEventListenTimeout();
         releaseASRSpeakFocus(false, ASRError::LISTEN_TIMEOUT);
 
@@ -578,16 +575,14 @@ void ASRAgent::onListeningState(ListeningState state)
         nugu_dbg("ListeningState::FAILED");
 
         stopRecognition();
+        closeRecognizeEvent();
         releaseASRSpeakFocus(false, ASRError::LISTEN_FAILED);
 
         break;
     case ListeningState::DONE:
         nugu_dbg("ListeningState::DONE");
 
-        if (rec_event) {
-            nugu_event_free(rec_event);
-            rec_event = NULL;
-        }
+        closeRecognizeEvent();
 
         // it consider cancel by user
         if (prev_listening_state == ListeningState::READY
@@ -603,6 +598,17 @@ void ASRAgent::onListeningState(ListeningState state)
     prev_listening_state = state;
 }
 
+void ASRAgent::closeRecognizeEvent()
+{
+    if (!rec_event)
+        return;
+
+    // the attachment is not sent anymore if the speech end is not detected
+    nugu_network_manager_close_event_data(rec_event);
+    nugu_event_free(rec_event);
+    rec_event = nullptr;
+}
+
 void ASRAgent::releaseASRSpeakFocus(bool is_cancel, ASRError error)
 {
     for (auto asr_listener : asr_listeners) {
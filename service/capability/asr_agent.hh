@@ -92,6 +92,7 @@ private:
     void parsingStopCapture(const char* message);
 
     void releaseASRSpeakFocus(bool is_cancel, ASRError error);
+    void closeRecognizeEvent();
 
     ExpectSpeechAttr es_attr;
     NuguEvent* rec_event;
@@ -18,8 +18,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <interface/nugu_configuration.hh>
+
 #include "audio_player_agent.hh"
 #include "media_player.hh"
+#include "nugu_config.h"
 #include "nugu_log.h"
 
 namespace NuguCore {
@@ -36,6 +39,9 @@ AudioPlayerAgent::AudioPlayerAgent()
     , report_interval_time(-1)
     , cur_token("")
     , is_finished(false)
+    , duck_level(0)
+    , duck_volume(-1)
+    , is_ducking(false)
 {
 }
 
@@ -55,6 +61,13 @@ void AudioPlayerAgent::initialize()
     player = dynamic_cast<IMediaPlayer*>(new MediaPlayer());
     player->addListener(this);
 
+    // lower the volume instead of pausing while the TTS or alert is playing
+    char* tmp = nugu_config_get(NuguConfig::Key::FOCUS_DUCK_LEVEL.c_str());
+    if (tmp) {
+        duck_level = atoi(tmp);
+        free(tmp);
+    }
+
     CapabilityManager::getInstance()->addFocus("cap_audio", NUGU_FOCUS_TYPE_MEDIA, this);
 
     initialized = true;
@@ -62,6 +75,14 @@ void AudioPlayerAgent::initialize()
 
 NuguFocusResult AudioPlayerAgent::onFocus(NuguFocusResource rsrc, void* event)
 {
+    bool ducked = duck_volume >= 0;
+
+    restoreVolume();
+
+    // the ducked media is still playing
+    if (ducked && player->state() == MediaPlayerState::PLAYING)
+        return NUGU_FOCUS_OK;
+
     if (is_paused)
         return NUGU_FOCUS_OK;
 
@@ -77,12 +98,24 @@ NuguFocusResult AudioPlayerAgent::onFocus(NuguFocusResource rsrc, void* event)
 
 NuguFocusResult AudioPlayerAgent::onUnfocus(NuguFocusResource rsrc, void* event)
 {
+    bool ducking = is_ducking;
+
+    is_ducking = false;
+
     if (is_finished)
         return NUGU_FOCUS_REMOVE;
 
     if (player->state() == MediaPlayerState::STOPPED || player->state() == MediaPlayerState::PAUSED)
         return NUGU_FOCUS_REMOVE;
 
+    if (ducking && player->state() == MediaPlayerState::PLAYING) {
+        if (duck_volume < 0)
+            duck_volume = player->volume();
+
+        player->setVolume(duck_volume * duck_level / NUGU_SET_VOLUME_MAX);
+        return NUGU_FOCUS_PAUSE;
+    }
+
     if (!player->pause()) {
         nugu_error("pause media failed");
         sendEventPlaybackError(AudioPlayerAgent::MEDIA_ERROR_INTERNAL_DEVICE_ERROR,
@@ -95,9 +128,21 @@ NuguFocusResult AudioPlayerAgent::onUnfocus(NuguFocusResource rsrc, void* event)
 
 NuguFocusStealResult AudioPlayerAgent::onStealRequest(NuguFocusResource rsrc, void* event, NuguFocusType target_type)
 {
+    is_ducking = duck_level > 0
+        && (target_type == NUGU_FOCUS_TYPE_TTS || target_type == NUGU_FOCUS_TYPE_ALERT);
+
     return NUGU_FOCUS_STEAL_ALLOW;
 }
 
+void AudioPlayerAgent::restoreVolume()
+{
+    if (duck_volume < 0)
+        return;
+
+    player->setVolume(duck_volume);
+    duck_volume = -1;
+}
+
 void AudioPlayerAgent::play()
 {
     sendEventByDisplayInterface("PlayCommandIssued");
@@ -436,6 +481,9 @@ void AudioPlayerAgent::parsingPlay(const char* message)
         return;
     }
 
+    // the previous media may have released the focus while it was ducked
+    restoreVolume();
+
     CapabilityManager::getInstance()->requestFocus("cap_audio", NUGU_FOCUS_RESOURCE_SPK, NULL);
 }
 
@@ -103,6 +103,7 @@ private:
 
     std::string playbackError(PlaybackError error);
     std::string playerActivity(AudioPlayerState state);
+    void restoreVolume();
 
     NuguFocusResult onFocus(NuguFocusResource rsrc, void* event) override;
     NuguFocusResult onUnfocus(NuguFocusResource rsrc, void* event) override;
@@ -117,6 +118,9 @@ private:
     long report_interval_time;
     std::string cur_token;
     bool is_finished;
+    int duck_level;
+    int duck_volume;
+    bool is_ducking;
     std::vector<IAudioPlayerListener*> aplayer_listeners;
 };
 
@@ -18,6 +18,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <interface/nugu_configuration.hh>
+
+#include "nugu_config.h"
 #include "nugu_log.h"
 #include "nugu_uuid.h"
 #include "tts_agent.hh"
@@ -34,6 +37,8 @@ TTSAgent::TTSAgent()
     , speak_dir(nullptr)
     , pcm(nullptr)
     , decoder(nullptr)
+    , duck_level(0)
+    , is_ducking(false)
     , ps_id("")
     , tts_listener(nullptr)
 {
@@ -47,10 +52,7 @@ TTSAgent::~TTSAgent()
         speak_dir = NULL;
     }
 
-    if (decoder) {
-        nugu_decoder_free(decoder);
-        decoder = NULL;
-    }
+    releaseDecoder();
 
     if (pcm) {
         nugu_pcm_stop(pcm);
@@ -78,12 +80,40 @@ void TTSAgent::initialize()
         nugu_pcm_free(pcm);
         return;
     }
-    decoder = nugu_decoder_new(nugu_decoder_driver_find("opus"), pcm);
 
     nugu_pcm_set_status_callback(pcm, pcmStatusCallback, this);
     nugu_pcm_set_event_callback(pcm, pcmEventCallback, this);
 
-    nugu_pcm_set_property(pcm, (NuguAudioProperty){ AUDIO_SAMPLE_RATE_22K, AUDIO_FORMAT_S16_LE, 1 });
+    NuguAudioProperty property = { AUDIO_SAMPLE_RATE_22K, AUDIO_FORMAT_S16_LE, 1 };
+    nugu_pcm_set_property(pcm, property);
+
+    // resample the TTS in libnugu if the device runs at another rate
+    char* tmp = nugu_config_get(NuguConfig::Key::TTS_DEVICE_SAMPLERATE.c_str());
+    int device_rate = tmp ? atoi(tmp) : 0;
+    free(tmp);
+
+    for (int i = 0; device_rate > 0 && i < AUDIO_SAMPLE_RATE_MAX; i++) {
+        if (nugu_audio_get_rate((enum nugu_audio_sample_rate)i) != device_rate)
+            continue;
+
+        property.samplerate = (enum nugu_audio_sample_rate)i;
+        nugu_pcm_set_device_property(pcm, property);
+        break;
+    }
+
+    // wait for the network to buffer the TTS before the playback starts
+    tmp = nugu_config_get(NuguConfig::Key::TTS_PREBUFFER_TIME.c_str());
+    if (tmp) {
+        nugu_pcm_set_prebuffer_time(pcm, atoi(tmp));
+        free(tmp);
+    }
+
+    // lower the volume instead of stopping when the alert takes the speaker
+    tmp = nugu_config_get(NuguConfig::Key::FOCUS_DUCK_LEVEL.c_str());
+    if (tmp) {
+        duck_level = atoi(tmp);
+        free(tmp);
+    }
 
     CapabilityManager::getInstance()->addFocus("cap_tts", NUGU_FOCUS_TYPE_TTS, this);
 
@@ -118,6 +148,7 @@ void TTSAgent::pcmEventCallback(enum nugu_media_event event, void* userdata)
     switch (event) {
     case MEDIA_EVENT_END_OF_STREAM:
         tts->sendEventSpeechFinished(tts->cur_token);
+        tts->releaseDecoder();
         tts->finish = true;
         tts->speak_status = MEDIA_STATUS_STOPPED;
         CapabilityManager::getInstance()->releaseFocus("cap_tts", NUGU_FOCUS_RESOURCE_SPK);
@@ -135,24 +166,28 @@ void TTSAgent::directiveDataCallback(NuguDirective* ndir, void* userdata)
 void TTSAgent::getAttachmentData(NuguDirective* ndir, void* userdata)
 {
     TTSAgent* tts = static_cast<TTSAgent*>(userdata);
-    unsigned char* buf;
-    size_t length = 0;
+    NuguChunkChain* chunks;
 
-    buf = nugu_directive_get_data(ndir, &length);
-    if (buf) {
-        unsigned char* dbuf;
-        size_t size;
+    chunks = nugu_directive_get_chunks(ndir);
+    if (chunks) {
+        int count = nugu_chunk_chain_get_count(chunks);
 
-        dbuf = (unsigned char*)nugu_decoder_decode(tts->decoder, (const void*)buf, length, &size);
+        /* Each segment holds a whole attachment, so queue it to the worker */
+        for (int i = 0; i < count; i++) {
+            const void* buf;
+            size_t length = 0;
 
-        nugu_pcm_push_data(tts->pcm, (const char*)dbuf, size, 0);
+            buf = nugu_chunk_chain_peek(chunks, i, &length);
+            if (buf && length > 0 && tts->decoder)
+                nugu_decoder_push(tts->decoder, buf, length);
+        }
 
-        free(dbuf);
-        free(buf);
+        nugu_chunk_chain_free(chunks);
     }
 
     if (nugu_directive_is_data_end(ndir)) {
-        nugu_pcm_push_data_done(tts->pcm);
+        if (tts->decoder)
+            nugu_decoder_push_done(tts->decoder);
         tts->destoryDirective(ndir);
         tts->speak_dir = NULL;
     }
@@ -162,6 +197,8 @@ NuguFocusResult TTSAgent::onFocus(NuguFocusResource rsrc, void* event)
 {
     nugu_info("speak_status: %d", speak_status);
 
+    nugu_pcm_set_duck_level(pcm, NUGU_SET_VOLUME_MAX);
+
     switch (speak_status) {
     case -1:
     case MEDIA_STATUS_STOPPED:
@@ -180,6 +217,16 @@ NuguFocusResult TTSAgent::onFocus(NuguFocusResource rsrc, void* event)
 
 NuguFocusResult TTSAgent::onUnfocus(NuguFocusResource rsrc, void* event)
 {
+    if (is_ducking) {
+        is_ducking = false;
+
+        if (speak_status == MEDIA_STATUS_PLAYING) {
+            nugu_pcm_set_duck_level(pcm, duck_level);
+            return NUGU_FOCUS_PAUSE;
+        }
+    }
+
+    releaseDecoder();
     nugu_pcm_stop(pcm);
 
     playsync_manager->removeContext(ps_id, getType(), !finish);
@@ -191,8 +238,13 @@ NuguFocusStealResult TTSAgent::onStealRequest(NuguFocusResource rsrc, void* even
 {
     if (target_type == NUGU_FOCUS_TYPE_ASR)
         return NUGU_FOCUS_STEAL_ALLOW;
-    else
-        return NUGU_FOCUS_STEAL_REJECT;
+
+    if (target_type == NUGU_FOCUS_TYPE_ALERT && duck_level > 0) {
+        is_ducking = true;
+        return NUGU_FOCUS_STEAL_ALLOW;
+    }
+
+    return NUGU_FOCUS_STEAL_REJECT;
 }
 
 void TTSAgent::stopTTS()
@@ -202,6 +254,7 @@ void TTSAgent::stopTTS()
         destoryDirective(speak_dir);
         speak_dir = NULL;
     }
+    releaseDecoder();
     if (pcm) {
         nugu_pcm_stop(pcm);
     }
@@ -211,15 +264,50 @@ void TTSAgent::startTTS(NuguDirective* ndir)
 {
     finish = false;
 
+    // the worker must not push the previous data while the pcm is started
+    releaseDecoder();
     if (pcm)
         nugu_pcm_start(pcm);
 
+    takeDecoder();
+
     if (ndir) {
         speak_dir = ndir;
         nugu_directive_set_data_callback(speak_dir, directiveDataCallback, this);
     }
 }
 
+void TTSAgent::takeDecoder()
+{
+    NuguDecoderDriver* driver = nugu_decoder_driver_find("opus");
+
+    if (decoder || !pcm || !driver)
+        return;
+
+    // reuse an idle decoder of the same rate instead of a new codec state
+    decoder = nugu_decoder_pool_get(driver, pcm);
+    if (!decoder) {
+        nugu_error("can't get the decoder");
+        return;
+    }
+
+    // decode the attachments in the worker, not in the main loop
+    if (nugu_decoder_start(decoder) < 0)
+        nugu_error("can't start the decoder worker");
+}
+
+void TTSAgent::releaseDecoder()
+{
+    if (!decoder)
+        return;
+
+    // the queued data is discarded, and the decoder is reset for the next
+    if (nugu_decoder_pool_put(decoder) < 0)
+        nugu_error("the decoder is destroyed instead of the reuse");
+
+    decoder = nullptr;
+}
+
 void TTSAgent::requestTTS(std::string text, std::string play_service_id)
 {
     std::string token;
@@ -70,6 +70,8 @@ private:
     void parsingStop(const char* message);
 
     void startTTS(NuguDirective* ndir);
+    void takeDecoder();
+    void releaseDecoder();
     NuguFocusResult onFocus(NuguFocusResource rsrc, void* event);
     NuguFocusResult onUnfocus(NuguFocusResource rsrc, void* event);
     NuguFocusStealResult onStealRequest(NuguFocusResource rsrc, void* event, NuguFocusType target_type);
@@ -77,6 +79,8 @@ private:
     NuguDirective* speak_dir;
     NuguPcm* pcm;
     NuguDecoder* decoder;
+    int duck_level;
+    bool is_ducking;
 
     std::string ps_id;
     ITTSListener* tts_listener;
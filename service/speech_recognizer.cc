@@ -14,12 +14,13 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 
 #include "endpoint_detector.h"
 #include "interface/nugu_configuration.hh"
 
+#include "audio_recorder_manager.hh"
 #include "nugu_config.h"
 #include "nugu_log.h"
 #include "speech_recognizer.hh"
@@ -50,16 +51,22 @@ static gboolean invoke_sync_event(gpointer userdata)
 
 SpeechRecognizer::SpeechRecognizer()
 {
-    NuguRecorderDriver* driver = nugu_recorder_driver_get_default();
+    char* preroll;
     int ret;
 
-    if (!driver) {
-        nugu_error("there is no recorder driver");
+    rec_asr = AudioRecorderManager::getInstance()->createReader();
+    if (!rec_asr) {
+        nugu_error("can't create the recorder reader");
         return;
     }
 
-    rec_asr = nugu_recorder_new("rec_asr", driver);
-    nugu_recorder_set_property(rec_asr, (NuguAudioProperty) { AUDIO_SAMPLE_RATE_16K, AUDIO_FORMAT_S16_LE, 1 });
+    preroll = nugu_config_get(NuguConfig::Key::ASR_PREROLL.c_str());
+    if (preroll) {
+        nugu_recorder_reader_set_preroll(rec_asr, atoi(preroll));
+        free(preroll);
+    }
+
+    createEncoder();
 
     asr_destroy = 0;
     asr_thread = std::thread([this] { this->loopListening(); });
@@ -80,7 +87,70 @@ SpeechRecognizer::~SpeechRecognizer()
     if (asr_thread.joinable())
         asr_thread.join();
 
-    nugu_recorder_free(rec_asr);
+    AudioRecorderManager::getInstance()->destroyReader(rec_asr);
+
+    if (encoder)
+        nugu_encoder_free(encoder);
+}
+
+void SpeechRecognizer::createEncoder(void)
+{
+    NuguEncoderDriver* driver;
+    NuguEncoderOption option;
+    char* value;
+    char* bitrate;
+    char* name;
+
+    value = nugu_config_get(NuguConfig::Key::ASR_CODEC.c_str());
+    if (!value)
+        return;
+
+    if (g_ascii_strcasecmp(value, "SPEEX") == 0) {
+        free(value);
+        return;
+    }
+
+    /* The SPEEX is encoded by the EPD, others by the encoder driver */
+    name = g_ascii_strdown(value, -1);
+    driver = nugu_encoder_driver_find(name);
+    g_free(name);
+
+    if (!driver) {
+        nugu_error("can't find the '%s' encoder driver, use SPEEX", value);
+        free(value);
+        return;
+    }
+
+    option.bitrate = 0;
+    option.complexity = -1;
+    option.frame_time = NUGU_ENCODER_DEFAULT_FRAME_TIME;
+
+    bitrate = nugu_config_get(NuguConfig::Key::ASR_CODEC_BITRATE.c_str());
+    if (bitrate) {
+        option.bitrate = atoi(bitrate);
+        free(bitrate);
+    }
+
+    encoder = nugu_encoder_new(driver, (NuguAudioProperty) { AUDIO_SAMPLE_RATE_16K, AUDIO_FORMAT_S16_LE, 1 }, &option);
+    if (!encoder) {
+        nugu_error("can't create the '%s' encoder, use SPEEX", value);
+        free(value);
+        return;
+    }
+
+    /* The EPD output starts with the audio before the start of the speech */
+    if (nugu_encoder_set_lookback(encoder, ENCODER_LOOKBACK_MSEC) < 0)
+        nugu_error("nugu_encoder_set_lookback() failed");
+
+    name = g_ascii_strup(value, -1);
+    codec = name;
+    g_free(name);
+    free(value);
+}
+
+std::string SpeechRecognizer::getCodec(void)
+{
+    return codec;
 }
 
 void SpeechRecognizer::sendSyncListeningEvent(ListeningState state)
@@ -110,11 +180,13 @@ void SpeechRecognizer::setListener(ISpeechRecognizerListener* listener)
 void SpeechRecognizer::loopListening(void)
 {
     unsigned char epd_buf[OUT_DATA_SIZE];
+    NuguBuffer* enc_buf = NULL;
     EpdParam epd_param;
     int pcm_size;
     int length;
     int prev_epd_ret = 0;
     bool is_epd_end = false;
+    bool is_encoding = false;
     char* model_file = NULL;
     char* model_path;
 
@@ -135,6 +207,9 @@ void SpeechRecognizer::loopListening(void)
         free(model_path);
     }
 
+    if (encoder)
+        enc_buf = nugu_buffer_new(0);
+
     while (g_atomic_int_get(&asr_destroy) == 0) {
         std::unique_lock<std::mutex> lock(asr_mutex);
         asr_cond.wait(lock);
@@ -150,34 +225,45 @@ void SpeechRecognizer::loopListening(void)
             break;
         };
 
-        if (nugu_recorder_start(rec_asr) < 0) {
-            nugu_error("nugu_recorder_start() failed.");
+        if (nugu_recorder_reader_start(rec_asr) < 0) {
+            nugu_error("nugu_recorder_reader_start() failed.");
             break;
         }
 
-        nugu_recorder_get_frame_size(rec_asr, &pcm_size, &length);
-
         sendSyncListeningEvent(ListeningState::LISTENING);
 
         prev_epd_ret = 0;
         is_epd_end = false;
+        is_encoding = false;
+
+        if (encoder)
+            nugu_encoder_reset(encoder);
 
         while (asr_is_running) {
-            char pcm_buf[pcm_size];
+            const char* pcm_buf;
 
-            if (nugu_recorder_is_recording(rec_asr) == 0) {
+            if (nugu_recorder_reader_is_recording(rec_asr) == 0) {
                 nugu_dbg("Listening Thread: not recording state");
-                usleep(10 * 1000);
+
+                /* Sleep until startRecorder() or stopListening() */
+                std::unique_lock<std::mutex> lock(asr_mutex);
+                asr_cond.wait(lock, [this] {
+                    return !asr_is_running || nugu_recorder_reader_is_recording(rec_asr) == 1;
+                });
                 continue;
             }
 
-            if (nugu_recorder_get_frame_timeout(rec_asr, pcm_buf, &pcm_size, 0) < 0) {
-                nugu_error("nugu_recorder_get_frame_timeout() failed");
+            if (nugu_recorder_reader_peek_frame_timeout(rec_asr, &pcm_buf, &pcm_size, 0) < 0) {
+                nugu_error("nugu_recorder_reader_peek_frame_timeout() failed");
                 sendSyncListeningEvent(ListeningState::FAILED);
                 break;
             }
 
             if (pcm_size == 0) {
+                /* Woken up by stopRecorder() */
+                if (nugu_recorder_reader_is_recording(rec_asr) == 0)
+                    continue;
+
                 nugu_error("pcm_size result is 0");
                 sendSyncListeningEvent(ListeningState::FAILED);
                 break;
@@ -186,13 +272,38 @@ void SpeechRecognizer::loopListening(void)
             length = OUT_DATA_SIZE;
             epd_ret = epd_client_run((char*)epd_buf, &length, (short*)pcm_buf, pcm_size);
 
+            /*
+             * Send the frames encoded by the encoder instead of the EPD output.
+             * The frames are held until the first output of the EPD, and then
+             * all frames are encoded with the held frames of the lookback.
+             */
+            if (encoder) {
+                if (length > 0)
+                    is_encoding = true;
+
+                if (is_encoding) {
+                    if (nugu_encoder_encode(encoder, pcm_buf, pcm_size, enc_buf) < 0)
+                        nugu_error("nugu_encoder_encode() failed");
+                } else if (nugu_encoder_hold(encoder, pcm_buf, pcm_size) < 0) {
+                    nugu_error("nugu_encoder_hold() failed");
+                }
+            }
+
+            if (nugu_recorder_reader_release_frame(rec_asr) < 0)
+                nugu_warn("the frame was overwritten during the EPD");
+
             if (epd_ret < 0 || epd_ret > EPD_END_CHECK) {
                 nugu_error("epd_client_run() failed: %d", epd_ret);
                 sendSyncListeningEvent(ListeningState::FAILED);
                 break;
             }
 
-            if (length > 0) {
+            if (enc_buf) {
+                if (nugu_buffer_get_size(enc_buf) > 0 && listener)
+                    listener->onRecordData((unsigned char*)nugu_buffer_peek(enc_buf), nugu_buffer_get_size(enc_buf));
+
+                nugu_buffer_clear(enc_buf);
+            } else if (length > 0) {
                 /* Invoke the onRecordData callback in thread context */
                 if (listener)
                     listener->onRecordData((unsigned char*)epd_buf, length);
@@ -226,7 +337,7 @@ void SpeechRecognizer::loopListening(void)
             prev_epd_ret = epd_ret;
         }
 
-        nugu_recorder_stop(rec_asr);
+        nugu_recorder_reader_stop(rec_asr);
         epd_client_release();
 
         if (g_atomic_int_get(&asr_destroy) == 0)
@@ -236,6 +347,9 @@ void SpeechRecognizer::loopListening(void)
     if (model_file)
         g_free(model_file);
 
+    if (enc_buf)
+        nugu_buffer_free(enc_buf, 1);
+
     nugu_dbg("Listening Thread: exited");
 }
 
@@ -252,6 +366,14 @@ void SpeechRecognizer::startListening(void)
     asr_is_running = true;
     epd_ret = 0;
 
+    /*
+     * Start reading in the caller context. If the wakeup detector is still
+     * holding the recording stream, the stream is kept without a gap and
+     * the pre-roll frames are replayed to the EPD.
+     */
+    if (rec_asr && nugu_recorder_reader_start(rec_asr) < 0)
+        nugu_error("nugu_recorder_reader_start() failed.");
+
     asr_mutex.lock();
     asr_cond.notify_all();
     asr_mutex.unlock();
@@ -264,19 +386,27 @@ void SpeechRecognizer::stopListening(void)
         return;
     }
 
+    asr_mutex.lock();
     asr_is_running = false;
+    asr_cond.notify_all();
+    asr_mutex.unlock();
 }
 
 void SpeechRecognizer::startRecorder(void)
 {
-    if (asr_is_running && nugu_recorder_is_recording(rec_asr) == 1)
-        nugu_recorder_start(rec_asr);
+    if (asr_is_running && nugu_recorder_reader_is_recording(rec_asr) == 0) {
+        nugu_recorder_reader_start(rec_asr);
+
+        asr_mutex.lock();
+        asr_cond.notify_all();
+        asr_mutex.unlock();
+    }
 }
 
 void SpeechRecognizer::stopRecorder(void)
 {
-    if (asr_is_running && nugu_recorder_is_recording(rec_asr) == 1)
-        nugu_recorder_stop(rec_asr);
+    if (asr_is_running && nugu_recorder_reader_is_recording(rec_asr) == 1)
+        nugu_recorder_reader_stop(rec_asr);
 }
 
 } // NuguCore
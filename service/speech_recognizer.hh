@@ -22,6 +22,7 @@
 #include <mutex>
 #include <thread>
 
+#include <core/nugu_encoder.h>
 #include <core/nugu_recorder.h>
 
 #define EPD_MODEL_FILE "nugu_model_epd.raw"
@@ -59,12 +60,15 @@ public:
     void stopListening(void);
     void startRecorder(void);
     void stopRecorder(void);
+    std::string getCodec(void);
 
 private:
     void loopListening(void);
+    void createEncoder(void);
     void sendSyncListeningEvent(ListeningState state);
 
     const unsigned int OUT_DATA_SIZE = 1024 * 9;
+    const int ENCODER_LOOKBACK_MSEC = 500;
     int epd_ret = -1;
     ISpeechRecognizerListener* listener = nullptr;
 
@@ -73,7 +77,9 @@ private:
     std::mutex asr_mutex;
     gint asr_destroy;
     bool asr_is_running = false;
-    NuguRecorder* rec_asr = nullptr;
+    NuguRecorderReader* rec_asr = nullptr;
+    NuguEncoder* encoder = nullptr;
+    std::string codec = "SPEEX";
 };
 
 } // NuguCore
@@ -14,11 +14,10 @@
  * limitations under the License.
  */
 
-#include <unistd.h>
-
 #include <interface/nugu_configuration.hh>
 #include <keyword_detector.h>
 
+#include "audio_recorder_manager.hh"
 #include "nugu_config.h"
 #include "nugu_log.h"
 #include "wakeup_detector.hh"
@@ -49,17 +48,14 @@ static gboolean invoke_sync_event(gpointer userdata)
 
 WakeupDetector::WakeupDetector()
 {
-    NuguRecorderDriver* driver = nugu_recorder_driver_get_default();
     int ret;
 
-    if (!driver) {
-        nugu_error("there is no recorder driver");
+    rec_kwd = AudioRecorderManager::getInstance()->createReader();
+    if (!rec_kwd) {
+        nugu_error("can't create the recorder reader");
         return;
     }
 
-    rec_kwd = nugu_recorder_new("rec_kwd", driver);
-    nugu_recorder_set_property(rec_kwd, (NuguAudioProperty) { AUDIO_SAMPLE_RATE_16K, AUDIO_FORMAT_S16_LE, 1 });
-
     thread_created = false;
     kwd_destroy = 0;
     kwd_thread = std::thread([this] { this->loopWakeup(); });
@@ -86,7 +82,7 @@ WakeupDetector::~WakeupDetector()
     if (kwd_thread.joinable())
         kwd_thread.join();
 
-    nugu_recorder_free(rec_kwd);
+    AudioRecorderManager::getInstance()->destroyReader(rec_kwd);
 }
 
 void WakeupDetector::sendSyncWakeupEvent(WakeupState state)
@@ -116,7 +112,6 @@ void WakeupDetector::setListener(IWakeupDetectorListener* listener)
 void WakeupDetector::loopWakeup(void)
 {
     int pcm_size;
-    int length;
     char* model_net_file = NULL;
     char* model_search_file = NULL;
     char* model_path;
@@ -156,24 +151,28 @@ void WakeupDetector::loopWakeup(void)
             break;
         }
 
-        if (nugu_recorder_start(rec_kwd) < 0) {
-            nugu_error("nugu_recorder_start() failed.");
+        if (nugu_recorder_reader_start(rec_kwd) < 0) {
+            nugu_error("nugu_recorder_reader_start() failed.");
             break;
         }
 
-        nugu_recorder_get_frame_size(rec_kwd, &pcm_size, &length);
-
         while (kwd_is_running) {
-            char pcm_buf[pcm_size];
+            const char* pcm_buf;
+            int detected;
 
-            if (nugu_recorder_is_recording(rec_kwd) == 0) {
+            if (nugu_recorder_reader_is_recording(rec_kwd) == 0) {
                 nugu_dbg("Wakeup Thread: not recording state");
-                usleep(10 * 1000);
+
+                /* Sleep until the recording is resumed or stopWakeup() */
+                std::unique_lock<std::mutex> lock(kwd_mutex);
+                kwd_cond.wait(lock, [this] {
+                    return !kwd_is_running || nugu_recorder_reader_is_recording(rec_kwd) == 1;
+                });
                 continue;
             }
 
-            if (nugu_recorder_get_frame_timeout(rec_kwd, pcm_buf, &pcm_size, 0) < 0) {
-                nugu_error("nugu_recorder_get_frame_timeout() failed");
+            if (nugu_recorder_reader_peek_frame_timeout(rec_kwd, &pcm_buf, &pcm_size, 0) < 0) {
+                nugu_error("nugu_recorder_reader_peek_frame_timeout() failed");
                 sendSyncWakeupEvent(WakeupState::FAIL);
                 break;
             }
@@ -184,14 +183,19 @@ void WakeupDetector::loopWakeup(void)
                 break;
             }
 
-            if (kwd_put_audio((short*)pcm_buf, pcm_size) == 1) {
+            detected = kwd_put_audio((short*)pcm_buf, pcm_size);
+
+            if (nugu_recorder_reader_release_frame(rec_kwd) < 0)
+                nugu_warn("the frame was overwritten during the detection");
+
+            if (detected == 1) {
                 sendSyncWakeupEvent(WakeupState::DETECTED);
                 kwd_is_running = false;
                 break;
             }
         }
 
-        nugu_recorder_stop(rec_kwd);
+        nugu_recorder_reader_stop(rec_kwd);
         kwd_deinitialize();
 
         if (g_atomic_int_get(&kwd_destroy) == 0)
@@ -231,7 +235,10 @@ void WakeupDetector::stopWakeup(void)
         return;
     }
 
+    kwd_mutex.lock();
     kwd_is_running = false;
+    kwd_cond.notify_all();
+    kwd_mutex.unlock();
 }
 
 } // NuguCore
@@ -63,7 +63,7 @@ private:
     std::mutex kwd_mutex;
     gint kwd_destroy;
     bool kwd_is_running = false;
-    NuguRecorder* rec_kwd = nullptr;
+    NuguRecorderReader* rec_kwd = nullptr;
     bool thread_created;
 };
 
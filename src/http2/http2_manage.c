@@ -73,6 +73,11 @@ struct _h2_manager {
 	GatewayHealthPolicy policy;
 	GList *servers;
 
+	/* attachment streams of the events, keyed by the event message id */
+	int attachment_stream;
+	GHashTable *attachments;
+	pthread_mutex_t attachments_lock;
+
 	pthread_t thread_id;
 };
 
@@ -104,6 +109,11 @@ static int _h2manager_network_stop(H2Manager *manager, int with_status)
 		return 0;
 	}
 
+	/* The attachment streams refer to the network */
+	pthread_mutex_lock(&manager->attachments_lock);
+	g_hash_table_remove_all(manager->attachments);
+	pthread_mutex_unlock(&manager->attachments_lock);
+
 	http2_network_free(manager->network);
 	manager->network = NULL;
 
@@ -293,6 +303,7 @@ H2Manager *h2manager_new(void)
 {
 	H2Manager *manager;
 	char *token_value;
+	char *value;
 
 	manager = calloc(1, sizeof(H2Manager));
 	if (!manager) {
@@ -303,6 +314,19 @@ H2Manager *h2manager_new(void)
 	manager->status = H2_STATUS_READY;
 	manager->tid = (pid_t)syscall(SYS_gettid);
 
+	manager->attachment_stream = 0;
+	value = nugu_config_get(NUGU_CONFIG_KEY_ATTACHMENT_STREAM);
+	if (value) {
+		if (g_ascii_strcasecmp(value, "true") == 0)
+			manager->attachment_stream = 1;
+		free(value);
+	}
+
+	manager->attachments = g_hash_table_new_full(
+		g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify)v1_event_attachment_free);
+	pthread_mutex_init(&manager->attachments_lock, NULL);
+
 	token_value = nugu_config_get(NUGU_CONFIG_KEY_TOKEN);
 
 	if (token_value) {
@@ -316,6 +340,11 @@ H2Manager *h2manager_new(void)
 	return manager;
 }
 
+void h2manager_deinitialize(void)
+{
+	http2_request_pool_deinit();
+}
+
 void h2manager_free(H2Manager *manager)
 {
 	g_return_if_fail(manager != NULL);
@@ -345,6 +374,13 @@ void h2manager_free(H2Manager *manager)
 	if (manager->thread_id)
 		pthread_join(manager->thread_id, NULL);
 
+	if (manager->attachments) {
+		g_hash_table_destroy(manager->attachments);
+		manager->attachments = NULL;
+	}
+
+	pthread_mutex_destroy(&manager->attachments_lock);
+
 	if (manager->host)
 		g_free(manager->host);
 
@@ -562,6 +598,70 @@ int h2manager_send_event(H2Manager *manager, const char *name_space,
 	return 0;
 }
 
+static gboolean _is_finished_attachment(gpointer key, gpointer value,
+					gpointer userdata)
+{
+	return v1_event_attachment_is_finished(value) == 1;
+}
+
+static V1EventAttachment *
+_h2manager_open_attachment(H2Manager *manager, const char *name_space,
+			   const char *name, const char *version,
+			   const char *parent_msg_id, const char *msg_id,
+			   const char *dialog_id, int seq)
+{
+	V1EventAttachment *ea;
+
+	/* Drop the streams completed without the end (e.g. timeout) */
+	g_hash_table_foreach_remove(manager->attachments,
+				    _is_finished_attachment, NULL);
+
+	ea = v1_event_attachment_new(manager->host);
+	if (!ea)
+		return NULL;
+
+	/*
+	 * The whole attachment is sent in the body of this request, so the
+	 * request is the last (and the only) part of the attachment.
+	 */
+	v1_event_attachment_set_query(ea, name_space, name, version,
+				      parent_msg_id, msg_id, dialog_id, seq, 1);
+	v1_event_attachment_add_header(ea, manager->token);
+
+	if (v1_event_attachment_send_stream(ea, manager->network) < 0) {
+		v1_event_attachment_free(ea);
+		return NULL;
+	}
+
+	g_hash_table_insert(manager->attachments, g_strdup(parent_msg_id),
+			    ea);
+
+	return ea;
+}
+
+static int _h2manager_send_attachment_request(
+	H2Manager *manager, const char *name_space, const char *name,
+	const char *version, const char *parent_msg_id, const char *msg_id,
+	const char *dialog_id, int seq, int is_end, size_t length,
+	unsigned char *data)
+{
+	V1EventAttachment *ea;
+
+	ea = v1_event_attachment_new(manager->host);
+	if (!ea)
+		return -1;
+
+	if (data != NULL && length > 0)
+		v1_event_attachment_set_data(ea, data, length);
+	v1_event_attachment_set_query(ea, name_space, name, version,
+				      parent_msg_id, msg_id, dialog_id, seq,
+				      is_end);
+	v1_event_attachment_add_header(ea, manager->token);
+	v1_event_attachment_send_with_free(ea, manager->network);
+
+	return 0;
+}
+
 int h2manager_send_event_attachment(H2Manager *manager, const char *name_space,
 				    const char *name, const char *version,
 				    const char *parent_msg_id,
@@ -570,6 +670,9 @@ int h2manager_send_event_attachment(H2Manager *manager, const char *name_space,
 				    unsigned char *data)
 {
 	V1EventAttachment *ea;
+	int ret = 0;
+
+	g_return_val_if_fail(parent_msg_id != NULL, -1);
 
 	if (h2manager_get_status(manager) != H2_STATUS_CONNECTED) {
 		nugu_error("http2 network is not ready(%d)",
@@ -577,17 +680,53 @@ int h2manager_send_event_attachment(H2Manager *manager, const char *name_space,
 		return -1;
 	}
 
-	ea = v1_event_attachment_new(manager->host);
-	if (!ea)
-		return -1;
+	if (manager->attachment_stream == 0)
+		return _h2manager_send_attachment_request(
+			manager, name_space, name, version, parent_msg_id,
+			msg_id, dialog_id, seq, is_end, length, data);
+
+	pthread_mutex_lock(&manager->attachments_lock);
+
+	ea = g_hash_table_lookup(manager->attachments, parent_msg_id);
+	if (!ea) {
+		ea = _h2manager_open_attachment(manager, name_space, name,
+						version, parent_msg_id, msg_id,
+						dialog_id, seq);
+		if (!ea) {
+			pthread_mutex_unlock(&manager->attachments_lock);
+			return -1;
+		}
+	}
 
 	if (data != NULL && length > 0)
-		v1_event_attachment_set_data(ea, data, length);
-	v1_event_attachment_set_query(ea, name_space, name, version,
-				      parent_msg_id, msg_id, dialog_id, seq,
-				      is_end);
-	v1_event_attachment_add_header(ea, manager->token);
-	v1_event_attachment_send_with_free(ea, manager->network);
+		ret = v1_event_attachment_write_stream(ea, data, length);
+
+	/* Closed by v1_event_attachment_free() */
+	if (is_end)
+		g_hash_table_remove(manager->attachments, parent_msg_id);
+
+	pthread_mutex_unlock(&manager->attachments_lock);
+
+	return ret;
+}
+
+int h2manager_close_event_attachment(H2Manager *manager,
+				     const char *parent_msg_id)
+{
+	g_return_val_if_fail(manager != NULL, -1);
+	g_return_val_if_fail(parent_msg_id != NULL, -1);
+
+	/* Closed by v1_event_attachment_free() */
+	pthread_mutex_lock(&manager->attachments_lock);
+	g_hash_table_remove(manager->attachments, parent_msg_id);
+	pthread_mutex_unlock(&manager->attachments_lock);
 
 	return 0;
 }
+
+int h2manager_is_attachment_stream(H2Manager *manager)
+{
+	g_return_val_if_fail(manager != NULL, -1);
+
+	return manager->attachment_stream;
+}
@@ -56,10 +56,18 @@ int h2manager_send_event_attachment(H2Manager *manager, const char *name_space,
 				    const char *msg_id, const char *dialog_id,
 				    int seq, int is_end, size_t length,
 				    unsigned char *data);
+int h2manager_close_event_attachment(H2Manager *manager,
+				     const char *parent_msg_id);
+
+/* 1: attachment stream, 0: a request per attachment data */
+int h2manager_is_attachment_stream(H2Manager *manager);
 
 int h2manager_connect(H2Manager *manager);
 int h2manager_disconnect(H2Manager *manager);
 
+/* Free the resources shared by all managers */
+void h2manager_deinitialize(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,11 +25,13 @@
 
 #include "nugu_log.h"
 #include "nugu_config.h"
+#include "nugu_pool.h"
 #include "http2_network.h"
 
 enum request_type {
 	REQUEST_ADD,
-	REQUEST_REMOVE
+	REQUEST_REMOVE,
+	REQUEST_RESUME
 };
 
 struct request_item {
@@ -57,6 +59,7 @@ struct _http2_network {
 	/* communication with thread loop */
 	int wakeup_fd;
 	GAsyncQueue *requests;
+	NuguPool *item_pool;
 
 	/* handled only thread loop */
 	CURLM *handle;
@@ -69,6 +72,14 @@ struct _http2_network {
 
 static int _curl_init;
 
+static void _request_item_free(HTTP2Network *net, struct request_item *item)
+{
+	pthread_cond_destroy(&item->cond);
+	pthread_mutex_destroy(&item->lock);
+
+	nugu_pool_release(net->item_pool, item);
+}
+
 static int _process_add(HTTP2Network *net, struct request_item *item)
 {
 	CURLMcode rc;
@@ -109,6 +120,28 @@ static int _process_remove(HTTP2Network *net, struct request_item *item)
 	return 0;
 }
 
+static int _process_resume(HTTP2Network *net, struct request_item *item)
+{
+	CURLcode rc;
+	CURL *req;
+
+	req = http2_request_get_handle(item->req);
+	if (!req)
+		return -1;
+
+	/* The request is already completed */
+	if (g_list_find(net->hlist, req) == NULL)
+		return -1;
+
+	rc = curl_easy_pause(req, CURLPAUSE_CONT);
+	if (rc != CURLE_OK) {
+		nugu_error("curl_easy_pause() failed. ret=%d", rc);
+		return -1;
+	}
+
+	return 0;
+}
+
 static void *_loop(void *data)
 {
 	HTTP2Network *net = data;
@@ -200,7 +233,7 @@ static void *_loop(void *data)
 
 				if (item->type == REQUEST_ADD) {
 					_process_add(net, item);
-					free(item);
+					_request_item_free(net, item);
 				} else if (item->type == REQUEST_REMOVE) {
 					_process_remove(net, item);
 
@@ -208,6 +241,10 @@ static void *_loop(void *data)
 					item->is_done = 1;
 					pthread_cond_signal(&item->cond);
 					pthread_mutex_unlock(&item->lock);
+				} else if (item->type == REQUEST_RESUME) {
+					_process_resume(net, item);
+					http2_request_unref(item->req);
+					_request_item_free(net, item);
 				}
 			}
 		}
@@ -282,7 +319,8 @@ HTTP2Network *http2_network_new()
 	pthread_mutex_init(&net->init_lock, NULL);
 
 	net->wakeup_fd = eventfd(0, EFD_CLOEXEC);
-	net->requests = g_async_queue_new_full(g_free);
+	net->requests = g_async_queue_new();
+	net->item_pool = nugu_pool_new(sizeof(struct request_item), 0);
 	net->useragent = nugu_config_get(NUGU_CONFIG_KEY_USER_AGENT);
 
 	return net;
@@ -314,12 +352,18 @@ void http2_network_free(HTTP2Network *net)
 		if (!item)
 			break;
 
-		free(item);
+		if (item->type == REQUEST_RESUME)
+			http2_request_unref(item->req);
+
+		_request_item_free(net, item);
 	}
 
 	if (net->requests)
 		g_async_queue_unref(net->requests);
 
+	if (net->item_pool)
+		nugu_pool_free(net->item_pool);
+
 	if (net->useragent)
 		free(net->useragent);
 
@@ -329,16 +373,15 @@ void http2_network_free(HTTP2Network *net)
 	free(net);
 }
 
-static struct request_item *_request_item_new(enum request_type type,
+static struct request_item *_request_item_new(HTTP2Network *net,
+					      enum request_type type,
 					      HTTP2Request *req)
 {
 	struct request_item *item;
 
-	item = malloc(sizeof(struct request_item));
-	if (!item) {
-		error_nomem();
+	item = nugu_pool_alloc(net->item_pool);
+	if (!item)
 		return NULL;
-	}
 
 	item->type = type;
 	item->req = req;
@@ -371,7 +414,7 @@ int http2_network_add_request(HTTP2Network *net, HTTP2Request *req)
 
 	http2_request_set_useragent(req, net->useragent);
 
-	item = _request_item_new(REQUEST_ADD, req);
+	item = _request_item_new(net, REQUEST_ADD, req);
 	if (!item)
 		return -1;
 
@@ -405,7 +448,7 @@ int http2_network_remove_request_sync(HTTP2Network *net, HTTP2Request *req)
 	}
 	pthread_mutex_unlock(&net->init_lock);
 
-	item = _request_item_new(REQUEST_REMOVE, req);
+	item = _request_item_new(net, REQUEST_REMOVE, req);
 	if (!item)
 		return -1;
 
@@ -436,7 +479,40 @@ int http2_network_remove_request_sync(HTTP2Network *net, HTTP2Request *req)
 	}
 
 	http2_request_unref(req);
-	free(item);
+	_request_item_free(net, item);
+
+	return 0;
+}
+
+int http2_network_resume_request(HTTP2Network *net, HTTP2Request *req)
+{
+	uint64_t ev = 1;
+	ssize_t written;
+	struct request_item *item;
+
+	g_return_val_if_fail(net != NULL, -1);
+	g_return_val_if_fail(req != NULL, -1);
+
+	pthread_mutex_lock(&net->init_lock);
+	if (!net->handle) {
+		nugu_error("network is not started");
+		pthread_mutex_unlock(&net->init_lock);
+		return -1;
+	}
+	pthread_mutex_unlock(&net->init_lock);
+
+	item = _request_item_new(net, REQUEST_RESUME, req);
+	if (!item)
+		return -1;
+
+	/* curl_easy_pause() must be called in the thread loop */
+	http2_request_ref(req);
+	g_async_queue_push(net->requests, item);
+
+	/* wakeup request using eventfd */
+	written = write(net->wakeup_fd, &ev, sizeof(uint64_t));
+	if (written != sizeof(uint64_t))
+		nugu_error("write failed");
 
 	return 0;
 }
@@ -18,12 +18,17 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include "nugu_log.h"
+#include "nugu_pool.h"
 #include "http2_request.h"
 
 #define SHOW_VERBOSE 0
 
+static NuguPool *_request_pool;
+static pthread_mutex_t _request_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
 struct _http2_request {
 	CURL *easy;
 	struct curl_slist *headers;
@@ -34,6 +39,12 @@ struct _http2_request {
 	NuguBuffer *response_body;
 	NuguBuffer *send_body;
 
+	/* streaming upload: send_body is fed while the request is running */
+	int stream;
+	int stream_paused;
+	int stream_closed;
+	pthread_mutex_t lock_send;
+
 	ResponseHeaderCallback header_cb;
 	void *header_cb_userdata;
 
@@ -106,6 +117,10 @@ static size_t _request_body_cb(char *buffer, size_t size, size_t nitems,
 	HTTP2Request *req = userdata;
 	size_t length;
 
+	if (req->stream)
+		return http2_request_read_stream_data(req, buffer,
+						      size * nitems);
+
 	if (!req->send_body)
 		return 0;
 
@@ -140,6 +155,15 @@ static size_t _request_body_cb(char *buffer, size_t size, size_t nitems,
 	return length;
 }
 
+static NuguBuffer *_get_buffer(NuguBuffer **buf)
+{
+	/* Buffers are created only when they are used */
+	if (*buf == NULL)
+		*buf = nugu_buffer_new(0);
+
+	return *buf;
+}
+
 static size_t _response_body_cb(char *ptr, size_t size, size_t nmemb,
 				void *userdata)
 {
@@ -148,7 +172,8 @@ static size_t _response_body_cb(char *ptr, size_t size, size_t nmemb,
 	if (req->body_cb)
 		req->body_cb(req, ptr, size, nmemb, req->body_cb_userdata);
 	else
-		nugu_buffer_add(req->response_body, ptr, size * nmemb);
+		nugu_buffer_add(_get_buffer(&req->response_body), ptr,
+				size * nmemb);
 
 	return size * nmemb;
 }
@@ -162,27 +187,78 @@ static size_t _response_header_cb(char *buffer, size_t size, size_t nmemb,
 		req->header_cb(req, buffer, size, nmemb,
 			       req->header_cb_userdata);
 	else
-		nugu_buffer_add(req->response_header, buffer, size * nmemb);
+		nugu_buffer_add(_get_buffer(&req->response_header), buffer,
+				size * nmemb);
 
 	http2_request_emit_response(req, HTTP2_REQUEST_SYNC_ITEM_HEADER);
 
 	return size * nmemb;
 }
 
+/* Created again after http2_request_pool_deinit() */
+static void *_request_alloc(void)
+{
+	void *item = NULL;
+
+	pthread_mutex_lock(&_request_pool_lock);
+
+	if (!_request_pool)
+		_request_pool = nugu_pool_new(sizeof(struct _http2_request), 0);
+
+	if (_request_pool)
+		item = nugu_pool_alloc(_request_pool);
+
+	pthread_mutex_unlock(&_request_pool_lock);
+
+	return item;
+}
+
+void http2_request_pool_deinit(void)
+{
+	NuguPoolStats stats;
+
+	pthread_mutex_lock(&_request_pool_lock);
+
+	if (_request_pool && nugu_pool_get_stats(_request_pool, &stats) == 0) {
+		/* The running requests are freed later by the network */
+		if (stats.in_use > 0) {
+			nugu_dbg("%d requests are still in use", stats.in_use);
+		} else {
+			nugu_pool_free(_request_pool);
+			_request_pool = NULL;
+		}
+	}
+
+	pthread_mutex_unlock(&_request_pool_lock);
+}
+
+int http2_request_get_pool_stats(NuguPoolStats *stats)
+{
+	int ret = 0;
+
+	g_return_val_if_fail(stats != NULL, -1);
+
+	pthread_mutex_lock(&_request_pool_lock);
+
+	if (_request_pool)
+		ret = nugu_pool_get_stats(_request_pool, stats);
+	else
+		memset(stats, 0, sizeof(NuguPoolStats));
+
+	pthread_mutex_unlock(&_request_pool_lock);
+
+	return ret;
+}
+
 HTTP2Request *http2_request_new()
 {
 	struct _http2_request *req;
 
-	req = calloc(1, sizeof(struct _http2_request));
-	if (!req) {
-		error_nomem();
+	req = _request_alloc();
+	if (!req)
 		return NULL;
-	}
 
 	req->ref_count = 1;
-	req->response_header = nugu_buffer_new(0);
-	req->response_body = nugu_buffer_new(0);
-	req->send_body = nugu_buffer_new(0);
 
 	req->easy = curl_easy_init();
 
@@ -202,6 +278,7 @@ HTTP2Request *http2_request_new()
 	curl_easy_setopt(req->easy, CURLOPT_HEADERDATA, req);
 
 	pthread_mutex_init(&req->lock_ref, NULL);
+	pthread_mutex_init(&req->lock_send, NULL);
 	pthread_mutex_init(&req->lock_header, NULL);
 	pthread_mutex_init(&req->lock_finish, NULL);
 	pthread_cond_init(&req->cond_header, NULL);
@@ -234,13 +311,13 @@ void http2_request_free(HTTP2Request *req)
 	curl_easy_cleanup(req->easy);
 
 	pthread_mutex_destroy(&req->lock_ref);
+	pthread_mutex_destroy(&req->lock_send);
 	pthread_mutex_destroy(&req->lock_header);
 	pthread_mutex_destroy(&req->lock_finish);
 	pthread_cond_destroy(&req->cond_header);
 	pthread_cond_destroy(&req->cond_finish);
 
-	memset(req, 0, sizeof(HTTP2Request));
-	free(req);
+	nugu_pool_release(_request_pool, req);
 }
 
 int http2_request_ref(HTTP2Request *req)
@@ -294,11 +371,108 @@ int http2_request_add_send_data(HTTP2Request *req, const unsigned char *data,
 {
 	g_return_val_if_fail(req != NULL, -1);
 
-	nugu_buffer_add(req->send_body, data, length);
+	nugu_buffer_add(_get_buffer(&req->send_body), data, length);
 
 	return 0;
 }
 
+int http2_request_set_stream(HTTP2Request *req)
+{
+	g_return_val_if_fail(req != NULL, -1);
+
+	req->stream = 1;
+
+	return 0;
+}
+
+static int _stream_resume_needed(HTTP2Request *req)
+{
+	if (req->stream_paused == 0)
+		return 0;
+
+	req->stream_paused = 0;
+
+	return 1;
+}
+
+int http2_request_add_stream_data(HTTP2Request *req, const unsigned char *data,
+				  size_t length)
+{
+	int ret;
+
+	g_return_val_if_fail(req != NULL, -1);
+	g_return_val_if_fail(req->stream == 1, -1);
+
+	pthread_mutex_lock(&req->lock_send);
+
+	if (req->stream_closed) {
+		pthread_mutex_unlock(&req->lock_send);
+		nugu_error("req(%p) stream is already closed", req);
+		return -1;
+	}
+
+	nugu_buffer_add(_get_buffer(&req->send_body), data, length);
+	ret = _stream_resume_needed(req);
+
+	pthread_mutex_unlock(&req->lock_send);
+
+	return ret;
+}
+
+int http2_request_close_stream(HTTP2Request *req)
+{
+	int ret;
+
+	g_return_val_if_fail(req != NULL, -1);
+	g_return_val_if_fail(req->stream == 1, -1);
+
+	pthread_mutex_lock(&req->lock_send);
+	req->stream_closed = 1;
+	ret = _stream_resume_needed(req);
+	pthread_mutex_unlock(&req->lock_send);
+
+	return ret;
+}
+
+size_t http2_request_read_stream_data(HTTP2Request *req, char *buffer,
+				      size_t size)
+{
+	size_t length = 0;
+
+	g_return_val_if_fail(req != NULL, 0);
+	g_return_val_if_fail(buffer != NULL, 0);
+
+	pthread_mutex_lock(&req->lock_send);
+
+	if (req->send_body)
+		length = nugu_buffer_get_size(req->send_body);
+
+	if (length == 0) {
+		if (req->stream_closed) {
+			pthread_mutex_unlock(&req->lock_send);
+			return 0;
+		}
+
+		/* Paused until http2_network_resume_request() */
+		req->stream_paused = 1;
+		pthread_mutex_unlock(&req->lock_send);
+		return CURL_READFUNC_PAUSE;
+	}
+
+	if (length > size)
+		length = size;
+
+	memcpy(buffer, nugu_buffer_peek(req->send_body), length);
+	nugu_buffer_shift_left(req->send_body, length);
+
+	pthread_mutex_unlock(&req->lock_send);
+
+	if ((nugu_log_get_modules() & NUGU_LOG_MODULE_NETWORK_TRACE) != 0)
+		nugu_info("--> Sent req(%p) %zu bytes (stream)", req, length);
+
+	return length;
+}
+
 int http2_request_set_method(HTTP2Request *req,
 			     enum http2_request_method method)
 {
@@ -376,6 +550,17 @@ int http2_request_set_timeout(HTTP2Request *req, int timeout)
 	return 0;
 }
 
+int http2_request_set_low_speed_limit(HTTP2Request *req, long limit,
+				      long time)
+{
+	g_return_val_if_fail(req != NULL, -1);
+
+	curl_easy_setopt(req->easy, CURLOPT_LOW_SPEED_LIMIT, limit);
+	curl_easy_setopt(req->easy, CURLOPT_LOW_SPEED_TIME, time);
+
+	return 0;
+}
+
 CURL *http2_request_get_handle(HTTP2Request *req)
 {
 	g_return_val_if_fail(req != NULL, NULL);
@@ -483,14 +668,27 @@ NuguBuffer *http2_request_peek_response_body(HTTP2Request *req)
 {
 	g_return_val_if_fail(req != NULL, NULL);
 
-	return req->response_body;
+	return _get_buffer(&req->response_body);
 }
 
 NuguBuffer *http2_request_peek_response_header(HTTP2Request *req)
 {
 	g_return_val_if_fail(req != NULL, NULL);
 
-	return req->response_header;
+	return _get_buffer(&req->response_header);
+}
+
+int http2_request_is_finished(HTTP2Request *req)
+{
+	int finished;
+
+	g_return_val_if_fail(req != NULL, -1);
+
+	pthread_mutex_lock(&req->lock_finish);
+	finished = req->finished;
+	pthread_mutex_unlock(&req->lock_finish);
+
+	return finished;
 }
 
 int http2_request_get_response_code(HTTP2Request *req)
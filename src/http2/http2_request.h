@@ -19,6 +19,7 @@
 
 #include "curl/curl.h"
 #include "nugu_buffer.h"
+#include "nugu_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -65,6 +66,20 @@ int http2_request_add_header(HTTP2Request *req, const char *header);
 int http2_request_add_send_data(HTTP2Request *req, const unsigned char *data,
 				size_t length);
 
+/*
+ * Streaming upload: the request body is fed while the request is running.
+ * The add/close functions return 1 if the transfer was paused for the data
+ * and must be resumed by http2_network_resume_request().
+ * The read function is the body callback of the transfer, which returns
+ * CURL_READFUNC_PAUSE while there is no data, and 0 after the close.
+ */
+int http2_request_set_stream(HTTP2Request *req);
+int http2_request_add_stream_data(HTTP2Request *req, const unsigned char *data,
+				  size_t length);
+int http2_request_close_stream(HTTP2Request *req);
+size_t http2_request_read_stream_data(HTTP2Request *req, char *buffer,
+				      size_t size);
+
 int http2_request_set_method(HTTP2Request *req,
 			     enum http2_request_method method);
 int http2_request_set_url(HTTP2Request *req, const char *url);
@@ -72,6 +87,8 @@ int http2_request_set_content_type(HTTP2Request *req,
 				   enum http2_request_content_type type);
 int http2_request_set_connection_timeout(HTTP2Request *req, int timeout);
 int http2_request_set_timeout(HTTP2Request *req, int timeout);
+int http2_request_set_low_speed_limit(HTTP2Request *req, long limit,
+				      long time);
 int http2_request_set_useragent(HTTP2Request *req, const char *useragent);
 
 CURL *http2_request_get_handle(HTTP2Request *req);
@@ -95,6 +112,7 @@ void http2_request_emit_response(HTTP2Request *req,
 
 void http2_request_emit_completed(HTTP2Request *req);
 
+int http2_request_is_finished(HTTP2Request *req);
 int http2_request_get_response_code(HTTP2Request *req);
 
 int http2_request_disable_verify_peer(HTTP2Request *req);
@@ -102,6 +120,10 @@ int http2_request_disable_verify_peer(HTTP2Request *req);
 void http2_request_enable_curl_log(HTTP2Request *req);
 void http2_request_disable_curl_log(HTTP2Request *req);
 
+/* The pool is kept while any request is in use */
+void http2_request_pool_deinit(void);
+int http2_request_get_pool_stats(NuguPoolStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
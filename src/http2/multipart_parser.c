@@ -19,12 +19,17 @@
 
 #include "nugu_log.h"
 #include "nugu_buffer.h"
+#include "nugu_chunk.h"
 #include "multipart_parser.h"
 
 #define MARK_CR '\r'
 #define MARK_LF '\n'
 #define MARK_HYPHEN '-'
 
+/* (body)CRLF + (emptyline)CRLF */
+#define MARK_BODY_END "\r\n\r\n"
+#define MARK_BODY_END_LENGTH 4
+
 enum bodyparser_step {
 	STEP_READY,
 	STEP_START_HYPHEN,
@@ -47,9 +52,10 @@ enum bodyparser_step {
 
 struct _multipart_parser {
 	NuguBuffer *header;
-	NuguBuffer *body;
+	NuguChunkChain *body;
 	char *boundary;
 	size_t boundary_length;
+	size_t boundary_matched;
 	enum bodyparser_step step;
 };
 
@@ -64,7 +70,7 @@ MultipartParser *multipart_parser_new()
 	}
 
 	parser->header = nugu_buffer_new(0);
-	parser->body = nugu_buffer_new(0);
+	parser->body = nugu_chunk_chain_new();
 	parser->step = STEP_READY;
 
 	return parser;
@@ -83,14 +89,12 @@ void multipart_parser_free(MultipartParser *parser)
 		nugu_dbg("\n%s", (char *)nugu_buffer_peek(parser->header));
 	}
 
-	if (nugu_buffer_get_size(parser->body) > 0) {
+	if (nugu_chunk_chain_get_size(parser->body) > 0)
 		nugu_dbg("remain body size: %d",
-			 nugu_buffer_get_size(parser->body));
-		nugu_dbg("\n%s", (char *)nugu_buffer_peek(parser->body));
-	}
+			 nugu_chunk_chain_get_size(parser->body));
 
 	nugu_buffer_free(parser->header, TRUE);
-	nugu_buffer_free(parser->body, TRUE);
+	nugu_chunk_chain_free(parser->body);
 
 	memset(parser, 0, sizeof(MultipartParser));
 	free(parser);
@@ -118,50 +122,95 @@ void multipart_parser_set_boundary(MultipartParser *parser, const char *src,
 	nugu_dbg("multipart boundary: '%s'", parser->boundary);
 }
 
+int multipart_parser_reserve_body(MultipartParser *parser, size_t size)
+{
+	g_return_val_if_fail(parser != NULL, -1);
+
+	return nugu_chunk_chain_reserve(parser->body, size);
+}
+
+static void _flush_body(MultipartParser *parser, const char *start,
+			const char *end)
+{
+	if (start == NULL || end <= start)
+		return;
+
+	nugu_chunk_chain_add(parser->body, start, end - start);
+}
+
+static void _found_body(MultipartParser *parser, const char *start,
+			const char *end, ParserBodyCallback onFoundBody,
+			void *userdata)
+{
+	size_t body_size;
+
+	/* Copy the body in this callback at once */
+	_flush_body(parser, start, end);
+
+	body_size = nugu_chunk_chain_get_size(parser->body);
+	if (body_size >= MARK_BODY_END_LENGTH) {
+		/* Remove trailing (body)CRLF+(emptyline)CRLF */
+		nugu_chunk_chain_truncate(parser->body,
+					  body_size - MARK_BODY_END_LENGTH);
+	}
+
+	onFoundBody(parser, parser->body, userdata);
+	nugu_chunk_chain_clear(parser->body);
+}
+
 int multipart_parser_parse(MultipartParser *parser, const char *src,
 			   size_t length, ParserCallback onFoundHeader,
-			   ParserCallback onFoundBody, void *userdata)
+			   ParserBodyCallback onFoundBody, void *userdata)
 {
 	const char *pos;
 	const char *end;
-	const char *b_pos;
-	const char *b_end;
+	const char *body_start = NULL;
+	size_t skip;
 
 	g_return_val_if_fail(parser != NULL, -1);
 	g_return_val_if_fail(src != NULL, -1);
 
 	end = src + length;
-	b_pos = parser->boundary;
-	b_end = parser->boundary + parser->boundary_length - 1;
 
 	for (pos = src; pos < end; pos++) {
 		switch (parser->step) {
 		case STEP_READY:
 			/* prev: '' */
-			if (*pos == MARK_HYPHEN)
-				parser->step = STEP_START_HYPHEN;
+			skip = nugu_buffer_search_byte(pos, end - pos,
+						       MARK_HYPHEN);
+			if (skip == NOT_FOUND) {
+				pos = end - 1;
+				break;
+			}
+			pos += skip;
+			parser->step = STEP_START_HYPHEN;
 			break;
 
 		case STEP_START_HYPHEN:
 			/* prev: '-' */
-			if (*pos == MARK_HYPHEN) {
+			if (*pos == MARK_HYPHEN && parser->boundary) {
 				parser->step = STEP_CHECK_BOUNDARY;
-				b_pos = parser->boundary;
+				parser->boundary_matched = 0;
 				break;
 			}
 			parser->step = STEP_READY;
 			break;
 
 		case STEP_CHECK_BOUNDARY:
-			/* prev: '--' */
-			if (*pos != *b_pos) {
+			/* prev: '--' and the matched part of boundary */
+			skip = MIN((size_t)(end - pos),
+				   parser->boundary_length -
+					   parser->boundary_matched);
+			if (memcmp(pos,
+				   parser->boundary + parser->boundary_matched,
+				   skip) != 0) {
 				nugu_error("boundary mismatch !");
 				parser->step = STEP_READY;
 				break;
 			}
-			if (b_pos < b_end)
-				b_pos++;
-			else
+			pos += skip - 1;
+			parser->boundary_matched += skip;
+			if (parser->boundary_matched == parser->boundary_length)
 				parser->step = STEP_END_BOUNDARY;
 			break;
 
@@ -250,14 +299,32 @@ int multipart_parser_parse(MultipartParser *parser, const char *src,
 
 		case STEP_BODY:
 			/* prev: '\r\n' or '{string}' */
-			nugu_buffer_add(parser->body, pos, 1);
+			if (!body_start)
+				body_start = pos;
+
+			/* Skip the payload to the end of body at once */
+			skip = nugu_buffer_search(pos, end - pos, MARK_BODY_END,
+						  MARK_BODY_END_LENGTH);
+			if (skip != NOT_FOUND) {
+				pos += skip + MARK_BODY_END_LENGTH - 1;
+				parser->step = STEP_READY;
+				_found_body(parser, body_start, pos + 1,
+					    onFoundBody, userdata);
+				body_start = NULL;
+				break;
+			}
+
+			/* Check only the last bytes for the partial end mark */
+			if (end - pos > MARK_BODY_END_LENGTH)
+				pos = end - MARK_BODY_END_LENGTH;
 			if (*pos == MARK_CR)
 				parser->step = STEP_BODY_CR;
 			break;
 
 		case STEP_BODY_CR:
 			/* prev: '{string}\r' */
-			nugu_buffer_add(parser->body, pos, 1);
+			if (!body_start)
+				body_start = pos;
 			if (*pos == MARK_LF)
 				parser->step = STEP_BODY_ENDLINE;
 			else if (*pos == MARK_CR)
@@ -268,7 +335,8 @@ int multipart_parser_parse(MultipartParser *parser, const char *src,
 
 		case STEP_BODY_ENDLINE:
 			/* prev: '{string}\r\n' */
-			nugu_buffer_add(parser->body, pos, 1);
+			if (!body_start)
+				body_start = pos;
 			if (*pos == MARK_CR)
 				parser->step = STEP_BODY_ENDLINE_CR;
 			else
@@ -277,22 +345,16 @@ int multipart_parser_parse(MultipartParser *parser, const char *src,
 
 		case STEP_BODY_ENDLINE_CR:
 			/* prev: '{string}\r\n\r' */
-			nugu_buffer_add(parser->body, pos, 1);
+			if (!body_start)
+				body_start = pos;
 			if (*pos != MARK_LF) {
 				parser->step = STEP_BODY;
 				break;
 			}
 			parser->step = STEP_READY;
-			if (nugu_buffer_get_size(parser->body) > 0) {
-				/* Remove trailing (body)CRLF+(emptyline)CRLF */
-				nugu_buffer_clear_from(
-					parser->body,
-					nugu_buffer_get_size(parser->body) - 4);
-			}
-			onFoundBody(parser, nugu_buffer_peek(parser->body),
-				    nugu_buffer_get_size(parser->body),
+			_found_body(parser, body_start, pos + 1, onFoundBody,
 				    userdata);
-			nugu_buffer_clear(parser->body);
+			body_start = NULL;
 			break;
 
 		default:
@@ -303,6 +365,9 @@ int multipart_parser_parse(MultipartParser *parser, const char *src,
 			break;
 	}
 
+	/* The body continues in the next data */
+	_flush_body(parser, body_start, end);
+
 	return 0;
 }
 
@@ -311,5 +376,5 @@ void multipart_parser_reset(MultipartParser *parser)
 	g_return_if_fail(parser != NULL);
 
 	nugu_buffer_clear(parser->header);
-	nugu_buffer_clear(parser->body);
+	nugu_chunk_chain_clear(parser->body);
 }
@@ -17,6 +17,8 @@
 #ifndef __HTTP2_MULTIPART_PARSER_H__
 #define __HTTP2_MULTIPART_PARSER_H__
 
+#include "nugu_chunk.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -25,15 +27,18 @@ typedef struct _multipart_parser MultipartParser;
 
 typedef void (*ParserCallback)(MultipartParser *parser, const char *data,
 			       size_t length, void *userdata);
+typedef void (*ParserBodyCallback)(MultipartParser *parser,
+				   NuguChunkChain *body, void *userdata);
 
 MultipartParser *multipart_parser_new();
 void multipart_parser_free(MultipartParser *parser);
 
 void multipart_parser_set_boundary(MultipartParser *parser, const char *src,
 				   size_t length);
+int multipart_parser_reserve_body(MultipartParser *parser, size_t size);
 int multipart_parser_parse(MultipartParser *parser, const char *src,
 			   size_t length, ParserCallback onFoundHeader,
-			   ParserCallback onFoundBody, void *userdata);
+			   ParserBodyCallback onFoundBody, void *userdata);
 void multipart_parser_reset(MultipartParser *parser);
 
 #ifdef __cplusplus
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "nugu_chunk.h"
 #include "nugu_log.h"
 #include "nugu_network_manager.h"
 #include "json/json.h"
@@ -72,6 +73,8 @@ static void on_parsing_header(MultipartParser* parser, const char* data, size_t
 
     nugu_dbg("body header: %s", data);
 
+    dir->body_size = 0;
+
     for (pos = data; pos < end; pos++) {
         switch (status) {
         case KEY:
@@ -126,9 +129,13 @@ static void on_parsing_header(MultipartParser* parser, const char* data, size_t
             value.clear();
         }
     }
+
+    /* Receive the attachment into a single block: body + trailing CRLFCRLF */
+    if (dir->ctype == CONTENT_TYPE_OPUS && dir->body_size > 0)
+        multipart_parser_reserve_body(parser, dir->body_size + 4);
 }
 
-static void _body_json(const char* data, size_t length)
+static void _body_json(NuguChunkChain* body)
 {
     Json::Value root;
     Json::Value dir_list;
@@ -137,9 +144,26 @@ static void _body_json(const char* data, size_t length)
     std::string dump;
     std::string group;
     char group_buf[32];
+    const char* data;
+    size_t length = 0;
+    bool parsed;
+
+    if (nugu_chunk_chain_get_count(body) == 1) {
+        data = (const char*)nugu_chunk_chain_peek(body, 0, &length);
+        parsed = reader.parse(data, data + length, root);
+    } else {
+        char* flat = (char*)nugu_chunk_chain_flatten(body, &length);
+        if (!flat) {
+            nugu_error("empty body");
+            return;
+        }
+
+        parsed = reader.parse(flat, flat + length, root);
+        free(flat);
+    }
 
-    if (!reader.parse(data, root)) {
-        nugu_error("parsing error: '%s'", data);
+    if (!parsed) {
+        nugu_error("parsing error: %s", reader.getFormattedErrorMessages().c_str());
         return;
     }
 
@@ -194,15 +218,25 @@ static void _body_json(const char* data, size_t length)
     }
 }
 
-static void _body_opus(const char* parent_msg_id, int is_end, const char* data, size_t length)
+static void _body_opus(const char* parent_msg_id, int is_end, NuguChunkChain* body)
 {
-    unsigned char* buf;
+    NuguChunkChain* chunks;
     char* p_msgid;
     char* media_type;
+    size_t length;
+
+    /* Share the received blocks without copying */
+    chunks = nugu_chunk_chain_new();
+    if (!chunks)
+        return;
+
+    nugu_chunk_chain_append(chunks, body);
+
+    /* The decoder needs the whole attachment in a contiguous memory */
+    nugu_chunk_chain_linearize(chunks);
 
+    length = nugu_chunk_chain_get_size(chunks);
     p_msgid = strdup(parent_msg_id);
-    buf = (unsigned char*)malloc(length);
-    memcpy(buf, data, length);
     media_type = strdup("audio/opus");
 
     if ((nugu_log_get_modules() & NUGU_LOG_MODULE_NETWORK_TRACE) != 0) {
@@ -216,17 +250,17 @@ static void _body_opus(const char* parent_msg_id, int is_end, const char* data,
         nugu_log_set_prefix_fields(back);
     }
 
-    nugu_network_manager_recv_directive_data(p_msgid, media_type, is_end, length, buf);
+    nugu_network_manager_recv_directive_chunks(p_msgid, media_type, is_end, chunks);
 }
 
-static void _on_parsing_body(MultipartParser* parser, const char* data, size_t length, void* userdata)
+static void _on_parsing_body(MultipartParser* parser, NuguChunkChain* body, void* userdata)
 {
     V1Directives* dir = (V1Directives*)userdata;
 
     if (dir->ctype == CONTENT_TYPE_JSON)
-        _body_json(data, length);
+        _body_json(body);
     else if (dir->ctype == CONTENT_TYPE_OPUS)
-        _body_opus(dir->parent_msg_id, dir->is_end, data, length);
+        _body_opus(dir->parent_msg_id, dir->is_end, body);
 }
 
 /* invoked in a thread loop */
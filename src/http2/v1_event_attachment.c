@@ -31,8 +31,12 @@
 	"&seq=%d"                                                              \
 	"&isEnd=%s"
 
+/* The stream is aborted if no data is transferred for 10 seconds */
+#define STREAM_IDLE_TIMEOUT 10
+
 struct _v1_event_attachment {
 	HTTP2Request *req;
+	HTTP2Network *net;
 	char *host;
 	char *msgid;
 	int seq;
@@ -73,8 +77,13 @@ void v1_event_attachment_free(V1EventAttachment *attach)
 	if (attach->msgid)
 		free(attach->msgid);
 
-	if (attach->req)
+	if (attach->req) {
+		/* Finish the stream not closed by the sender */
+		if (attach->net)
+			v1_event_attachment_close_stream(attach);
+
 		http2_request_unref(attach->req);
+	}
 
 	memset(attach, 0, sizeof(V1EventAttachment));
 	free(attach);
@@ -140,3 +149,62 @@ int v1_event_attachment_send_with_free(V1EventAttachment *attach,
 
 	return ret;
 }
+
+int v1_event_attachment_send_stream(V1EventAttachment *attach,
+				    HTTP2Network *net)
+{
+	int ret;
+
+	g_return_val_if_fail(attach != NULL, -1);
+	g_return_val_if_fail(net != NULL, -1);
+
+	http2_request_set_stream(attach->req);
+
+	/* The stream is kept for the whole speech, but not while it is idle */
+	http2_request_set_timeout(attach->req, 0);
+	http2_request_set_low_speed_limit(attach->req, 1, STREAM_IDLE_TIMEOUT);
+
+	ret = http2_network_add_request(net, attach->req);
+	if (ret < 0)
+		return ret;
+
+	attach->net = net;
+
+	return 0;
+}
+
+int v1_event_attachment_write_stream(V1EventAttachment *attach,
+				     const unsigned char *data, size_t length)
+{
+	int ret;
+
+	g_return_val_if_fail(attach != NULL, -1);
+	g_return_val_if_fail(attach->net != NULL, -1);
+
+	ret = http2_request_add_stream_data(attach->req, data, length);
+	if (ret <= 0)
+		return ret;
+
+	return http2_network_resume_request(attach->net, attach->req);
+}
+
+int v1_event_attachment_close_stream(V1EventAttachment *attach)
+{
+	int ret;
+
+	g_return_val_if_fail(attach != NULL, -1);
+	g_return_val_if_fail(attach->net != NULL, -1);
+
+	ret = http2_request_close_stream(attach->req);
+	if (ret <= 0)
+		return ret;
+
+	return http2_network_resume_request(attach->net, attach->req);
+}
+
+int v1_event_attachment_is_finished(V1EventAttachment *attach)
+{
+	g_return_val_if_fail(attach != NULL, -1);
+
+	return http2_request_is_finished(attach->req);
+}
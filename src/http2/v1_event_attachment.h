@@ -43,6 +43,17 @@ int v1_event_attachment_add_header(V1EventAttachment *attach,
 int v1_event_attachment_send_with_free(V1EventAttachment *attach,
 				       HTTP2Network *net);
 
+/*
+ * Streaming upload: the attachment is sent as one request and the data is
+ * written to the running request until the stream is closed.
+ */
+int v1_event_attachment_send_stream(V1EventAttachment *attach,
+				    HTTP2Network *net);
+int v1_event_attachment_write_stream(V1EventAttachment *attach,
+				     const unsigned char *data, size_t length);
+int v1_event_attachment_close_stream(V1EventAttachment *attach);
+int v1_event_attachment_is_finished(V1EventAttachment *attach);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+
+#include "nugu_log.h"
+#include "nugu_audio.h"
+
+EXPORT_API int nugu_audio_get_rate(enum nugu_audio_sample_rate samplerate)
+{
+	switch (samplerate) {
+	case AUDIO_SAMPLE_RATE_8K:
+		return 8000;
+	case AUDIO_SAMPLE_RATE_16K:
+		return 16000;
+	case AUDIO_SAMPLE_RATE_32K:
+		return 32000;
+	case AUDIO_SAMPLE_RATE_22K:
+		return 22050;
+	case AUDIO_SAMPLE_RATE_44K:
+		return 44100;
+	case AUDIO_SAMPLE_RATE_48K:
+		return 48000;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+EXPORT_API int nugu_audio_get_sample_width(enum nugu_audio_format format)
+{
+	switch (format) {
+	case AUDIO_FORMAT_S8:
+	case AUDIO_FORMAT_U8:
+		return 1;
+	case AUDIO_FORMAT_S16_LE:
+	case AUDIO_FORMAT_S16_BE:
+	case AUDIO_FORMAT_U16_LE:
+	case AUDIO_FORMAT_U16_BE:
+		return 2;
+	case AUDIO_FORMAT_S24_LE:
+	case AUDIO_FORMAT_S24_BE:
+	case AUDIO_FORMAT_U24_LE:
+	case AUDIO_FORMAT_U24_BE:
+		return 3;
+	case AUDIO_FORMAT_S32_LE:
+	case AUDIO_FORMAT_S32_BE:
+	case AUDIO_FORMAT_U32_LE:
+	case AUDIO_FORMAT_U32_BE:
+	case AUDIO_FORMAT_FLOAT_LE:
+	case AUDIO_FORMAT_FLOAT_BE:
+		return 4;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+EXPORT_API int nugu_audio_get_bytes_per_sec(NuguAudioProperty property)
+{
+	return nugu_audio_get_rate(property.samplerate) *
+	       nugu_audio_get_sample_width(property.format) *
+	       MAX(property.channel, 1);
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <glib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "nugu_log.h"
+#include "nugu_audio_convert.h"
+
+/* Count of float samples converted at once by the generic path */
+#define CONVERT_BLOCK_SAMPLES 1024
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define CONVERT_FORMAT_S16 AUDIO_FORMAT_S16_LE
+#define CONVERT_FORMAT_S32 AUDIO_FORMAT_S32_LE
+#define CONVERT_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_LE
+#else
+#define CONVERT_FORMAT_S16 AUDIO_FORMAT_S16_BE
+#define CONVERT_FORMAT_S32 AUDIO_FORMAT_S32_BE
+#define CONVERT_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_BE
+#endif
+
+struct sample_format {
+	int width;
+	int is_signed;
+	int is_be;
+	int is_float;
+};
+
+static const struct sample_format _formats[AUDIO_FORMAT_MAX] = {
+	[AUDIO_FORMAT_S8] = { 1, 1, 0, 0 },
+	[AUDIO_FORMAT_U8] = { 1, 0, 0, 0 },
+	[AUDIO_FORMAT_S16_LE] = { 2, 1, 0, 0 },
+	[AUDIO_FORMAT_S16_BE] = { 2, 1, 1, 0 },
+	[AUDIO_FORMAT_U16_LE] = { 2, 0, 0, 0 },
+	[AUDIO_FORMAT_U16_BE] = { 2, 0, 1, 0 },
+	[AUDIO_FORMAT_S24_LE] = { 3, 1, 0, 0 },
+	[AUDIO_FORMAT_S24_BE] = { 3, 1, 1, 0 },
+	[AUDIO_FORMAT_U24_LE] = { 3, 0, 0, 0 },
+	[AUDIO_FORMAT_U24_BE] = { 3, 0, 1, 0 },
+	[AUDIO_FORMAT_S32_LE] = { 4, 1, 0, 0 },
+	[AUDIO_FORMAT_S32_BE] = { 4, 1, 1, 0 },
+	[AUDIO_FORMAT_U32_LE] = { 4, 0, 0, 0 },
+	[AUDIO_FORMAT_U32_BE] = { 4, 0, 1, 0 },
+	[AUDIO_FORMAT_FLOAT_LE] = { 4, 1, 0, 1 },
+	[AUDIO_FORMAT_FLOAT_BE] = { 4, 1, 1, 1 },
+};
+
+EXPORT_API void nugu_audio_s16_to_float(const int16_t *src, float *dest,
+					size_t count)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dest + i + 4,
+			      _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+#endif
+
+	for (; i < count; i++)
+		dest[i] = src[i] * (1.0f / 32768.0f);
+}
+
+EXPORT_API void nugu_audio_float_to_s16(const float *src, int16_t *dest,
+					size_t count)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	const __m128 max = _mm_set1_ps(32767.0f);
+	const __m128 min = _mm_set1_ps(-32768.0f);
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 lo = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		__m128 hi = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+
+		/* Clamp before the conversion (out of range is INT32_MIN) */
+		lo = _mm_max_ps(_mm_min_ps(lo, max), min);
+		hi = _mm_max_ps(_mm_min_ps(hi, max), min);
+
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_packs_epi32(_mm_cvtps_epi32(lo),
+						 _mm_cvtps_epi32(hi)));
+	}
+#endif
+
+	for (; i < count; i++) {
+		float value = CLAMP(src[i] * 32768.0f, -32768.0f, 32767.0f);
+
+		dest[i] = (int16_t)lrintf(value);
+	}
+}
+
+EXPORT_API void nugu_audio_s24_to_s32(const unsigned char *src, int32_t *dest,
+				      size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		const unsigned char *p = src + i * 3;
+
+		dest[i] = (int32_t)(((uint32_t)p[0] << 8) |
+				    ((uint32_t)p[1] << 16) |
+				    ((uint32_t)p[2] << 24));
+	}
+}
+
+EXPORT_API void nugu_audio_s32_to_s24(const int32_t *src, unsigned char *dest,
+				      size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		uint32_t value = (uint32_t)src[i];
+		unsigned char *p = dest + i * 3;
+
+		p[0] = (unsigned char)(value >> 8);
+		p[1] = (unsigned char)(value >> 16);
+		p[2] = (unsigned char)(value >> 24);
+	}
+}
+
+EXPORT_API void nugu_audio_swap16(void *data, size_t count)
+{
+	uint16_t *samples = data;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+		samples[i] = GUINT16_SWAP_LE_BE(samples[i]);
+}
+
+EXPORT_API void nugu_audio_swap32(void *data, size_t count)
+{
+	uint32_t *samples = data;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+		samples[i] = GUINT32_SWAP_LE_BE(samples[i]);
+}
+
+EXPORT_API void nugu_audio_deinterleave(const float *src, float *const *dest,
+					int channel, size_t frames)
+{
+	size_t i;
+	int ch;
+
+	for (ch = 0; ch < channel; ch++) {
+		float *out = dest[ch];
+
+		for (i = 0; i < frames; i++)
+			out[i] = src[i * channel + ch];
+	}
+}
+
+EXPORT_API void nugu_audio_interleave(const float *const *src, float *dest,
+				      int channel, size_t frames)
+{
+	size_t i;
+	int ch;
+
+	for (ch = 0; ch < channel; ch++) {
+		const float *in = src[ch];
+
+		for (i = 0; i < frames; i++)
+			dest[i * channel + ch] = in[i];
+	}
+}
+
+EXPORT_API void nugu_audio_downmix_float(const float *src, float *dest,
+					 int channel, size_t frames)
+{
+	float scale = 1.0f / channel;
+	size_t i;
+	int ch;
+
+	if (channel == 2) {
+		for (i = 0; i < frames; i++)
+			dest[i] = (src[i * 2] + src[i * 2 + 1]) * 0.5f;
+		return;
+	}
+
+	for (i = 0; i < frames; i++) {
+		float sum = 0.0f;
+
+		for (ch = 0; ch < channel; ch++)
+			sum += src[i * channel + ch];
+
+		dest[i] = sum * scale;
+	}
+}
+
+EXPORT_API void nugu_audio_downmix_s16(const int16_t *src, int16_t *dest,
+				       int channel, size_t frames)
+{
+	size_t i;
+	int ch;
+
+	if (channel == 2) {
+		for (i = 0; i < frames; i++) {
+			int32_t sum = (int32_t)src[i * 2] + src[i * 2 + 1];
+
+			dest[i] = (int16_t)(sum / 2);
+		}
+		return;
+	}
+
+	for (i = 0; i < frames; i++) {
+		int32_t sum = 0;
+
+		for (ch = 0; ch < channel; ch++)
+			sum += src[i * channel + ch];
+
+		dest[i] = (int16_t)(sum / channel);
+	}
+}
+
+/* Generic path: any format to float */
+static void _decode(const struct sample_format *fmt, const unsigned char *src,
+		    float *dest, size_t count)
+{
+	int shift = 32 - fmt->width * 8;
+	float scale = 1.0f / 2147483648.0f;
+	size_t i;
+	int b;
+
+	for (i = 0; i < count; i++) {
+		const unsigned char *p = src + i * fmt->width;
+		uint32_t value = 0;
+
+		if (fmt->is_be) {
+			for (b = 0; b < fmt->width; b++)
+				value = (value << 8) | p[b];
+		} else {
+			for (b = fmt->width - 1; b >= 0; b--)
+				value = (value << 8) | p[b];
+		}
+
+		if (fmt->is_float) {
+			memcpy(dest + i, &value, sizeof(float));
+			continue;
+		}
+
+		/* Left-justify to 32 bits and make it signed */
+		value <<= shift;
+		if (!fmt->is_signed)
+			value ^= 0x80000000U;
+
+		dest[i] = (float)(int32_t)value * scale;
+	}
+}
+
+/* Generic path: float to any format */
+static void _encode(const struct sample_format *fmt, const float *src,
+		    unsigned char *dest, size_t count)
+{
+	int shift = 32 - fmt->width * 8;
+	double max = (double)(1U << (31 - shift));
+	size_t i;
+	int b;
+
+	for (i = 0; i < count; i++) {
+		unsigned char *p = dest + i * fmt->width;
+		uint32_t value;
+
+		if (fmt->is_float) {
+			memcpy(&value, src + i, sizeof(float));
+		} else {
+			double scaled = CLAMP(src[i] * max, -max, max - 1.0);
+
+			value = (uint32_t)(int32_t)lrint(scaled);
+			if (!fmt->is_signed)
+				value ^= 1U << (31 - shift);
+		}
+
+		if (fmt->is_be) {
+			for (b = fmt->width - 1; b >= 0; b--) {
+				p[b] = (unsigned char)value;
+				value >>= 8;
+			}
+		} else {
+			for (b = 0; b < fmt->width; b++) {
+				p[b] = (unsigned char)value;
+				value >>= 8;
+			}
+		}
+	}
+}
+
+/* Copy mono samples to all channels */
+static void _upmix(const float *src, float *dest, int channel, size_t frames)
+{
+	size_t i;
+	int ch;
+
+	for (i = 0; i < frames; i++) {
+		for (ch = 0; ch < channel; ch++)
+			dest[i * channel + ch] = src[i];
+	}
+}
+
+static int _convert_generic(NuguAudioProperty from, const void *src,
+			    NuguAudioProperty to, void *dest, size_t frames)
+{
+	const struct sample_format *in = _formats + from.format;
+	const struct sample_format *out = _formats + to.format;
+	float block[CONVERT_BLOCK_SAMPLES];
+	float mapped[CONVERT_BLOCK_SAMPLES];
+	int channel = MAX(from.channel, to.channel);
+	size_t step;
+	size_t done;
+
+	step = CONVERT_BLOCK_SAMPLES / channel;
+	if (step == 0) {
+		nugu_error("too many channels(%d)", channel);
+		return -1;
+	}
+
+	for (done = 0; done < frames; done += step) {
+		size_t count = MIN(step, frames - done);
+		const float *samples = block;
+
+		_decode(in, (const unsigned char *)src +
+				    done * in->width * from.channel,
+			block, count * from.channel);
+
+		if (to.channel == 1 && from.channel > 1) {
+			nugu_audio_downmix_float(block, block, from.channel,
+						 count);
+		} else if (from.channel == 1 && to.channel > 1) {
+			_upmix(block, mapped, to.channel, count);
+			samples = mapped;
+		}
+
+		_encode(out, samples,
+			(unsigned char *)dest + done * out->width * to.channel,
+			count * to.channel);
+	}
+
+	return 0;
+}
+
+EXPORT_API int nugu_audio_convert(NuguAudioProperty from, const void *src,
+				  NuguAudioProperty to, void *dest,
+				  size_t frames)
+{
+	const struct sample_format *in;
+	const struct sample_format *out;
+	size_t count;
+
+	g_return_val_if_fail(src != NULL, -1);
+	g_return_val_if_fail(dest != NULL, -1);
+	g_return_val_if_fail(from.format < AUDIO_FORMAT_MAX, -1);
+	g_return_val_if_fail(to.format < AUDIO_FORMAT_MAX, -1);
+	g_return_val_if_fail(from.channel > 0 && to.channel > 0, -1);
+
+	if (from.channel != to.channel && from.channel != 1 &&
+	    to.channel != 1) {
+		nugu_error("not support the channel layout(%d -> %d)",
+			   from.channel, to.channel);
+		return -1;
+	}
+
+	in = _formats + from.format;
+	out = _formats + to.format;
+	count = frames * from.channel;
+
+	if (from.channel == to.channel) {
+		if (from.format == to.format) {
+			memcpy(dest, src, count * in->width);
+			return 0;
+		}
+
+		if (from.format == CONVERT_FORMAT_S16 &&
+		    to.format == CONVERT_FORMAT_FLOAT) {
+			nugu_audio_s16_to_float(src, dest, count);
+			return 0;
+		}
+
+		if (from.format == CONVERT_FORMAT_FLOAT &&
+		    to.format == CONVERT_FORMAT_S16) {
+			nugu_audio_float_to_s16(src, dest, count);
+			return 0;
+		}
+
+		if (from.format == AUDIO_FORMAT_S24_LE &&
+		    to.format == CONVERT_FORMAT_S32) {
+			nugu_audio_s24_to_s32(src, dest, count);
+			return 0;
+		}
+
+		if (from.format == CONVERT_FORMAT_S32 &&
+		    to.format == AUDIO_FORMAT_S24_LE) {
+			nugu_audio_s32_to_s24(src, dest, count);
+			return 0;
+		}
+
+		/* Only the byte order is different */
+		if (in->width == out->width &&
+		    in->is_signed == out->is_signed &&
+		    in->is_float == out->is_float &&
+		    (in->width == 2 || in->width == 4)) {
+			memcpy(dest, src, count * in->width);
+			if (in->width == 2)
+				nugu_audio_swap16(dest, count);
+			else
+				nugu_audio_swap32(dest, count);
+			return 0;
+		}
+	} else if (to.channel == 1 && from.format == CONVERT_FORMAT_S16 &&
+		   to.format == CONVERT_FORMAT_S16) {
+		nugu_audio_downmix_s16(src, dest, from.channel, frames);
+		return 0;
+	}
+
+	return _convert_generic(from, src, to, dest, frames);
+}
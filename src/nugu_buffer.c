@@ -25,12 +25,49 @@
 #define CONFIG_DEFAULT_BUFFER_SIZE 1024
 #endif
 
+/**
+ * The valid data is located at data[offset] ~ data[offset + index - 1].
+ * Consuming the data only moves the offset, and the data is moved to the
+ * front (compaction) only when the free space at the end is not enough.
+ * One more byte than alloc_size is allocated to always keep the data
+ * null-terminated.
+ */
 struct _nugu_buffer {
 	size_t alloc_size;
+	size_t offset;
 	size_t index;
 	unsigned char *data;
+	gboolean secure;
 };
 
+static void _buffer_zero(void *ptr, size_t size)
+{
+	volatile unsigned char *pos = ptr;
+
+	/* Not to be optimized out by the compiler */
+	while (size--)
+		*pos++ = 0;
+}
+
+static void _buffer_terminate(NuguBuffer *buf)
+{
+	buf->data[buf->offset + buf->index] = '\0';
+}
+
+static void _buffer_compact(NuguBuffer *buf)
+{
+	if (buf->offset == 0)
+		return;
+
+	memmove(buf->data, buf->data + buf->offset, buf->index);
+
+	if (buf->secure)
+		_buffer_zero(buf->data + buf->index, buf->offset);
+
+	buf->offset = 0;
+	_buffer_terminate(buf);
+}
+
 EXPORT_API NuguBuffer *nugu_buffer_new(size_t default_size)
 {
 	NuguBuffer *buf;
@@ -41,13 +78,14 @@ EXPORT_API NuguBuffer *nugu_buffer_new(size_t default_size)
 		return NULL;
 	}
 
+	buf->offset = 0;
 	buf->index = 0;
 	buf->alloc_size = default_size;
 
 	if (default_size == 0)
 		buf->alloc_size = CONFIG_DEFAULT_BUFFER_SIZE;
 
-	buf->data = calloc(1, buf->alloc_size);
+	buf->data = calloc(1, buf->alloc_size + 1);
 	if (!buf->data) {
 		free(buf);
 		error_nomem();
@@ -62,7 +100,10 @@ EXPORT_API void *nugu_buffer_free(NuguBuffer *buf, gboolean data_free)
 	g_return_val_if_fail(buf != NULL, NULL);
 
 	if (data_free == FALSE) {
-		void *return_data = buf->data;
+		void *return_data;
+
+		_buffer_compact(buf);
+		return_data = buf->data;
 
 		memset(buf, 0, sizeof(struct _nugu_buffer));
 		free(buf);
@@ -70,7 +111,9 @@ EXPORT_API void *nugu_buffer_free(NuguBuffer *buf, gboolean data_free)
 		return return_data;
 	}
 
-	memset(buf->data, 0, buf->alloc_size);
+	if (buf->secure)
+		_buffer_zero(buf->data, buf->alloc_size + 1);
+
 	free(buf->data);
 
 	memset(buf, 0, sizeof(struct _nugu_buffer));
@@ -79,6 +122,15 @@ EXPORT_API void *nugu_buffer_free(NuguBuffer *buf, gboolean data_free)
 	return NULL;
 }
 
+EXPORT_API int nugu_buffer_set_secure(NuguBuffer *buf, gboolean secure)
+{
+	g_return_val_if_fail(buf != NULL, -1);
+
+	buf->secure = secure;
+
+	return 0;
+}
+
 static int _buffer_resize(NuguBuffer *buf, size_t needed)
 {
 	size_t new_size = buf->alloc_size;
@@ -89,7 +141,18 @@ static int _buffer_resize(NuguBuffer *buf, size_t needed)
 	else
 		new_size += buf->alloc_size;
 
-	tmp = realloc(buf->data, new_size);
+	if (buf->secure) {
+		/* realloc() may leave the old data in the freed memory */
+		tmp = malloc(new_size + 1);
+		if (tmp) {
+			memcpy(tmp, buf->data, buf->index + 1);
+			_buffer_zero(buf->data, buf->alloc_size + 1);
+			free(buf->data);
+		}
+	} else {
+		tmp = realloc(buf->data, new_size + 1);
+	}
+
 	if (!tmp) {
 		error_nomem();
 		return -1;
@@ -108,13 +171,18 @@ EXPORT_API size_t nugu_buffer_add(NuguBuffer *buf, const void *data,
 	g_return_val_if_fail(data != NULL, -1);
 	g_return_val_if_fail(data_len > 0, -1);
 
-	if (buf->alloc_size - buf->index < data_len) {
-		if (_buffer_resize(buf, data_len) < 0)
-			return -1;
+	if (buf->alloc_size - buf->offset - buf->index < data_len) {
+		_buffer_compact(buf);
+
+		if (buf->alloc_size - buf->index < data_len) {
+			if (_buffer_resize(buf, data_len) < 0)
+				return -1;
+		}
 	}
 
-	memcpy(buf->data + buf->index, data, data_len);
+	memcpy(buf->data + buf->offset + buf->index, data, data_len);
 	buf->index += data_len;
+	_buffer_terminate(buf);
 
 	return data_len;
 }
@@ -123,7 +191,7 @@ EXPORT_API const void *nugu_buffer_peek(NuguBuffer *buf)
 {
 	g_return_val_if_fail(buf != NULL, NULL);
 
-	return buf->data;
+	return buf->data + buf->offset;
 }
 
 EXPORT_API size_t nugu_buffer_get_size(NuguBuffer *buf)
@@ -140,19 +208,52 @@ EXPORT_API size_t nugu_buffer_get_alloc_size(NuguBuffer *buf)
 	return buf->alloc_size;
 }
 
-EXPORT_API size_t nugu_buffer_find_byte(NuguBuffer *buf, unsigned char want)
+EXPORT_API size_t nugu_buffer_search_byte(const void *data, size_t length,
+					  unsigned char want)
 {
-	unsigned char *pos;
-	unsigned char *last_pos;
+	const unsigned char *pos;
 
-	g_return_val_if_fail(buf != NULL, -1);
+	g_return_val_if_fail(data != NULL, NOT_FOUND);
 
-	pos = buf->data;
-	last_pos = buf->data + buf->index;
+	/* memchr() of libc is optimized by SIMD instructions */
+	pos = memchr(data, want, length);
+	if (!pos)
+		return NOT_FOUND;
 
-	while (pos != last_pos) {
-		if (*pos == want)
-			return pos - buf->data;
+	return pos - (const unsigned char *)data;
+}
+
+EXPORT_API size_t nugu_buffer_search(const void *data, size_t length,
+				     const void *want, size_t want_len)
+{
+	const unsigned char *start = data;
+	const unsigned char *pattern = want;
+	const unsigned char *pos;
+	const unsigned char *last;
+
+	g_return_val_if_fail(data != NULL, NOT_FOUND);
+	g_return_val_if_fail(want != NULL, NOT_FOUND);
+
+	if (want_len == 0 || want_len > length)
+		return NOT_FOUND;
+
+	if (want_len == 1)
+		return nugu_buffer_search_byte(data, length, pattern[0]);
+
+	/*
+	 * Find the candidates by the first byte using memchr(), and filter
+	 * them by the last byte before comparing the whole pattern.
+	 */
+	pos = start;
+	last = start + length - want_len;
+	while (pos <= last) {
+		pos = memchr(pos, pattern[0], last - pos + 1);
+		if (!pos)
+			break;
+
+		if (pos[want_len - 1] == pattern[want_len - 1] &&
+		    memcmp(pos + 1, pattern + 1, want_len - 2) == 0)
+			return pos - start;
 
 		pos++;
 	}
@@ -160,6 +261,24 @@ EXPORT_API size_t nugu_buffer_find_byte(NuguBuffer *buf, unsigned char want)
 	return NOT_FOUND;
 }
 
+EXPORT_API size_t nugu_buffer_find_byte(NuguBuffer *buf, unsigned char want)
+{
+	g_return_val_if_fail(buf != NULL, NOT_FOUND);
+
+	return nugu_buffer_search_byte(buf->data + buf->offset, buf->index,
+				       want);
+}
+
+EXPORT_API size_t nugu_buffer_find_bytes(NuguBuffer *buf, const void *want,
+					 size_t want_len)
+{
+	g_return_val_if_fail(buf != NULL, NOT_FOUND);
+	g_return_val_if_fail(want != NULL, NOT_FOUND);
+
+	return nugu_buffer_search(buf->data + buf->offset, buf->index, want,
+				  want_len);
+}
+
 EXPORT_API unsigned char nugu_buffer_peek_byte(NuguBuffer *buf, size_t pos)
 {
 	g_return_val_if_fail(buf != NULL, 0);
@@ -167,16 +286,19 @@ EXPORT_API unsigned char nugu_buffer_peek_byte(NuguBuffer *buf, size_t pos)
 	if (pos >= buf->index)
 		return 0;
 
-	return *(buf->data + pos);
+	return *(buf->data + buf->offset + pos);
 }
 
 EXPORT_API int nugu_buffer_clear(NuguBuffer *buf)
 {
 	g_return_val_if_fail(buf != NULL, -1);
 
-	memset(buf->data, 0, buf->alloc_size);
+	if (buf->secure)
+		_buffer_zero(buf->data, buf->alloc_size + 1);
 
+	buf->offset = 0;
 	buf->index = 0;
+	_buffer_terminate(buf);
 
 	return 0;
 }
@@ -186,38 +308,27 @@ EXPORT_API int nugu_buffer_clear_from(NuguBuffer *buf, size_t pos)
 	g_return_val_if_fail(buf != NULL, -1);
 	g_return_val_if_fail(pos <= buf->index, -1);
 
-	memset(buf->data + pos, 0, buf->alloc_size - pos);
+	if (buf->secure)
+		_buffer_zero(buf->data + buf->offset + pos, buf->index - pos);
 
-	buf->index = buf->index - (buf->index - pos);
+	buf->index = pos;
+	_buffer_terminate(buf);
 
 	return 0;
 }
 
 EXPORT_API int nugu_buffer_shift_left(NuguBuffer *buf, size_t size)
 {
-	unsigned char *dst;
-	unsigned char *src;
-
 	g_return_val_if_fail(buf != NULL, -1);
 
 	if (size >= buf->index)
 		return nugu_buffer_clear(buf);
 
-	dst = buf->data;
-	src = buf->data + size;
-
-	while (src != buf->data + buf->index) {
-		*dst = *src;
-		src++;
-		dst++;
-	}
-
-	while (dst != buf->data + buf->index) {
-		*dst = '\0';
-		dst++;
-	}
+	if (buf->secure)
+		_buffer_zero(buf->data + buf->offset, size);
 
-	buf->index = buf->index - size;
+	buf->offset += size;
+	buf->index -= size;
 
 	return 0;
 }
@@ -237,7 +348,7 @@ EXPORT_API void *nugu_buffer_pop(NuguBuffer *buf, size_t size)
 		return NULL;
 	}
 
-	memcpy(tmp, buf->data, size);
+	memcpy(tmp, buf->data + buf->offset, size);
 	tmp[size] = '\0';
 	nugu_buffer_shift_left(buf, size);
 
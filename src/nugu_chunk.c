@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <glib.h>
+
+#include "nugu_log.h"
+#include "nugu_pool.h"
+#include "nugu_chunk.h"
+
+#ifndef CONFIG_DEFAULT_CHUNK_SIZE
+#define CONFIG_DEFAULT_CHUNK_SIZE 4096
+#endif
+
+#define DEFAULT_SEGMENTS 4
+
+/**
+ * Reference counted memory block.
+ *
+ * Only the chain that holds the block as 'tail' can write the data after
+ * 'used', so the data before 'used' is never changed and can be shared.
+ */
+struct chunk_block {
+	int ref_count;
+	size_t capacity;
+	size_t used;
+	unsigned char *data;
+	int external;
+};
+
+struct chunk_segment {
+	struct chunk_block *block;
+	size_t offset;
+	size_t length;
+};
+
+struct _nugu_chunk_chain {
+	struct chunk_segment *segs;
+	int count;
+	int alloc_count;
+	size_t size;
+
+	/* writable block */
+	struct chunk_block *tail;
+
+	/* used as 'segs' until more segments are needed */
+	struct chunk_segment inline_segs[DEFAULT_SEGMENTS];
+};
+
+static NuguPool *_chain_pool;
+static pthread_mutex_t _chain_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *_chain_alloc(void)
+{
+	void *item = NULL;
+
+	pthread_mutex_lock(&_chain_pool_lock);
+
+	if (!_chain_pool)
+		_chain_pool =
+			nugu_pool_new(sizeof(struct _nugu_chunk_chain), 0);
+
+	if (_chain_pool)
+		item = nugu_pool_alloc(_chain_pool);
+
+	pthread_mutex_unlock(&_chain_pool_lock);
+
+	return item;
+}
+
+EXPORT_API void nugu_chunk_chain_pool_deinit(void)
+{
+	NuguPoolStats stats;
+
+	pthread_mutex_lock(&_chain_pool_lock);
+
+	if (_chain_pool && nugu_pool_get_stats(_chain_pool, &stats) == 0) {
+		/* The chains in use are still referred by the owners */
+		if (stats.in_use > 0) {
+			nugu_dbg("%d chains are still in use", stats.in_use);
+		} else {
+			nugu_pool_free(_chain_pool);
+			_chain_pool = NULL;
+		}
+	}
+
+	pthread_mutex_unlock(&_chain_pool_lock);
+}
+
+EXPORT_API int nugu_chunk_chain_get_pool_stats(NuguPoolStats *stats)
+{
+	int ret = 0;
+
+	g_return_val_if_fail(stats != NULL, -1);
+
+	pthread_mutex_lock(&_chain_pool_lock);
+
+	if (_chain_pool)
+		ret = nugu_pool_get_stats(_chain_pool, stats);
+	else
+		memset(stats, 0, sizeof(NuguPoolStats));
+
+	pthread_mutex_unlock(&_chain_pool_lock);
+
+	return ret;
+}
+
+static struct chunk_block *_block_new(size_t capacity)
+{
+	struct chunk_block *block;
+
+	block = malloc(sizeof(struct chunk_block) + capacity);
+	if (!block) {
+		error_nomem();
+		return NULL;
+	}
+
+	block->ref_count = 1;
+	block->capacity = capacity;
+	block->used = 0;
+	block->data = (unsigned char *)(block + 1);
+	block->external = 0;
+
+	return block;
+}
+
+static struct chunk_block *_block_new_take(void *data, size_t length)
+{
+	struct chunk_block *block;
+
+	block = malloc(sizeof(struct chunk_block));
+	if (!block) {
+		error_nomem();
+		return NULL;
+	}
+
+	block->ref_count = 1;
+	block->capacity = length;
+	block->used = length;
+	block->data = data;
+	block->external = 1;
+
+	return block;
+}
+
+static struct chunk_block *_block_ref(struct chunk_block *block)
+{
+	g_atomic_int_inc(&block->ref_count);
+
+	return block;
+}
+
+static void _block_unref(struct chunk_block *block)
+{
+	if (!g_atomic_int_dec_and_test(&block->ref_count))
+		return;
+
+	if (block->external)
+		free(block->data);
+
+	free(block);
+}
+
+static int _chain_grow(NuguChunkChain *chain, int needed)
+{
+	struct chunk_segment *tmp;
+	int new_count;
+
+	if (chain->count + needed <= chain->alloc_count)
+		return 0;
+
+	new_count = chain->alloc_count * 2;
+	if (new_count < chain->count + needed)
+		new_count = chain->count + needed;
+
+	if (chain->segs == chain->inline_segs) {
+		tmp = malloc(sizeof(struct chunk_segment) * new_count);
+		if (tmp)
+			memcpy(tmp, chain->segs,
+			       sizeof(struct chunk_segment) * chain->count);
+	} else {
+		tmp = realloc(chain->segs,
+			      sizeof(struct chunk_segment) * new_count);
+	}
+
+	if (!tmp) {
+		error_nomem();
+		return -1;
+	}
+
+	chain->segs = tmp;
+	chain->alloc_count = new_count;
+
+	return 0;
+}
+
+/* The chain takes the reference of the block */
+static int _chain_push(NuguChunkChain *chain, struct chunk_block *block,
+		       size_t offset, size_t length)
+{
+	struct chunk_segment *seg;
+
+	if (_chain_grow(chain, 1) < 0)
+		return -1;
+
+	seg = chain->segs + chain->count;
+	seg->block = block;
+	seg->offset = offset;
+	seg->length = length;
+
+	chain->count++;
+	chain->size += length;
+
+	return 0;
+}
+
+EXPORT_API NuguChunkChain *nugu_chunk_chain_new(void)
+{
+	NuguChunkChain *chain;
+
+	chain = _chain_alloc();
+	if (!chain)
+		return NULL;
+
+	chain->segs = chain->inline_segs;
+	chain->alloc_count = DEFAULT_SEGMENTS;
+
+	return chain;
+}
+
+EXPORT_API void nugu_chunk_chain_free(NuguChunkChain *chain)
+{
+	g_return_if_fail(chain != NULL);
+
+	nugu_chunk_chain_clear(chain);
+
+	if (chain->tail)
+		_block_unref(chain->tail);
+
+	if (chain->segs != chain->inline_segs)
+		free(chain->segs);
+
+	nugu_pool_release(_chain_pool, chain);
+}
+
+EXPORT_API int nugu_chunk_chain_reserve(NuguChunkChain *chain, size_t size)
+{
+	struct chunk_block *block;
+
+	g_return_val_if_fail(chain != NULL, -1);
+
+	if (chain->tail && chain->tail->capacity - chain->tail->used >= size)
+		return 0;
+
+	block = _block_new(size);
+	if (!block)
+		return -1;
+
+	if (chain->tail)
+		_block_unref(chain->tail);
+
+	chain->tail = block;
+
+	return 0;
+}
+
+EXPORT_API int nugu_chunk_chain_add(NuguChunkChain *chain, const void *data,
+				    size_t length)
+{
+	struct chunk_block *block;
+	struct chunk_segment *last;
+
+	g_return_val_if_fail(chain != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(length > 0, -1);
+
+	/* Do not split the data to keep it contiguous */
+	if (!chain->tail || chain->tail->capacity - chain->tail->used < length) {
+		if (nugu_chunk_chain_reserve(chain,
+					     MAX(length,
+						 CONFIG_DEFAULT_CHUNK_SIZE)) < 0)
+			return -1;
+	}
+
+	block = chain->tail;
+	memcpy(block->data + block->used, data, length);
+
+	/* Extend the last segment if the data is contiguous */
+	last = chain->count > 0 ? chain->segs + chain->count - 1 : NULL;
+	if (last && last->block == block &&
+	    last->offset + last->length == block->used) {
+		last->length += length;
+		chain->size += length;
+		block->used += length;
+		return 0;
+	}
+
+	if (_chain_push(chain, _block_ref(block), block->used, length) < 0) {
+		_block_unref(block);
+		return -1;
+	}
+
+	block->used += length;
+
+	return 0;
+}
+
+EXPORT_API int nugu_chunk_chain_add_take(NuguChunkChain *chain, void *data,
+					 size_t length)
+{
+	struct chunk_block *block;
+
+	g_return_val_if_fail(chain != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(length > 0, -1);
+
+	block = _block_new_take(data, length);
+	if (!block)
+		return -1;
+
+	if (_chain_push(chain, block, 0, length) < 0) {
+		/* The data is still owned by the caller */
+		free(block);
+		return -1;
+	}
+
+	return 0;
+}
+
+EXPORT_API int nugu_chunk_chain_append(NuguChunkChain *dest,
+				       NuguChunkChain *src)
+{
+	int i;
+
+	g_return_val_if_fail(dest != NULL, -1);
+	g_return_val_if_fail(src != NULL, -1);
+	g_return_val_if_fail(dest != src, -1);
+
+	if (_chain_grow(dest, src->count) < 0)
+		return -1;
+
+	for (i = 0; i < src->count; i++) {
+		struct chunk_segment *seg = src->segs + i;
+
+		_chain_push(dest, _block_ref(seg->block), seg->offset,
+			    seg->length);
+	}
+
+	return 0;
+}
+
+EXPORT_API size_t nugu_chunk_chain_get_size(NuguChunkChain *chain)
+{
+	g_return_val_if_fail(chain != NULL, 0);
+
+	return chain->size;
+}
+
+EXPORT_API int nugu_chunk_chain_get_count(NuguChunkChain *chain)
+{
+	g_return_val_if_fail(chain != NULL, -1);
+
+	return chain->count;
+}
+
+EXPORT_API const void *nugu_chunk_chain_peek(NuguChunkChain *chain, int index,
+					     size_t *length)
+{
+	struct chunk_segment *seg;
+
+	g_return_val_if_fail(chain != NULL, NULL);
+	g_return_val_if_fail(index >= 0 && index < chain->count, NULL);
+
+	seg = chain->segs + index;
+	if (length)
+		*length = seg->length;
+
+	return seg->block->data + seg->offset;
+}
+
+EXPORT_API int nugu_chunk_chain_get_iovec(NuguChunkChain *chain,
+					  struct iovec *iov, int max_count)
+{
+	int i;
+
+	g_return_val_if_fail(chain != NULL, -1);
+	g_return_val_if_fail(iov != NULL, -1);
+
+	for (i = 0; i < chain->count && i < max_count; i++) {
+		iov[i].iov_base = chain->segs[i].block->data +
+				  chain->segs[i].offset;
+		iov[i].iov_len = chain->segs[i].length;
+	}
+
+	return i;
+}
+
+EXPORT_API int nugu_chunk_chain_truncate(NuguChunkChain *chain, size_t size)
+{
+	size_t remain = size;
+	int i;
+
+	g_return_val_if_fail(chain != NULL, -1);
+
+	if (size >= chain->size)
+		return 0;
+
+	for (i = 0; i < chain->count; i++) {
+		if (remain <= chain->segs[i].length)
+			break;
+
+		remain -= chain->segs[i].length;
+	}
+
+	/* segs[i] is the last segment to keep */
+	chain->segs[i].length = remain;
+	if (remain > 0)
+		i++;
+
+	while (chain->count > i) {
+		chain->count--;
+		_block_unref(chain->segs[chain->count].block);
+	}
+
+	chain->size = size;
+
+	return 0;
+}
+
+EXPORT_API int nugu_chunk_chain_linearize(NuguChunkChain *chain)
+{
+	struct chunk_block *block;
+	int i;
+
+	g_return_val_if_fail(chain != NULL, -1);
+
+	if (chain->count <= 1)
+		return 0;
+
+	block = _block_new(chain->size);
+	if (!block)
+		return -1;
+
+	for (i = 0; i < chain->count; i++) {
+		struct chunk_segment *seg = chain->segs + i;
+
+		memcpy(block->data + block->used, seg->block->data + seg->offset,
+		       seg->length);
+		block->used += seg->length;
+		_block_unref(seg->block);
+	}
+
+	chain->count = 0;
+	chain->size = 0;
+	_chain_push(chain, block, 0, block->used);
+
+	return 0;
+}
+
+EXPORT_API void *nugu_chunk_chain_flatten(NuguChunkChain *chain,
+					  size_t *length)
+{
+	unsigned char *buf;
+	size_t pos = 0;
+	int i;
+
+	g_return_val_if_fail(chain != NULL, NULL);
+
+	if (length)
+		*length = chain->size;
+
+	if (chain->size == 0)
+		return NULL;
+
+	buf = malloc(chain->size + 1);
+	if (!buf) {
+		error_nomem();
+		return NULL;
+	}
+
+	for (i = 0; i < chain->count; i++) {
+		struct chunk_segment *seg = chain->segs + i;
+
+		memcpy(buf + pos, seg->block->data + seg->offset, seg->length);
+		pos += seg->length;
+	}
+
+	buf[pos] = '\0';
+
+	return buf;
+}
+
+EXPORT_API void nugu_chunk_chain_clear(NuguChunkChain *chain)
+{
+	int i;
+
+	g_return_if_fail(chain != NULL);
+
+	for (i = 0; i < chain->count; i++)
+		_block_unref(chain->segs[i].block);
+
+	chain->count = 0;
+	chain->size = 0;
+}
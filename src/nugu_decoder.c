@@ -14,21 +14,49 @@
  * limitations under the License.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <glib.h>
 
 #include "nugu_log.h"
 #include "nugu_decoder.h"
 
 #define DEFAULT_DECODE_BUFFER_SIZE 65536
+#define DECODER_POOL_MAX 4
+
+enum decoder_job_type {
+	DECODER_JOB_DATA, /* decode the data and push to the pcm */
+	DECODER_JOB_DONE, /* all data is pushed */
+	DECODER_JOB_EXIT /* exit the worker */
+};
+
+struct decoder_job {
+	enum decoder_job_type type;
+	gint seq;
+	size_t length;
+	unsigned char *data;
+};
 
 struct _nugu_decoder {
 	NuguDecoderDriver *driver;
 	NuguPcm *pcm;
 	NuguBuffer *buf;
 	void *userdata;
+	int pool_rate; /* sample rate of the sink: key of the decoder pool */
+
+	/**
+	 * Worker thread decoding the queued jobs to the pcm.
+	 *  - seq: jobs queued before the last cancel have an old sequence
+	 *  - worker_lock: held by the worker while running a job
+	 */
+	GAsyncQueue *jobs;
+	pthread_t worker;
+	int has_worker;
+	gint seq;
+	pthread_mutex_t worker_lock;
 };
 
 struct _nugu_decoder_driver {
@@ -40,6 +68,20 @@ struct _nugu_decoder_driver {
 
 static GList *_decoder_drivers;
 
+/* Idle decoders returned by nugu_decoder_pool_put() */
+static GList *_decoder_pool;
+static pthread_mutex_t _decoder_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int _get_sink_rate(NuguPcm *pcm)
+{
+	NuguAudioProperty property;
+
+	if (!pcm || nugu_pcm_get_property(pcm, &property) < 0)
+		return -1;
+
+	return property.samplerate;
+}
+
 EXPORT_API NuguDecoderDriver *
 nugu_decoder_driver_new(const char *name, enum decoder_type type,
 			struct nugu_decoder_driver_ops *ops)
@@ -141,10 +183,12 @@ EXPORT_API NuguDecoder *nugu_decoder_new(NuguDecoderDriver *driver,
 
 	g_return_val_if_fail(driver != NULL, NULL);
 
-	dec = malloc(sizeof(struct _nugu_decoder));
+	dec = calloc(1, sizeof(struct _nugu_decoder));
 	dec->driver = driver;
 	dec->pcm = sink;
 	dec->buf = nugu_buffer_new(DEFAULT_DECODE_BUFFER_SIZE);
+	dec->pool_rate = _get_sink_rate(sink);
+	pthread_mutex_init(&dec->worker_lock, NULL);
 
 	driver->ref_count++;
 
@@ -155,6 +199,9 @@ EXPORT_API NuguDecoder *nugu_decoder_new(NuguDecoderDriver *driver,
 		return dec;
 
 	driver->ref_count--;
+	if (dec->buf)
+		nugu_buffer_free(dec->buf, TRUE);
+	pthread_mutex_destroy(&dec->worker_lock);
 	memset(dec, 0, sizeof(struct _nugu_decoder));
 	free(dec);
 
@@ -165,6 +212,8 @@ EXPORT_API int nugu_decoder_free(NuguDecoder *dec)
 {
 	g_return_val_if_fail(dec != NULL, -1);
 
+	nugu_decoder_stop(dec);
+
 	if (dec->driver->ops->destroy &&
 	    dec->driver->ops->destroy(dec->driver, dec) < 0)
 		return -1;
@@ -174,6 +223,8 @@ EXPORT_API int nugu_decoder_free(NuguDecoder *dec)
 	if (dec->buf)
 		nugu_buffer_free(dec->buf, TRUE);
 
+	pthread_mutex_destroy(&dec->worker_lock);
+
 	memset(dec, 0, sizeof(struct _nugu_decoder));
 	free(dec);
 
@@ -187,13 +238,76 @@ EXPORT_API NuguPcm *nugu_decoder_get_pcm(NuguDecoder *dec)
 	return dec->pcm;
 }
 
-EXPORT_API int nugu_decoder_play(NuguDecoder *dec, const void *data,
-				 size_t data_len)
+/* The state carried from the previous data is dropped */
+static int _decoder_reset(NuguDecoder *dec)
+{
+	if (dec->driver->ops->reset &&
+	    dec->driver->ops->reset(dec->driver, dec) < 0) {
+		nugu_error("reset failed");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Decode the data straight into the ring of pcm. The rest which does not
+ * fit in the ring is decoded through the buffer and pushed to the pcm.
+ */
+static int _decoder_push_pcm(NuguDecoder *dec, const unsigned char *data,
+			     size_t length)
 {
-	int ret;
 	void *out;
-	size_t out_length;
+	size_t size;
+	size_t consumed;
+	int ret = 0;
+
+	while (length > 0 && dec->driver->ops->decode_into) {
+		out = nugu_pcm_reserve_data(dec->pcm, &size);
+		if (!out)
+			break;
+
+		consumed = 0;
+		ret = dec->driver->ops->decode_into(dec->driver, dec, data,
+						    length, out, size,
+						    &consumed);
+		nugu_pcm_commit_data(dec->pcm, ret > 0 ? ret : 0);
+		if (ret < 0)
+			return -1;
+
+		/* The space is too small for a frame */
+		if (consumed == 0)
+			break;
+
+		data += consumed;
+		length -= consumed;
+	}
+
+	if (length == 0)
+		return 0;
+
+	nugu_buffer_clear(dec->buf);
+
+	if (dec->driver->ops->decode(dec->driver, dec, data, length,
+				     dec->buf) != 0)
+		return -1;
+
+	ret = 0;
+	size = nugu_buffer_get_size(dec->buf);
+	if (size > 0 &&
+	    nugu_pcm_push_data(dec->pcm,
+			       (const char *)nugu_buffer_peek(dec->buf), size,
+			       0) < 0)
+		ret = -1;
+
+	nugu_buffer_clear(dec->buf);
 
+	return ret;
+}
+
+EXPORT_API int nugu_decoder_play(NuguDecoder *dec, const void *data,
+				 size_t data_len)
+{
 	g_return_val_if_fail(dec != NULL, -1);
 	g_return_val_if_fail(data != NULL, -1);
 	g_return_val_if_fail(data_len > 0, -1);
@@ -204,27 +318,15 @@ EXPORT_API int nugu_decoder_play(NuguDecoder *dec, const void *data,
 		return -1;
 	}
 
-	ret = dec->driver->ops->decode(dec->driver, dec, data, data_len,
-				       dec->buf);
-	if (ret != 0)
-		return -1;
-
-	if (!dec->pcm)
-		return ret;
-
-	out_length = nugu_buffer_get_size(dec->buf);
-	out = nugu_buffer_pop(dec->buf, 0);
-	if (!out)
-		return -1;
+	if (!dec->pcm) {
+		if (dec->driver->ops->decode(dec->driver, dec, data, data_len,
+					     dec->buf) != 0)
+			return -1;
 
-	if (nugu_pcm_push_data(dec->pcm, out, out_length, 0) < 0) {
-		free(out);
-		return -1;
+		return 0;
 	}
 
-	free(out);
-
-	return 0;
+	return _decoder_push_pcm(dec, data, data_len);
 }
 
 EXPORT_API void *nugu_decoder_decode(NuguDecoder *dec, const void *data,
@@ -258,6 +360,278 @@ EXPORT_API void *nugu_decoder_decode(NuguDecoder *dec, const void *data,
 	return out;
 }
 
+EXPORT_API int nugu_decoder_decode_into(NuguDecoder *dec, const void *data,
+				       size_t data_len, void *out,
+				       size_t out_size, size_t *consumed)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(data_len > 0, -1);
+	g_return_val_if_fail(out != NULL, -1);
+	g_return_val_if_fail(consumed != NULL, -1);
+	g_return_val_if_fail(dec->driver != NULL, -1);
+
+	if (dec->driver->ops->decode_into == NULL) {
+		nugu_error("Not supported");
+		return -1;
+	}
+
+	*consumed = 0;
+
+	return dec->driver->ops->decode_into(dec->driver, dec, data, data_len,
+					     out, out_size, consumed);
+}
+
+static void _decoder_run_job(NuguDecoder *dec, struct decoder_job *job)
+{
+	if (job->type == DECODER_JOB_DONE) {
+		_decoder_reset(dec);
+		nugu_pcm_push_data_done(dec->pcm);
+		return;
+	}
+
+	if (_decoder_push_pcm(dec, job->data, job->length) < 0)
+		nugu_error("decode failed");
+}
+
+static void *_decoder_worker(void *data)
+{
+	NuguDecoder *dec = data;
+	struct decoder_job *job;
+
+	while (1) {
+		job = g_async_queue_pop(dec->jobs);
+		if (job->type == DECODER_JOB_EXIT) {
+			g_free(job);
+			break;
+		}
+
+		/* The jobs queued before the last cancel are discarded */
+		pthread_mutex_lock(&dec->worker_lock);
+		if (job->seq == g_atomic_int_get(&dec->seq))
+			_decoder_run_job(dec, job);
+		pthread_mutex_unlock(&dec->worker_lock);
+
+		g_free(job);
+	}
+
+	return NULL;
+}
+
+static int _decoder_queue_job(NuguDecoder *dec, enum decoder_job_type type,
+			      const void *data, size_t length)
+{
+	struct decoder_job *job;
+
+	if (!dec->has_worker) {
+		nugu_error("worker is not started");
+		return -1;
+	}
+
+	/* The data is copied after the job in one allocation */
+	job = g_malloc(sizeof(struct decoder_job) + length);
+	job->type = type;
+	job->seq = g_atomic_int_get(&dec->seq);
+	job->length = length;
+	job->data = (unsigned char *)(job + 1);
+	if (length > 0)
+		memcpy(job->data, data, length);
+
+	g_async_queue_push(dec->jobs, job);
+
+	return 0;
+}
+
+EXPORT_API int nugu_decoder_start(NuguDecoder *dec)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+	g_return_val_if_fail(dec->pcm != NULL, -1);
+	g_return_val_if_fail(dec->driver != NULL, -1);
+
+	if (dec->has_worker) {
+		nugu_dbg("already started");
+		return 0;
+	}
+
+	if (dec->driver->ops->decode == NULL) {
+		nugu_error("Not supported");
+		return -1;
+	}
+
+	dec->jobs = g_async_queue_new();
+
+	if (pthread_create(&dec->worker, NULL, _decoder_worker, dec) != 0) {
+		nugu_error("pthread_create() failed.");
+		g_async_queue_unref(dec->jobs);
+		dec->jobs = NULL;
+		return -1;
+	}
+
+	if (pthread_setname_np(dec->worker, "decoder") != 0)
+		nugu_error("pthread_setname_np() failed");
+
+	dec->has_worker = 1;
+
+	return 0;
+}
+
+EXPORT_API int nugu_decoder_stop(NuguDecoder *dec)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+
+	if (!dec->has_worker)
+		return 0;
+
+	/* The queued jobs are discarded */
+	g_atomic_int_inc(&dec->seq);
+	_decoder_queue_job(dec, DECODER_JOB_EXIT, NULL, 0);
+	pthread_join(dec->worker, NULL);
+
+	g_async_queue_unref(dec->jobs);
+	dec->jobs = NULL;
+	dec->has_worker = 0;
+
+	return _decoder_reset(dec);
+}
+
+EXPORT_API int nugu_decoder_push(NuguDecoder *dec, const void *data,
+				 size_t data_len)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(data_len > 0, -1);
+
+	return _decoder_queue_job(dec, DECODER_JOB_DATA, data, data_len);
+}
+
+EXPORT_API int nugu_decoder_push_done(NuguDecoder *dec)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+
+	return _decoder_queue_job(dec, DECODER_JOB_DONE, NULL, 0);
+}
+
+/* Discard the queued jobs and reset the driver */
+static int _decoder_discard(NuguDecoder *dec)
+{
+	int ret;
+
+	g_atomic_int_inc(&dec->seq);
+
+	/* Wait for the job which may be running with the old sequence */
+	pthread_mutex_lock(&dec->worker_lock);
+	ret = _decoder_reset(dec);
+	pthread_mutex_unlock(&dec->worker_lock);
+
+	return ret;
+}
+
+EXPORT_API int nugu_decoder_cancel(NuguDecoder *dec)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+
+	if (!dec->has_worker)
+		return 0;
+
+	_decoder_discard(dec);
+
+	return 0;
+}
+
+EXPORT_API int nugu_decoder_reset(NuguDecoder *dec)
+{
+	g_return_val_if_fail(dec != NULL, -1);
+
+	if (dec->has_worker)
+		return _decoder_discard(dec);
+
+	nugu_buffer_clear(dec->buf);
+
+	return _decoder_reset(dec);
+}
+
+EXPORT_API NuguDecoder *nugu_decoder_pool_get(NuguDecoderDriver *driver,
+					      NuguPcm *sink)
+{
+	NuguDecoder *dec = NULL;
+	int rate = _get_sink_rate(sink);
+	GList *cur;
+
+	g_return_val_if_fail(driver != NULL, NULL);
+
+	pthread_mutex_lock(&_decoder_pool_lock);
+
+	for (cur = _decoder_pool; cur; cur = cur->next) {
+		NuguDecoder *item = cur->data;
+
+		if (item->driver == driver && item->pool_rate == rate) {
+			dec = item;
+			_decoder_pool = g_list_delete_link(_decoder_pool, cur);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&_decoder_pool_lock);
+
+	if (!dec)
+		return nugu_decoder_new(driver, sink);
+
+	dec->pcm = sink;
+
+	return dec;
+}
+
+EXPORT_API int nugu_decoder_pool_put(NuguDecoder *dec)
+{
+	int ret;
+
+	g_return_val_if_fail(dec != NULL, -1);
+
+	/* The stopped worker also resets the decoder */
+	if (dec->has_worker)
+		ret = nugu_decoder_stop(dec);
+	else
+		ret = nugu_decoder_reset(dec);
+
+	/* The decoder in an unknown state is not reused */
+	if (ret < 0) {
+		nugu_decoder_free(dec);
+		return -1;
+	}
+
+	dec->pcm = NULL;
+
+	pthread_mutex_lock(&_decoder_pool_lock);
+
+	if (g_list_length(_decoder_pool) < DECODER_POOL_MAX) {
+		_decoder_pool = g_list_prepend(_decoder_pool, dec);
+		dec = NULL;
+	}
+
+	pthread_mutex_unlock(&_decoder_pool_lock);
+
+	if (dec)
+		return nugu_decoder_free(dec);
+
+	return 0;
+}
+
+EXPORT_API void nugu_decoder_pool_clear(void)
+{
+	GList *list;
+	GList *cur;
+
+	pthread_mutex_lock(&_decoder_pool_lock);
+	list = _decoder_pool;
+	_decoder_pool = NULL;
+	pthread_mutex_unlock(&_decoder_pool_lock);
+
+	for (cur = list; cur; cur = cur->next)
+		nugu_decoder_free(cur->data);
+
+	g_list_free(list);
+}
+
 EXPORT_API int nugu_decoder_set_userdata(NuguDecoder *dec, void *userdata)
 {
 	g_return_val_if_fail(dec != NULL, -1);
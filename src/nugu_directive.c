@@ -17,13 +17,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <glib.h>
 
 #include "nugu_log.h"
+#include "nugu_pool.h"
 #include "nugu_directive.h"
-#include "nugu_buffer.h"
+#include "nugu_chunk.h"
 
+/**
+ * All strings of the directive are stored in the 'strings' memory, and the
+ * directive object is allocated from the pool.
+ */
 struct _nugu_directive {
+	char *strings;
 	char *name_space;
 	char *name;
 	char *version;
@@ -35,17 +42,88 @@ struct _nugu_directive {
 	int is_end;
 
 	char *media_type;
-	NuguBuffer *buf;
+	NuguChunkChain *chunks;
 	DirectiveDataCallback callback;
 	void *callback_userdata;
 };
 
+static NuguPool *_directive_pool;
+static pthread_mutex_t _directive_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *_directive_alloc(void)
+{
+	void *item = NULL;
+
+	pthread_mutex_lock(&_directive_pool_lock);
+
+	if (!_directive_pool)
+		_directive_pool = nugu_pool_new(sizeof(NuguDirective), 0);
+
+	if (_directive_pool)
+		item = nugu_pool_alloc(_directive_pool);
+
+	pthread_mutex_unlock(&_directive_pool_lock);
+
+	return item;
+}
+
+EXPORT_API void nugu_directive_pool_deinit(void)
+{
+	NuguPoolStats stats;
+
+	pthread_mutex_lock(&_directive_pool_lock);
+
+	if (_directive_pool &&
+	    nugu_pool_get_stats(_directive_pool, &stats) == 0) {
+		/* The directives can be still held by the sequencer */
+		if (stats.in_use > 0) {
+			nugu_dbg("%d directives are still in use",
+				 stats.in_use);
+		} else {
+			nugu_pool_free(_directive_pool);
+			_directive_pool = NULL;
+		}
+	}
+
+	pthread_mutex_unlock(&_directive_pool_lock);
+}
+
+EXPORT_API int nugu_directive_get_pool_stats(NuguPoolStats *stats)
+{
+	int ret = 0;
+
+	g_return_val_if_fail(stats != NULL, -1);
+
+	pthread_mutex_lock(&_directive_pool_lock);
+
+	if (_directive_pool)
+		ret = nugu_pool_get_stats(_directive_pool, stats);
+	else
+		memset(stats, 0, sizeof(NuguPoolStats));
+
+	pthread_mutex_unlock(&_directive_pool_lock);
+
+	return ret;
+}
+
+static char *_copy_string(char **pos, const char *src, size_t length)
+{
+	char *dest = *pos;
+
+	memcpy(dest, src, length + 1);
+	*pos += length + 1;
+
+	return dest;
+}
+
 EXPORT_API NuguDirective *
 nugu_directive_new(const char *name_space, const char *name,
 		   const char *version, const char *msg_id,
 		   const char *dialog_id, const char *json)
 {
 	NuguDirective *ndir;
+	size_t len[6];
+	char *pos;
 
 	g_return_val_if_fail(name_space != NULL, NULL);
 	g_return_val_if_fail(name != NULL, NULL);
@@ -54,16 +132,36 @@ nugu_directive_new(const char *name_space, const char *name,
 	g_return_val_if_fail(dialog_id != NULL, NULL);
 	g_return_val_if_fail(json != NULL, NULL);
 
-	ndir = calloc(1, sizeof(NuguDirective));
-	ndir->name_space = strdup(name_space);
-	ndir->name = strdup(name);
-	ndir->version = strdup(version);
-	ndir->msg_id = strdup(msg_id);
-	ndir->dialog_id = strdup(dialog_id);
-	ndir->json = strdup(json);
+	ndir = _directive_alloc();
+	if (!ndir)
+		return NULL;
+
+	len[0] = strlen(name_space);
+	len[1] = strlen(name);
+	len[2] = strlen(version);
+	len[3] = strlen(msg_id);
+	len[4] = strlen(dialog_id);
+	len[5] = strlen(json);
+
+	ndir->strings = malloc(len[0] + len[1] + len[2] + len[3] + len[4] +
+			       len[5] + 6);
+	if (!ndir->strings) {
+		error_nomem();
+		nugu_pool_release(_directive_pool, ndir);
+		return NULL;
+	}
 
+	pos = ndir->strings;
+	ndir->name_space = _copy_string(&pos, name_space, len[0]);
+	ndir->name = _copy_string(&pos, name, len[1]);
+	ndir->version = _copy_string(&pos, version, len[2]);
+	ndir->msg_id = _copy_string(&pos, msg_id, len[3]);
+	ndir->dialog_id = _copy_string(&pos, dialog_id, len[4]);
+	ndir->json = _copy_string(&pos, json, len[5]);
+
+	/* The attachment chunks are created when the data is received */
 	ndir->is_active = 0;
-	ndir->buf = nugu_buffer_new(0);
+	ndir->chunks = NULL;
 	ndir->media_type = NULL;
 
 	return ndir;
@@ -76,32 +174,23 @@ EXPORT_API void nugu_directive_free(NuguDirective *ndir)
 	nugu_info("destroy: %s.%s 'id=%s'", ndir->name_space, ndir->name,
 		  ndir->msg_id);
 
-	free(ndir->name_space);
-	ndir->name_space = NULL;
-
-	free(ndir->name);
-	ndir->name = NULL;
-
-	free(ndir->version);
-	ndir->version = NULL;
-
-	free(ndir->msg_id);
-	ndir->msg_id = NULL;
-
-	free(ndir->dialog_id);
-	ndir->dialog_id = NULL;
+	free(ndir->strings);
 
-	free(ndir->json);
-	ndir->json = NULL;
-
-	nugu_buffer_free(ndir->buf, TRUE);
-	ndir->buf = NULL;
+	if (ndir->chunks)
+		nugu_chunk_chain_free(ndir->chunks);
 
 	if (ndir->media_type)
 		free(ndir->media_type);
 
-	memset(ndir, 0, sizeof(NuguDirective));
-	free(ndir);
+	nugu_pool_release(_directive_pool, ndir);
+}
+
+static NuguChunkChain *_directive_get_chain(NuguDirective *ndir)
+{
+	if (!ndir->chunks)
+		ndir->chunks = nugu_chunk_chain_new();
+
+	return ndir->chunks;
 }
 
 EXPORT_API int nugu_directive_is_active(NuguDirective *ndir)
@@ -188,10 +277,23 @@ EXPORT_API const char *nugu_directive_peek_media_type(NuguDirective *ndir)
 	return ndir->media_type;
 }
 
+static int _directive_notify_data(NuguDirective *ndir)
+{
+	if (nugu_directive_is_active(ndir) == 0) {
+		nugu_dbg("skip callback. directive is not active");
+		return 0;
+	}
+
+	if (ndir->callback)
+		ndir->callback(ndir, ndir->callback_userdata);
+
+	return 0;
+}
+
 EXPORT_API int nugu_directive_add_data(NuguDirective *ndir, size_t length,
 				       unsigned char *data)
 {
-	size_t written;
+	unsigned char *copied;
 
 	g_return_val_if_fail(ndir != NULL, -1);
 
@@ -201,23 +303,40 @@ EXPORT_API int nugu_directive_add_data(NuguDirective *ndir, size_t length,
 			return -1;
 		}
 
-		written = nugu_buffer_add(ndir->buf, data, length);
-		if (written != length) {
-			nugu_error("buffer_add failed() (%zd != %zd)", written,
-				   length);
+		/* Keep each attachment in its own segment */
+		copied = malloc(length);
+		if (!copied) {
+			error_nomem();
 			return -1;
 		}
-	}
 
-	if (nugu_directive_is_active(ndir) == 0) {
-		nugu_dbg("skip callback. directive is not active");
-		return 0;
+		memcpy(copied, data, length);
+
+		if (nugu_chunk_chain_add_take(_directive_get_chain(ndir), copied,
+					      length) < 0) {
+			nugu_error("chunk_chain_add failed() (%zd)", length);
+			free(copied);
+			return -1;
+		}
 	}
 
-	if (ndir->callback)
-		ndir->callback(ndir, ndir->callback_userdata);
+	return _directive_notify_data(ndir);
+}
 
-	return 0;
+EXPORT_API int nugu_directive_add_chunks(NuguDirective *ndir,
+					 NuguChunkChain *chunks)
+{
+	g_return_val_if_fail(ndir != NULL, -1);
+
+	if (chunks && nugu_chunk_chain_get_size(chunks) > 0) {
+		if (nugu_chunk_chain_append(_directive_get_chain(ndir),
+					    chunks) < 0) {
+			nugu_error("chunk_chain_append failed()");
+			return -1;
+		}
+	}
+
+	return _directive_notify_data(ndir);
 }
 
 EXPORT_API int nugu_directive_close_data(NuguDirective *ndir)
@@ -240,32 +359,44 @@ EXPORT_API unsigned char *nugu_directive_get_data(NuguDirective *ndir,
 						  size_t *length)
 {
 	unsigned char *buf;
-	size_t buf_size;
 
 	g_return_val_if_fail(ndir != NULL, NULL);
 
-	buf_size = nugu_buffer_get_size(ndir->buf);
+	if (!ndir->chunks) {
+		if (length)
+			*length = 0;
+		return NULL;
+	}
 
-	if (length)
-		*length = buf_size;
+	buf = nugu_chunk_chain_flatten(ndir->chunks, length);
+	nugu_chunk_chain_clear(ndir->chunks);
 
-	if (buf_size == 0)
+	return buf;
+}
+
+EXPORT_API NuguChunkChain *nugu_directive_get_chunks(NuguDirective *ndir)
+{
+	NuguChunkChain *chunks;
+
+	g_return_val_if_fail(ndir != NULL, NULL);
+
+	if (nugu_directive_get_data_size(ndir) == 0)
 		return NULL;
 
-	buf = nugu_buffer_pop(ndir->buf, 0);
+	chunks = ndir->chunks;
+	ndir->chunks = NULL;
 
-	return buf;
+	return chunks;
 }
 
 EXPORT_API size_t nugu_directive_get_data_size(NuguDirective *ndir)
 {
-	size_t size;
-
 	g_return_val_if_fail(ndir != NULL, 0);
 
-	size = nugu_buffer_get_size(ndir->buf);
+	if (!ndir->chunks)
+		return 0;
 
-	return size;
+	return nugu_chunk_chain_get_size(ndir->chunks);
 }
 
 EXPORT_API int nugu_directive_set_data_callback(NuguDirective *ndir,
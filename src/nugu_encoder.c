@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_log.h"
+#include "nugu_encoder.h"
+
+struct _nugu_encoder {
+	NuguEncoderDriver *driver;
+	NuguAudioProperty property;
+	NuguEncoderOption option;
+	void *userdata;
+
+	/* part of frame remained from the last data */
+	size_t frame_size;
+	unsigned char *pending;
+	size_t pending_size;
+
+	/* the last pcm data held by nugu_encoder_hold() */
+	NuguBuffer *held;
+	size_t lookback_size;
+};
+
+struct _nugu_encoder_driver {
+	char *name;
+	enum encoder_type type;
+	struct nugu_encoder_driver_ops *ops;
+	int ref_count;
+};
+
+static GList *_encoder_drivers;
+
+EXPORT_API NuguEncoderDriver *
+nugu_encoder_driver_new(const char *name, enum encoder_type type,
+			struct nugu_encoder_driver_ops *ops)
+{
+	NuguEncoderDriver *driver;
+
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(ops != NULL, NULL);
+
+	driver = malloc(sizeof(struct _nugu_encoder_driver));
+	if (!driver) {
+		error_nomem();
+		return NULL;
+	}
+
+	driver->name = g_strdup(name);
+	driver->type = type;
+	driver->ops = ops;
+	driver->ref_count = 0;
+
+	return driver;
+}
+
+EXPORT_API int nugu_encoder_driver_free(NuguEncoderDriver *driver)
+{
+	g_return_val_if_fail(driver != NULL, -1);
+
+	if (driver->ref_count != 0)
+		return -1;
+
+	g_free(driver->name);
+
+	memset(driver, 0, sizeof(struct _nugu_encoder_driver));
+	free(driver);
+
+	return 0;
+}
+
+EXPORT_API int nugu_encoder_driver_register(NuguEncoderDriver *driver)
+{
+	g_return_val_if_fail(driver != NULL, -1);
+
+	if (nugu_encoder_driver_find(driver->name)) {
+		nugu_error("'%s' encoder driver already exist.", driver->name);
+		return -1;
+	}
+
+	_encoder_drivers = g_list_append(_encoder_drivers, driver);
+
+	return 0;
+}
+
+EXPORT_API int nugu_encoder_driver_remove(NuguEncoderDriver *driver)
+{
+	GList *l;
+
+	l = g_list_find(_encoder_drivers, driver);
+	if (!l)
+		return -1;
+
+	_encoder_drivers = g_list_delete_link(_encoder_drivers, l);
+
+	return 0;
+}
+
+EXPORT_API NuguEncoderDriver *nugu_encoder_driver_find(const char *name)
+{
+	GList *cur;
+
+	g_return_val_if_fail(name != NULL, NULL);
+
+	cur = _encoder_drivers;
+	while (cur) {
+		if (g_strcmp0(((NuguEncoderDriver *)cur->data)->name, name) ==
+		    0)
+			return cur->data;
+
+		cur = cur->next;
+	}
+
+	return NULL;
+}
+
+EXPORT_API NuguEncoderDriver *
+nugu_encoder_driver_find_bytype(enum encoder_type type)
+{
+	GList *cur;
+
+	cur = _encoder_drivers;
+	while (cur) {
+		if (((NuguEncoderDriver *)cur->data)->type == type)
+			return cur->data;
+
+		cur = cur->next;
+	}
+
+	return NULL;
+}
+
+static size_t _get_frame_size(NuguEncoder *enc)
+{
+	size_t sample_size;
+	size_t size;
+
+	sample_size = nugu_audio_get_sample_width(enc->property.format) *
+		      enc->property.channel;
+	size = (size_t)nugu_audio_get_bytes_per_sec(enc->property) *
+	       enc->option.frame_time / 1000;
+
+	/* Only the whole samples */
+	if (sample_size == 0 || size % sample_size != 0)
+		return 0;
+
+	return size;
+}
+
+EXPORT_API NuguEncoder *nugu_encoder_new(NuguEncoderDriver *driver,
+					 NuguAudioProperty property,
+					 const NuguEncoderOption *option)
+{
+	NuguEncoder *enc;
+
+	g_return_val_if_fail(driver != NULL, NULL);
+	g_return_val_if_fail(driver->ops->encode != NULL, NULL);
+
+	enc = calloc(1, sizeof(struct _nugu_encoder));
+	if (!enc) {
+		error_nomem();
+		return NULL;
+	}
+
+	enc->driver = driver;
+	enc->property = property;
+
+	if (option) {
+		enc->option = *option;
+	} else {
+		enc->option.bitrate = 0;
+		enc->option.complexity = -1;
+		enc->option.frame_time = NUGU_ENCODER_DEFAULT_FRAME_TIME;
+	}
+
+	enc->frame_size = _get_frame_size(enc);
+	if (enc->frame_size == 0) {
+		nugu_error("not supported frame time(%d ms)",
+			   enc->option.frame_time);
+		free(enc);
+		return NULL;
+	}
+
+	enc->pending = malloc(enc->frame_size);
+	if (!enc->pending) {
+		error_nomem();
+		free(enc);
+		return NULL;
+	}
+
+	driver->ref_count++;
+
+	if (driver->ops->create == NULL)
+		return enc;
+
+	if (driver->ops->create(driver, enc) == 0)
+		return enc;
+
+	driver->ref_count--;
+	free(enc->pending);
+	if (enc->held)
+		nugu_buffer_free(enc->held, TRUE);
+	memset(enc, 0, sizeof(struct _nugu_encoder));
+	free(enc);
+
+	return NULL;
+}
+
+EXPORT_API int nugu_encoder_free(NuguEncoder *enc)
+{
+	g_return_val_if_fail(enc != NULL, -1);
+
+	if (enc->driver->ops->destroy &&
+	    enc->driver->ops->destroy(enc->driver, enc) < 0)
+		return -1;
+
+	enc->driver->ref_count--;
+
+	free(enc->pending);
+	if (enc->held)
+		nugu_buffer_free(enc->held, TRUE);
+
+	memset(enc, 0, sizeof(struct _nugu_encoder));
+	free(enc);
+
+	return 0;
+}
+
+static int _encode(NuguEncoder *enc, const void *data, size_t data_len,
+		   NuguBuffer *out_buf)
+{
+	const unsigned char *src = data;
+	size_t length;
+
+	/* Complete the frame remained from the last data */
+	if (enc->pending_size > 0) {
+		length = MIN(data_len, enc->frame_size - enc->pending_size);
+
+		memcpy(enc->pending + enc->pending_size, src, length);
+		enc->pending_size += length;
+		src += length;
+		data_len -= length;
+
+		if (enc->pending_size < enc->frame_size)
+			return 0;
+
+		enc->pending_size = 0;
+
+		if (enc->driver->ops->encode(enc->driver, enc, enc->pending,
+					     enc->frame_size, out_buf) != 0)
+			return -1;
+	}
+
+	for (; data_len >= enc->frame_size; data_len -= enc->frame_size) {
+		if (enc->driver->ops->encode(enc->driver, enc, src,
+					     enc->frame_size, out_buf) != 0)
+			return -1;
+
+		src += enc->frame_size;
+	}
+
+	if (data_len > 0) {
+		memcpy(enc->pending, src, data_len);
+		enc->pending_size = data_len;
+	}
+
+	return 0;
+}
+
+EXPORT_API int nugu_encoder_encode(NuguEncoder *enc, const void *data,
+				   size_t data_len, NuguBuffer *out_buf)
+{
+	int ret = 0;
+
+	g_return_val_if_fail(enc != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(out_buf != NULL, -1);
+
+	/* The held data is encoded before the new data */
+	if (enc->held && nugu_buffer_get_size(enc->held) > 0) {
+		ret = _encode(enc, nugu_buffer_peek(enc->held),
+			      nugu_buffer_get_size(enc->held), out_buf);
+		nugu_buffer_clear(enc->held);
+		if (ret < 0)
+			return ret;
+	}
+
+	return _encode(enc, data, data_len, out_buf);
+}
+
+EXPORT_API int nugu_encoder_set_lookback(NuguEncoder *enc, int msec)
+{
+	size_t sample_size;
+
+	g_return_val_if_fail(enc != NULL, -1);
+	g_return_val_if_fail(msec >= 0, -1);
+
+	if (!enc->held) {
+		enc->held = nugu_buffer_new(0);
+		if (!enc->held)
+			return -1;
+	}
+
+	/* Only the whole samples */
+	sample_size = nugu_audio_get_sample_width(enc->property.format) *
+		      enc->property.channel;
+	enc->lookback_size =
+		(size_t)nugu_audio_get_bytes_per_sec(enc->property) * msec /
+		1000;
+	if (sample_size > 0)
+		enc->lookback_size -= enc->lookback_size % sample_size;
+
+	nugu_buffer_clear(enc->held);
+
+	return 0;
+}
+
+EXPORT_API int nugu_encoder_hold(NuguEncoder *enc, const void *data,
+				 size_t data_len)
+{
+	size_t size;
+
+	g_return_val_if_fail(enc != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+
+	if (!enc->held || enc->lookback_size == 0)
+		return 0;
+
+	nugu_buffer_add(enc->held, data, data_len);
+
+	/* Only the last data of the lookback time is kept */
+	size = nugu_buffer_get_size(enc->held);
+	if (size > enc->lookback_size)
+		nugu_buffer_shift_left(enc->held, size - enc->lookback_size);
+
+	return 0;
+}
+
+EXPORT_API int nugu_encoder_reset(NuguEncoder *enc)
+{
+	g_return_val_if_fail(enc != NULL, -1);
+
+	enc->pending_size = 0;
+	if (enc->held)
+		nugu_buffer_clear(enc->held);
+
+	if (enc->driver->ops->reset == NULL)
+		return 0;
+
+	return enc->driver->ops->reset(enc->driver, enc);
+}
+
+EXPORT_API int nugu_encoder_get_property(NuguEncoder *enc,
+					 NuguAudioProperty *property)
+{
+	g_return_val_if_fail(enc != NULL, -1);
+	g_return_val_if_fail(property != NULL, -1);
+
+	*property = enc->property;
+
+	return 0;
+}
+
+EXPORT_API int nugu_encoder_get_option(NuguEncoder *enc,
+				       NuguEncoderOption *option)
+{
+	g_return_val_if_fail(enc != NULL, -1);
+	g_return_val_if_fail(option != NULL, -1);
+
+	*option = enc->option;
+
+	return 0;
+}
+
+EXPORT_API size_t nugu_encoder_get_frame_size(NuguEncoder *enc)
+{
+	g_return_val_if_fail(enc != NULL, 0);
+
+	return enc->frame_size;
+}
+
+EXPORT_API int nugu_encoder_set_userdata(NuguEncoder *enc, void *userdata)
+{
+	g_return_val_if_fail(enc != NULL, -1);
+
+	enc->userdata = userdata;
+
+	return 0;
+}
+
+EXPORT_API void *nugu_encoder_get_userdata(NuguEncoder *enc)
+{
+	g_return_val_if_fail(enc != NULL, NULL);
+
+	return enc->userdata;
+}
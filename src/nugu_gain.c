@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "nugu_log.h"
+#include "nugu_media.h"
+#include "nugu_gain.h"
+
+/* Fixed-point gain: 1.0 is (1 << GAIN_SHIFT) */
+#define GAIN_SHIFT 16
+#define GAIN_UNITY (1 << GAIN_SHIFT)
+
+#define DEFAULT_SAMPLE_RATE 16000
+
+struct sample_format {
+	int width;
+	int is_signed;
+	int is_be;
+	int is_float;
+};
+
+static const struct sample_format _formats[AUDIO_FORMAT_MAX] = {
+	[AUDIO_FORMAT_S8] = { 1, 1, 0, 0 },
+	[AUDIO_FORMAT_U8] = { 1, 0, 0, 0 },
+	[AUDIO_FORMAT_S16_LE] = { 2, 1, 0, 0 },
+	[AUDIO_FORMAT_S16_BE] = { 2, 1, 1, 0 },
+	[AUDIO_FORMAT_U16_LE] = { 2, 0, 0, 0 },
+	[AUDIO_FORMAT_U16_BE] = { 2, 0, 1, 0 },
+	[AUDIO_FORMAT_S24_LE] = { 3, 1, 0, 0 },
+	[AUDIO_FORMAT_S24_BE] = { 3, 1, 1, 0 },
+	[AUDIO_FORMAT_U24_LE] = { 3, 0, 0, 0 },
+	[AUDIO_FORMAT_U24_BE] = { 3, 0, 1, 0 },
+	[AUDIO_FORMAT_S32_LE] = { 4, 1, 0, 0 },
+	[AUDIO_FORMAT_S32_BE] = { 4, 1, 1, 0 },
+	[AUDIO_FORMAT_U32_LE] = { 4, 0, 0, 0 },
+	[AUDIO_FORMAT_U32_BE] = { 4, 0, 1, 0 },
+	[AUDIO_FORMAT_FLOAT_LE] = { 4, 1, 0, 1 },
+	[AUDIO_FORMAT_FLOAT_BE] = { 4, 1, 1, 1 },
+};
+
+enum gain_kernel {
+	KERNEL_GENERIC,
+	KERNEL_S16,
+	KERNEL_S32,
+	KERNEL_FLOAT
+};
+
+struct _nugu_gain {
+	struct sample_format fmt;
+	enum gain_kernel kernel;
+	int channel;
+	int rate;
+	int ramp_time;
+
+	int volume;
+	int active;
+
+	/* current gain (ramp in progress if ramp_remain > 0) */
+	float level;
+	float target;
+	float step;
+	int ramp_remain;
+};
+
+static int _is_host_order(const struct sample_format *fmt)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	return fmt->width == 1 || !fmt->is_be;
+#else
+	return fmt->width == 1 || fmt->is_be;
+#endif
+}
+
+static enum gain_kernel _select_kernel(const struct sample_format *fmt)
+{
+	if (!_is_host_order(fmt) || !fmt->is_signed)
+		return KERNEL_GENERIC;
+
+	if (fmt->is_float)
+		return KERNEL_FLOAT;
+
+	if (fmt->width == 2)
+		return KERNEL_S16;
+
+	if (fmt->width == 4)
+		return KERNEL_S32;
+
+	return KERNEL_GENERIC;
+}
+
+static int32_t _level_to_fixed(float level)
+{
+	return (int32_t)(level * GAIN_UNITY + 0.5f);
+}
+
+/*
+ * Kernels for host-endian samples with a constant gain. The vector paths
+ * give the same result as the scalar loop which handles the rest.
+ */
+static void _scale_s16(const int16_t *src, int16_t *dest, size_t count,
+		       int32_t g)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	/*
+	 * Unsigned high multiply, corrected for the negative samples:
+	 * (s * g) >> 16 == mulhi_epu16(s, g) - (s < 0 ? g : 0)
+	 */
+	if (g < GAIN_UNITY) {
+		const __m128i vg = _mm_set1_epi16((short)g);
+
+		for (; i + 8 <= count; i += 8) {
+			__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i hi = _mm_mulhi_epu16(v, vg);
+			__m128i neg = _mm_and_si128(_mm_srai_epi16(v, 15), vg);
+
+			_mm_storeu_si128((__m128i *)(dest + i),
+					 _mm_sub_epi16(hi, neg));
+		}
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t v = vld1q_s16(src + i);
+		int32x4_t lo = vmulq_n_s32(vmovl_s16(vget_low_s16(v)), g);
+		int32x4_t hi = vmulq_n_s32(vmovl_s16(vget_high_s16(v)), g);
+
+		vst1q_s16(dest + i,
+			  vcombine_s16(vmovn_s32(vshrq_n_s32(lo, GAIN_SHIFT)),
+				       vmovn_s32(vshrq_n_s32(hi, GAIN_SHIFT))));
+	}
+#endif
+
+	for (; i < count; i++)
+		dest[i] = (int16_t)(((int32_t)src[i] * g) >> GAIN_SHIFT);
+}
+
+static void _scale_s32(const int32_t *src, int32_t *dest, size_t count,
+		       int32_t g)
+{
+	size_t i = 0;
+
+	/* SSE2 has no signed 32 bits widening multiply */
+#if defined(__ARM_NEON)
+	const int32x2_t vg = vdup_n_s32(g);
+
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t v = vld1q_s32(src + i);
+		int64x2_t lo = vmull_s32(vget_low_s32(v), vg);
+		int64x2_t hi = vmull_s32(vget_high_s32(v), vg);
+
+		vst1q_s32(dest + i,
+			  vcombine_s32(vmovn_s64(vshrq_n_s64(lo, GAIN_SHIFT)),
+				       vmovn_s64(vshrq_n_s64(hi, GAIN_SHIFT))));
+	}
+#endif
+
+	for (; i < count; i++)
+		dest[i] = (int32_t)(((int64_t)src[i] * g) >> GAIN_SHIFT);
+}
+
+static void _scale_float(const float *src, float *dest, size_t count,
+			 float level)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 vl = _mm_set1_ps(level);
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), vl));
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= count; i += 4)
+		vst1q_f32(dest + i, vmulq_n_f32(vld1q_f32(src + i), level));
+#endif
+
+	for (; i < count; i++)
+		dest[i] = src[i] * level;
+}
+
+/* Read one sample as a signed value in the range of the sample width */
+static int64_t _read_sample(const struct sample_format *fmt,
+			    const unsigned char *p)
+{
+	uint32_t v = 0;
+	int i;
+
+	if (fmt->is_be) {
+		for (i = 0; i < fmt->width; i++)
+			v = (v << 8) | p[i];
+	} else {
+		for (i = fmt->width - 1; i >= 0; i--)
+			v = (v << 8) | p[i];
+	}
+
+	if (!fmt->is_signed)
+		return (int64_t)v - ((int64_t)1 << (fmt->width * 8 - 1));
+
+	/* sign extension */
+	if (fmt->width < 4 && (v & (1U << (fmt->width * 8 - 1))))
+		v |= ~0U << (fmt->width * 8);
+
+	return (int32_t)v;
+}
+
+static void _write_sample(const struct sample_format *fmt, unsigned char *p,
+			  int64_t value)
+{
+	uint32_t v;
+	int i;
+
+	if (!fmt->is_signed)
+		value += (int64_t)1 << (fmt->width * 8 - 1);
+
+	v = (uint32_t)value;
+
+	if (fmt->is_be) {
+		for (i = fmt->width - 1; i >= 0; i--, v >>= 8)
+			p[i] = v & 0xFF;
+	} else {
+		for (i = 0; i < fmt->width; i++, v >>= 8)
+			p[i] = v & 0xFF;
+	}
+}
+
+static void _scale_generic_sample(const struct sample_format *fmt,
+				  const unsigned char *src, unsigned char *dest,
+				  float level)
+{
+	if (fmt->is_float) {
+		union {
+			uint32_t u;
+			float f;
+		} v;
+
+		v.u = (uint32_t)_read_sample(fmt, src);
+		v.f *= level;
+		_write_sample(fmt, dest, (int32_t)v.u);
+		return;
+	}
+
+	_write_sample(fmt, dest,
+		      (_read_sample(fmt, src) * _level_to_fixed(level)) >>
+			      GAIN_SHIFT);
+}
+
+static void _scale_frames(NuguGain *gain, const unsigned char *src,
+			  unsigned char *dest, size_t frames)
+{
+	size_t count = frames * gain->channel;
+	size_t i;
+
+	switch (gain->kernel) {
+	case KERNEL_S16:
+		_scale_s16((const int16_t *)src, (int16_t *)dest, count,
+			   _level_to_fixed(gain->level));
+		break;
+	case KERNEL_S32:
+		_scale_s32((const int32_t *)src, (int32_t *)dest, count,
+			   _level_to_fixed(gain->level));
+		break;
+	case KERNEL_FLOAT:
+		_scale_float((const float *)src, (float *)dest, count,
+			     gain->level);
+		break;
+	default:
+		for (i = 0; i < count; i++) {
+			_scale_generic_sample(&gain->fmt, src, dest,
+					      gain->level);
+			src += gain->fmt.width;
+			dest += gain->fmt.width;
+		}
+		break;
+	}
+}
+
+/* Change the gain frame by frame. Returns the count of processed frames */
+static size_t _ramp_frames(NuguGain *gain, const unsigned char *src,
+			   unsigned char *dest, size_t frames)
+{
+	size_t frame_size = gain->fmt.width * gain->channel;
+	size_t i;
+	int ch;
+
+	for (i = 0; i < frames && gain->ramp_remain > 0; i++) {
+		gain->level += gain->step;
+		gain->ramp_remain--;
+		if (gain->ramp_remain == 0)
+			gain->level = gain->target;
+
+		for (ch = 0; ch < gain->channel; ch++) {
+			size_t offset = ch * gain->fmt.width;
+
+			_scale_generic_sample(&gain->fmt, src + offset,
+					      dest + offset, gain->level);
+		}
+
+		src += frame_size;
+		dest += frame_size;
+	}
+
+	return i;
+}
+
+EXPORT_API NuguGain *nugu_gain_new(void)
+{
+	NuguGain *gain;
+
+	gain = calloc(1, sizeof(struct _nugu_gain));
+	if (!gain) {
+		error_nomem();
+		return NULL;
+	}
+
+	gain->fmt = _formats[AUDIO_FORMAT_S16_LE];
+	gain->kernel = _select_kernel(&gain->fmt);
+	gain->channel = 1;
+	gain->rate = DEFAULT_SAMPLE_RATE;
+	gain->ramp_time = NUGU_GAIN_DEFAULT_RAMP_TIME;
+	gain->volume = NUGU_SET_VOLUME_MAX;
+	gain->level = 1.0f;
+	gain->target = 1.0f;
+
+	return gain;
+}
+
+EXPORT_API void nugu_gain_free(NuguGain *gain)
+{
+	g_return_if_fail(gain != NULL);
+
+	memset(gain, 0, sizeof(struct _nugu_gain));
+	free(gain);
+}
+
+EXPORT_API int nugu_gain_set_property(NuguGain *gain,
+				      NuguAudioProperty property)
+{
+	g_return_val_if_fail(gain != NULL, -1);
+
+	if ((int)property.format < 0 || property.format >= AUDIO_FORMAT_MAX) {
+		nugu_error("not support the audio format(%d)", property.format);
+		return -1;
+	}
+
+	gain->fmt = _formats[property.format];
+	gain->kernel = _select_kernel(&gain->fmt);
+	gain->channel = MAX(property.channel, 1);
+	gain->rate = nugu_audio_get_rate(property.samplerate);
+	if (gain->rate == 0)
+		gain->rate = DEFAULT_SAMPLE_RATE;
+
+	/* The ramp is calculated with the previous sample rate */
+	nugu_gain_reset(gain);
+
+	return 0;
+}
+
+EXPORT_API int nugu_gain_set_volume(NuguGain *gain, int volume)
+{
+	int frames;
+
+	g_return_val_if_fail(gain != NULL, -1);
+
+	volume = CLAMP(volume, NUGU_SET_VOLUME_MIN, NUGU_SET_VOLUME_MAX);
+	if (volume == gain->volume)
+		return 0;
+
+	gain->volume = volume;
+	gain->target = (float)volume / NUGU_SET_VOLUME_MAX;
+
+	frames = gain->rate * gain->ramp_time / 1000;
+	if (!gain->active || frames <= 0) {
+		gain->level = gain->target;
+		gain->ramp_remain = 0;
+		return 0;
+	}
+
+	gain->step = (gain->target - gain->level) / frames;
+	gain->ramp_remain = frames;
+
+	return 0;
+}
+
+EXPORT_API int nugu_gain_get_volume(NuguGain *gain)
+{
+	g_return_val_if_fail(gain != NULL, -1);
+
+	return gain->volume;
+}
+
+EXPORT_API int nugu_gain_set_ramp_time(NuguGain *gain, int msec)
+{
+	g_return_val_if_fail(gain != NULL, -1);
+	g_return_val_if_fail(msec >= 0, -1);
+
+	gain->ramp_time = msec;
+
+	return 0;
+}
+
+EXPORT_API void nugu_gain_reset(NuguGain *gain)
+{
+	g_return_if_fail(gain != NULL);
+
+	gain->level = gain->target;
+	gain->ramp_remain = 0;
+	gain->active = 0;
+}
+
+EXPORT_API int nugu_gain_is_unity(NuguGain *gain)
+{
+	g_return_val_if_fail(gain != NULL, 0);
+
+	return gain->ramp_remain == 0 && gain->volume == NUGU_SET_VOLUME_MAX;
+}
+
+EXPORT_API int nugu_gain_apply(NuguGain *gain, const void *src, void *dest,
+			       size_t size)
+{
+	const unsigned char *s = src;
+	unsigned char *d = dest;
+	size_t frame_size;
+	size_t frames;
+	size_t done;
+
+	g_return_val_if_fail(gain != NULL, -1);
+	g_return_val_if_fail(src != NULL, -1);
+	g_return_val_if_fail(dest != NULL, -1);
+
+	gain->active = 1;
+
+	if (nugu_gain_is_unity(gain)) {
+		if (s != d)
+			memmove(d, s, size);
+		return size;
+	}
+
+	frame_size = gain->fmt.width * gain->channel;
+	frames = size / frame_size;
+
+	done = _ramp_frames(gain, s, d, frames);
+	s += done * frame_size;
+	d += done * frame_size;
+	frames -= done;
+
+	if (frames > 0) {
+		_scale_frames(gain, s, d, frames);
+		s += frames * frame_size;
+		d += frames * frame_size;
+	}
+
+	/* Partial frame: scale the whole samples and copy the rest */
+	done = (size % frame_size) / gain->fmt.width;
+	while (done > 0) {
+		_scale_generic_sample(&gain->fmt, s, d, gain->level);
+		s += gain->fmt.width;
+		d += gain->fmt.width;
+		done--;
+	}
+
+	if (s != d)
+		memmove(d, s, size % gain->fmt.width);
+
+	return size;
+}
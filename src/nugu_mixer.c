@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "nugu_log.h"
+#include "nugu_mixer.h"
+
+#define MIXER_BLOCK_SIZE 4096
+#define MIXER_WAIT_USEC 1000
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define MIXER_FORMAT_S16 AUDIO_FORMAT_S16_LE
+#define MIXER_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_LE
+#else
+#define MIXER_FORMAT_S16 AUDIO_FORMAT_S16_BE
+#define MIXER_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_BE
+#endif
+
+struct mixer_input {
+	gpointer pcm; /* NuguPcm, NULL if the slot is empty */
+	gint paused;
+	gint ended; /* the end callback is already called */
+};
+
+struct _nugu_mixer {
+	NuguAudioProperty property;
+	int sample_width;
+	size_t block_size;
+
+	struct mixer_input inputs[NUGU_MIXER_MAX_INPUTS];
+
+	/* nugu_mixer_mix() is running, and the count of finished mixing */
+	gint mixing;
+	gint mix_seq;
+
+	NuguMixerEndCallback end_cb;
+	void *end_cb_data;
+
+	/* delay of the output device (usec), passed to the inputs */
+	gint device_delay;
+
+	/* data of the second and later inputs (used only by mixing thread) */
+	float scratch[MIXER_BLOCK_SIZE / sizeof(float)];
+};
+
+/* Saturating add, the scalar loop handles the rest of the vectors */
+static void _mix_s16(int16_t *dest, const int16_t *src, size_t count)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	for (; i + 8 <= count; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(dest + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_adds_epi16(a, b));
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 8 <= count; i += 8)
+		vst1q_s16(dest + i,
+			  vqaddq_s16(vld1q_s16(dest + i), vld1q_s16(src + i)));
+#endif
+
+	for (; i < count; i++) {
+		int32_t value = (int32_t)dest[i] + src[i];
+
+		dest[i] = (int16_t)CLAMP(value, INT16_MIN, INT16_MAX);
+	}
+}
+
+static void _mix_float(float *dest, const float *src, size_t count)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i),
+						   _mm_loadu_ps(src + i)));
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= count; i += 4)
+		vst1q_f32(dest + i,
+			  vaddq_f32(vld1q_f32(dest + i), vld1q_f32(src + i)));
+#endif
+
+	for (; i < count; i++)
+		dest[i] += src[i];
+}
+
+static struct mixer_input *_find_input(NuguMixer *mixer, NuguPcm *pcm)
+{
+	int i;
+
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		if (g_atomic_pointer_get(&mixer->inputs[i].pcm) == pcm)
+			return mixer->inputs + i;
+	}
+
+	return NULL;
+}
+
+/* Returns the size of data read from the pcm */
+static size_t _mix_input(NuguMixer *mixer, NuguPcm *pcm, unsigned char *out,
+			 size_t size, int first)
+{
+	size_t total = 0;
+	int ret;
+
+	/* The first input is read into the output directly */
+	if (first) {
+		ret = nugu_pcm_get_data(pcm, (char *)out, size);
+		if (ret > 0)
+			total = ret;
+
+		if (total < size)
+			memset(out + total, 0, size - total);
+
+		return total;
+	}
+
+	while (total < size) {
+		size_t length = MIN(size - total, mixer->block_size);
+		size_t count;
+
+		ret = nugu_pcm_get_data(pcm, (char *)mixer->scratch, length);
+		if (ret <= 0)
+			break;
+
+		count = ret / mixer->sample_width;
+		if (mixer->property.format == MIXER_FORMAT_S16)
+			_mix_s16((int16_t *)(out + total),
+				 (const int16_t *)mixer->scratch, count);
+		else
+			_mix_float((float *)(out + total),
+				   (const float *)mixer->scratch, count);
+
+		total += ret;
+		if ((size_t)ret < length)
+			break;
+	}
+
+	return total;
+}
+
+EXPORT_API NuguMixer *nugu_mixer_new(NuguAudioProperty property)
+{
+	NuguMixer *mixer;
+	size_t frame_size;
+
+	if (property.format != MIXER_FORMAT_S16 &&
+	    property.format != MIXER_FORMAT_FLOAT) {
+		nugu_error("not support the audio format(%d)", property.format);
+		return NULL;
+	}
+
+	mixer = calloc(1, sizeof(struct _nugu_mixer));
+	if (!mixer) {
+		error_nomem();
+		return NULL;
+	}
+
+	mixer->property = property;
+	mixer->sample_width = nugu_audio_get_sample_width(property.format);
+
+	frame_size = mixer->sample_width * MAX(property.channel, 1);
+	mixer->block_size = MIXER_BLOCK_SIZE - (MIXER_BLOCK_SIZE % frame_size);
+
+	return mixer;
+}
+
+EXPORT_API void nugu_mixer_free(NuguMixer *mixer)
+{
+	g_return_if_fail(mixer != NULL);
+
+	if (nugu_mixer_get_input_count(mixer) > 0)
+		nugu_dbg("mixer(%p) destroyed with %d inputs", mixer,
+			 nugu_mixer_get_input_count(mixer));
+
+	memset(mixer, 0, sizeof(struct _nugu_mixer));
+	free(mixer);
+}
+
+EXPORT_API int nugu_mixer_get_property(NuguMixer *mixer,
+				       NuguAudioProperty *property)
+{
+	g_return_val_if_fail(mixer != NULL, -1);
+	g_return_val_if_fail(property != NULL, -1);
+
+	memcpy(property, &mixer->property, sizeof(NuguAudioProperty));
+
+	return 0;
+}
+
+EXPORT_API void nugu_mixer_set_end_callback(NuguMixer *mixer,
+					    NuguMixerEndCallback callback,
+					    void *userdata)
+{
+	g_return_if_fail(mixer != NULL);
+
+	mixer->end_cb = callback;
+	mixer->end_cb_data = userdata;
+}
+
+EXPORT_API int nugu_mixer_set_device_delay(NuguMixer *mixer, int usec)
+{
+	g_return_val_if_fail(mixer != NULL, -1);
+
+	g_atomic_int_set(&mixer->device_delay, MAX(usec, 0));
+
+	return 0;
+}
+
+EXPORT_API int nugu_mixer_add_input(NuguMixer *mixer, NuguPcm *pcm)
+{
+	NuguAudioProperty property;
+	struct mixer_input *input;
+
+	g_return_val_if_fail(mixer != NULL, -1);
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	if (nugu_pcm_get_device_property(pcm, &property) < 0)
+		return -1;
+
+	if (property.samplerate != mixer->property.samplerate ||
+	    property.format != mixer->property.format ||
+	    property.channel != mixer->property.channel) {
+		nugu_error("pcm property is different from the mixer");
+		return -1;
+	}
+
+	/* Restart the input already added */
+	input = _find_input(mixer, pcm);
+	if (input) {
+		g_atomic_int_set(&input->paused, 0);
+		g_atomic_int_set(&input->ended, 0);
+		return 0;
+	}
+
+	input = _find_input(mixer, NULL);
+	if (!input) {
+		nugu_error("too many inputs");
+		return -1;
+	}
+
+	g_atomic_int_set(&input->paused, 0);
+	g_atomic_int_set(&input->ended, 0);
+
+	/* Publish the input to the mixing thread */
+	g_atomic_pointer_set(&input->pcm, pcm);
+
+	return 0;
+}
+
+EXPORT_API int nugu_mixer_remove_input(NuguMixer *mixer, NuguPcm *pcm)
+{
+	struct mixer_input *input;
+	gint seq;
+
+	g_return_val_if_fail(mixer != NULL, -1);
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	input = _find_input(mixer, pcm);
+	if (!input)
+		return -1;
+
+	g_atomic_pointer_set(&input->pcm, NULL);
+
+	/* Wait for the mixing that may still read the pcm */
+	seq = g_atomic_int_get(&mixer->mix_seq);
+	while (g_atomic_int_get(&mixer->mixing) &&
+	       g_atomic_int_get(&mixer->mix_seq) == seq)
+		g_usleep(MIXER_WAIT_USEC);
+
+	return 0;
+}
+
+EXPORT_API int nugu_mixer_set_input_paused(NuguMixer *mixer, NuguPcm *pcm,
+					   int paused)
+{
+	struct mixer_input *input;
+
+	g_return_val_if_fail(mixer != NULL, -1);
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	input = _find_input(mixer, pcm);
+	if (!input)
+		return -1;
+
+	g_atomic_int_set(&input->paused, paused ? 1 : 0);
+
+	return 0;
+}
+
+EXPORT_API int nugu_mixer_get_input_count(NuguMixer *mixer)
+{
+	int count = 0;
+	int i;
+
+	g_return_val_if_fail(mixer != NULL, -1);
+
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		if (g_atomic_pointer_get(&mixer->inputs[i].pcm))
+			count++;
+	}
+
+	return count;
+}
+
+EXPORT_API int nugu_mixer_mix(NuguMixer *mixer, void *data, size_t size)
+{
+	int mixed = 0;
+	int delay;
+	int i;
+
+	g_return_val_if_fail(mixer != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+
+	g_atomic_int_set(&mixer->mixing, 1);
+
+	delay = g_atomic_int_get(&mixer->device_delay);
+
+	for (i = 0; i < NUGU_MIXER_MAX_INPUTS; i++) {
+		struct mixer_input *input = mixer->inputs + i;
+		NuguPcm *pcm;
+
+		pcm = g_atomic_pointer_get(&input->pcm);
+		if (!pcm || g_atomic_int_get(&input->paused) ||
+		    g_atomic_int_get(&input->ended))
+			continue;
+
+		nugu_pcm_set_device_delay(pcm, delay);
+
+		if (_mix_input(mixer, pcm, data, size, mixed == 0) > 0) {
+			mixed++;
+			continue;
+		}
+
+		if (nugu_pcm_receive_is_last_data(pcm) &&
+		    nugu_pcm_get_data_size(pcm) == 0) {
+			g_atomic_int_set(&input->ended, 1);
+			if (mixer->end_cb)
+				mixer->end_cb(mixer, pcm, mixer->end_cb_data);
+		}
+	}
+
+	if (mixed == 0)
+		memset(data, 0, size);
+
+	g_atomic_int_inc(&mixer->mix_seq);
+	g_atomic_int_set(&mixer->mixing, 0);
+
+	return mixed;
+}
@@ -16,18 +16,25 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <sys/eventfd.h>
 #include <glib.h>
 #include <unistd.h>
 #include <string.h>
 
 #include "nugu_log.h"
+#include "nugu_config.h"
+#include "nugu_buffer.h"
 #include "nugu_uuid.h"
+#include "nugu_pool.h"
 #include "nugu_network_manager.h"
 #include "nugu_directive_sequencer.h"
 
 #include "http2_manage.h"
 
+/* Same as the default of NuguConfig::Key::ATTACHMENT_COALESCE_SIZE */
+#define DEFAULT_COALESCE_SIZE 8192
+
 enum pending_type {
 	PENDING_DIRECTIVE,
 	PENDING_ATTACHMENT
@@ -36,12 +43,24 @@ enum pending_type {
 struct recv_pending {
 	enum pending_type type;
 	void *data;
-	size_t length;
+	NuguChunkChain *chunks;
 	char *parent_msg_id;
 	char *media_type;
 	int is_end;
 };
 
+/* attachment data held to send with the next data of the same event */
+struct send_pending {
+	char *name_space;
+	char *name;
+	char *version;
+	char *parent_msg_id;
+	char *dialog_id;
+	int seq;
+	NuguBuffer *buf;
+	guint timer;
+};
+
 struct _nugu_network {
 	NuguNetworkStatus cur_status;
 	NetworkManagerCallback callback;
@@ -50,11 +69,17 @@ struct _nugu_network {
 	int efd;
 	guint event_source;
 	GAsyncQueue *recv_pendings;
+	NuguPool *pending_pool;
 
 	guint idle_source;
 
 	H2Manager *h2;
 
+	/* attachment coalescing (delay 0: disabled) */
+	int coalesce_delay;
+	size_t coalesce_size;
+	struct send_pending *send_pending;
+
 	pthread_mutex_t lock;
 };
 
@@ -81,28 +106,183 @@ EXPORT_API int nugu_network_manager_send_event(NuguEvent *nev)
 		nugu_event_peek_dialog_id(nev), nugu_event_peek_json(nev));
 }
 
-EXPORT_API int nugu_network_manager_send_event_data(NuguEvent *nev, int is_end,
-						    size_t length,
-						    unsigned char *data)
+static int _send_attachment(const char *name_space, const char *name,
+			    const char *version, const char *parent_msg_id,
+			    const char *dialog_id, int seq, int is_end,
+			    size_t length, unsigned char *data)
 {
-	int ret = -1;
 	char *msg_id;
+	int ret;
 
-	if (!_network) {
-		nugu_error("network manager not initialized");
+	if (!_network->h2) {
+		nugu_error("network is not connected");
 		return -1;
 	}
 
 	msg_id = nugu_uuid_generate_short();
 
-	ret = h2manager_send_event_attachment(
-		_network->h2, nugu_event_peek_namespace(nev),
-		nugu_event_peek_name(nev), nugu_event_peek_version(nev),
-		nugu_event_peek_msg_id(nev), msg_id,
-		nugu_event_peek_dialog_id(nev), nugu_event_get_seq(nev), is_end,
-		length, data);
+	ret = h2manager_send_event_attachment(_network->h2, name_space, name,
+					      version, parent_msg_id, msg_id,
+					      dialog_id, seq, is_end, length,
+					      data);
 
 	free(msg_id);
+
+	return ret;
+}
+
+static void _send_pending_free(struct send_pending *pending)
+{
+	if (pending->timer)
+		g_source_remove(pending->timer);
+
+	g_free(pending->name_space);
+	g_free(pending->name);
+	g_free(pending->version);
+	g_free(pending->parent_msg_id);
+	g_free(pending->dialog_id);
+	nugu_buffer_free(pending->buf, TRUE);
+
+	memset(pending, 0, sizeof(struct send_pending));
+	free(pending);
+}
+
+static struct send_pending *_send_pending_new(NuguEvent *nev)
+{
+	struct send_pending *pending;
+
+	pending = calloc(1, sizeof(struct send_pending));
+	if (!pending) {
+		error_nomem();
+		return NULL;
+	}
+
+	/* The event can be destroyed before the pending data is sent */
+	pending->name_space = g_strdup(nugu_event_peek_namespace(nev));
+	pending->name = g_strdup(nugu_event_peek_name(nev));
+	pending->version = g_strdup(nugu_event_peek_version(nev));
+	pending->parent_msg_id = g_strdup(nugu_event_peek_msg_id(nev));
+	pending->dialog_id = g_strdup(nugu_event_peek_dialog_id(nev));
+	pending->seq = nugu_event_get_seq(nev);
+	pending->buf = nugu_buffer_new(0);
+
+	return pending;
+}
+
+/* Send the pending data in a request. Called with the lock held. */
+static int _flush_send_pending(int is_end)
+{
+	struct send_pending *pending = _network->send_pending;
+	int ret;
+
+	if (!pending)
+		return 0;
+
+	_network->send_pending = NULL;
+
+	ret = _send_attachment(pending->name_space, pending->name,
+			       pending->version, pending->parent_msg_id,
+			       pending->dialog_id, pending->seq, is_end,
+			       nugu_buffer_get_size(pending->buf),
+			       (unsigned char *)nugu_buffer_peek(pending->buf));
+
+	_send_pending_free(pending);
+
+	return ret;
+}
+
+static gboolean _on_coalesce_timeout(gpointer userdata)
+{
+	struct send_pending *pending;
+	guint id;
+
+	if (!_network)
+		return FALSE;
+
+	id = g_source_get_id(g_main_current_source());
+
+	pthread_mutex_lock(&_network->lock);
+
+	/* The data may be already sent and replaced by new one */
+	pending = _network->send_pending;
+	if (pending && pending->timer == id) {
+		pending->timer = 0;
+		if (_flush_send_pending(0) < 0)
+			nugu_error("can't send the coalesced attachment");
+	}
+
+	pthread_mutex_unlock(&_network->lock);
+
+	return FALSE;
+}
+
+static int _send_event_data_coalesced(NuguEvent *nev, int is_end,
+				      size_t length, unsigned char *data)
+{
+	struct send_pending *pending;
+	int ret = 0;
+
+	pthread_mutex_lock(&_network->lock);
+
+	/* Data of another event is sent first */
+	pending = _network->send_pending;
+	if (pending && g_strcmp0(pending->parent_msg_id,
+				 nugu_event_peek_msg_id(nev)) != 0) {
+		if (_flush_send_pending(0) < 0)
+			nugu_error("can't send the coalesced attachment");
+		pending = NULL;
+	}
+
+	if (!pending) {
+		pending = _send_pending_new(nev);
+		if (!pending) {
+			pthread_mutex_unlock(&_network->lock);
+			return -1;
+		}
+
+		/* The seq is increased per request, not per data */
+		nugu_event_increase_seq(nev);
+		_network->send_pending = pending;
+	}
+
+	if (data != NULL && length > 0)
+		nugu_buffer_add(pending->buf, data, length);
+
+	if (is_end || (_network->coalesce_size > 0 &&
+		       nugu_buffer_get_size(pending->buf) >=
+			       _network->coalesce_size))
+		ret = _flush_send_pending(is_end);
+	else if (pending->timer == 0)
+		pending->timer = g_timeout_add(_network->coalesce_delay,
+					       _on_coalesce_timeout, NULL);
+
+	pthread_mutex_unlock(&_network->lock);
+
+	return ret;
+}
+
+EXPORT_API int nugu_network_manager_send_event_data(NuguEvent *nev, int is_end,
+						    size_t length,
+						    unsigned char *data)
+{
+	int ret;
+
+	if (!_network) {
+		nugu_error("network manager not initialized");
+		return -1;
+	}
+
+	/* The attachment stream doesn't need the coalescing */
+	if (_network->coalesce_delay > 0 && _network->h2 &&
+	    h2manager_is_attachment_stream(_network->h2) == 0)
+		return _send_event_data_coalesced(nev, is_end, length, data);
+
+	ret = _send_attachment(nugu_event_peek_namespace(nev),
+			       nugu_event_peek_name(nev),
+			       nugu_event_peek_version(nev),
+			       nugu_event_peek_msg_id(nev),
+			       nugu_event_peek_dialog_id(nev),
+			       nugu_event_get_seq(nev), is_end, length, data);
 	if (ret < 0)
 		return ret;
 
@@ -111,6 +291,35 @@ EXPORT_API int nugu_network_manager_send_event_data(NuguEvent *nev, int is_end,
 	return 0;
 }
 
+EXPORT_API int nugu_network_manager_close_event_data(NuguEvent *nev)
+{
+	struct send_pending *pending;
+
+	g_return_val_if_fail(nev != NULL, -1);
+
+	if (!_network) {
+		nugu_error("network manager not initialized");
+		return -1;
+	}
+
+	pthread_mutex_lock(&_network->lock);
+
+	pending = _network->send_pending;
+	if (pending && g_strcmp0(pending->parent_msg_id,
+				 nugu_event_peek_msg_id(nev)) == 0) {
+		_network->send_pending = NULL;
+		_send_pending_free(pending);
+	}
+
+	pthread_mutex_unlock(&_network->lock);
+
+	if (!_network->h2)
+		return 0;
+
+	return h2manager_close_event_attachment(_network->h2,
+						nugu_event_peek_msg_id(nev));
+}
+
 static gboolean on_event(GIOChannel *channel, GIOCondition cond,
 			 gpointer userdata)
 {
@@ -147,12 +356,11 @@ static gboolean on_event(GIOChannel *channel, GIOCondition cond,
 
 				nugu_directive_set_media_type(ndir,
 							      item->media_type);
-				nugu_directive_add_data(ndir, item->length,
-							item->data);
+				nugu_directive_add_chunks(ndir, item->chunks);
 			}
 
-			if (item->data)
-				free(item->data);
+			if (item->chunks)
+				nugu_chunk_chain_free(item->chunks);
 			if (item->parent_msg_id)
 				free(item->parent_msg_id);
 			if (item->media_type)
@@ -161,7 +369,7 @@ static gboolean on_event(GIOChannel *channel, GIOCondition cond,
 			nugu_error("invalid type: %d", item->type);
 		}
 
-		free(item);
+		nugu_pool_release(_network->pending_pool, item);
 	}
 
 	return TRUE;
@@ -194,11 +402,9 @@ EXPORT_API int nugu_network_manager_recv_directive(NuguDirective *ndir)
 		return -1;
 	}
 
-	item = (struct recv_pending *)malloc(sizeof(struct recv_pending));
-	if (!item) {
-		error_nomem();
+	item = nugu_pool_alloc(_network->pending_pool);
+	if (!item)
 		return -1;
-	}
 
 	item->type = PENDING_DIRECTIVE;
 	item->data = ndir;
@@ -211,6 +417,27 @@ EXPORT_API int nugu_network_manager_recv_directive_data(char *parent_msg_id,
 							int is_end,
 							size_t length,
 							unsigned char *data)
+{
+	NuguChunkChain *chunks;
+
+	chunks = nugu_chunk_chain_new();
+	if (!chunks)
+		return -1;
+
+	if (length > 0 && data) {
+		if (nugu_chunk_chain_add_take(chunks, data, length) < 0) {
+			nugu_chunk_chain_free(chunks);
+			return -1;
+		}
+	}
+
+	return nugu_network_manager_recv_directive_chunks(
+		parent_msg_id, media_type, is_end, chunks);
+}
+
+EXPORT_API int nugu_network_manager_recv_directive_chunks(
+	char *parent_msg_id, char *media_type, int is_end,
+	NuguChunkChain *chunks)
 {
 	struct recv_pending *item;
 
@@ -219,15 +446,13 @@ EXPORT_API int nugu_network_manager_recv_directive_data(char *parent_msg_id,
 		return -1;
 	}
 
-	item = (struct recv_pending *)malloc(sizeof(struct recv_pending));
-	if (!item) {
-		error_nomem();
+	item = nugu_pool_alloc(_network->pending_pool);
+	if (!item)
 		return -1;
-	}
 
 	item->type = PENDING_ATTACHMENT;
-	item->data = data;
-	item->length = length;
+	item->data = NULL;
+	item->chunks = chunks;
 	item->is_end = is_end;
 	item->parent_msg_id = parent_msg_id;
 	item->media_type = media_type;
@@ -235,6 +460,31 @@ EXPORT_API int nugu_network_manager_recv_directive_data(char *parent_msg_id,
 	return _event_to_main_context(item);
 }
 
+static void _load_coalesce_config(NetworkManager *nm)
+{
+	char *value;
+
+	nm->coalesce_size = DEFAULT_COALESCE_SIZE;
+
+	value = nugu_config_get(NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_DELAY);
+	if (value) {
+		nm->coalesce_delay = atoi(value);
+		if (nm->coalesce_delay < 0)
+			nm->coalesce_delay = 0;
+		free(value);
+	}
+
+	value = nugu_config_get(NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_SIZE);
+	if (value) {
+		if (atoi(value) >= 0)
+			nm->coalesce_size = (size_t)atoi(value);
+		free(value);
+	}
+
+	nugu_dbg("attachment coalescing: delay=%dms, size=%zu",
+		 nm->coalesce_delay, nm->coalesce_size);
+}
+
 static NetworkManager *nugu_network_manager_new(void)
 {
 	NetworkManager *nm;
@@ -257,10 +507,14 @@ static NetworkManager *nugu_network_manager_new(void)
 	nm->event_source = g_io_add_watch(channel, G_IO_IN, on_event, NULL);
 	g_io_channel_unref(channel);
 
-	nm->recv_pendings = g_async_queue_new_full(g_free);
+	nm->recv_pendings = g_async_queue_new();
+	nm->pending_pool = nugu_pool_new(sizeof(struct recv_pending), 0);
 
 	nm->cur_status = NUGU_NETWORK_UNKNOWN;
 
+	pthread_mutex_init(&nm->lock, NULL);
+	_load_coalesce_config(nm);
+
 	return nm;
 }
 
@@ -289,19 +543,27 @@ static void nugu_network_manager_free(NetworkManager *nm)
 			if (item->type == PENDING_DIRECTIVE) {
 				nugu_directive_free(item->data);
 			} else if (item->type == PENDING_ATTACHMENT) {
-				if (item->data)
-					free(item->data);
+				if (item->chunks)
+					nugu_chunk_chain_free(item->chunks);
 				if (item->parent_msg_id)
 					free(item->parent_msg_id);
 				if (item->media_type)
 					free(item->media_type);
 			}
-			free(item);
+			nugu_pool_release(nm->pending_pool, item);
 		}
 
 		g_async_queue_unref(nm->recv_pendings);
 	}
 
+	if (nm->pending_pool)
+		nugu_pool_free(nm->pending_pool);
+
+	if (nm->send_pending)
+		_send_pending_free(nm->send_pending);
+
+	pthread_mutex_destroy(&nm->lock);
+
 	memset(nm, 0, sizeof(NetworkManager));
 	free(nm);
 }
@@ -330,6 +592,11 @@ EXPORT_API void nugu_network_manager_deinitialize(void)
 	_network = NULL;
 
 	nugu_dirseq_deinitialize();
+
+	/* The pools are kept if the objects are still in use */
+	h2manager_deinitialize();
+	nugu_directive_pool_deinit();
+	nugu_chunk_chain_pool_deinit();
 }
 
 static void _emit_event(NuguNetworkStatus status)
@@ -436,6 +703,14 @@ EXPORT_API int nugu_network_manager_disconnect(void)
 		event_emit = 1;
 	}
 
+	/* Drop the coalesced attachment not sent yet */
+	pthread_mutex_lock(&_network->lock);
+	if (_network->send_pending) {
+		_send_pending_free(_network->send_pending);
+		_network->send_pending = NULL;
+	}
+	pthread_mutex_unlock(&_network->lock);
+
 	h2manager_set_status_callback(_network->h2, NULL, NULL);
 	h2manager_disconnect(_network->h2);
 	h2manager_free(_network->h2);
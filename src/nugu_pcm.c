@@ -24,6 +24,43 @@
 #include "nugu_pcm.h"
 #include "nugu_dbus.h"
 #include "nugu_buffer.h"
+#include "nugu_gain.h"
+#include "nugu_resampler.h"
+#include "nugu_audio_convert.h"
+
+#ifndef CONFIG_PCM_BUFFER_TIME
+#define CONFIG_PCM_BUFFER_TIME 1000
+#endif
+
+#define PCM_RING_MIN_SIZE 4096
+
+/* count of pushed blocks waiting for the measurement (power of two) */
+#define PCM_LATENCY_MARKS 64
+
+/* count of recent measurements kept for the histogram */
+#define PCM_LATENCY_WINDOW 256
+
+/* upper limit of the first histogram bucket (msec) */
+#define PCM_LATENCY_BUCKET_BASE 10
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define PCM_FORMAT_S16 AUDIO_FORMAT_S16_LE
+#define PCM_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_LE
+#else
+#define PCM_FORMAT_S16 AUDIO_FORMAT_S16_BE
+#define PCM_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_BE
+#endif
+
+struct conv_buffer {
+	unsigned char *data;
+	size_t size;
+};
+
+/* stream position of the first byte of a pushed block and its time */
+struct latency_mark {
+	guint pos;
+	gint64 time;
+};
 
 struct _nugu_pcm_driver {
 	char *name;
@@ -36,14 +73,94 @@ struct _nugu_pcm {
 	NuguPcmDriver *driver;
 	enum nugu_media_status status;
 	NuguAudioProperty property;
+	NuguAudioProperty device_property;
+	int has_device_property;
+	enum nugu_resampler_quality quality;
 	mediaEventCallback ecb;
 	mediaStatusCallback scb;
 	void *eud; /* user data for event callback */
 	void *sud; /* user data for status callback */
 	void *dud; /* user data for driver */
+	gint is_last;
+	gint volume;
+	gint duck_level;
+
+	/**
+	 * Lock-free ring between one producer (nugu_pcm_push_data) and one
+	 * consumer (nugu_pcm_get_data, usually the audio callback)
+	 *  - ring_size: power of two, allocated by nugu_pcm_start()
+	 *  - head: total bytes written (written only by the producer)
+	 *  - tail: total bytes read (written only by the consumer)
+	 *  - clear_pos: head at the last clear, applied by the consumer
+	 *  - clear_seq: incremented by each clear
+	 *  - clear_seen: last clear_seq applied (consumer private)
+	 */
+	unsigned char *ring;
+	guint ring_size;
+	gint head;
+	gint tail;
+	gint clear_pos;
+	gint clear_seq;
+	gint clear_seen;
+
+	/* data that does not fit in the ring (protected by mutex) */
 	NuguBuffer *buf;
-	int is_last;
-	int volume;
+	gint overflow_size;
+
+	/**
+	 * Conversion to the device property by the producer (protected by
+	 * mutex): property -> work_property -> resampler -> device property
+	 *  - convert_in: convert the pushed data to the work property
+	 *  - convert_out: convert the output of the resampler to the device
+	 *  - pending: part of frame remained from the last push (convert_in)
+	 */
+	int converter_changed;
+	int convert_in;
+	int convert_out;
+	NuguAudioProperty work_property;
+	NuguResampler *resampler;
+	unsigned char *pending;
+	size_t pending_size;
+	struct conv_buffer in_buf;
+	struct conv_buffer rs_buf;
+	struct conv_buffer out_buf;
+
+	/* used only by the consumer */
+	NuguGain *gain;
+
+	/**
+	 * Prebuffering and underrun accounting
+	 *  - prebuffer_ms: start threshold set by nugu_pcm_set_prebuffer_time
+	 *  - prebuffer_size, frame_size: in the device property (set by start)
+	 *  - buffering: wait until the threshold is buffered or is_last
+	 *  - playing: data was played since the last start or clear (consumer)
+	 *  - starved: the last read was short (consumer)
+	 *  - stats_*: counters written by the consumer
+	 */
+	gint prebuffer_ms;
+	size_t prebuffer_size;
+	size_t frame_size;
+	gint buffering;
+	int playing;
+	int starved;
+	gint stats_frames;
+	gint stats_silence_frames;
+	gint stats_underruns;
+
+	/**
+	 * Latency measurement
+	 *  - marks: written by the producer and published by mark_head,
+	 *    consumed when the consumer reads the marked position
+	 *  - device_delay: delay of the device reported by the driver (usec)
+	 *  - latency_*: recent measurements written by the consumer (usec)
+	 */
+	struct latency_mark marks[PCM_LATENCY_MARKS];
+	gint mark_head;
+	gint mark_tail;
+	gint device_delay;
+	gint latency_queue[PCM_LATENCY_WINDOW];
+	gint latency_device[PCM_LATENCY_WINDOW];
+	gint latency_count;
 
 	pthread_mutex_t mutex;
 };
@@ -174,11 +291,18 @@ EXPORT_API NuguPcm *nugu_pcm_new(const char *name, NuguPcmDriver *driver)
 	pcm->dud = NULL;
 	pcm->status = MEDIA_STATUS_STOPPED;
 	pcm->volume = NUGU_SET_VOLUME_MAX;
+	pcm->duck_level = NUGU_SET_VOLUME_MAX;
+	pcm->quality = NUGU_RESAMPLER_QUALITY_MEDIUM;
+	pcm->gain = nugu_gain_new();
 
-	if (pcm->buf == NULL) {
+	if (pcm->buf == NULL || pcm->gain == NULL) {
 		nugu_error("buffer new is internal error");
+		if (pcm->buf)
+			nugu_buffer_free(pcm->buf, TRUE);
+		if (pcm->gain)
+			nugu_gain_free(pcm->gain);
 		g_free(pcm->name);
-		free(pcm);
+		g_free(pcm);
 		return NULL;
 	}
 
@@ -194,10 +318,32 @@ EXPORT_API void nugu_pcm_free(NuguPcm *pcm)
 	g_return_if_fail(pcm != NULL);
 	g_return_if_fail(pcm->driver != NULL);
 
+	/*
+	 * Stop the driver first, so that it does not refer to the pcm and
+	 * removes the pending events. The owner is not notified.
+	 */
+	if (pcm->status != MEDIA_STATUS_STOPPED && pcm->driver->ops->stop) {
+		pcm->scb = NULL;
+		pcm->ecb = NULL;
+		pcm->driver->ops->stop(pcm->driver, pcm);
+	}
+
 	pcm->driver->ref_count--;
 
 	g_free(pcm->name);
 	nugu_buffer_free(pcm->buf, TRUE);
+	nugu_gain_free(pcm->gain);
+
+	if (pcm->ring)
+		free(pcm->ring);
+
+	if (pcm->resampler)
+		nugu_resampler_free(pcm->resampler);
+
+	free(pcm->pending);
+	free(pcm->in_buf.data);
+	free(pcm->rs_buf.data);
+	free(pcm->out_buf.data);
 
 	pthread_mutex_destroy(&pcm->mutex);
 
@@ -254,10 +400,575 @@ EXPORT_API int nugu_pcm_set_property(NuguPcm *pcm, NuguAudioProperty property)
 	g_return_val_if_fail(pcm != NULL, -1);
 
 	memcpy(&pcm->property, &property, sizeof(NuguAudioProperty));
+	pcm->converter_changed = 1;
+
+	return 0;
+}
+
+EXPORT_API int nugu_pcm_get_property(NuguPcm *pcm,
+				     NuguAudioProperty *property)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+	g_return_val_if_fail(property != NULL, -1);
+
+	memcpy(property, &pcm->property, sizeof(NuguAudioProperty));
+
+	return 0;
+}
+
+static const NuguAudioProperty *_get_device_property(NuguPcm *pcm)
+{
+	if (pcm->has_device_property)
+		return &pcm->device_property;
+
+	return &pcm->property;
+}
+
+EXPORT_API int nugu_pcm_set_device_property(NuguPcm *pcm,
+					    NuguAudioProperty property)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	memcpy(&pcm->device_property, &property, sizeof(NuguAudioProperty));
+	pcm->has_device_property = 1;
+	pcm->converter_changed = 1;
+
+	return 0;
+}
+
+EXPORT_API int nugu_pcm_get_device_property(NuguPcm *pcm,
+					    NuguAudioProperty *property)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+	g_return_val_if_fail(property != NULL, -1);
+
+	memcpy(property, _get_device_property(pcm), sizeof(NuguAudioProperty));
+
+	return 0;
+}
+
+EXPORT_API int
+nugu_pcm_set_resampler_quality(NuguPcm *pcm,
+			       enum nugu_resampler_quality quality)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+	g_return_val_if_fail(quality <= NUGU_RESAMPLER_QUALITY_HIGH, -1);
+
+	pcm->quality = quality;
+	pcm->converter_changed = 1;
+
+	return 0;
+}
+
+static guint _round_up_pow2(guint value)
+{
+	guint result = 1;
+
+	while (result < value)
+		result <<= 1;
+
+	return result;
+}
+
+static size_t _get_frame_size(const NuguAudioProperty *property)
+{
+	return nugu_audio_get_sample_width(property->format) *
+	       MAX(property->channel, 1);
+}
+
+/* Prepare the conversion. Must be called with the mutex held */
+static int _converter_reset(NuguPcm *pcm)
+{
+	const NuguAudioProperty *device = _get_device_property(pcm);
+	int same_layout;
+
+	pcm->pending_size = 0;
+
+	if (!pcm->converter_changed) {
+		if (pcm->resampler)
+			nugu_resampler_reset(pcm->resampler);
+		return 0;
+	}
+
+	if (pcm->resampler) {
+		nugu_resampler_free(pcm->resampler);
+		pcm->resampler = NULL;
+	}
+
+	free(pcm->pending);
+	pcm->pending = NULL;
+
+	if (_get_frame_size(&pcm->property) == 0 ||
+	    _get_frame_size(device) == 0) {
+		nugu_error("not support the audio format");
+		return -1;
+	}
+
+	if (device->channel != pcm->property.channel && device->channel != 1 &&
+	    pcm->property.channel != 1) {
+		nugu_error("not support the channel layout");
+		return -1;
+	}
+
+	same_layout = (device->format == pcm->property.format &&
+		       device->channel == pcm->property.channel);
+
+	memcpy(&pcm->work_property, device, sizeof(NuguAudioProperty));
+	pcm->convert_in = !same_layout;
+	pcm->convert_out = 0;
+
+	if (device->samplerate != pcm->property.samplerate) {
+		pcm->work_property.samplerate = pcm->property.samplerate;
+
+		/* Other formats are resampled in float */
+		if (!same_layout || (device->format != PCM_FORMAT_S16 &&
+				     device->format != PCM_FORMAT_FLOAT)) {
+			pcm->work_property.format = PCM_FORMAT_FLOAT;
+			pcm->convert_in = 1;
+			pcm->convert_out = (device->format != PCM_FORMAT_FLOAT);
+		}
+
+		pcm->resampler = nugu_resampler_new(
+			pcm->work_property, device->samplerate, pcm->quality);
+		if (!pcm->resampler)
+			return -1;
+	}
+
+	if (pcm->convert_in) {
+		pcm->pending = malloc(_get_frame_size(&pcm->property));
+		if (!pcm->pending) {
+			error_nomem();
+			return -1;
+		}
+	}
+
+	pcm->converter_changed = 0;
+
+	return 0;
+}
+
+/* Must be called while the driver does not get the data (stopped) */
+static int _ring_reset(NuguPcm *pcm)
+{
+	const NuguAudioProperty *device = _get_device_property(pcm);
+	gint64 bytes_per_sec = nugu_audio_get_bytes_per_sec(*device);
+	guint size;
+
+	size = (guint)(bytes_per_sec * CONFIG_PCM_BUFFER_TIME / 1000);
+	size = _round_up_pow2(MAX(size, PCM_RING_MIN_SIZE));
+
+	pthread_mutex_lock(&pcm->mutex);
+
+	if (_converter_reset(pcm) < 0) {
+		pthread_mutex_unlock(&pcm->mutex);
+		return -1;
+	}
+
+	if (pcm->ring_size != size) {
+		unsigned char *ring;
+
+		ring = malloc(size);
+		if (!ring) {
+			pthread_mutex_unlock(&pcm->mutex);
+			error_nomem();
+			return -1;
+		}
+
+		if (pcm->ring)
+			free(pcm->ring);
+
+		pcm->ring = ring;
+		pcm->ring_size = size;
+	}
+
+	g_atomic_int_set(&pcm->head, 0);
+	g_atomic_int_set(&pcm->tail, 0);
+	g_atomic_int_set(&pcm->clear_pos, 0);
+	pcm->clear_seen = g_atomic_int_get(&pcm->clear_seq);
+
+	nugu_buffer_clear(pcm->buf);
+	g_atomic_int_set(&pcm->overflow_size, 0);
+	g_atomic_int_set(&pcm->is_last, 0);
+
+	nugu_gain_set_property(pcm->gain, *device);
+	nugu_gain_reset(pcm->gain);
+
+	pcm->frame_size = MAX(_get_frame_size(device), 1);
+	pcm->prebuffer_size = (size_t)(bytes_per_sec *
+				       g_atomic_int_get(&pcm->prebuffer_ms) /
+				       1000);
+	g_atomic_int_set(&pcm->buffering, pcm->prebuffer_size > 0);
+	pcm->playing = 0;
+	pcm->starved = 0;
+	g_atomic_int_set(&pcm->stats_frames, 0);
+	g_atomic_int_set(&pcm->stats_silence_frames, 0);
+	g_atomic_int_set(&pcm->stats_underruns, 0);
+
+	g_atomic_int_set(&pcm->mark_head, 0);
+	g_atomic_int_set(&pcm->mark_tail, 0);
+	g_atomic_int_set(&pcm->device_delay, 0);
+	g_atomic_int_set(&pcm->latency_count, 0);
+
+	pthread_mutex_unlock(&pcm->mutex);
+
+	return 0;
+}
+
+/* Producer side. Must be called with the mutex held */
+static size_t _ring_write(NuguPcm *pcm, const char *data, size_t size)
+{
+	guint head;
+	guint space;
+	guint offset;
+	size_t first;
+
+	if (!pcm->ring)
+		return 0;
+
+	head = g_atomic_int_get(&pcm->head);
+	space = pcm->ring_size - (head - (guint)g_atomic_int_get(&pcm->tail));
+
+	size = MIN(size, space);
+	if (size == 0)
+		return 0;
+
+	offset = head & (pcm->ring_size - 1);
+	first = MIN(size, pcm->ring_size - offset);
+
+	memcpy(pcm->ring + offset, data, first);
+	memcpy(pcm->ring, data + first, size - first);
+
+	/* Publish the data to the consumer */
+	g_atomic_int_set(&pcm->head, (gint)(head + size));
+
+	return size;
+}
+
+/* Move the overflow data to the ring. Must be called with the mutex held */
+static void _ring_flush_overflow(NuguPcm *pcm)
+{
+	size_t size;
+	size_t written;
+
+	size = nugu_buffer_get_size(pcm->buf);
+	if (size == 0)
+		return;
+
+	written = _ring_write(pcm, nugu_buffer_peek(pcm->buf), size);
+	if (written > 0)
+		nugu_buffer_shift_left(pcm->buf, written);
+
+	g_atomic_int_set(&pcm->overflow_size, (gint)(size - written));
+}
+
+/* Producer side. Must be called with the mutex held */
+static int _ring_push(NuguPcm *pcm, const char *data, size_t size)
+{
+	size_t written = 0;
+	int ret = 0;
+
+	/* Keep the order of data: the overflow data goes first */
+	_ring_flush_overflow(pcm);
+	if (nugu_buffer_get_size(pcm->buf) == 0)
+		written = _ring_write(pcm, data, size);
+
+	if (written < size) {
+		if (nugu_buffer_add(pcm->buf, data + written,
+				    size - written) == (size_t)-1)
+			ret = -1;
+
+		g_atomic_int_set(&pcm->overflow_size,
+				 (gint)nugu_buffer_get_size(pcm->buf));
+	}
+
+	return ret;
+}
+
+/* Grow the buffer for the conversion. Must be called with the mutex held */
+static int _conv_reserve(struct conv_buffer *buf, size_t size)
+{
+	unsigned char *data;
+
+	if (size <= buf->size)
+		return 0;
+
+	data = realloc(buf->data, size);
+	if (!data) {
+		error_nomem();
+		return -1;
+	}
+
+	buf->data = data;
+	buf->size = size;
 
 	return 0;
 }
 
+/* Producer side: data in the device property after the resampler */
+static int _output_push(NuguPcm *pcm, const unsigned char *data, size_t size)
+{
+	const NuguAudioProperty *device = _get_device_property(pcm);
+	size_t frames;
+	size_t need;
+
+	if (!pcm->convert_out)
+		return _ring_push(pcm, (const char *)data, size);
+
+	frames = size / _get_frame_size(&pcm->work_property);
+	need = frames * _get_frame_size(device);
+	if (_conv_reserve(&pcm->out_buf, need) < 0)
+		return -1;
+
+	if (nugu_audio_convert(pcm->work_property, data, *device,
+			       pcm->out_buf.data, frames) < 0)
+		return -1;
+
+	return _ring_push(pcm, (const char *)pcm->out_buf.data, need);
+}
+
+/* Producer side. Must be called with the mutex held */
+static int _resample_flush(NuguPcm *pcm)
+{
+	size_t need;
+	int length;
+
+	need = nugu_resampler_get_flush_size(pcm->resampler);
+	if (_conv_reserve(&pcm->rs_buf, need) < 0)
+		return -1;
+
+	length = nugu_resampler_flush(pcm->resampler, pcm->rs_buf.data,
+				      pcm->rs_buf.size);
+	if (length <= 0)
+		return length;
+
+	return _output_push(pcm, pcm->rs_buf.data, length);
+}
+
+/* Producer side: data in the work property */
+static int _work_push(NuguPcm *pcm, const unsigned char *data, size_t size)
+{
+	size_t need;
+	int length;
+
+	if (!pcm->resampler)
+		return _output_push(pcm, data, size);
+
+	need = nugu_resampler_get_output_size(pcm->resampler, size);
+	if (_conv_reserve(&pcm->rs_buf, need) < 0)
+		return -1;
+
+	length = nugu_resampler_process(pcm->resampler, data, size,
+					pcm->rs_buf.data, pcm->rs_buf.size);
+	if (length <= 0)
+		return length;
+
+	return _output_push(pcm, pcm->rs_buf.data, length);
+}
+
+/* Producer side: whole frames in the property of pcm */
+static int _convert_push(NuguPcm *pcm, const unsigned char *data,
+			 size_t frames)
+{
+	size_t need = frames * _get_frame_size(&pcm->work_property);
+
+	if (_conv_reserve(&pcm->in_buf, need) < 0)
+		return -1;
+
+	if (nugu_audio_convert(pcm->property, data, pcm->work_property,
+			       pcm->in_buf.data, frames) < 0)
+		return -1;
+
+	return _work_push(pcm, pcm->in_buf.data, need);
+}
+
+/* Producer side: pushed data. Must be called with the mutex held */
+static int _input_push(NuguPcm *pcm, const char *data, size_t size,
+		       int is_last)
+{
+	const unsigned char *src = (const unsigned char *)data;
+	size_t frame_size;
+	size_t frames;
+	int ret = 0;
+
+	if (!pcm->convert_in) {
+		ret = _work_push(pcm, src, size);
+	} else {
+		frame_size = _get_frame_size(&pcm->property);
+
+		/* Complete the frame remained from the last push */
+		if (pcm->pending_size > 0) {
+			size_t length =
+				MIN(size, frame_size - pcm->pending_size);
+
+			memcpy(pcm->pending + pcm->pending_size, src, length);
+			pcm->pending_size += length;
+			src += length;
+			size -= length;
+
+			if (pcm->pending_size == frame_size) {
+				ret = _convert_push(pcm, pcm->pending, 1);
+				pcm->pending_size = 0;
+			}
+		}
+
+		frames = size / frame_size;
+		if (frames > 0 && _convert_push(pcm, src, frames) < 0)
+			ret = -1;
+
+		size -= frames * frame_size;
+		if (size > 0) {
+			memcpy(pcm->pending, src + frames * frame_size, size);
+			pcm->pending_size = size;
+		}
+	}
+
+	/* The last samples remained in the resampler */
+	if (is_last && pcm->resampler && _resample_flush(pcm) < 0)
+		ret = -1;
+
+	return ret;
+}
+
+/* Producer side. Must be called with the mutex held */
+static void _latency_mark(NuguPcm *pcm)
+{
+	guint head = g_atomic_int_get(&pcm->mark_head);
+	struct latency_mark *mark;
+
+	/* Skip the block if the consumer does not keep up */
+	if (head - (guint)g_atomic_int_get(&pcm->mark_tail) >=
+	    PCM_LATENCY_MARKS)
+		return;
+
+	mark = pcm->marks + (head & (PCM_LATENCY_MARKS - 1));
+	mark->pos = (guint)g_atomic_int_get(&pcm->head) +
+		    (guint)g_atomic_int_get(&pcm->overflow_size);
+	mark->time = g_get_monotonic_time();
+
+	g_atomic_int_set(&pcm->mark_head, (gint)(head + 1));
+}
+
+/* Consumer side: discard the marks before the position */
+static void _latency_drop(NuguPcm *pcm, guint pos)
+{
+	guint tail = g_atomic_int_get(&pcm->mark_tail);
+	guint head = g_atomic_int_get(&pcm->mark_head);
+
+	while (tail != head &&
+	       (gint)(pcm->marks[tail & (PCM_LATENCY_MARKS - 1)].pos - pos) < 0)
+		tail++;
+
+	g_atomic_int_set(&pcm->mark_tail, (gint)tail);
+}
+
+/* Consumer side: measure the blocks which start before the position */
+static void _latency_measure(NuguPcm *pcm, guint pos)
+{
+	guint tail = g_atomic_int_get(&pcm->mark_tail);
+	guint head = g_atomic_int_get(&pcm->mark_head);
+	gint64 now = 0;
+
+	while (tail != head) {
+		struct latency_mark *mark;
+		guint index;
+
+		mark = pcm->marks + (tail & (PCM_LATENCY_MARKS - 1));
+		if ((gint)(mark->pos - pos) >= 0)
+			break;
+
+		if (now == 0)
+			now = g_get_monotonic_time();
+
+		index = (guint)g_atomic_int_get(&pcm->latency_count) %
+			PCM_LATENCY_WINDOW;
+		g_atomic_int_set(&pcm->latency_queue[index],
+				 (gint)(now - mark->time));
+		g_atomic_int_set(&pcm->latency_device[index],
+				 g_atomic_int_get(&pcm->device_delay));
+		g_atomic_int_inc(&pcm->latency_count);
+		tail++;
+	}
+
+	g_atomic_int_set(&pcm->mark_tail, (gint)tail);
+}
+
+/* Consumer side: discard the data pushed before the last clear */
+static void _ring_apply_clear(NuguPcm *pcm)
+{
+	gint seq;
+	guint tail;
+	guint pos;
+
+	seq = g_atomic_int_get(&pcm->clear_seq);
+	if (seq == pcm->clear_seen)
+		return;
+
+	pcm->clear_seen = seq;
+
+	tail = g_atomic_int_get(&pcm->tail);
+	pos = g_atomic_int_get(&pcm->clear_pos);
+	if ((gint)(pos - tail) > 0)
+		g_atomic_int_set(&pcm->tail, (gint)pos);
+
+	nugu_gain_reset(pcm->gain);
+
+	/* The discarded blocks are not measured */
+	_latency_drop(pcm, pos);
+
+	/* The next data is prebuffered again */
+	g_atomic_int_set(&pcm->buffering, pcm->prebuffer_size > 0);
+	pcm->playing = 0;
+	pcm->starved = 0;
+}
+
+/**
+ * Consumer side: count the part of the request which is not filled while
+ * playing, and start the re-buffering at the underrun.
+ */
+static void _account_read(NuguPcm *pcm, size_t request, size_t size,
+			  int is_last)
+{
+	if (size > 0) {
+		pcm->playing = 1;
+		g_atomic_int_add(&pcm->stats_frames,
+				 (gint)(size / pcm->frame_size));
+	}
+
+	if (size == request || is_last || !pcm->playing) {
+		pcm->starved = 0;
+		return;
+	}
+
+	g_atomic_int_add(&pcm->stats_silence_frames,
+			 (gint)((request - size) / pcm->frame_size));
+
+	if (pcm->starved)
+		return;
+
+	pcm->starved = 1;
+	g_atomic_int_inc(&pcm->stats_underruns);
+
+	if (pcm->prebuffer_size > 0)
+		g_atomic_int_set(&pcm->buffering, 1);
+}
+
+static size_t _ring_get_size(NuguPcm *pcm)
+{
+	guint head;
+	guint tail;
+	guint pos;
+
+	head = g_atomic_int_get(&pcm->head);
+	tail = g_atomic_int_get(&pcm->tail);
+	pos = g_atomic_int_get(&pcm->clear_pos);
+
+	/* The data before the pending clear position is not counted */
+	if ((gint)(pos - tail) > 0)
+		tail = pos;
+
+	return head - tail;
+}
+
 EXPORT_API int nugu_pcm_start(NuguPcm *pcm)
 {
 	g_return_val_if_fail(pcm != NULL, -1);
@@ -267,10 +978,23 @@ EXPORT_API int nugu_pcm_start(NuguPcm *pcm)
 		nugu_error("Not supported");
 		return -1;
 	}
-	nugu_pcm_clear_buffer(pcm);
+
+	/*
+	 * The pcm started again without nugu_pcm_stop() can still be read by
+	 * the driver (e.g. an input of the mixer), so the driver is stopped
+	 * before the ring is reset.
+	 */
+	if (pcm->status != MEDIA_STATUS_STOPPED && pcm->driver->ops->stop &&
+	    pcm->driver->ops->stop(pcm->driver, pcm) < 0)
+		return -1;
+
+	if (_ring_reset(pcm) < 0)
+		return -1;
+
 	nugu_pcm_set_userdata(pcm, NULL);
 
-	return pcm->driver->ops->start(pcm->driver, pcm, pcm->property);
+	return pcm->driver->ops->start(pcm->driver, pcm,
+				       *_get_device_property(pcm));
 }
 
 EXPORT_API int nugu_pcm_stop(NuguPcm *pcm)
@@ -317,14 +1041,10 @@ EXPORT_API int nugu_pcm_set_volume(NuguPcm *pcm, int volume)
 {
 	g_return_val_if_fail(pcm != NULL, -1);
 
-	if (volume < NUGU_SET_VOLUME_MIN)
-		pcm->volume = NUGU_SET_VOLUME_MIN;
-	else if (volume > NUGU_SET_VOLUME_MAX)
-		pcm->volume = NUGU_SET_VOLUME_MAX;
-	else
-		pcm->volume = volume;
+	volume = CLAMP(volume, NUGU_SET_VOLUME_MIN, NUGU_SET_VOLUME_MAX);
+	g_atomic_int_set(&pcm->volume, volume);
 
-	nugu_dbg("change volume: %d", pcm->volume);
+	nugu_dbg("change volume: %d", volume);
 
 	return 0;
 }
@@ -333,7 +1053,26 @@ EXPORT_API int nugu_pcm_get_volume(NuguPcm *pcm)
 {
 	g_return_val_if_fail(pcm != NULL, -1);
 
-	return pcm->volume;
+	return g_atomic_int_get(&pcm->volume);
+}
+
+EXPORT_API int nugu_pcm_set_duck_level(NuguPcm *pcm, int level)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	level = CLAMP(level, NUGU_SET_VOLUME_MIN, NUGU_SET_VOLUME_MAX);
+	g_atomic_int_set(&pcm->duck_level, level);
+
+	nugu_dbg("change duck level: %d", level);
+
+	return 0;
+}
+
+EXPORT_API int nugu_pcm_get_duck_level(NuguPcm *pcm)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	return g_atomic_int_get(&pcm->duck_level);
 }
 
 EXPORT_API void nugu_pcm_set_status_callback(NuguPcm *pcm,
@@ -409,7 +1148,16 @@ EXPORT_API void nugu_pcm_clear_buffer(NuguPcm *pcm)
 	pthread_mutex_lock(&pcm->mutex);
 
 	nugu_buffer_clear(pcm->buf);
-	pcm->is_last = 0;
+	g_atomic_int_set(&pcm->overflow_size, 0);
+	g_atomic_int_set(&pcm->is_last, 0);
+
+	if (pcm->resampler)
+		nugu_resampler_reset(pcm->resampler);
+	pcm->pending_size = 0;
+
+	/* The consumer discards the ring data at the next get_data() */
+	g_atomic_int_set(&pcm->clear_pos, g_atomic_int_get(&pcm->head));
+	g_atomic_int_inc(&pcm->clear_seq);
 
 	pthread_mutex_unlock(&pcm->mutex);
 }
@@ -417,7 +1165,7 @@ EXPORT_API void nugu_pcm_clear_buffer(NuguPcm *pcm)
 EXPORT_API int nugu_pcm_push_data(NuguPcm *pcm, const char *data, size_t size,
 				  int is_last)
 {
-	int ret;
+	int ret = size;
 
 	g_return_val_if_fail(pcm != NULL, -1);
 	g_return_val_if_fail(pcm->buf != NULL, -1);
@@ -427,16 +1175,20 @@ EXPORT_API int nugu_pcm_push_data(NuguPcm *pcm, const char *data, size_t size,
 
 	pthread_mutex_lock(&pcm->mutex);
 
-	if (!pcm->is_last)
-		pcm->is_last = is_last;
+	_latency_mark(pcm);
+
+	if (_input_push(pcm, data, size, is_last) < 0)
+		ret = -1;
 
-	ret = nugu_buffer_add(pcm->buf, (void *)data, size);
+	/* Set after the data is visible to the consumer */
+	if (is_last)
+		g_atomic_int_set(&pcm->is_last, 1);
 
 	pthread_mutex_unlock(&pcm->mutex);
 
 	if (pcm->driver->ops->push_data)
 		pcm->driver->ops->push_data(pcm->driver, pcm, data, size,
-					    pcm->is_last);
+					    g_atomic_int_get(&pcm->is_last));
 
 	return ret;
 }
@@ -448,76 +1200,274 @@ EXPORT_API int nugu_pcm_push_data_done(NuguPcm *pcm)
 
 	pthread_mutex_lock(&pcm->mutex);
 
-	pcm->is_last = 1;
+	/* The last samples remained in the resampler */
+	if (pcm->resampler && !g_atomic_int_get(&pcm->is_last))
+		_resample_flush(pcm);
+
+	g_atomic_int_set(&pcm->is_last, 1);
 
 	pthread_mutex_unlock(&pcm->mutex);
 
 	return 0;
 }
 
+EXPORT_API void *nugu_pcm_reserve_data(NuguPcm *pcm, size_t *size)
+{
+	guint head;
+	guint space;
+	guint offset;
+
+	g_return_val_if_fail(pcm != NULL, NULL);
+	g_return_val_if_fail(size != NULL, NULL);
+
+	*size = 0;
+
+	pthread_mutex_lock(&pcm->mutex);
+
+	/* The data should be converted, or the ring is not allocated yet */
+	if (!pcm->ring || pcm->convert_in || pcm->resampler ||
+	    pcm->convert_out)
+		goto unavailable;
+
+	/* Keep the order of data: the overflow data goes first */
+	_ring_flush_overflow(pcm);
+	if (nugu_buffer_get_size(pcm->buf) > 0)
+		goto unavailable;
+
+	head = g_atomic_int_get(&pcm->head);
+	space = pcm->ring_size - (head - (guint)g_atomic_int_get(&pcm->tail));
+	offset = head & (pcm->ring_size - 1);
+
+	/* Only the contiguous space until the end of the ring */
+	*size = MIN(space, pcm->ring_size - offset);
+	if (*size == 0)
+		goto unavailable;
+
+	_latency_mark(pcm);
+
+	/* The mutex is released by nugu_pcm_commit_data() */
+	return pcm->ring + offset;
+
+unavailable:
+	pthread_mutex_unlock(&pcm->mutex);
+	return NULL;
+}
+
+EXPORT_API int nugu_pcm_commit_data(NuguPcm *pcm, size_t size)
+{
+	guint head;
+	guint space;
+	guint offset;
+	int ret = 0;
+
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	head = g_atomic_int_get(&pcm->head);
+	space = pcm->ring_size - (head - (guint)g_atomic_int_get(&pcm->tail));
+	offset = head & (pcm->ring_size - 1);
+
+	if (size > MIN(space, pcm->ring_size - offset)) {
+		nugu_error("commit size(%zd) is over the reserved", size);
+		size = 0;
+		ret = -1;
+	}
+
+	/* Publish the data to the consumer */
+	if (size > 0)
+		g_atomic_int_set(&pcm->head, (gint)(head + size));
+
+	pthread_mutex_unlock(&pcm->mutex);
+
+	if (size > 0 && pcm->driver && pcm->driver->ops->push_data)
+		pcm->driver->ops->push_data(pcm->driver, pcm,
+					    (const char *)pcm->ring + offset,
+					    size,
+					    g_atomic_int_get(&pcm->is_last));
+
+	return ret;
+}
+
 EXPORT_API int nugu_pcm_get_data(NuguPcm *pcm, char *data, size_t size)
 {
-	size_t data_size;
-	const char *ptr;
-	float vol;
-	int ret;
-	size_t i;
+	size_t request = size;
+	guint tail;
+	guint offset;
+	size_t first;
+	int is_last;
+	int volume;
 
 	g_return_val_if_fail(pcm != NULL, -1);
 	g_return_val_if_fail(pcm->buf != NULL, -1);
 	g_return_val_if_fail(data != NULL, -1);
 	g_return_val_if_fail(size != 0, -1);
 
-	pthread_mutex_lock(&pcm->mutex);
-
-	data_size = nugu_buffer_get_size(pcm->buf);
-	if (data_size < size)
-		size = data_size;
+	_ring_apply_clear(pcm);
 
-	ptr = nugu_buffer_peek(pcm->buf);
-	if (ptr == NULL) {
+	/*
+	 * Refill the ring from the overflow data only if the producer does
+	 * not hold the lock. The consumer never waits for the producer.
+	 */
+	if (g_atomic_int_get(&pcm->overflow_size) > 0 &&
+	    pthread_mutex_trylock(&pcm->mutex) == 0) {
+		_ring_flush_overflow(pcm);
 		pthread_mutex_unlock(&pcm->mutex);
-
-		nugu_error("buffer peek is internal error");
-		return -1;
 	}
 
-	vol = (float)pcm->volume / NUGU_SET_VOLUME_MAX;
+	if (!pcm->ring)
+		return 0;
 
-	for (i = 0; i < size; i++)
-		*(data + i) = *(ptr + i) * vol;
+	/* All data is visible to the consumer once is_last is set */
+	is_last = g_atomic_int_get(&pcm->is_last);
 
-	ret = nugu_buffer_shift_left(pcm->buf, size);
-	if (ret == -1) {
-		pthread_mutex_unlock(&pcm->mutex);
+	/* Wait until the threshold is buffered (or the stream is complete) */
+	if (g_atomic_int_get(&pcm->buffering)) {
+		if (!is_last &&
+		    nugu_pcm_get_data_size(pcm) < pcm->prebuffer_size) {
+			_account_read(pcm, request, 0, is_last);
+			return 0;
+		}
 
-		nugu_error("buffer shift left is internal error");
-		return -1;
+		g_atomic_int_set(&pcm->buffering, 0);
+		pcm->starved = 0;
 	}
 
-	pthread_mutex_unlock(&pcm->mutex);
+	tail = g_atomic_int_get(&pcm->tail);
+	size = MIN(size, (guint)g_atomic_int_get(&pcm->head) - tail);
+
+	_account_read(pcm, request, size, is_last);
+	if (size == 0)
+		return 0;
+
+	offset = tail & (pcm->ring_size - 1);
+	first = MIN(size, pcm->ring_size - offset);
+
+	memcpy(data, pcm->ring + offset, first);
+	memcpy(data + first, pcm->ring, size - first);
+
+	/* Return the space to the producer */
+	g_atomic_int_set(&pcm->tail, (gint)(tail + size));
+
+	_latency_measure(pcm, tail + size);
+
+	/* Volume and ducking changes are applied with a short ramp */
+	volume = g_atomic_int_get(&pcm->volume) *
+		 g_atomic_int_get(&pcm->duck_level) / NUGU_SET_VOLUME_MAX;
+	nugu_gain_set_volume(pcm->gain, volume);
+	nugu_gain_apply(pcm->gain, data, data, size);
 
 	return size;
 }
 
 EXPORT_API size_t nugu_pcm_get_data_size(NuguPcm *pcm)
 {
-	size_t ret;
+	g_return_val_if_fail(pcm != NULL, -1);
 
+	return _ring_get_size(pcm) + g_atomic_int_get(&pcm->overflow_size);
+}
+
+EXPORT_API int nugu_pcm_set_prebuffer_time(NuguPcm *pcm, int msec)
+{
 	g_return_val_if_fail(pcm != NULL, -1);
+	g_return_val_if_fail(msec >= 0, -1);
 
-	pthread_mutex_lock(&pcm->mutex);
+	g_atomic_int_set(&pcm->prebuffer_ms, msec);
 
-	ret = nugu_buffer_get_size(pcm->buf);
+	return 0;
+}
 
-	pthread_mutex_unlock(&pcm->mutex);
+EXPORT_API int nugu_pcm_get_prebuffer_time(NuguPcm *pcm)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
 
-	return ret;
+	return g_atomic_int_get(&pcm->prebuffer_ms);
+}
+
+EXPORT_API int nugu_pcm_get_stats(NuguPcm *pcm, NuguPcmStats *stats)
+{
+	int bytes_per_sec;
+
+	g_return_val_if_fail(pcm != NULL, -1);
+	g_return_val_if_fail(stats != NULL, -1);
+
+	stats->frames = (unsigned int)g_atomic_int_get(&pcm->stats_frames);
+	stats->silence_frames =
+		(unsigned int)g_atomic_int_get(&pcm->stats_silence_frames);
+	stats->underruns =
+		(unsigned int)g_atomic_int_get(&pcm->stats_underruns);
+	stats->is_buffering = g_atomic_int_get(&pcm->buffering);
+
+	stats->buffered_ms = 0;
+	bytes_per_sec =
+		nugu_audio_get_bytes_per_sec(*_get_device_property(pcm));
+	if (bytes_per_sec > 0)
+		stats->buffered_ms = (int)((gint64)nugu_pcm_get_data_size(pcm) *
+					   1000 / bytes_per_sec);
+
+	return 0;
+}
+
+EXPORT_API int nugu_pcm_set_device_delay(NuguPcm *pcm, int usec)
+{
+	g_return_val_if_fail(pcm != NULL, -1);
+
+	g_atomic_int_set(&pcm->device_delay, MAX(usec, 0));
+
+	return 0;
+}
+
+static int _latency_get_bucket(gint64 usec)
+{
+	gint64 limit = PCM_LATENCY_BUCKET_BASE * 1000;
+	int i;
+
+	for (i = 0; i < NUGU_PCM_LATENCY_BUCKETS - 1; i++) {
+		if (usec < limit)
+			return i;
+
+		limit *= 2;
+	}
+
+	return NUGU_PCM_LATENCY_BUCKETS - 1;
+}
+
+EXPORT_API int nugu_pcm_get_latency(NuguPcm *pcm, NuguPcmLatency *latency)
+{
+	gint64 queue_sum = 0;
+	gint64 device_sum = 0;
+	guint count;
+	guint i;
+
+	g_return_val_if_fail(pcm != NULL, -1);
+	g_return_val_if_fail(latency != NULL, -1);
+
+	memset(latency, 0, sizeof(NuguPcmLatency));
+
+	count = MIN((guint)g_atomic_int_get(&pcm->latency_count),
+		    PCM_LATENCY_WINDOW);
+
+	for (i = 0; i < count; i++) {
+		gint queue = g_atomic_int_get(&pcm->latency_queue[i]);
+		gint device = g_atomic_int_get(&pcm->latency_device[i]);
+
+		queue_sum += queue;
+		device_sum += device;
+		latency->queue_max = MAX(latency->queue_max, queue);
+		latency->device_max = MAX(latency->device_max, device);
+		latency->histogram[_latency_get_bucket(queue + device)]++;
+	}
+
+	latency->count = count;
+	if (count > 0) {
+		latency->queue_avg = (int)(queue_sum / count);
+		latency->device_avg = (int)(device_sum / count);
+	}
+
+	return 0;
 }
 
 EXPORT_API int nugu_pcm_receive_is_last_data(NuguPcm *pcm)
 {
 	g_return_val_if_fail(pcm != NULL, -1);
 
-	return pcm->is_last;
+	return g_atomic_int_get(&pcm->is_last);
 }
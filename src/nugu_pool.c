@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <glib.h>
+
+#include "nugu_log.h"
+#include "nugu_pool.h"
+
+#define DEFAULT_ITEMS_PER_SLAB 16
+
+/* Same alignment as malloc() on 64bit systems */
+#define POOL_ALIGN 16
+#define POOL_ALIGN_SIZE(x)                                                     \
+	(((x) + POOL_ALIGN - 1) & ~((size_t)POOL_ALIGN - 1))
+
+/* The memory of a free object is used as a link of the free list */
+struct pool_free_item {
+	struct pool_free_item *next;
+};
+
+struct pool_slab {
+	struct pool_slab *next;
+};
+
+struct _nugu_pool {
+	size_t item_size;
+	size_t stride;
+	int items_per_slab;
+
+	struct pool_slab *slabs;
+	struct pool_free_item *free_list;
+
+	NuguPoolStats stats;
+
+	pthread_mutex_t lock;
+};
+
+EXPORT_API NuguPool *nugu_pool_new(size_t item_size, int items_per_slab)
+{
+	NuguPool *pool;
+
+	g_return_val_if_fail(item_size > 0, NULL);
+
+	pool = calloc(1, sizeof(struct _nugu_pool));
+	if (!pool) {
+		error_nomem();
+		return NULL;
+	}
+
+	if (items_per_slab <= 0)
+		items_per_slab = DEFAULT_ITEMS_PER_SLAB;
+
+	pool->item_size = item_size;
+	pool->items_per_slab = items_per_slab;
+
+	pool->stride = POOL_ALIGN_SIZE(
+		MAX(item_size, sizeof(struct pool_free_item)));
+
+	pthread_mutex_init(&pool->lock, NULL);
+
+	return pool;
+}
+
+EXPORT_API void nugu_pool_free(NuguPool *pool)
+{
+	struct pool_slab *slab;
+
+	g_return_if_fail(pool != NULL);
+
+	if (pool->stats.in_use > 0)
+		nugu_dbg("pool(%p) destroyed with %d objects in use", pool,
+			 pool->stats.in_use);
+
+	slab = pool->slabs;
+	while (slab) {
+		struct pool_slab *next = slab->next;
+
+		free(slab);
+		slab = next;
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+
+	memset(pool, 0, sizeof(struct _nugu_pool));
+	free(pool);
+}
+
+/* Must be called with the lock held */
+static int _pool_add_slab(NuguPool *pool)
+{
+	struct pool_slab *slab;
+	unsigned char *pos;
+	size_t header;
+	int i;
+
+	header = POOL_ALIGN_SIZE(sizeof(struct pool_slab));
+
+	slab = malloc(header + pool->stride * pool->items_per_slab);
+	if (!slab) {
+		error_nomem();
+		return -1;
+	}
+
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+
+	pos = (unsigned char *)slab + header;
+	for (i = 0; i < pool->items_per_slab; i++) {
+		struct pool_free_item *item = (struct pool_free_item *)pos;
+
+		item->next = pool->free_list;
+		pool->free_list = item;
+		pos += pool->stride;
+	}
+
+	pool->stats.slabs++;
+	pool->stats.available += pool->items_per_slab;
+
+	return 0;
+}
+
+EXPORT_API void *nugu_pool_alloc(NuguPool *pool)
+{
+	struct pool_free_item *item;
+
+	g_return_val_if_fail(pool != NULL, NULL);
+
+	pthread_mutex_lock(&pool->lock);
+
+	if (!pool->free_list && _pool_add_slab(pool) < 0) {
+		pthread_mutex_unlock(&pool->lock);
+		return NULL;
+	}
+
+	item = pool->free_list;
+	pool->free_list = item->next;
+
+	pool->stats.allocs++;
+	pool->stats.available--;
+	pool->stats.in_use++;
+	if (pool->stats.in_use > pool->stats.high_watermark)
+		pool->stats.high_watermark = pool->stats.in_use;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	memset(item, 0, pool->item_size);
+
+	return item;
+}
+
+EXPORT_API void nugu_pool_release(NuguPool *pool, void *item)
+{
+	struct pool_free_item *free_item = item;
+
+	g_return_if_fail(pool != NULL);
+
+	if (!item)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+
+	free_item->next = pool->free_list;
+	pool->free_list = free_item;
+
+	pool->stats.releases++;
+	pool->stats.available++;
+	pool->stats.in_use--;
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+EXPORT_API int nugu_pool_get_stats(NuguPool *pool, NuguPoolStats *stats)
+{
+	g_return_val_if_fail(pool != NULL, -1);
+	g_return_val_if_fail(stats != NULL, -1);
+
+	pthread_mutex_lock(&pool->lock);
+	memcpy(stats, &pool->stats, sizeof(NuguPoolStats));
+	pthread_mutex_unlock(&pool->lock);
+
+	return 0;
+}
@@ -21,15 +21,23 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <unistd.h>
-#include <sys/time.h>
+#include <poll.h>
 #include <errno.h>
+#include <sys/eventfd.h>
 
 #include "nugu_log.h"
 #include "nugu_recorder.h"
 #include "nugu_ringbuffer.h"
+#include "nugu_audio_convert.h"
 
 //#define RECORDER_FILE_DUMP
 
+/* size of the converted data pushed to the ring at once */
+#define CONVERT_BUFFER_SIZE 4096
+
+/* max size of a device frame (16 channels of 32 bits samples) */
+#define MAX_DEVICE_FRAME_SIZE 64
+
 struct _nugu_recorder_driver {
 	char *name;
 	struct nugu_recorder_driver_ops *ops;
@@ -39,27 +47,207 @@ struct _nugu_recorder {
 	char *name;
 	NuguRecorderDriver *driver;
 	NuguAudioProperty property;
+	NuguAudioProperty device_property;
+	int has_device_property;
 	NuguRingBuffer *buf;
 	int is_recording;
 	void *userdata;
-	pthread_cond_t cond;
+
+	/**
+	 * conversion from the device property (audio thread only).
+	 * 'pending' keeps a part of the device frame until the rest is pushed.
+	 */
+	int convert;
+	size_t in_frame_size;
+	size_t out_frame_size;
+	unsigned char pending[MAX_DEVICE_FRAME_SIZE];
+	size_t pending_size;
+	unsigned char conv_buf[CONVERT_BUFFER_SIZE];
+
+	/* notified when frames are pushed or the recording is stopped */
+	int efd;
+
+	/* readers (protected by lock) */
+	GList *readers;
 	pthread_mutex_t lock;
+
+	/**
+	 * eventfds of the readers notified by the audio thread without the
+	 * lock. The array is replaced by an atomic pointer swap, and the old
+	 * one is freed after the notifications in progress are finished.
+	 * The audio thread wakes up the waiting updater via notify_efd.
+	 */
+	struct notify_fds *notify_fds;
+	gint notify_busy;
+	gint notify_waiting;
+	int notify_efd;
+
+	/* count of started readers (protected by ctrl_lock) */
+	int users;
+	pthread_mutex_t ctrl_lock;
 #ifdef RECORDER_FILE_DUMP
 	FILE *file;
 #endif
 };
 
+struct notify_fds {
+	int count;
+	int fds[];
+};
+
+struct _nugu_recorder_reader {
+	NuguRecorder *rec;
+	NuguRingBufferReader *cursor;
+	int efd;
+	int is_started;
+	int preroll_ms;
+};
+
 static GList *_recorders;
 static GList *_recorder_drivers;
 static NuguRecorderDriver *_default_driver;
 
-static void _recorder_release_condition(NuguRecorder *rec)
+static void _recorder_notify_fd(int fd)
+{
+	uint64_t ev = 1;
+	ssize_t written;
+
+	written = write(fd, &ev, sizeof(uint64_t));
+	if (written != sizeof(uint64_t) && errno != EAGAIN)
+		nugu_error("write failed");
+}
+
+/* Called from the audio thread, so the lock must not be taken */
+static void _recorder_notify(NuguRecorder *rec)
 {
+	struct notify_fds *snapshot;
+	int i;
+
 	g_return_if_fail(rec != NULL);
 
-	pthread_mutex_lock(&rec->lock);
-	pthread_cond_signal(&rec->cond);
-	pthread_mutex_unlock(&rec->lock);
+	_recorder_notify_fd(rec->efd);
+
+	g_atomic_int_inc(&rec->notify_busy);
+
+	snapshot = g_atomic_pointer_get(&rec->notify_fds);
+	if (snapshot) {
+		for (i = 0; i < snapshot->count; i++)
+			_recorder_notify_fd(snapshot->fds[i]);
+	}
+
+	/* The updater checks the busy count after it sets the waiting flag */
+	if (g_atomic_int_dec_and_test(&rec->notify_busy) &&
+	    g_atomic_int_get(&rec->notify_waiting))
+		_recorder_notify_fd(rec->notify_efd);
+}
+
+/**
+ * Wait on the eventfd until the predicate becomes false. The predicate is
+ * checked after the notification is consumed, so a frame pushed between the
+ * check and the poll() is never missed.
+ */
+static int _recorder_wait(int fd, int (*need_wait)(void *data), void *data,
+			  int timeout)
+{
+	gint64 deadline = 0;
+	struct pollfd pfd;
+	uint64_t ev;
+	int remain = -1;
+
+	if (timeout)
+		deadline = g_get_monotonic_time() + (gint64)timeout * 1000;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	while (need_wait(data)) {
+		if (timeout) {
+			gint64 now = g_get_monotonic_time();
+
+			if (now >= deadline) {
+				nugu_dbg("timeout");
+				break;
+			}
+
+			remain = (int)((deadline - now + 999) / 1000);
+		}
+
+		pfd.revents = 0;
+		if (poll(&pfd, 1, remain) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			nugu_error("poll failed");
+			return -1;
+		}
+
+		if (pfd.revents & POLLIN) {
+			if (read(fd, &ev, sizeof(uint64_t)) < 0 &&
+			    errno != EAGAIN)
+				nugu_error("read failed");
+		}
+	}
+
+	return 0;
+}
+
+static int _recorder_notify_is_busy(void *data)
+{
+	NuguRecorder *rec = data;
+
+	return g_atomic_int_get(&rec->notify_busy) > 0;
+}
+
+/* Publish the eventfds of the readers. Called with the lock held. */
+static void _recorder_update_notify_fds(NuguRecorder *rec)
+{
+	struct notify_fds *snapshot = NULL;
+	struct notify_fds *old;
+	guint count;
+	GList *l;
+	int i = 0;
+
+	count = g_list_length(rec->readers);
+	if (count > 0) {
+		snapshot = g_malloc(sizeof(struct notify_fds) +
+				    sizeof(int) * count);
+		for (l = rec->readers; l; l = l->next) {
+			NuguRecorderReader *reader = l->data;
+
+			snapshot->fds[i++] = reader->efd;
+		}
+		snapshot->count = i;
+	}
+
+	old = rec->notify_fds;
+	g_atomic_pointer_set(&rec->notify_fds, snapshot);
+
+	/* Wait for the audio thread still using the old one */
+	g_atomic_int_set(&rec->notify_waiting, 1);
+	_recorder_wait(rec->notify_efd, _recorder_notify_is_busy, rec, 0);
+	g_atomic_int_set(&rec->notify_waiting, 0);
+
+	g_free(old);
+}
+
+static void _recorder_reader_preroll(NuguRecorderReader *reader)
+{
+	NuguRecorder *rec = reader->rec;
+	gint64 bytes;
+	int item_size;
+	int frames;
+
+	item_size = nugu_ring_buffer_get_item_size(rec->buf);
+	bytes = (gint64)nugu_audio_get_bytes_per_sec(rec->property) *
+		reader->preroll_ms / 1000;
+	if (bytes <= 0 || item_size <= 0)
+		return;
+
+	frames = (int)MIN((bytes + item_size - 1) / item_size, G_MAXINT);
+	frames = nugu_ring_buffer_reader_rewind(reader->cursor, frames);
+
+	nugu_dbg("replay %d frames for %d ms pre-roll", frames,
+		 reader->preroll_ms);
 }
 
 EXPORT_API NuguRecorderDriver *
@@ -170,15 +358,14 @@ EXPORT_API NuguRecorder *nugu_recorder_new(const char *name,
 	rec = g_malloc0(sizeof(struct _nugu_recorder));
 	rec->name = g_strdup(name);
 	rec->driver = driver;
-	rec->buf = nugu_ring_buffer_new(NUGU_RECORDER_FRAME_SIZE,
-					NUGU_RECORDER_MAX_FRAMES);
-	rec->is_recording = 0;
-	pthread_mutex_init(&rec->lock, NULL);
-	pthread_cond_init(&rec->cond, NULL);
-
-#ifdef RECORDER_FILE_DUMP
-	rec->file = fopen(name, "w");
-#endif
+	/**
+	 * The driver pushes frames from the audio callback and only one
+	 * thread reads them, so the lock-free mode is used to avoid blocking
+	 * the audio callback.
+	 */
+	rec->buf = nugu_ring_buffer_new_full(NUGU_RECORDER_FRAME_SIZE,
+					     NUGU_RECORDER_MAX_FRAMES,
+					     NUGU_RING_BUFFER_MODE_SPSC);
 	if (rec->buf == NULL) {
 		nugu_error("buffer new is internal error");
 		g_free(rec->name);
@@ -186,6 +373,34 @@ EXPORT_API NuguRecorder *nugu_recorder_new(const char *name,
 		return NULL;
 	}
 
+	rec->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (rec->efd < 0) {
+		nugu_error("eventfd() failed");
+		nugu_ring_buffer_free(rec->buf);
+		g_free(rec->name);
+		g_free(rec);
+		return NULL;
+	}
+
+	rec->notify_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (rec->notify_efd < 0) {
+		nugu_error("eventfd() failed");
+		close(rec->efd);
+		nugu_ring_buffer_free(rec->buf);
+		g_free(rec->name);
+		g_free(rec);
+		return NULL;
+	}
+
+	rec->is_recording = 0;
+	rec->users = 0;
+	pthread_mutex_init(&rec->lock, NULL);
+	pthread_mutex_init(&rec->ctrl_lock, NULL);
+
+#ifdef RECORDER_FILE_DUMP
+	rec->file = fopen(name, "w");
+#endif
+
 	return rec;
 }
 
@@ -194,11 +409,20 @@ EXPORT_API void nugu_recorder_free(NuguRecorder *rec)
 	g_return_if_fail(rec != NULL);
 	g_return_if_fail(rec->driver != NULL);
 
+	if (rec->readers) {
+		nugu_error("readers are still remained");
+		g_list_free(rec->readers);
+	}
+
+	g_free(rec->notify_fds);
+
 	g_free(rec->name);
 	nugu_ring_buffer_free(rec->buf);
+	close(rec->efd);
+	close(rec->notify_efd);
 
 	pthread_mutex_destroy(&rec->lock);
-	pthread_cond_destroy(&rec->cond);
+	pthread_mutex_destroy(&rec->ctrl_lock);
 
 #ifdef RECORDER_FILE_DUMP
 	fclose(rec->file);
@@ -261,8 +485,97 @@ EXPORT_API int nugu_recorder_set_property(NuguRecorder *rec,
 	return 0;
 }
 
+EXPORT_API int nugu_recorder_get_property(NuguRecorder *rec,
+					  NuguAudioProperty *property)
+{
+	g_return_val_if_fail(rec != NULL, -1);
+	g_return_val_if_fail(property != NULL, -1);
+
+	memcpy(property, &rec->property, sizeof(NuguAudioProperty));
+
+	return 0;
+}
+
+EXPORT_API int nugu_recorder_set_device_property(NuguRecorder *rec,
+						 NuguAudioProperty property)
+{
+	g_return_val_if_fail(rec != NULL, -1);
+
+	memcpy(&rec->device_property, &property, sizeof(NuguAudioProperty));
+	rec->has_device_property = 1;
+
+	return 0;
+}
+
+EXPORT_API int nugu_recorder_get_device_property(NuguRecorder *rec,
+						 NuguAudioProperty *property)
+{
+	g_return_val_if_fail(rec != NULL, -1);
+	g_return_val_if_fail(property != NULL, -1);
+
+	if (rec->has_device_property)
+		memcpy(property, &rec->device_property,
+		       sizeof(NuguAudioProperty));
+	else
+		memcpy(property, &rec->property, sizeof(NuguAudioProperty));
+
+	return 0;
+}
+
+static int _recorder_converter_reset(NuguRecorder *rec)
+{
+	NuguAudioProperty *from = &rec->device_property;
+	NuguAudioProperty *to = &rec->property;
+	int in_width;
+	int out_width;
+
+	rec->convert = 0;
+	rec->pending_size = 0;
+
+	if (!rec->has_device_property)
+		return 0;
+
+	if (from->format == to->format && from->channel == to->channel &&
+	    from->samplerate == to->samplerate)
+		return 0;
+
+	if (from->samplerate != to->samplerate) {
+		nugu_error("not support the sample rate conversion");
+		return -1;
+	}
+
+	if (from->channel <= 0 || to->channel <= 0 ||
+	    (from->channel != to->channel && from->channel != 1 &&
+	     to->channel != 1)) {
+		nugu_error("not support the channel layout(%d -> %d)",
+			   from->channel, to->channel);
+		return -1;
+	}
+
+	in_width = nugu_audio_get_sample_width(from->format);
+	out_width = nugu_audio_get_sample_width(to->format);
+	if (in_width <= 0 || out_width <= 0) {
+		nugu_error("not support the format");
+		return -1;
+	}
+
+	rec->in_frame_size = (size_t)in_width * from->channel;
+	rec->out_frame_size = (size_t)out_width * to->channel;
+	if (rec->in_frame_size > MAX_DEVICE_FRAME_SIZE ||
+	    rec->out_frame_size > CONVERT_BUFFER_SIZE) {
+		nugu_error("frame size is too big");
+		return -1;
+	}
+
+	rec->convert = 1;
+
+	return 0;
+}
+
 EXPORT_API int nugu_recorder_start(NuguRecorder *rec)
 {
+	NuguAudioProperty property;
+
 	g_return_val_if_fail(rec != NULL, -1);
 	g_return_val_if_fail(rec->driver != NULL, -1);
 
@@ -270,10 +583,16 @@ EXPORT_API int nugu_recorder_start(NuguRecorder *rec)
 		nugu_error("Not supported");
 		return -1;
 	}
+
+	if (_recorder_converter_reset(rec) < 0)
+		return -1;
+
 	nugu_ring_buffer_clear_items(rec->buf);
 	rec->is_recording = 1;
 
-	return rec->driver->ops->start(rec->driver, rec, rec->property);
+	nugu_recorder_get_device_property(rec, &property);
+
+	return rec->driver->ops->start(rec->driver, rec, property);
 }
 
 EXPORT_API int nugu_recorder_stop(NuguRecorder *rec)
@@ -286,8 +605,8 @@ EXPORT_API int nugu_recorder_stop(NuguRecorder *rec)
 		return -1;
 	}
 	nugu_ring_buffer_clear_items(rec->buf);
-	_recorder_release_condition(rec);
 	rec->is_recording = 0;
+	_recorder_notify(rec);
 
 	return rec->driver->ops->stop(rec->driver, rec);
 }
@@ -338,6 +657,61 @@ EXPORT_API int nugu_recorder_set_frame_size(NuguRecorder *rec, int size,
 	return nugu_ring_buffer_resize(rec->buf, size, max);
 }
 
+/* Convert whole device frames through the fixed buffer */
+static int _recorder_convert_frames(NuguRecorder *rec,
+				    const unsigned char *data, size_t frames)
+{
+	size_t max = CONVERT_BUFFER_SIZE / rec->out_frame_size;
+
+	while (frames > 0) {
+		size_t count = MIN(frames, max);
+
+		nugu_audio_convert(rec->device_property, data, rec->property,
+				   rec->conv_buf, count);
+		if (nugu_ring_buffer_push_data(rec->buf,
+					       (const char *)rec->conv_buf,
+					       count * rec->out_frame_size) < 0)
+			return -1;
+
+		data += count * rec->in_frame_size;
+		frames -= count;
+	}
+
+	return 0;
+}
+
+static int _recorder_convert_push(NuguRecorder *rec,
+				  const unsigned char *data, size_t size)
+{
+	size_t frame_size = rec->in_frame_size;
+
+	if (rec->pending_size > 0) {
+		size_t length = MIN(frame_size - rec->pending_size, size);
+
+		memcpy(rec->pending + rec->pending_size, data, length);
+		rec->pending_size += length;
+		data += length;
+		size -= length;
+
+		if (rec->pending_size < frame_size)
+			return 0;
+
+		rec->pending_size = 0;
+		if (_recorder_convert_frames(rec, rec->pending, 1) < 0)
+			return -1;
+	}
+
+	if (_recorder_convert_frames(rec, data, size / frame_size) < 0)
+		return -1;
+
+	rec->pending_size = size % frame_size;
+	if (rec->pending_size > 0)
+		memcpy(rec->pending, data + size - rec->pending_size,
+		       rec->pending_size);
+
+	return 0;
+}
+
 EXPORT_API int nugu_recorder_push_frame(NuguRecorder *rec, const char *data,
 					int size)
 {
@@ -351,10 +725,13 @@ EXPORT_API int nugu_recorder_push_frame(NuguRecorder *rec, const char *data,
 #ifdef RECORDER_FILE_DUMP
 	fwrite(data, size, 1, rec->file);
 #endif
-	ret = nugu_ring_buffer_push_data(rec->buf, data, size);
+	if (rec->convert)
+		ret = _recorder_convert_push(rec, (const unsigned char *)data,
+					     size);
+	else
+		ret = nugu_ring_buffer_push_data(rec->buf, data, size);
 
-	if (nugu_recorder_get_frame_count(rec))
-		_recorder_release_condition(rec);
+	_recorder_notify(rec);
 
 	return ret;
 }
@@ -368,34 +745,70 @@ EXPORT_API int nugu_recorder_get_frame(NuguRecorder *rec, char *data, int *size)
 	return nugu_ring_buffer_read_item(rec->buf, data, size);
 }
 
+static int _recorder_need_wait(void *data)
+{
+	NuguRecorder *rec = data;
+
+	return nugu_recorder_get_frame_count(rec) == 0 &&
+	       nugu_recorder_is_recording(rec) == 1;
+}
+
 EXPORT_API int nugu_recorder_get_frame_timeout(NuguRecorder *rec, char *data,
 					       int *size, int timeout)
 {
-	struct timeval curtime;
-	struct timespec spec;
-	int status = 0;
+	g_return_val_if_fail(rec != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(size != NULL, -1);
+
+	if (_recorder_wait(rec->efd, _recorder_need_wait, rec, timeout) < 0)
+		return -1;
+
+	return nugu_ring_buffer_read_item(rec->buf, data, size);
+}
+
+EXPORT_API int nugu_recorder_get_fd(NuguRecorder *rec)
+{
+	g_return_val_if_fail(rec != NULL, -1);
+
+	return rec->efd;
+}
+
+EXPORT_API int nugu_recorder_peek_frame(NuguRecorder *rec, const char **data,
+				       int *size)
+{
+	int count;
 
 	g_return_val_if_fail(rec != NULL, -1);
 	g_return_val_if_fail(data != NULL, -1);
 	g_return_val_if_fail(size != NULL, -1);
 
-	if (nugu_recorder_get_frame_count(rec) == 0) {
-		pthread_mutex_lock(&rec->lock);
-		if (timeout) {
-			gettimeofday(&curtime, NULL);
-			spec.tv_sec = curtime.tv_sec + timeout / 1000;
-			spec.tv_nsec = curtime.tv_usec * 1000 + timeout % 1000;
-			status = pthread_cond_timedwait(&rec->cond, &rec->lock,
-							&spec);
-		} else
-			pthread_cond_wait(&rec->cond, &rec->lock);
-		pthread_mutex_unlock(&rec->lock);
-	}
+	count = nugu_ring_buffer_peek_items(rec->buf, data, 1);
+	if (count < 0)
+		return -1;
 
-	if (status == ETIMEDOUT)
-		nugu_dbg("timeout");
+	*size = count ? nugu_ring_buffer_get_item_size(rec->buf) : 0;
 
-	return nugu_ring_buffer_read_item(rec->buf, data, size);
+	return 0;
+}
+
+EXPORT_API int nugu_recorder_peek_frames(NuguRecorder *rec, const char **data,
+					 int max_count)
+{
+	g_return_val_if_fail(rec != NULL, -1);
+
+	return nugu_ring_buffer_peek_items(rec->buf, data, max_count);
+}
+
+EXPORT_API int nugu_recorder_release_frame(NuguRecorder *rec)
+{
+	return nugu_recorder_release_frames(rec, 1);
+}
+
+EXPORT_API int nugu_recorder_release_frames(NuguRecorder *rec, int count)
+{
+	g_return_val_if_fail(rec != NULL, -1);
+
+	return nugu_ring_buffer_release_items(rec->buf, count);
 }
 
 EXPORT_API int nugu_recorder_get_frame_count(NuguRecorder *rec)
@@ -404,3 +817,325 @@ EXPORT_API int nugu_recorder_get_frame_count(NuguRecorder *rec)
 
 	return nugu_ring_buffer_get_count(rec->buf);
 }
+
+static void _recorder_merge_stats(NuguRecorderStats *stats,
+				  NuguRingBufferStats *rstats)
+{
+	stats->frames = rstats->pushed;
+	stats->dropped += rstats->dropped;
+	stats->overwrites += rstats->overwrites;
+	stats->underruns += rstats->underruns;
+	stats->high_watermark =
+		MAX(stats->high_watermark, rstats->high_watermark);
+	stats->fill_level = MAX(stats->fill_level, rstats->count);
+	stats->max_frames = rstats->max_items;
+}
+
+EXPORT_API int nugu_recorder_get_stats(NuguRecorder *rec,
+				       NuguRecorderStats *stats)
+{
+	NuguRingBufferStats rstats;
+	GList *l;
+
+	g_return_val_if_fail(rec != NULL, -1);
+	g_return_val_if_fail(stats != NULL, -1);
+
+	memset(stats, 0, sizeof(NuguRecorderStats));
+
+	pthread_mutex_lock(&rec->lock);
+
+	/* The frames are not read from the recorder itself if it is shared */
+	if (!rec->readers) {
+		pthread_mutex_unlock(&rec->lock);
+
+		if (nugu_ring_buffer_get_stats(rec->buf, &rstats) < 0)
+			return -1;
+
+		_recorder_merge_stats(stats, &rstats);
+		return 0;
+	}
+
+	for (l = rec->readers; l; l = l->next) {
+		NuguRecorderReader *reader = l->data;
+
+		if (nugu_ring_buffer_reader_get_stats(reader->cursor,
+						      &rstats) == 0)
+			_recorder_merge_stats(stats, &rstats);
+	}
+
+	pthread_mutex_unlock(&rec->lock);
+
+	return 0;
+}
+
+EXPORT_API NuguRecorderReader *nugu_recorder_reader_new(NuguRecorder *rec)
+{
+	NuguRecorderReader *reader;
+
+	g_return_val_if_fail(rec != NULL, NULL);
+	g_return_val_if_fail(rec->buf != NULL, NULL);
+
+	reader = g_malloc0(sizeof(struct _nugu_recorder_reader));
+	reader->rec = rec;
+	reader->is_started = 0;
+	reader->cursor = nugu_ring_buffer_reader_new(rec->buf);
+	if (!reader->cursor) {
+		g_free(reader);
+		return NULL;
+	}
+
+	reader->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (reader->efd < 0) {
+		nugu_error("eventfd() failed");
+		nugu_ring_buffer_reader_free(reader->cursor);
+		g_free(reader);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&rec->lock);
+	rec->readers = g_list_append(rec->readers, reader);
+	_recorder_update_notify_fds(rec);
+	pthread_mutex_unlock(&rec->lock);
+
+	return reader;
+}
+
+EXPORT_API void nugu_recorder_reader_free(NuguRecorderReader *reader)
+{
+	g_return_if_fail(reader != NULL);
+
+	nugu_recorder_reader_stop(reader);
+
+	pthread_mutex_lock(&reader->rec->lock);
+	reader->rec->readers = g_list_remove(reader->rec->readers, reader);
+	_recorder_update_notify_fds(reader->rec);
+	pthread_mutex_unlock(&reader->rec->lock);
+
+	nugu_ring_buffer_reader_free(reader->cursor);
+	close(reader->efd);
+
+	memset(reader, 0, sizeof(struct _nugu_recorder_reader));
+	g_free(reader);
+}
+
+EXPORT_API NuguRecorder *nugu_recorder_reader_get_recorder(
+	NuguRecorderReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, NULL);
+
+	return reader->rec;
+}
+
+EXPORT_API int nugu_recorder_reader_set_preroll(NuguRecorderReader *reader,
+					       int msec)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(msec >= 0, -1);
+
+	reader->preroll_ms = msec;
+
+	return 0;
+}
+
+EXPORT_API int nugu_recorder_reader_get_preroll(NuguRecorderReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+
+	return reader->preroll_ms;
+}
+
+EXPORT_API int nugu_recorder_reader_start(NuguRecorderReader *reader)
+{
+	NuguRecorder *rec;
+	int ret = 0;
+
+	g_return_val_if_fail(reader != NULL, -1);
+
+	rec = reader->rec;
+
+	pthread_mutex_lock(&rec->ctrl_lock);
+
+	if (reader->is_started) {
+		pthread_mutex_unlock(&rec->ctrl_lock);
+		return 0;
+	}
+
+	/* Only the first reader opens the recording stream */
+	if (rec->users == 0)
+		ret = nugu_recorder_start(rec);
+
+	if (ret == 0) {
+		rec->users++;
+		nugu_ring_buffer_reader_clear_items(reader->cursor);
+		if (reader->preroll_ms > 0)
+			_recorder_reader_preroll(reader);
+		reader->is_started = 1;
+	}
+
+	pthread_mutex_unlock(&rec->ctrl_lock);
+
+	return ret;
+}
+
+EXPORT_API int nugu_recorder_reader_stop(NuguRecorderReader *reader)
+{
+	NuguRecorder *rec;
+	int ret = 0;
+
+	g_return_val_if_fail(reader != NULL, -1);
+
+	rec = reader->rec;
+
+	pthread_mutex_lock(&rec->ctrl_lock);
+
+	if (!reader->is_started) {
+		pthread_mutex_unlock(&rec->ctrl_lock);
+		return 0;
+	}
+
+	reader->is_started = 0;
+	rec->users--;
+
+	/* Only the last reader closes the recording stream */
+	if (rec->users == 0)
+		ret = nugu_recorder_stop(rec);
+	else
+		_recorder_notify_fd(reader->efd);
+
+	pthread_mutex_unlock(&rec->ctrl_lock);
+
+	return ret;
+}
+
+EXPORT_API int nugu_recorder_reader_is_recording(NuguRecorderReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+
+	if (!reader->is_started)
+		return 0;
+
+	return nugu_recorder_is_recording(reader->rec);
+}
+
+EXPORT_API int nugu_recorder_reader_get_frame(NuguRecorderReader *reader,
+					      char *data, int *size)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(size != NULL, -1);
+
+	return nugu_ring_buffer_reader_read_item(reader->cursor, data, size);
+}
+
+static int _recorder_reader_need_wait(void *data)
+{
+	NuguRecorderReader *reader = data;
+
+	return nugu_ring_buffer_reader_get_count(reader->cursor) == 0 &&
+	       nugu_recorder_reader_is_recording(reader) == 1;
+}
+
+static int _recorder_reader_wait(NuguRecorderReader *reader, int timeout)
+{
+	return _recorder_wait(reader->efd, _recorder_reader_need_wait, reader,
+			      timeout);
+}
+
+EXPORT_API int nugu_recorder_reader_get_frame_timeout(
+	NuguRecorderReader *reader, char *data, int *size, int timeout)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(size != NULL, -1);
+
+	if (_recorder_reader_wait(reader, timeout) < 0)
+		return -1;
+
+	return nugu_ring_buffer_reader_read_item(reader->cursor, data, size);
+}
+
+EXPORT_API int nugu_recorder_reader_peek_frame(NuguRecorderReader *reader,
+					       const char **data, int *size)
+{
+	int count;
+
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(size != NULL, -1);
+
+	count = nugu_ring_buffer_reader_peek_items(reader->cursor, data, 1);
+	if (count < 0)
+		return -1;
+
+	*size = count ? nugu_ring_buffer_get_item_size(reader->rec->buf) : 0;
+
+	return 0;
+}
+
+EXPORT_API int nugu_recorder_reader_peek_frame_timeout(
+	NuguRecorderReader *reader, const char **data, int *size, int timeout)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(size != NULL, -1);
+
+	if (_recorder_reader_wait(reader, timeout) < 0)
+		return -1;
+
+	return nugu_recorder_reader_peek_frame(reader, data, size);
+}
+
+EXPORT_API int nugu_recorder_reader_peek_frames(NuguRecorderReader *reader,
+						const char **data,
+						int max_count)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+
+	return nugu_ring_buffer_reader_peek_items(reader->cursor, data,
+						  max_count);
+}
+
+EXPORT_API int nugu_recorder_reader_release_frame(NuguRecorderReader *reader)
+{
+	return nugu_recorder_reader_release_frames(reader, 1);
+}
+
+EXPORT_API int nugu_recorder_reader_release_frames(NuguRecorderReader *reader,
+						   int count)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+
+	return nugu_ring_buffer_reader_release_items(reader->cursor, count);
+}
+
+EXPORT_API int nugu_recorder_reader_get_fd(NuguRecorderReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+
+	return reader->efd;
+}
+
+EXPORT_API int nugu_recorder_reader_get_stats(NuguRecorderReader *reader,
+					    NuguRecorderStats *stats)
+{
+	NuguRingBufferStats rstats;
+
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(stats != NULL, -1);
+
+	memset(stats, 0, sizeof(NuguRecorderStats));
+
+	if (nugu_ring_buffer_reader_get_stats(reader->cursor, &rstats) < 0)
+		return -1;
+
+	_recorder_merge_stats(stats, &rstats);
+
+	return 0;
+}
+
+EXPORT_API int nugu_recorder_reader_get_frame_count(NuguRecorderReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, 0);
+
+	return nugu_ring_buffer_reader_get_count(reader->cursor);
+}
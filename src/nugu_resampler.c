@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <glib.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "nugu_log.h"
+#include "nugu_resampler.h"
+
+/* Count of input frames converted at once */
+#define RESAMPLER_BLOCK_FRAMES 512
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define RESAMPLER_FORMAT_S16 AUDIO_FORMAT_S16_LE
+#define RESAMPLER_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_LE
+#else
+#define RESAMPLER_FORMAT_S16 AUDIO_FORMAT_S16_BE
+#define RESAMPLER_FORMAT_FLOAT AUDIO_FORMAT_FLOAT_BE
+#endif
+
+struct filter_preset {
+	guint taps;
+	double beta; /* Kaiser window */
+	double rolloff; /* cutoff relative to the Nyquist frequency */
+};
+
+static const struct filter_preset _presets[] = {
+	[NUGU_RESAMPLER_QUALITY_LOW] = { 8, 5.0, 0.85 },
+	[NUGU_RESAMPLER_QUALITY_MEDIUM] = { 16, 7.0, 0.91 },
+	[NUGU_RESAMPLER_QUALITY_HIGH] = { 32, 9.0, 0.95 },
+};
+
+struct _nugu_resampler {
+	enum nugu_audio_format format;
+	int channel;
+	size_t frame_size;
+
+	/* output position advances 'down / up' input frames per output */
+	guint up;
+	guint down;
+
+	/* 'up' phases of 'taps' coefficients (taps is a multiple of 4) */
+	guint taps;
+	float *filter;
+
+	/*
+	 * Planar input history of each channel ('capacity' frames)
+	 *  - hist_len: frames in the history
+	 *  - pos: first frame of the next output (may be after the history)
+	 *  - phase: fractional part of the position in 1/up frames
+	 */
+	float *work;
+	guint capacity;
+	guint hist_len;
+	guint pos;
+	guint phase;
+
+	/* part of frame remained from the last input */
+	unsigned char *pending;
+	size_t pending_size;
+};
+
+static guint _gcd(guint a, guint b)
+{
+	while (b != 0) {
+		guint t = a % b;
+
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+static double _bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	int k;
+
+	for (k = 1; k < 64; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+
+	return sum;
+}
+
+static void _make_filter(NuguResampler *rs, double cutoff, double beta)
+{
+	double half = rs->taps / 2.0;
+	double i0_beta = _bessel_i0(beta);
+	guint p;
+	guint k;
+
+	for (p = 0; p < rs->up; p++) {
+		float *h = rs->filter + p * rs->taps;
+		double frac = (double)p / rs->up;
+		double sum = 0.0;
+
+		for (k = 0; k < rs->taps; k++) {
+			/* distance from the output position (center tap) */
+			double t = (double)k - (half - 1.0) - frac;
+			double x = t / half;
+			double value;
+
+			if (x <= -1.0 || x >= 1.0) {
+				h[k] = 0.0f;
+				continue;
+			}
+
+			value = cutoff;
+			if (t != 0.0)
+				value = sin(G_PI * cutoff * t) / (G_PI * t);
+
+			value *= _bessel_i0(beta * sqrt(1.0 - x * x)) / i0_beta;
+
+			h[k] = (float)value;
+			sum += value;
+		}
+
+		/* Unity gain for DC in every phase */
+		for (k = 0; k < rs->taps; k++)
+			h[k] = (float)(h[k] / sum);
+	}
+}
+
+/* Inner loop of the filter. taps is a multiple of 4. */
+static float _dot(const float *h, const float *x, guint taps)
+{
+#if defined(__SSE__)
+	__m128 acc = _mm_setzero_ps();
+	float out[4];
+	guint i;
+
+	for (i = 0; i < taps; i += 4)
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(h + i),
+						 _mm_loadu_ps(x + i)));
+
+	_mm_storeu_ps(out, acc);
+
+	return (out[0] + out[1]) + (out[2] + out[3]);
+#elif defined(__ARM_NEON)
+	float32x4_t acc = vdupq_n_f32(0.0f);
+	float32x2_t sum;
+	guint i;
+
+	for (i = 0; i < taps; i += 4)
+		acc = vmlaq_f32(acc, vld1q_f32(h + i), vld1q_f32(x + i));
+
+	sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+
+	return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+	float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	guint i;
+
+	for (i = 0; i < taps; i += 4) {
+		acc[0] += h[i] * x[i];
+		acc[1] += h[i + 1] * x[i + 1];
+		acc[2] += h[i + 2] * x[i + 2];
+		acc[3] += h[i + 3] * x[i + 3];
+	}
+
+	return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
+
+static void _load_frames(NuguResampler *rs, const void *data, guint frames)
+{
+	guint ch;
+	guint i;
+
+	for (ch = 0; ch < (guint)rs->channel; ch++) {
+		float *w = rs->work + ch * rs->capacity + rs->hist_len;
+
+		if (rs->format == RESAMPLER_FORMAT_S16) {
+			const int16_t *src = (const int16_t *)data + ch;
+
+			for (i = 0; i < frames; i++)
+				w[i] = src[i * rs->channel] * (1.0f / 32768.0f);
+		} else {
+			const float *src = (const float *)data + ch;
+
+			for (i = 0; i < frames; i++)
+				w[i] = src[i * rs->channel];
+		}
+	}
+
+	rs->hist_len += frames;
+}
+
+static void _store_sample(NuguResampler *rs, void *out, size_t index,
+			  float value)
+{
+	if (rs->format == RESAMPLER_FORMAT_S16) {
+		float scaled = value * 32768.0f;
+
+		scaled += (scaled >= 0.0f) ? 0.5f : -0.5f;
+		((int16_t *)out)[index] =
+			(int16_t)CLAMP(scaled, (float)INT16_MIN,
+				       (float)INT16_MAX);
+	} else {
+		((float *)out)[index] = value;
+	}
+}
+
+/* Generate the output from the history. Returns the count of frames. */
+static size_t _filter_frames(NuguResampler *rs, void *out)
+{
+	size_t count = 0;
+	guint ch;
+
+	while (rs->pos + rs->taps <= rs->hist_len) {
+		const float *h = rs->filter + rs->phase * rs->taps;
+
+		for (ch = 0; ch < (guint)rs->channel; ch++) {
+			const float *x = rs->work + ch * rs->capacity + rs->pos;
+
+			_store_sample(rs, out, count * rs->channel + ch,
+				      _dot(h, x, rs->taps));
+		}
+
+		count++;
+
+		rs->phase += rs->down;
+		rs->pos += rs->phase / rs->up;
+		rs->phase %= rs->up;
+	}
+
+	/* Keep the frames that are still needed by the next output */
+	if (rs->pos < rs->hist_len) {
+		for (ch = 0; ch < (guint)rs->channel; ch++) {
+			float *w = rs->work + ch * rs->capacity;
+
+			memmove(w, w + rs->pos,
+				(rs->hist_len - rs->pos) * sizeof(float));
+		}
+
+		rs->hist_len -= rs->pos;
+		rs->pos = 0;
+	} else {
+		rs->pos -= rs->hist_len;
+		rs->hist_len = 0;
+	}
+
+	return count;
+}
+
+static size_t _get_output_frames(NuguResampler *rs, guint64 frames)
+{
+	return (size_t)(((rs->hist_len + frames) * rs->up) / rs->down + 1);
+}
+
+EXPORT_API NuguResampler *
+nugu_resampler_new(NuguAudioProperty property,
+		   enum nugu_audio_sample_rate samplerate,
+		   enum nugu_resampler_quality quality)
+{
+	const struct filter_preset *preset;
+	NuguResampler *rs;
+	guint in_rate;
+	guint out_rate;
+	guint gcd;
+	double cutoff;
+
+	g_return_val_if_fail(quality <= NUGU_RESAMPLER_QUALITY_HIGH, NULL);
+	g_return_val_if_fail(property.channel > 0, NULL);
+
+	if (property.format != RESAMPLER_FORMAT_S16 &&
+	    property.format != RESAMPLER_FORMAT_FLOAT) {
+		nugu_error("not support the audio format(%d)", property.format);
+		return NULL;
+	}
+
+	in_rate = nugu_audio_get_rate(property.samplerate);
+	out_rate = nugu_audio_get_rate(samplerate);
+	if (in_rate == 0 || out_rate == 0) {
+		nugu_error("not support the sample rate");
+		return NULL;
+	}
+
+	rs = calloc(1, sizeof(struct _nugu_resampler));
+	if (!rs) {
+		error_nomem();
+		return NULL;
+	}
+
+	gcd = _gcd(in_rate, out_rate);
+	rs->up = out_rate / gcd;
+	rs->down = in_rate / gcd;
+	rs->format = property.format;
+	rs->channel = property.channel;
+	rs->frame_size =
+		nugu_audio_get_sample_width(property.format) * property.channel;
+
+	/*
+	 * Downsampling lowers the cutoff below the output Nyquist frequency,
+	 * and the filter is widened to keep the same transition band.
+	 */
+	preset = _presets + quality;
+	cutoff = preset->rolloff * MIN(1.0, (double)rs->up / rs->down);
+	rs->taps = (guint)(preset->taps * preset->rolloff / cutoff);
+	rs->taps = (rs->taps + 3) & ~3U;
+
+	rs->capacity = rs->taps + RESAMPLER_BLOCK_FRAMES;
+
+	rs->filter = malloc(sizeof(float) * rs->up * rs->taps);
+	rs->work = malloc(sizeof(float) * rs->capacity * rs->channel);
+	rs->pending = malloc(rs->frame_size);
+	if (!rs->filter || !rs->work || !rs->pending) {
+		error_nomem();
+		nugu_resampler_free(rs);
+		return NULL;
+	}
+
+	_make_filter(rs, cutoff, preset->beta);
+	nugu_resampler_reset(rs);
+
+	nugu_dbg("resampler %u -> %u Hz (%u/%u, %u taps)", in_rate, out_rate,
+		 rs->up, rs->down, rs->taps);
+
+	return rs;
+}
+
+EXPORT_API void nugu_resampler_free(NuguResampler *rs)
+{
+	g_return_if_fail(rs != NULL);
+
+	if (rs->filter)
+		free(rs->filter);
+	if (rs->work)
+		free(rs->work);
+	if (rs->pending)
+		free(rs->pending);
+
+	memset(rs, 0, sizeof(struct _nugu_resampler));
+	free(rs);
+}
+
+EXPORT_API void nugu_resampler_reset(NuguResampler *rs)
+{
+	g_return_if_fail(rs != NULL);
+
+	/* Leading silence puts the first input frame on the center tap */
+	memset(rs->work, 0, sizeof(float) * rs->capacity * rs->channel);
+	rs->hist_len = rs->taps / 2 - 1;
+	rs->pos = 0;
+	rs->phase = 0;
+	rs->pending_size = 0;
+}
+
+EXPORT_API size_t nugu_resampler_get_output_size(NuguResampler *rs,
+						 size_t size)
+{
+	g_return_val_if_fail(rs != NULL, 0);
+
+	return _get_output_frames(rs, (rs->pending_size + size) /
+					      rs->frame_size) *
+	       rs->frame_size;
+}
+
+EXPORT_API int nugu_resampler_process(NuguResampler *rs, const void *data,
+				      size_t size, void *out, size_t out_size)
+{
+	const unsigned char *src = data;
+	unsigned char *dest = out;
+	size_t written = 0;
+
+	g_return_val_if_fail(rs != NULL, -1);
+	g_return_val_if_fail(data != NULL, -1);
+	g_return_val_if_fail(out != NULL, -1);
+
+	if (out_size < nugu_resampler_get_output_size(rs, size)) {
+		nugu_error("output buffer is too small");
+		return -1;
+	}
+
+	/* Complete the frame remained from the last input */
+	if (rs->pending_size > 0) {
+		size_t length = MIN(size, rs->frame_size - rs->pending_size);
+
+		memcpy(rs->pending + rs->pending_size, src, length);
+		rs->pending_size += length;
+		src += length;
+		size -= length;
+
+		if (rs->pending_size < rs->frame_size)
+			return 0;
+
+		_load_frames(rs, rs->pending, 1);
+		written += _filter_frames(rs, dest) * rs->frame_size;
+		rs->pending_size = 0;
+	}
+
+	while (size >= rs->frame_size) {
+		guint frames = MIN(size / rs->frame_size,
+				   rs->capacity - rs->hist_len);
+
+		_load_frames(rs, src, frames);
+		written += _filter_frames(rs, dest + written) * rs->frame_size;
+
+		src += frames * rs->frame_size;
+		size -= frames * rs->frame_size;
+	}
+
+	if (size > 0) {
+		memcpy(rs->pending, src, size);
+		rs->pending_size = size;
+	}
+
+	return written;
+}
+
+EXPORT_API size_t nugu_resampler_get_flush_size(NuguResampler *rs)
+{
+	g_return_val_if_fail(rs != NULL, 0);
+
+	return _get_output_frames(rs, rs->taps / 2) * rs->frame_size;
+}
+
+EXPORT_API int nugu_resampler_flush(NuguResampler *rs, void *out,
+				    size_t out_size)
+{
+	guint ch;
+	guint frames;
+	size_t written;
+
+	g_return_val_if_fail(rs != NULL, -1);
+	g_return_val_if_fail(out != NULL, -1);
+
+	if (out_size < nugu_resampler_get_flush_size(rs)) {
+		nugu_error("output buffer is too small");
+		return -1;
+	}
+
+	/* Trailing silence moves the last input frame to the center tap */
+	frames = rs->taps / 2;
+	for (ch = 0; ch < (guint)rs->channel; ch++)
+		memset(rs->work + ch * rs->capacity + rs->hist_len, 0,
+		       frames * sizeof(float));
+
+	rs->hist_len += frames;
+	written = _filter_frames(rs, out) * rs->frame_size;
+
+	nugu_resampler_reset(rs);
+
+	return written;
+}
@@ -25,16 +25,264 @@
 
 //#define DEBUG_RINGBUFFER
 
+struct _nugu_ring_buffer_reader {
+	NuguRingBuffer *buf;
+	gint tail; /* count of consumed items (written only by the reader) */
+
+	/* statistics (written only by the reader) */
+	gint dropped;
+	gint overwrites;
+	gint underruns;
+	gint high_watermark;
+
+	/*
+	 * The reader has received the data since the last underrun. The
+	 * reader reads when it needs the data, so the empty buffer is an
+	 * underrun only once per gap, and not before the first data.
+	 */
+	gint receiving;
+};
+
 struct _nugu_ring_buffer {
 	unsigned char *buf;
+	enum nugu_ring_buffer_mode mode;
 	int item_size;
 	int max_items;
 	int read_index;
 	int count;
+	unsigned int pushed;
 	unsigned long woffset;
 	pthread_mutex_t mutex;
+
+	/**
+	 * NUGU_RING_BUFFER_MODE_SPSC
+	 *  - slots: power of two (at least max_items + 1)
+	 *  - head: count of completed items (written only by producer)
+	 *  - base: head at the last clear, older items are not rewindable
+	 *  - wpartial: bytes of the item being filled (producer private)
+	 *  - reader: default reader used by nugu_ring_buffer_read_item()
+	 *  - readers: additional readers (protected by mutex)
+	 */
+	guint slots;
+	gint head;
+	gint base;
+	int wpartial;
+	struct _nugu_ring_buffer_reader reader;
+	GList *readers;
 };
 
+static guint _round_up_pow2(guint value)
+{
+	guint result = 1;
+
+	while (result < value)
+		result <<= 1;
+
+	return result;
+}
+
+static void _reader_reset(NuguRingBufferReader *reader)
+{
+	reader->tail = 0;
+	reader->dropped = 0;
+	reader->overwrites = 0;
+	reader->underruns = 0;
+	reader->high_watermark = 0;
+	reader->receiving = 0;
+}
+
+static void _reader_update_underruns(NuguRingBufferReader *reader, int empty)
+{
+	if (!empty) {
+		reader->receiving = 1;
+		return;
+	}
+
+	if (!reader->receiving)
+		return;
+
+	reader->receiving = 0;
+	g_atomic_int_inc(&reader->underruns);
+}
+
+static int _buffer_alloc(NuguRingBuffer *buf, int item_size, int max_items)
+{
+	guint slots = max_items;
+	GList *l;
+
+	/* Reserve one more slot for the item being filled by the producer */
+	if (buf->mode == NUGU_RING_BUFFER_MODE_SPSC)
+		slots = _round_up_pow2(max_items + 1);
+
+	buf->buf = (unsigned char *)calloc(slots, item_size);
+	if (!buf->buf) {
+		error_nomem();
+		return -1;
+	}
+
+	buf->slots = slots;
+	buf->item_size = item_size;
+	buf->max_items = max_items;
+	buf->read_index = 0;
+	buf->woffset = 0;
+	buf->count = 0;
+	buf->pushed = 0;
+	buf->head = 0;
+	buf->base = 0;
+	buf->wpartial = 0;
+	_reader_reset(&buf->reader);
+
+	for (l = buf->readers; l; l = l->next)
+		_reader_reset((NuguRingBufferReader *)l->data);
+
+	return 0;
+}
+
+static guint _spsc_get_count(NuguRingBufferReader *reader)
+{
+	NuguRingBuffer *buf = reader->buf;
+	guint head = (guint)g_atomic_int_get(&buf->head);
+	guint tail = (guint)g_atomic_int_get(&reader->tail);
+
+	if (head - tail > (guint)buf->max_items)
+		return buf->max_items;
+
+	return head - tail;
+}
+
+/**
+ * Skip the items overwritten by the producer and update the statistics
+ * before the reader consumes items. Returns the new tail.
+ */
+static guint _spsc_account(NuguRingBufferReader *reader, guint head,
+			   guint tail)
+{
+	NuguRingBuffer *buf = reader->buf;
+	guint count = head - tail;
+
+	_reader_update_underruns(reader, count == 0);
+	if (count == 0)
+		return tail;
+
+	if (count > (guint)buf->max_items) {
+		g_atomic_int_add(&reader->dropped,
+				 (gint)(count - buf->max_items));
+		g_atomic_int_inc(&reader->overwrites);
+		count = buf->max_items;
+	}
+
+	if ((gint)count > g_atomic_int_get(&reader->high_watermark))
+		g_atomic_int_set(&reader->high_watermark, (gint)count);
+
+	return head - count;
+}
+
+static int _spsc_push_data(NuguRingBuffer *buf, const char *data, int size)
+{
+	guint head = (guint)g_atomic_int_get(&buf->head);
+	guint mask = buf->slots - 1;
+	int written = 0;
+
+	while (written < size) {
+		int len = MIN(buf->item_size - buf->wpartial, size - written);
+
+		memcpy(buf->buf + (head & mask) * buf->item_size +
+			       buf->wpartial,
+		       data + written, len);
+
+		written += len;
+		buf->wpartial += len;
+		if (buf->wpartial < buf->item_size)
+			continue;
+
+		/* Publish the completed item */
+		buf->wpartial = 0;
+		head++;
+		g_atomic_int_set(&buf->head, (gint)head);
+	}
+
+	return 0;
+}
+
+static int _spsc_read_item(NuguRingBufferReader *reader, char *item,
+			   int *size)
+{
+	NuguRingBuffer *buf = reader->buf;
+	guint tail = (guint)g_atomic_int_get(&reader->tail);
+	guint mask = buf->slots - 1;
+	guint head;
+
+	while (1) {
+		head = (guint)g_atomic_int_get(&buf->head);
+
+		/* The producer may have overwritten the oldest items */
+		tail = _spsc_account(reader, head, tail);
+		if (head == tail) {
+			*size = 0;
+			return 0;
+		}
+
+		memcpy(item, buf->buf + (tail & mask) * buf->item_size,
+		       buf->item_size);
+
+		/**
+		 * The producer may have started to overwrite the slot during
+		 * the copy. In that case, retry with the newest items.
+		 */
+		head = (guint)g_atomic_int_get(&buf->head);
+		if (head - tail < buf->slots)
+			break;
+	}
+
+	g_atomic_int_set(&reader->tail, (gint)(tail + 1));
+	*size = buf->item_size;
+
+	return 0;
+}
+
+static int _spsc_peek_items(NuguRingBufferReader *reader, const char **items,
+			    int max_count)
+{
+	NuguRingBuffer *buf = reader->buf;
+	guint tail = (guint)g_atomic_int_get(&reader->tail);
+	guint head = (guint)g_atomic_int_get(&buf->head);
+	guint mask = buf->slots - 1;
+	guint count;
+
+	/* The producer may have overwritten the oldest items */
+	tail = _spsc_account(reader, head, tail);
+	g_atomic_int_set(&reader->tail, (gint)tail);
+
+	/* Only the items stored contiguously up to the end of the buffer */
+	count = MIN(head - tail, buf->slots - (tail & mask));
+	count = MIN(count, (guint)max_count);
+
+	*items = (const char *)buf->buf + (tail & mask) * buf->item_size;
+
+	return (int)count;
+}
+
+static int _spsc_release_items(NuguRingBufferReader *reader, int count)
+{
+	NuguRingBuffer *buf = reader->buf;
+	guint tail = (guint)g_atomic_int_get(&reader->tail);
+	guint head = (guint)g_atomic_int_get(&buf->head);
+
+	if (head - tail < (guint)count)
+		count = head - tail;
+
+	g_atomic_int_set(&reader->tail, (gint)(tail + count));
+
+	/**
+	 * The producer writes the slot of the head item. If it reached the
+	 * slot of the first peeked item, the peeked data was overwritten.
+	 */
+	if (head - tail >= buf->slots)
+		return -1;
+
+	return 0;
+}
+
 static void _calculate_count(NuguRingBuffer *buf, int write_item, int size)
 {
 	int write_index = buf->woffset / buf->item_size;
@@ -50,6 +298,14 @@ static void _calculate_count(NuguRingBuffer *buf, int write_item, int size)
 }
 
 EXPORT_API NuguRingBuffer *nugu_ring_buffer_new(int item_size, int max_items)
+{
+	return nugu_ring_buffer_new_full(item_size, max_items,
+					 NUGU_RING_BUFFER_MODE_LOCK);
+}
+
+EXPORT_API NuguRingBuffer *
+nugu_ring_buffer_new_full(int item_size, int max_items,
+			  enum nugu_ring_buffer_mode mode)
 {
 	NuguRingBuffer *buffer;
 
@@ -57,12 +313,17 @@ EXPORT_API NuguRingBuffer *nugu_ring_buffer_new(int item_size, int max_items)
 	g_return_val_if_fail(max_items > 0, NULL);
 
 	buffer = (NuguRingBuffer *)calloc(1, sizeof(struct _nugu_ring_buffer));
-	buffer->buf = (unsigned char *)calloc(1, item_size * max_items);
-	buffer->item_size = item_size;
-	buffer->max_items = max_items;
-	buffer->read_index = 0;
-	buffer->woffset = 0;
-	buffer->count = 0;
+	if (!buffer) {
+		error_nomem();
+		return NULL;
+	}
+
+	buffer->mode = mode;
+	buffer->reader.buf = buffer;
+	if (_buffer_alloc(buffer, item_size, max_items) < 0) {
+		free(buffer);
+		return NULL;
+	}
 
 	pthread_mutex_init(&buffer->mutex, NULL);
 
@@ -73,6 +334,11 @@ EXPORT_API void nugu_ring_buffer_free(NuguRingBuffer *buf)
 	g_return_if_fail(buf != NULL);
 	g_return_if_fail(buf->buf != NULL);
 
+	if (buf->readers) {
+		nugu_error("readers are still remained");
+		g_list_free_full(buf->readers, free);
+	}
+
 	pthread_mutex_destroy(&buf->mutex);
 	free(buf->buf);
 	free(buf);
@@ -81,6 +347,8 @@ EXPORT_API void nugu_ring_buffer_free(NuguRingBuffer *buf)
 EXPORT_API int nugu_ring_buffer_resize(NuguRingBuffer *buf, int item_size,
 				       int max_items)
 {
+	int ret;
+
 	g_return_val_if_fail(buf != NULL, -1);
 	g_return_val_if_fail(buf->buf != NULL, -1);
 	g_return_val_if_fail(item_size > 0, -1);
@@ -92,16 +360,11 @@ EXPORT_API int nugu_ring_buffer_resize(NuguRingBuffer *buf, int item_size,
 	pthread_mutex_lock(&buf->mutex);
 
 	free(buf->buf);
-	buf->buf = (unsigned char *)calloc(1, item_size * max_items);
-	buf->item_size = item_size;
-	buf->max_items = max_items;
-	buf->read_index = 0;
-	buf->woffset = 0;
-	buf->count = 0;
+	ret = _buffer_alloc(buf, item_size, max_items);
 
 	pthread_mutex_unlock(&buf->mutex);
 
-	return 0;
+	return ret;
 }
 
 EXPORT_API int nugu_ring_buffer_push_data(NuguRingBuffer *buf, const char *data,
@@ -121,6 +384,10 @@ EXPORT_API int nugu_ring_buffer_push_data(NuguRingBuffer *buf, const char *data,
 		nugu_error("Should be setting more space for ring buffer!!!");
 		return -1;
 	}
+
+	if (buf->mode == NUGU_RING_BUFFER_MODE_SPSC)
+		return _spsc_push_data(buf, data, size);
+
 	// Remainder write offset over item_size
 	temp = buf->woffset - (buf->woffset / buf->item_size * buf->item_size);
 	// Remainder data offset over item_size
@@ -135,6 +402,10 @@ EXPORT_API int nugu_ring_buffer_push_data(NuguRingBuffer *buf, const char *data,
 	count = buf->count;
 	_calculate_count(buf, write_item, size);
 
+	buf->pushed += (temp + size) / buf->item_size;
+	if (buf->count > buf->reader.high_watermark)
+		buf->reader.high_watermark = buf->count;
+
 #ifdef DEBUG_RINGBUFFER
 	nugu_dbg("[0-%d] write %d (r: %d, w: %d, c: %d)", buf->max_items,
 		 write_item, buf->read_index, buf->woffset / buf->item_size,
@@ -147,6 +418,8 @@ EXPORT_API int nugu_ring_buffer_push_data(NuguRingBuffer *buf, const char *data,
 #ifdef DEBUG_RINGBUFFER
 		nugu_dbg("ring buffer is full. reduce %d", write_item);
 #endif
+		buf->reader.dropped += write_item;
+		buf->reader.overwrites++;
 		buf->read_index += write_item;
 
 		if (buf->read_index >= buf->max_items)
@@ -183,11 +456,17 @@ EXPORT_API int nugu_ring_buffer_read_item(NuguRingBuffer *buf, char *item,
 	g_return_val_if_fail(item != NULL, -1);
 	g_return_val_if_fail(size != NULL, -1);
 
+	if (buf->mode == NUGU_RING_BUFFER_MODE_SPSC)
+		return _spsc_read_item(&buf->reader, item, size);
+
 	if (nugu_ring_buffer_get_count(buf) <= 0) {
+		_reader_update_underruns(&buf->reader, 1);
 		*size = 0;
 		return 0;
 	}
 
+	_reader_update_underruns(&buf->reader, 0);
+
 	pthread_mutex_lock(&buf->mutex);
 
 	*size = buf->item_size;
@@ -203,9 +482,41 @@ EXPORT_API int nugu_ring_buffer_read_item(NuguRingBuffer *buf, char *item,
 	return 0;
 }
 
+EXPORT_API int nugu_ring_buffer_peek_items(NuguRingBuffer *buf,
+					   const char **items, int max_count)
+{
+	g_return_val_if_fail(buf != NULL, -1);
+	g_return_val_if_fail(items != NULL, -1);
+	g_return_val_if_fail(max_count > 0, -1);
+
+	if (buf->mode != NUGU_RING_BUFFER_MODE_SPSC) {
+		nugu_error("peek is only supported in SPSC mode");
+		return -1;
+	}
+
+	return _spsc_peek_items(&buf->reader, items, max_count);
+}
+
+EXPORT_API int nugu_ring_buffer_release_items(NuguRingBuffer *buf, int count)
+{
+	g_return_val_if_fail(buf != NULL, -1);
+	g_return_val_if_fail(count >= 0, -1);
+
+	if (buf->mode != NUGU_RING_BUFFER_MODE_SPSC) {
+		nugu_error("peek is only supported in SPSC mode");
+		return -1;
+	}
+
+	return _spsc_release_items(&buf->reader, count);
+}
+
 EXPORT_API int nugu_ring_buffer_get_count(NuguRingBuffer *buf)
 {
 	g_return_val_if_fail(buf != NULL, -1);
+
+	if (buf->mode == NUGU_RING_BUFFER_MODE_SPSC)
+		return _spsc_get_count(&buf->reader);
+
 	return buf->count;
 }
 
@@ -221,15 +532,207 @@ EXPORT_API int nugu_ring_buffer_get_item_size(NuguRingBuffer *buf)
 	return buf->item_size;
 }
 
+EXPORT_API enum nugu_ring_buffer_mode
+nugu_ring_buffer_get_mode(NuguRingBuffer *buf)
+{
+	g_return_val_if_fail(buf != NULL, NUGU_RING_BUFFER_MODE_LOCK);
+	return buf->mode;
+}
+
+static void _fill_stats(NuguRingBufferReader *reader, unsigned int pushed,
+			int count, NuguRingBufferStats *stats)
+{
+	stats->pushed = pushed;
+	stats->dropped = (unsigned int)g_atomic_int_get(&reader->dropped);
+	stats->overwrites = (unsigned int)g_atomic_int_get(&reader->overwrites);
+	stats->underruns = (unsigned int)g_atomic_int_get(&reader->underruns);
+	stats->high_watermark = g_atomic_int_get(&reader->high_watermark);
+	stats->count = count;
+	stats->max_items = reader->buf->max_items;
+}
+
+static void _spsc_fill_stats(NuguRingBufferReader *reader,
+			     NuguRingBufferStats *stats)
+{
+	NuguRingBuffer *buf = reader->buf;
+	guint head = (guint)g_atomic_int_get(&buf->head);
+	guint count = head - (guint)g_atomic_int_get(&reader->tail);
+
+	_fill_stats(reader, head, MIN(count, (guint)buf->max_items), stats);
+
+	/* Include the overflow which is not yet noticed by the reader */
+	if (count > (guint)buf->max_items) {
+		stats->dropped += count - buf->max_items;
+		stats->overwrites++;
+	}
+
+	stats->high_watermark = MAX(stats->high_watermark, stats->count);
+}
+
+EXPORT_API int nugu_ring_buffer_get_stats(NuguRingBuffer *buf,
+					  NuguRingBufferStats *stats)
+{
+	g_return_val_if_fail(buf != NULL, -1);
+	g_return_val_if_fail(stats != NULL, -1);
+
+	if (buf->mode == NUGU_RING_BUFFER_MODE_SPSC) {
+		_spsc_fill_stats(&buf->reader, stats);
+		return 0;
+	}
+
+	pthread_mutex_lock(&buf->mutex);
+	_fill_stats(&buf->reader, buf->pushed, buf->count, stats);
+	pthread_mutex_unlock(&buf->mutex);
+
+	return 0;
+}
+
 EXPORT_API void nugu_ring_buffer_clear_items(NuguRingBuffer *buf)
 {
 	g_return_if_fail(buf != NULL);
 
+	if (buf->mode == NUGU_RING_BUFFER_MODE_SPSC) {
+		gint head = g_atomic_int_get(&buf->head);
+
+		g_atomic_int_set(&buf->base, head);
+		g_atomic_int_set(&buf->reader.tail, head);
+		buf->reader.receiving = 0;
+		return;
+	}
+
 	pthread_mutex_lock(&buf->mutex);
 
+	buf->reader.receiving = 0;
 	buf->read_index = 0;
 	buf->woffset = 0;
 	buf->count = 0;
 
 	pthread_mutex_unlock(&buf->mutex);
 }
+
+EXPORT_API NuguRingBufferReader *nugu_ring_buffer_reader_new(NuguRingBuffer *buf)
+{
+	NuguRingBufferReader *reader;
+
+	g_return_val_if_fail(buf != NULL, NULL);
+
+	if (buf->mode != NUGU_RING_BUFFER_MODE_SPSC) {
+		nugu_error("reader is only supported in SPSC mode");
+		return NULL;
+	}
+
+	reader = (NuguRingBufferReader *)calloc(
+		1, sizeof(struct _nugu_ring_buffer_reader));
+	if (!reader) {
+		error_nomem();
+		return NULL;
+	}
+
+	pthread_mutex_lock(&buf->mutex);
+
+	reader->buf = buf;
+	reader->tail = g_atomic_int_get(&buf->head);
+	buf->readers = g_list_append(buf->readers, reader);
+
+	pthread_mutex_unlock(&buf->mutex);
+
+	return reader;
+}
+
+EXPORT_API void nugu_ring_buffer_reader_free(NuguRingBufferReader *reader)
+{
+	NuguRingBuffer *buf;
+
+	g_return_if_fail(reader != NULL);
+
+	buf = reader->buf;
+
+	pthread_mutex_lock(&buf->mutex);
+	buf->readers = g_list_remove(buf->readers, reader);
+	pthread_mutex_unlock(&buf->mutex);
+
+	memset(reader, 0, sizeof(struct _nugu_ring_buffer_reader));
+	free(reader);
+}
+
+EXPORT_API int nugu_ring_buffer_reader_read_item(NuguRingBufferReader *reader,
+						 char *item, int *size)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(item != NULL, -1);
+	g_return_val_if_fail(size != NULL, -1);
+
+	return _spsc_read_item(reader, item, size);
+}
+
+EXPORT_API int nugu_ring_buffer_reader_peek_items(NuguRingBufferReader *reader,
+						  const char **items,
+						  int max_count)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(items != NULL, -1);
+	g_return_val_if_fail(max_count > 0, -1);
+
+	return _spsc_peek_items(reader, items, max_count);
+}
+
+EXPORT_API int
+nugu_ring_buffer_reader_release_items(NuguRingBufferReader *reader, int count)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(count >= 0, -1);
+
+	return _spsc_release_items(reader, count);
+}
+
+EXPORT_API int nugu_ring_buffer_reader_get_count(NuguRingBufferReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+
+	return _spsc_get_count(reader);
+}
+
+EXPORT_API int nugu_ring_buffer_reader_get_stats(NuguRingBufferReader *reader,
+					       NuguRingBufferStats *stats)
+{
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(stats != NULL, -1);
+
+	_spsc_fill_stats(reader, stats);
+
+	return 0;
+}
+
+EXPORT_API void
+nugu_ring_buffer_reader_clear_items(NuguRingBufferReader *reader)
+{
+	g_return_if_fail(reader != NULL);
+
+	g_atomic_int_set(&reader->tail, g_atomic_int_get(&reader->buf->head));
+	reader->receiving = 0;
+}
+
+EXPORT_API int nugu_ring_buffer_reader_rewind(NuguRingBufferReader *reader,
+					      int count)
+{
+	NuguRingBuffer *buf;
+	guint head;
+	guint avail;
+
+	g_return_val_if_fail(reader != NULL, -1);
+	g_return_val_if_fail(count >= 0, -1);
+
+	buf = reader->buf;
+	head = (guint)g_atomic_int_get(&buf->head);
+	avail = head - (guint)g_atomic_int_get(&buf->base);
+
+	if (avail > (guint)buf->max_items)
+		avail = buf->max_items;
+
+	if ((guint)count > avail)
+		count = avail;
+
+	g_atomic_int_set(&reader->tail, (gint)(head - count));
+
+	return count;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+
+#include "nugu_audio_convert.h"
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_S16 AUDIO_FORMAT_S16_LE
+#define FORMAT_FLOAT AUDIO_FORMAT_FLOAT_LE
+#else
+#define FORMAT_S16 AUDIO_FORMAT_S16_BE
+#define FORMAT_FLOAT AUDIO_FORMAT_FLOAT_BE
+#endif
+
+static void test_convert_kernel(void)
+{
+	int16_t s16[11] = { 0, 16384, -16384, 32767, -32768, 1, -1,
+			    100, -100, 8192, -8192 };
+	int16_t s16_out[11];
+	float f32[11];
+	unsigned char s24[6] = { 0x01, 0x02, 0x03, 0xFF, 0xFF, 0xFF };
+	int32_t s32[2];
+	uint16_t u16[2] = { 0x1234, 0xABCD };
+	uint32_t u32[1] = { 0x12345678 };
+	float stereo[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	float left[4];
+	float right[4];
+	float *planes[2] = { left, right };
+	float merged[8];
+	int16_t frames[6] = { 100, 200, -100, -300, 32767, 32767 };
+	int i;
+
+	/* 8 samples with SIMD and the remainder */
+	nugu_audio_s16_to_float(s16, f32, 11);
+	g_assert(f32[0] == 0.0f);
+	g_assert(f32[1] == 0.5f);
+	g_assert(f32[2] == -0.5f);
+	g_assert(f32[4] == -1.0f);
+	g_assert(f32[10] == -0.25f);
+
+	nugu_audio_float_to_s16(f32, s16_out, 11);
+	g_assert(memcmp(s16, s16_out, sizeof(s16)) == 0);
+
+	/* saturation */
+	for (i = 0; i < 11; i++)
+		f32[i] = (i % 2) ? 2.0f : -2.0f;
+	nugu_audio_float_to_s16(f32, s16_out, 11);
+	for (i = 0; i < 11; i++)
+		g_assert(s16_out[i] == ((i % 2) ? 32767 : -32768));
+
+	nugu_audio_s24_to_s32(s24, s32, 2);
+	g_assert(s32[0] == 0x03020100);
+	g_assert(s32[1] == -256);
+	memset(s24, 0, sizeof(s24));
+	nugu_audio_s32_to_s24(s32, s24, 2);
+	g_assert(s24[0] == 0x01 && s24[1] == 0x02 && s24[2] == 0x03);
+	g_assert(s24[3] == 0xFF && s24[4] == 0xFF && s24[5] == 0xFF);
+
+	nugu_audio_swap16(u16, 2);
+	g_assert(u16[0] == 0x3412 && u16[1] == 0xCDAB);
+	nugu_audio_swap32(u32, 1);
+	g_assert(u32[0] == 0x78563412);
+
+	nugu_audio_deinterleave(stereo, planes, 2, 4);
+	g_assert(left[0] == 1 && left[3] == 7);
+	g_assert(right[0] == 2 && right[3] == 8);
+	nugu_audio_interleave((const float *const *)planes, merged, 2, 4);
+	g_assert(memcmp(stereo, merged, sizeof(stereo)) == 0);
+
+	nugu_audio_downmix_float(stereo, stereo, 2, 4);
+	g_assert(stereo[0] == 1.5f && stereo[3] == 7.5f);
+
+	nugu_audio_downmix_s16(frames, frames, 2, 3);
+	g_assert(frames[0] == 150);
+	g_assert(frames[1] == -200);
+	g_assert(frames[2] == 32767);
+
+	nugu_audio_downmix_s16(s16, s16_out, 3, 1);
+	g_assert(s16_out[0] == 0);
+}
+
+static void test_convert_property(void)
+{
+	NuguAudioProperty in;
+	NuguAudioProperty out;
+	unsigned char u8[4] = { 0x80, 0xC0, 0x40, 0xFF };
+	unsigned char s16be[8];
+	unsigned char s24be[12] = { 0x40, 0x00, 0x00, 0x20, 0x00, 0x00,
+				    0xC0, 0x00, 0x00, 0xC0, 0x00, 0x00 };
+	int16_t s16[4];
+	float mono[2] = { 0.5f, -0.25f };
+	float stereo[4];
+
+	in.samplerate = AUDIO_SAMPLE_RATE_16K;
+	out.samplerate = AUDIO_SAMPLE_RATE_16K;
+
+	/* unsigned 8 bits to signed 16 bits big endian */
+	in.format = AUDIO_FORMAT_U8;
+	in.channel = 1;
+	out.format = AUDIO_FORMAT_S16_BE;
+	out.channel = 1;
+	g_assert(nugu_audio_convert(in, u8, out, s16be, 4) == 0);
+	g_assert(s16be[0] == 0x00 && s16be[1] == 0x00);
+	g_assert(s16be[2] == 0x40 && s16be[3] == 0x00);
+	g_assert(s16be[4] == 0xC0 && s16be[5] == 0x00);
+	g_assert(s16be[6] == 0x7F && s16be[7] == 0x00);
+
+	/* byte order only */
+	in.format = AUDIO_FORMAT_S16_BE;
+	in.channel = 2;
+	out.format = AUDIO_FORMAT_S16_LE;
+	out.channel = 2;
+	g_assert(nugu_audio_convert(in, s16be, out, s16, 2) == 0);
+	g_assert(((unsigned char *)s16)[2] == 0x00);
+	g_assert(((unsigned char *)s16)[3] == 0x40);
+
+	/* 24 bits big endian stereo to mono */
+	in.format = AUDIO_FORMAT_S24_BE;
+	out.format = FORMAT_S16;
+	out.channel = 1;
+	g_assert(nugu_audio_convert(in, s24be, out, s16, 2) == 0);
+	g_assert(s16[0] == 0x3000);
+	g_assert(s16[1] == -0x4000);
+
+	/* mono to stereo */
+	in.format = FORMAT_FLOAT;
+	in.channel = 1;
+	out.format = FORMAT_FLOAT;
+	out.channel = 2;
+	g_assert(nugu_audio_convert(in, mono, out, stereo, 2) == 0);
+	g_assert(stereo[0] == 0.5f && stereo[1] == 0.5f);
+	g_assert(stereo[2] == -0.25f && stereo[3] == -0.25f);
+
+	/* not supported channel layout */
+	in.channel = 2;
+	out.channel = 3;
+	g_assert(nugu_audio_convert(in, stereo, out, s16, 1) == -1);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/audio_convert/kernel", test_convert_kernel);
+	g_test_add_func("/audio_convert/property", test_convert_property);
+
+	return g_test_run();
+}
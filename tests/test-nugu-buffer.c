@@ -220,6 +220,77 @@ static void test_buffer_clear_from(void)
 	g_assert(nugu_buffer_free(buf, TRUE) == NULL);
 }
 
+static void test_buffer_compact(void)
+{
+	NuguBuffer *buf;
+	char *tmp;
+
+	buf = nugu_buffer_new(10);
+	g_assert(buf != NULL);
+
+	g_assert(nugu_buffer_add(buf, "1234567890", 10) == 10);
+	g_assert(nugu_buffer_shift_left(buf, 4) == 0);
+	g_assert_cmpstr(nugu_buffer_peek(buf), ==, "567890");
+	g_assert(nugu_buffer_peek_byte(buf, 0) == '5');
+	g_assert(nugu_buffer_find_byte(buf, '9') == 4);
+
+	/* reuse the consumed space without resizing */
+	g_assert(nugu_buffer_add(buf, "abcd", 4) == 4);
+	g_assert(nugu_buffer_get_alloc_size(buf) == 10);
+	g_assert(nugu_buffer_get_size(buf) == 10);
+	g_assert_cmpstr(nugu_buffer_peek(buf), ==, "567890abcd");
+
+	g_assert(nugu_buffer_shift_left(buf, 2) == 0);
+	g_assert(nugu_buffer_clear_from(buf, 4) == 0);
+	g_assert_cmpstr(nugu_buffer_peek(buf), ==, "7890");
+
+	/* secure mode keeps the same behavior */
+	g_assert(nugu_buffer_set_secure(buf, TRUE) == 0);
+	g_assert(nugu_buffer_add(buf, "efghijklmn", 10) == 10);
+	g_assert(nugu_buffer_get_alloc_size(buf) == 20);
+	g_assert_cmpstr(nugu_buffer_peek(buf), ==, "7890efghijklmn");
+
+	g_assert(nugu_buffer_shift_left(buf, 4) == 0);
+	tmp = nugu_buffer_free(buf, FALSE);
+	g_assert(tmp != NULL);
+	g_assert_cmpstr(tmp, ==, "efghijklmn");
+	free(tmp);
+}
+
+static void test_buffer_search(void)
+{
+	NuguBuffer *buf;
+	const char *data = "--boundary\r\nbody\r\n\r\n--boundary--";
+
+	g_assert(nugu_buffer_search_byte(data, strlen(data), '\n') == 11);
+	g_assert(nugu_buffer_search_byte(data, 11, '\n') == NOT_FOUND);
+	g_assert(nugu_buffer_search_byte(data, 0, '-') == NOT_FOUND);
+
+	g_assert(nugu_buffer_search(data, strlen(data), "\r\n\r\n", 4) == 16);
+	g_assert(nugu_buffer_search(data, strlen(data), "--boundary--", 12) ==
+		 20);
+	g_assert(nugu_buffer_search(data, strlen(data), "-", 1) == 0);
+	g_assert(nugu_buffer_search(data, strlen(data), "bodx", 4) ==
+		 NOT_FOUND);
+	g_assert(nugu_buffer_search(data, 19, "\r\n\r\n", 4) == NOT_FOUND);
+	g_assert(nugu_buffer_search(data, 20, "\r\n\r\n", 4) == 16);
+	g_assert(nugu_buffer_search(data, 3, "--boundary", 10) == NOT_FOUND);
+	g_assert(nugu_buffer_search(data, strlen(data), "", 0) == NOT_FOUND);
+
+	buf = nugu_buffer_new(0);
+	g_assert(buf != NULL);
+
+	g_assert(nugu_buffer_add(buf, data, strlen(data)) == strlen(data));
+	g_assert(nugu_buffer_find_bytes(buf, "body", 4) == 12);
+
+	/* the position is relative to the remaining data */
+	g_assert(nugu_buffer_shift_left(buf, 12) == 0);
+	g_assert(nugu_buffer_find_bytes(buf, "body", 4) == 0);
+	g_assert(nugu_buffer_find_byte(buf, '-') == 8);
+
+	g_assert(nugu_buffer_free(buf, TRUE) == NULL);
+}
+
 int main(int argc, char *argv[])
 {
 #if !GLIB_CHECK_VERSION(2, 36, 0)
@@ -234,6 +305,8 @@ int main(int argc, char *argv[])
 	g_test_add_func("/buffer/shift", test_buffer_shift);
 	g_test_add_func("/buffer/pop", test_buffer_pop);
 	g_test_add_func("/buffer/clearfrom", test_buffer_clear_from);
+	g_test_add_func("/buffer/compact", test_buffer_compact);
+	g_test_add_func("/buffer/search", test_buffer_search);
 
 	return g_test_run();
 }
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_chunk.h"
+
+static void test_chunk_default(void)
+{
+	NuguChunkChain *chain;
+	const char *data;
+	size_t length = 0;
+	char *tmp;
+
+	chain = nugu_chunk_chain_new();
+	g_assert(chain != NULL);
+
+	g_assert(nugu_chunk_chain_get_size(chain) == 0);
+	g_assert(nugu_chunk_chain_get_count(chain) == 0);
+	g_assert(nugu_chunk_chain_flatten(chain, NULL) == NULL);
+	g_assert(nugu_chunk_chain_peek(chain, 0, NULL) == NULL);
+
+	g_assert(nugu_chunk_chain_add(chain, NULL, 1) == -1);
+	g_assert(nugu_chunk_chain_add(chain, "1234", 0) == -1);
+
+	/* contiguous data is merged into one segment */
+	g_assert(nugu_chunk_chain_add(chain, "1234", 4) == 0);
+	g_assert(nugu_chunk_chain_add(chain, "5678", 4) == 0);
+	g_assert(nugu_chunk_chain_get_size(chain) == 8);
+	g_assert(nugu_chunk_chain_get_count(chain) == 1);
+
+	data = nugu_chunk_chain_peek(chain, 0, &length);
+	g_assert(data != NULL);
+	g_assert(length == 8);
+	g_assert(memcmp(data, "12345678", 8) == 0);
+
+	tmp = strdup("abcd");
+	g_assert(nugu_chunk_chain_add_take(chain, tmp, 4) == 0);
+	g_assert(nugu_chunk_chain_get_count(chain) == 2);
+	g_assert(nugu_chunk_chain_peek(chain, 1, NULL) == tmp);
+
+	tmp = nugu_chunk_chain_flatten(chain, &length);
+	g_assert(tmp != NULL);
+	g_assert(length == 12);
+	g_assert_cmpstr(tmp, ==, "12345678abcd");
+	free(tmp);
+
+	nugu_chunk_chain_clear(chain);
+	g_assert(nugu_chunk_chain_get_size(chain) == 0);
+	g_assert(nugu_chunk_chain_get_count(chain) == 0);
+
+	nugu_chunk_chain_free(chain);
+}
+
+static void test_chunk_share(void)
+{
+	NuguChunkChain *src;
+	NuguChunkChain *dest;
+	struct iovec iov[4];
+	const char *data;
+	size_t length = 0;
+
+	src = nugu_chunk_chain_new();
+	g_assert(src != NULL);
+	dest = nugu_chunk_chain_new();
+	g_assert(dest != NULL);
+
+	g_assert(nugu_chunk_chain_add(src, "1234", 4) == 0);
+	g_assert(nugu_chunk_chain_append(dest, src) == 0);
+	g_assert(nugu_chunk_chain_append(dest, dest) == -1);
+
+	/* the data is shared without copying */
+	g_assert(nugu_chunk_chain_peek(dest, 0, NULL) ==
+		 nugu_chunk_chain_peek(src, 0, NULL));
+
+	/* the source can be reused without changing the shared data */
+	nugu_chunk_chain_clear(src);
+	g_assert(nugu_chunk_chain_add(src, "5678", 4) == 0);
+	g_assert(nugu_chunk_chain_append(dest, src) == 0);
+	nugu_chunk_chain_free(src);
+
+	g_assert(nugu_chunk_chain_get_count(dest) == 2);
+	g_assert(nugu_chunk_chain_get_iovec(dest, iov, 4) == 2);
+	g_assert(iov[0].iov_len == 4);
+	g_assert(memcmp(iov[0].iov_base, "1234", 4) == 0);
+	g_assert(iov[1].iov_len == 4);
+	g_assert(memcmp(iov[1].iov_base, "5678", 4) == 0);
+
+	g_assert(nugu_chunk_chain_linearize(dest) == 0);
+	g_assert(nugu_chunk_chain_get_count(dest) == 1);
+	data = nugu_chunk_chain_peek(dest, 0, &length);
+	g_assert(length == 8);
+	g_assert(memcmp(data, "12345678", 8) == 0);
+
+	nugu_chunk_chain_free(dest);
+}
+
+static void test_chunk_truncate(void)
+{
+	NuguChunkChain *chain;
+	char *tmp;
+
+	chain = nugu_chunk_chain_new();
+	g_assert(chain != NULL);
+
+	/* the data larger than the reserved size goes to a new block */
+	g_assert(nugu_chunk_chain_reserve(chain, 6) == 0);
+	g_assert(nugu_chunk_chain_add(chain, "1234", 4) == 0);
+	g_assert(nugu_chunk_chain_add(chain, "5678", 4) == 0);
+	g_assert(nugu_chunk_chain_add(chain, "\r\n\r\n", 4) == 0);
+	g_assert(nugu_chunk_chain_get_count(chain) == 2);
+
+	g_assert(nugu_chunk_chain_truncate(chain, 20) == 0);
+	g_assert(nugu_chunk_chain_get_size(chain) == 12);
+
+	g_assert(nugu_chunk_chain_truncate(chain, 6) == 0);
+	g_assert(nugu_chunk_chain_get_size(chain) == 6);
+	g_assert(nugu_chunk_chain_get_count(chain) == 2);
+
+	tmp = nugu_chunk_chain_flatten(chain, NULL);
+	g_assert_cmpstr(tmp, ==, "123456");
+	free(tmp);
+
+	g_assert(nugu_chunk_chain_truncate(chain, 4) == 0);
+	g_assert(nugu_chunk_chain_get_count(chain) == 1);
+
+	g_assert(nugu_chunk_chain_truncate(chain, 0) == 0);
+	g_assert(nugu_chunk_chain_get_size(chain) == 0);
+	g_assert(nugu_chunk_chain_get_count(chain) == 0);
+
+	nugu_chunk_chain_free(chain);
+}
+
+static void test_chunk_pool(void)
+{
+	NuguChunkChain *chain;
+	NuguPoolStats stats;
+
+	chain = nugu_chunk_chain_new();
+	g_assert(chain != NULL);
+
+	/* The pool is kept while the chain is in use */
+	nugu_chunk_chain_pool_deinit();
+	g_assert(nugu_chunk_chain_get_pool_stats(&stats) == 0);
+	g_assert(stats.in_use == 1);
+
+	nugu_chunk_chain_free(chain);
+
+	nugu_chunk_chain_pool_deinit();
+	g_assert(nugu_chunk_chain_get_pool_stats(&stats) == 0);
+	g_assert(stats.allocs == 0 && stats.slabs == 0);
+
+	/* A new pool is created on demand */
+	chain = nugu_chunk_chain_new();
+	g_assert(chain != NULL);
+	g_assert(nugu_chunk_chain_get_pool_stats(&stats) == 0);
+	g_assert(stats.allocs == 1 && stats.in_use == 1);
+
+	nugu_chunk_chain_free(chain);
+	nugu_chunk_chain_pool_deinit();
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/chunk/default", test_chunk_default);
+	g_test_add_func("/chunk/share", test_chunk_share);
+	g_test_add_func("/chunk/truncate", test_chunk_truncate);
+	g_test_add_func("/chunk/pool", test_chunk_pool);
+
+	return g_test_run();
+}
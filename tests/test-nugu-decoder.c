@@ -84,6 +84,338 @@ static void test_decoder_decode(void)
 
 static struct nugu_decoder_driver_ops empty_ops = { .decode = NULL };
 
+/**
+ * wrap the data with '[]'
+ */
+static int worker_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
+			 const void *data, size_t data_len, NuguBuffer *out_buf)
+{
+	nugu_buffer_add(out_buf, "[", 1);
+	nugu_buffer_add(out_buf, data, data_len);
+	nugu_buffer_add(out_buf, "]", 1);
+
+	return 0;
+}
+
+static struct nugu_decoder_driver_ops worker_ops = { .decode = worker_decode };
+
+static int dummy_pcm_start(NuguPcmDriver *driver, NuguPcm *pcm,
+			   NuguAudioProperty prop)
+{
+	return 0;
+}
+
+static int dummy_pcm_stop(NuguPcmDriver *driver, NuguPcm *pcm)
+{
+	return 0;
+}
+
+static struct nugu_pcm_driver_ops pcm_ops = { .start = dummy_pcm_start,
+					      .stop = dummy_pcm_stop };
+
+static void _wait_last_data(NuguPcm *pcm)
+{
+	int i;
+
+	for (i = 0; i < 1000 && !nugu_pcm_receive_is_last_data(pcm); i++)
+		g_usleep(1000);
+
+	g_assert(nugu_pcm_receive_is_last_data(pcm) == 1);
+}
+
+static void test_decoder_worker(void)
+{
+	NuguDecoderDriver *driver;
+	NuguPcmDriver *pcm_driver;
+	NuguDecoder *dec;
+	NuguPcm *pcm;
+	char out[32];
+
+	driver = nugu_decoder_driver_new("worker", DECODER_TYPE_CUSTOM,
+					 &worker_ops);
+	g_assert(driver != NULL);
+
+	pcm_driver = nugu_pcm_driver_new("dummy", &pcm_ops);
+	pcm = nugu_pcm_new("worker", pcm_driver);
+	g_assert(pcm != NULL);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	/* The worker needs the pcm */
+	dec = nugu_decoder_new(driver, NULL);
+	g_assert(nugu_decoder_start(dec) == -1);
+	nugu_decoder_free(dec);
+
+	dec = nugu_decoder_new(driver, pcm);
+	g_assert(dec != NULL);
+	g_assert(nugu_decoder_push(dec, "ab", 2) == -1);
+
+	g_assert(nugu_decoder_start(dec) == 0);
+	g_assert(nugu_decoder_push(dec, "ab", 2) == 0);
+	g_assert(nugu_decoder_push(dec, "c", 1) == 0);
+	g_assert(nugu_decoder_push_done(dec) == 0);
+
+	/* The decoded data is pushed in order before the end of data */
+	_wait_last_data(pcm);
+	g_assert(nugu_pcm_get_data_size(pcm) == 7);
+	g_assert(nugu_pcm_get_data(pcm, out, sizeof(out)) == 7);
+	g_assert(memcmp(out, "[ab][c]", 7) == 0);
+
+	/* The canceled data is not pushed */
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_decoder_push(dec, "xyz", 3) == 0);
+	g_assert(nugu_decoder_cancel(dec) == 0);
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_decoder_push(dec, "d", 1) == 0);
+	g_assert(nugu_decoder_push_done(dec) == 0);
+
+	_wait_last_data(pcm);
+	g_assert(nugu_pcm_get_data(pcm, out, sizeof(out)) == 3);
+	g_assert(memcmp(out, "[d]", 3) == 0);
+
+	g_assert(nugu_decoder_stop(dec) == 0);
+	g_assert(nugu_decoder_push(dec, "ab", 2) == -1);
+
+	/* The worker is stopped by nugu_decoder_free() */
+	g_assert(nugu_decoder_start(dec) == 0);
+	g_assert(nugu_decoder_push(dec, "ab", 2) == 0);
+	g_assert(nugu_decoder_free(dec) == 0);
+
+	g_assert(nugu_pcm_stop(pcm) == 0);
+	nugu_pcm_free(pcm);
+	g_assert(nugu_pcm_driver_free(pcm_driver) == 0);
+	g_assert(nugu_decoder_driver_free(driver) == 0);
+}
+
+/**
+ * a frame of 1 byte is decoded to 2 bytes (e.g. 'a' -> "aa")
+ */
+static int frame_decode_into(NuguDecoderDriver *driver, NuguDecoder *dec,
+			     const void *data, size_t data_len, void *out,
+			     size_t out_size, size_t *consumed)
+{
+	const char *src = data;
+	char *dest = out;
+	size_t frames = MIN(data_len, out_size / 2);
+	size_t i;
+
+	for (i = 0; i < frames; i++) {
+		dest[i * 2] = src[i];
+		dest[i * 2 + 1] = src[i];
+	}
+
+	*consumed = frames;
+
+	return frames * 2;
+}
+
+static int frame_decode(NuguDecoderDriver *driver, NuguDecoder *dec,
+			const void *data, size_t data_len, NuguBuffer *out_buf)
+{
+	char out[2];
+	size_t consumed;
+	size_t i;
+
+	for (i = 0; i < data_len; i++) {
+		frame_decode_into(driver, dec, (const char *)data + i, 1, out,
+				  sizeof(out), &consumed);
+		nugu_buffer_add(out_buf, out, sizeof(out));
+	}
+
+	return 0;
+}
+
+static int _reset_count;
+static int _reset_fail;
+
+static int frame_reset(NuguDecoderDriver *driver, NuguDecoder *dec)
+{
+	_reset_count++;
+
+	return _reset_fail ? -1 : 0;
+}
+
+static struct nugu_decoder_driver_ops frame_ops = {
+	.decode = frame_decode,
+	.decode_into = frame_decode_into,
+	.reset = frame_reset
+};
+
+static void test_decoder_decode_into(void)
+{
+	NuguDecoderDriver *driver;
+	NuguPcmDriver *pcm_driver;
+	NuguDecoder *dec;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	char *src;
+	char *out;
+	size_t size = 10000;
+	size_t consumed = 0;
+	size_t pos = 0;
+	size_t i;
+	int ret;
+
+	src = malloc(size);
+	out = malloc(size * 2);
+	g_assert(src != NULL && out != NULL);
+
+	for (i = 0; i < size; i++)
+		src[i] = (char)(i % 251);
+
+	/* Not supported by the driver */
+	driver = nugu_decoder_driver_new("worker", DECODER_TYPE_CUSTOM,
+					 &worker_ops);
+	dec = nugu_decoder_new(driver, NULL);
+	g_assert(nugu_decoder_decode_into(dec, "a", 1, out, 2, &consumed) ==
+		 -1);
+	nugu_decoder_free(dec);
+	nugu_decoder_driver_free(driver);
+
+	driver = nugu_decoder_driver_new("frame", DECODER_TYPE_CUSTOM,
+					 &frame_ops);
+	g_assert(driver != NULL);
+
+	/* Only the whole frames which fit in the buffer */
+	dec = nugu_decoder_new(driver, NULL);
+	g_assert(nugu_decoder_decode_into(dec, "abc", 3, out, 5, &consumed) ==
+		 4);
+	g_assert(consumed == 2);
+	g_assert(memcmp(out, "aabb", 4) == 0);
+	nugu_decoder_free(dec);
+
+	pcm_driver = nugu_pcm_driver_new("dummy", &pcm_ops);
+	pcm = nugu_pcm_new("decode_into", pcm_driver);
+	g_assert(pcm != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S8;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	/* Decoded into the ring, and the rest through the buffer */
+	dec = nugu_decoder_new(driver, pcm);
+	g_assert(dec != NULL);
+	g_assert(nugu_decoder_play(dec, src, size) == 0);
+	g_assert(nugu_pcm_get_data_size(pcm) == size * 2);
+
+	while (pos < size * 2) {
+		ret = nugu_pcm_get_data(pcm, out + pos, 333);
+		g_assert(ret > 0);
+		pos += ret;
+	}
+
+	for (i = 0; i < size; i++) {
+		g_assert(out[i * 2] == src[i]);
+		g_assert(out[i * 2 + 1] == src[i]);
+	}
+
+	/* The worker also decodes into the ring, and resets at the end */
+	_reset_count = 0;
+	g_assert(nugu_decoder_start(dec) == 0);
+	g_assert(nugu_decoder_push(dec, "xy", 2) == 0);
+	g_assert(nugu_decoder_push_done(dec) == 0);
+	_wait_last_data(pcm);
+	g_assert(nugu_pcm_get_data(pcm, out, size) == 4);
+	g_assert(memcmp(out, "xxyy", 4) == 0);
+	g_assert(_reset_count == 1);
+
+	g_assert(nugu_decoder_cancel(dec) == 0);
+	g_assert(_reset_count == 2);
+
+	g_assert(nugu_decoder_free(dec) == 0);
+	g_assert(nugu_pcm_stop(pcm) == 0);
+	nugu_pcm_free(pcm);
+	g_assert(nugu_pcm_driver_free(pcm_driver) == 0);
+	g_assert(nugu_decoder_driver_free(driver) == 0);
+
+	free(src);
+	free(out);
+}
+
+static void test_decoder_pool(void)
+{
+	NuguDecoderDriver *driver;
+	NuguPcmDriver *pcm_driver;
+	NuguDecoder *dec;
+	NuguDecoder *dec2;
+	NuguDecoder *decs[6];
+	NuguPcm *pcm;
+	NuguPcm *pcm2;
+	NuguAudioProperty prop;
+	int i;
+
+	driver = nugu_decoder_driver_new("frame", DECODER_TYPE_CUSTOM,
+					 &frame_ops);
+	g_assert(driver != NULL);
+
+	pcm_driver = nugu_pcm_driver_new("dummy", &pcm_ops);
+	pcm = nugu_pcm_new("pool", pcm_driver);
+	pcm2 = nugu_pcm_new("pool2", pcm_driver);
+	g_assert(pcm != NULL && pcm2 != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S8;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	g_assert(nugu_pcm_set_property(pcm2, prop) == 0);
+
+	/* Reset without the worker */
+	_reset_count = 0;
+	dec = nugu_decoder_pool_get(driver, pcm);
+	g_assert(dec != NULL);
+	g_assert(nugu_decoder_get_pcm(dec) == pcm);
+	g_assert(nugu_decoder_reset(dec) == 0);
+	g_assert(_reset_count == 1);
+
+	/* The idle decoder is reused for the sink of the same rate */
+	g_assert(nugu_decoder_start(dec) == 0);
+	g_assert(nugu_decoder_pool_put(dec) == 0);
+	g_assert(_reset_count == 2);
+	g_assert(nugu_decoder_driver_free(driver) == -1);
+
+	dec2 = nugu_decoder_pool_get(driver, pcm2);
+	g_assert(dec2 != NULL && dec2 != dec);
+	g_assert(nugu_decoder_pool_get(driver, pcm) == dec);
+	g_assert(nugu_decoder_get_pcm(dec) == pcm);
+
+	/* The worker is started again */
+	g_assert(nugu_decoder_push(dec, "a", 1) == -1);
+	g_assert(nugu_decoder_start(dec) == 0);
+	g_assert(nugu_decoder_push(dec, "a", 1) == 0);
+
+	g_assert(nugu_decoder_pool_put(dec) == 0);
+	g_assert(nugu_decoder_pool_put(dec2) == 0);
+
+	/* The decoder is destroyed if the pool is full */
+	for (i = 0; i < 6; i++) {
+		decs[i] = nugu_decoder_pool_get(driver, NULL);
+		g_assert(decs[i] != NULL);
+	}
+	for (i = 0; i < 6; i++)
+		g_assert(nugu_decoder_pool_put(decs[i]) == 0);
+
+	/* The decoder is destroyed if the reset is failed */
+	nugu_decoder_pool_clear();
+	dec = nugu_decoder_pool_get(driver, pcm);
+	g_assert(dec != NULL);
+	_reset_fail = 1;
+	g_assert(nugu_decoder_pool_put(dec) == -1);
+	_reset_fail = 0;
+	g_assert(nugu_decoder_driver_free(driver) == 0);
+	driver = nugu_decoder_driver_new("frame", DECODER_TYPE_CUSTOM,
+					 &frame_ops);
+	g_assert(driver != NULL);
+
+	nugu_decoder_pool_clear();
+	g_assert(nugu_decoder_driver_free(driver) == 0);
+
+	nugu_pcm_free(pcm);
+	nugu_pcm_free(pcm2);
+	g_assert(nugu_pcm_driver_free(pcm_driver) == 0);
+}
+
 static void test_decoder_default(void)
 {
 	NuguDecoderDriver *driver;
@@ -170,6 +502,9 @@ int main(int argc, char *argv[])
 
 	g_test_add_func("/decoder/driver_default", test_decoder_default);
 	g_test_add_func("/decoder/decode", test_decoder_decode);
+	g_test_add_func("/decoder/worker", test_decoder_worker);
+	g_test_add_func("/decoder/decode_into", test_decoder_decode_into);
+	g_test_add_func("/decoder/pool", test_decoder_pool);
 
 	return g_test_run();
 }
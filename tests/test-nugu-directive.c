@@ -117,6 +117,62 @@ static void test_nugu_directive_default(void)
 	nugu_directive_free(ndir);
 }
 
+static void test_nugu_directive_chunks(void)
+{
+	NuguDirective *ndir;
+	NuguChunkChain *chunks;
+	NuguChunkChain *received;
+	size_t length = 0;
+
+	ndir = nugu_directive_new("TTS", "Speak", "1.0", TEST_UUID_1,
+				  TEST_UUID_2, "{}");
+	g_assert(ndir != NULL);
+
+	g_assert(nugu_directive_get_chunks(ndir) == NULL);
+
+	chunks = nugu_chunk_chain_new();
+	g_assert(chunks != NULL);
+	g_assert(nugu_chunk_chain_add(chunks, dummy, sizeof(dummy)) == 0);
+
+	g_assert(nugu_directive_add_chunks(ndir, chunks) == 0);
+	g_assert(nugu_directive_add_data(ndir, sizeof(dummy), dummy) == 0);
+	g_assert(nugu_directive_get_data_size(ndir) == sizeof(dummy) * 2);
+
+	/* each attachment keeps its own segment */
+	received = nugu_directive_get_chunks(ndir);
+	g_assert(received != NULL);
+	g_assert(nugu_chunk_chain_get_count(received) == 2);
+	g_assert(nugu_chunk_chain_peek(received, 0, &length) ==
+		 nugu_chunk_chain_peek(chunks, 0, NULL));
+	g_assert(length == sizeof(dummy));
+	g_assert(nugu_directive_get_data_size(ndir) == 0);
+
+	nugu_chunk_chain_free(received);
+	nugu_chunk_chain_free(chunks);
+	nugu_directive_free(ndir);
+}
+
+static void test_nugu_directive_pool(void)
+{
+	NuguDirective *ndir;
+	NuguPoolStats stats;
+
+	ndir = nugu_directive_new("TTS", "Speak", "1.0", TEST_UUID_1,
+				  TEST_UUID_2, "{}");
+	g_assert(ndir != NULL);
+
+	/* The pool is kept while the directive is in use */
+	nugu_directive_pool_deinit();
+	g_assert(nugu_directive_get_pool_stats(&stats) == 0);
+	g_assert(stats.in_use == 1);
+
+	nugu_directive_free(ndir);
+
+	nugu_directive_pool_deinit();
+	g_assert(nugu_directive_get_pool_stats(&stats) == 0);
+	g_assert(stats.allocs == 0 && stats.slabs == 0);
+}
+
 int main(int argc, char *argv[])
 {
 #if !GLIB_CHECK_VERSION(2, 36, 0)
@@ -127,8 +183,10 @@ int main(int argc, char *argv[])
 	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
 
 	g_test_add_func("/nugu_directive/default", test_nugu_directive_default);
+	g_test_add_func("/nugu_directive/chunks", test_nugu_directive_chunks);
 	g_test_add_func("/nugu_directive/callback",
 			test_nugu_directive_callback);
+	g_test_add_func("/nugu_directive/pool", test_nugu_directive_pool);
 
 	return g_test_run();
 }
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_encoder.h"
+
+static int _frame_count;
+static int _reset_count;
+
+static int dummy_create(NuguEncoderDriver *driver, NuguEncoder *enc)
+{
+	NuguEncoderOption option;
+
+	g_assert(nugu_encoder_get_option(enc, &option) == 0);
+
+	/* The driver rejects the option */
+	if (option.bitrate < 0)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * a frame is encoded to the first byte of the frame
+ */
+static int dummy_encode(NuguEncoderDriver *driver, NuguEncoder *enc,
+			const void *data, size_t data_len, NuguBuffer *out_buf)
+{
+	g_assert(data_len == nugu_encoder_get_frame_size(enc));
+	_frame_count++;
+
+	nugu_buffer_add(out_buf, data, 1);
+
+	return 0;
+}
+
+static int dummy_reset(NuguEncoderDriver *driver, NuguEncoder *enc)
+{
+	_reset_count++;
+
+	return 0;
+}
+
+static struct nugu_encoder_driver_ops encoder_driver_ops = {
+	.create = dummy_create,
+	.encode = dummy_encode,
+	.reset = dummy_reset
+};
+
+static void test_encoder_default(void)
+{
+	NuguEncoderDriver *driver;
+	NuguEncoderDriver *driver2;
+	NuguEncoder *enc;
+	NuguEncoderOption option;
+	NuguAudioProperty prop;
+	char *mydata = "test";
+
+	g_assert(nugu_encoder_driver_new(NULL, ENCODER_TYPE_CUSTOM, NULL) ==
+		 NULL);
+	g_assert(nugu_encoder_driver_new("test", ENCODER_TYPE_CUSTOM, NULL) ==
+		 NULL);
+	g_assert(nugu_encoder_driver_register(NULL) < 0);
+	g_assert(nugu_encoder_driver_remove(NULL) < 0);
+	g_assert(nugu_encoder_driver_find(NULL) == NULL);
+	g_assert(nugu_encoder_driver_find("") == NULL);
+
+	driver = nugu_encoder_driver_new("test", ENCODER_TYPE_CUSTOM,
+					 &encoder_driver_ops);
+	g_assert(driver != NULL);
+	g_assert(nugu_encoder_driver_register(driver) == 0);
+	g_assert(nugu_encoder_driver_register(driver) < 0);
+	g_assert(nugu_encoder_driver_find("test") == driver);
+	g_assert(nugu_encoder_driver_find_bytype(ENCODER_TYPE_CUSTOM) ==
+		 driver);
+	g_assert(nugu_encoder_driver_find_bytype(ENCODER_TYPE_OPUS) == NULL);
+
+	driver2 = nugu_encoder_driver_new("test2", ENCODER_TYPE_OPUS,
+					  &encoder_driver_ops);
+	g_assert(driver2 != NULL);
+	g_assert(nugu_encoder_driver_register(driver2) == 0);
+	g_assert(nugu_encoder_driver_find_bytype(ENCODER_TYPE_OPUS) ==
+		 driver2);
+	g_assert(nugu_encoder_driver_remove(driver2) == 0);
+	g_assert(nugu_encoder_driver_free(driver2) == 0);
+
+	/* 1000 bytes per 10 ms */
+	prop.samplerate = AUDIO_SAMPLE_RATE_48K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+
+	g_assert(nugu_encoder_new(NULL, prop, NULL) == NULL);
+
+	/* The default option */
+	enc = nugu_encoder_new(driver, prop, NULL);
+	g_assert(enc != NULL);
+	g_assert(nugu_encoder_driver_free(driver) == -1);
+	g_assert(nugu_encoder_get_option(enc, &option) == 0);
+	g_assert(option.bitrate == 0);
+	g_assert(option.complexity == -1);
+	g_assert(option.frame_time == NUGU_ENCODER_DEFAULT_FRAME_TIME);
+	g_assert(nugu_encoder_get_property(enc, &prop) == 0);
+	g_assert(prop.samplerate == AUDIO_SAMPLE_RATE_48K);
+	g_assert(nugu_encoder_get_frame_size(enc) == 1920);
+
+	g_assert(nugu_encoder_set_userdata(enc, mydata) == 0);
+	g_assert(nugu_encoder_get_userdata(enc) == mydata);
+	g_assert(nugu_encoder_free(enc) == 0);
+
+	/* The option is rejected by the core or the driver */
+	option.bitrate = 16000;
+	option.complexity = 5;
+	option.frame_time = 0;
+	g_assert(nugu_encoder_new(driver, prop, &option) == NULL);
+	option.frame_time = 10;
+	option.bitrate = -1;
+	g_assert(nugu_encoder_new(driver, prop, &option) == NULL);
+
+	g_assert(nugu_encoder_driver_remove(driver) == 0);
+	g_assert(nugu_encoder_driver_remove(driver) == -1);
+	g_assert(nugu_encoder_driver_free(driver) == 0);
+}
+
+static void test_encoder_encode(void)
+{
+	NuguEncoderDriver *driver;
+	NuguEncoder *enc;
+	NuguEncoderOption option;
+	NuguAudioProperty prop;
+	NuguBuffer *out;
+	unsigned char data[5000];
+	size_t i;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = (unsigned char)(i / 1000);
+
+	driver = nugu_encoder_driver_new("test", ENCODER_TYPE_CUSTOM,
+					 &encoder_driver_ops);
+	g_assert(driver != NULL);
+
+	/* 1000 bytes per 10 ms */
+	prop.samplerate = AUDIO_SAMPLE_RATE_48K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+
+	option.bitrate = 0;
+	option.complexity = -1;
+	option.frame_time = 10;
+	enc = nugu_encoder_new(driver, prop, &option);
+	g_assert(enc != NULL);
+	g_assert(nugu_encoder_get_frame_size(enc) == 960);
+
+	out = nugu_buffer_new(0);
+
+	/* The part of frame is kept until the next data */
+	_frame_count = 0;
+	g_assert(nugu_encoder_encode(enc, data, 500, out) == 0);
+	g_assert(_frame_count == 0);
+	g_assert(nugu_encoder_encode(enc, data + 500, 500, out) == 0);
+	g_assert(_frame_count == 1);
+	g_assert(nugu_encoder_encode(enc, data + 1000, 4000, out) == 0);
+	g_assert(_frame_count == 5);
+	g_assert(nugu_buffer_get_size(out) == 5);
+	g_assert(nugu_buffer_peek_byte(out, 0) == 0);
+	g_assert(nugu_buffer_peek_byte(out, 1) == 0);
+	g_assert(nugu_buffer_peek_byte(out, 2) == 1);
+	g_assert(nugu_buffer_peek_byte(out, 4) == 3);
+
+	/* The reset drops the part of frame */
+	_reset_count = 0;
+	g_assert(nugu_encoder_reset(enc) == 0);
+	g_assert(_reset_count == 1);
+	nugu_buffer_clear(out);
+	g_assert(nugu_encoder_encode(enc, data + 4000, 960, out) == 0);
+	g_assert(_frame_count == 6);
+	g_assert(nugu_buffer_peek_byte(out, 0) == 4);
+
+	nugu_buffer_free(out, TRUE);
+	g_assert(nugu_encoder_free(enc) == 0);
+	g_assert(nugu_encoder_driver_free(driver) == 0);
+}
+
+/* The EPD outputs from the 5th frame, and buffers every odd frame */
+#define EPD_START_FRAME 5
+#define EPD_FRAME_COUNT 20
+
+static int _fake_epd_output(int index)
+{
+	if (index < EPD_START_FRAME)
+		return 0;
+
+	return (index % 2 == 0 || index == EPD_START_FRAME) ? 1 : 0;
+}
+
+static void test_encoder_lookback(void)
+{
+	NuguEncoderDriver *driver;
+	NuguEncoder *enc;
+	NuguEncoderOption option;
+	NuguAudioProperty prop;
+	NuguBuffer *out;
+	unsigned char frame[960];
+	int started = 0;
+	int i;
+
+	driver = nugu_encoder_driver_new("test", ENCODER_TYPE_CUSTOM,
+					 &encoder_driver_ops);
+	g_assert(driver != NULL);
+
+	/* 960 bytes per 10 ms */
+	prop.samplerate = AUDIO_SAMPLE_RATE_48K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+
+	option.bitrate = 0;
+	option.complexity = -1;
+	option.frame_time = 10;
+	enc = nugu_encoder_new(driver, prop, &option);
+	g_assert(enc != NULL);
+
+	/* 3 frames before the start of the speech */
+	g_assert(nugu_encoder_set_lookback(enc, 30) == 0);
+
+	out = nugu_buffer_new(0);
+	_frame_count = 0;
+
+	/* Same as the speech recognizer */
+	for (i = 0; i < EPD_FRAME_COUNT; i++) {
+		memset(frame, i, sizeof(frame));
+
+		if (_fake_epd_output(i) > 0)
+			started = 1;
+
+		if (started)
+			g_assert(nugu_encoder_encode(enc, frame, sizeof(frame),
+						     out) == 0);
+		else
+			g_assert(nugu_encoder_hold(enc, frame,
+						   sizeof(frame)) == 0);
+	}
+
+	/* The lookback frames and all frames after the start are encoded */
+	g_assert(_frame_count == EPD_FRAME_COUNT - EPD_START_FRAME + 3);
+	for (i = 0; i < _frame_count; i++)
+		g_assert(nugu_buffer_peek_byte(out, i) ==
+			 EPD_START_FRAME - 3 + i);
+
+	/* The reset drops the held data */
+	g_assert(nugu_encoder_hold(enc, frame, sizeof(frame)) == 0);
+	g_assert(nugu_encoder_reset(enc) == 0);
+	nugu_buffer_clear(out);
+	_frame_count = 0;
+	g_assert(nugu_encoder_encode(enc, frame, sizeof(frame), out) == 0);
+	g_assert(_frame_count == 1);
+
+	nugu_buffer_free(out, TRUE);
+	g_assert(nugu_encoder_free(enc) == 0);
+	g_assert(nugu_encoder_driver_free(driver) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/encoder/default", test_encoder_default);
+	g_test_add_func("/encoder/encode", test_encoder_encode);
+	g_test_add_func("/encoder/lookback", test_encoder_lookback);
+
+	return g_test_run();
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+
+#include "nugu_media.h"
+#include "nugu_gain.h"
+
+static void test_gain_default(void)
+{
+	NuguGain *gain;
+	int16_t src[4] = { 1000, -1000, 32767, -32768 };
+	int16_t dest[4] = { 0, 0, 0, 0 };
+
+	gain = nugu_gain_new();
+	g_assert(gain != NULL);
+
+	g_assert(nugu_gain_get_volume(gain) == NUGU_SET_VOLUME_MAX);
+	g_assert(nugu_gain_is_unity(gain) == 1);
+
+	/* maximum volume: copy without change */
+	g_assert(nugu_gain_apply(gain, src, dest, sizeof(src)) ==
+		 sizeof(src));
+	g_assert(memcmp(src, dest, sizeof(src)) == 0);
+
+	/* volume change before the first data is applied at once */
+	g_assert(nugu_gain_set_volume(gain, 50) == 0);
+	g_assert(nugu_gain_is_unity(gain) == 0);
+	nugu_gain_reset(gain);
+	g_assert(nugu_gain_set_volume(gain, 150) == 0);
+	g_assert(nugu_gain_get_volume(gain) == NUGU_SET_VOLUME_MAX);
+	g_assert(nugu_gain_set_volume(gain, 50) == 0);
+
+	g_assert(nugu_gain_apply(gain, src, dest, sizeof(src)) ==
+		 sizeof(src));
+	g_assert(dest[0] == 500);
+	g_assert(dest[1] == -500);
+	g_assert(dest[2] == 16383);
+	g_assert(dest[3] == -16384);
+
+	/* in-place */
+	g_assert(nugu_gain_apply(gain, dest, dest, sizeof(dest)) ==
+		 sizeof(dest));
+	g_assert(dest[0] == 250);
+
+	g_assert(nugu_gain_set_volume(gain, -1) == 0);
+	g_assert(nugu_gain_get_volume(gain) == NUGU_SET_VOLUME_MIN);
+
+	nugu_gain_free(gain);
+}
+
+static void test_gain_format(void)
+{
+	NuguGain *gain;
+	NuguAudioProperty prop;
+	unsigned char s16be[4] = { 0x10, 0x00, 0xF0, 0x00 };
+	unsigned char u8[3] = { 0x80, 0xFF, 0x00 };
+	unsigned char s24le[6] = { 0x00, 0x00, 0x10, 0x00, 0x00, 0xF0 };
+	float f32[2] = { 1.0f, -0.5f };
+
+	gain = nugu_gain_new();
+	g_assert(gain != NULL);
+
+	g_assert(nugu_gain_set_volume(gain, 50) == 0);
+
+	/* 0x1000, -0x1000 */
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	prop.format = AUDIO_FORMAT_S16_BE;
+	prop.channel = 1;
+	g_assert(nugu_gain_set_property(gain, prop) == 0);
+	g_assert(nugu_gain_apply(gain, s16be, s16be, 4) == 4);
+	g_assert(s16be[0] == 0x08 && s16be[1] == 0x00);
+	g_assert(s16be[2] == 0xF8 && s16be[3] == 0x00);
+
+	/* 0x80 is the silence of unsigned samples */
+	prop.format = AUDIO_FORMAT_U8;
+	g_assert(nugu_gain_set_property(gain, prop) == 0);
+	g_assert(nugu_gain_apply(gain, u8, u8, 3) == 3);
+	g_assert(u8[0] == 0x80);
+	g_assert(u8[1] == 0x80 + 0x3F);
+	g_assert(u8[2] == 0x80 - 0x40);
+
+	/* 0x100000, -0x100000 */
+	prop.format = AUDIO_FORMAT_S24_LE;
+	prop.channel = 2;
+	g_assert(nugu_gain_set_property(gain, prop) == 0);
+	g_assert(nugu_gain_apply(gain, s24le, s24le, 6) == 6);
+	g_assert(s24le[0] == 0x00 && s24le[1] == 0x00 && s24le[2] == 0x08);
+	g_assert(s24le[3] == 0x00 && s24le[4] == 0x00 && s24le[5] == 0xF8);
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	prop.format = AUDIO_FORMAT_FLOAT_LE;
+#else
+	prop.format = AUDIO_FORMAT_FLOAT_BE;
+#endif
+	prop.channel = 1;
+	g_assert(nugu_gain_set_property(gain, prop) == 0);
+	g_assert(nugu_gain_apply(gain, f32, f32, sizeof(f32)) == sizeof(f32));
+	g_assert(f32[0] == 0.5f);
+	g_assert(f32[1] == -0.25f);
+
+	prop.format = AUDIO_FORMAT_MAX;
+	g_assert(nugu_gain_set_property(gain, prop) == -1);
+
+	nugu_gain_free(gain);
+}
+
+static void test_gain_ramp(void)
+{
+	NuguGain *gain;
+	NuguAudioProperty prop;
+	int16_t src[320];
+	int16_t dest[320];
+	int i;
+
+	for (i = 0; i < 320; i++)
+		src[i] = 10000;
+
+	gain = nugu_gain_new();
+	g_assert(gain != NULL);
+
+	/* 16K, 10ms: 160 frames */
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+	g_assert(nugu_gain_set_property(gain, prop) == 0);
+	g_assert(nugu_gain_apply(gain, src, dest, sizeof(src)) ==
+		 sizeof(src));
+
+	g_assert(nugu_gain_set_volume(gain, 0) == 0);
+	g_assert(nugu_gain_is_unity(gain) == 0);
+	g_assert(nugu_gain_apply(gain, src, dest, sizeof(src)) ==
+		 sizeof(src));
+
+	/* the gain decreases smoothly to the new volume */
+	g_assert(dest[0] < 10000 && dest[0] > 9900);
+	for (i = 1; i < 160; i++)
+		g_assert(dest[i] <= dest[i - 1]);
+	for (i = 159; i < 320; i++)
+		g_assert(dest[i] == 0);
+
+	/* ramp time 0: change at once */
+	g_assert(nugu_gain_set_ramp_time(gain, 0) == 0);
+	g_assert(nugu_gain_set_volume(gain, 100) == 0);
+	g_assert(nugu_gain_is_unity(gain) == 1);
+
+	/* a partial sample is copied as is */
+	g_assert(nugu_gain_set_volume(gain, 50) == 0);
+	memset(dest, 0, sizeof(dest));
+	g_assert(nugu_gain_apply(gain, src, dest, 5) == 5);
+	g_assert(dest[0] == 5000 && dest[1] == 5000);
+	g_assert(((unsigned char *)dest)[4] == ((unsigned char *)src)[4]);
+
+	nugu_gain_free(gain);
+}
+
+static void test_gain_kernel(void)
+{
+	NuguGain *gain;
+	NuguAudioProperty prop;
+	int16_t src[37];
+	int16_t dest[37];
+	int32_t g;
+	int volume;
+	int i;
+
+	/* odd count: the vector loop and the scalar rest */
+	for (i = 0; i < 37; i++)
+		src[i] = (int16_t)(i * 1789 - 32768);
+	src[36] = 32767;
+
+	gain = nugu_gain_new();
+	g_assert(gain != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	prop.format = AUDIO_FORMAT_S16_LE;
+#else
+	prop.format = AUDIO_FORMAT_S16_BE;
+#endif
+	prop.channel = 1;
+	g_assert(nugu_gain_set_property(gain, prop) == 0);
+	g_assert(nugu_gain_set_ramp_time(gain, 0) == 0);
+
+	for (volume = 0; volume < NUGU_SET_VOLUME_MAX; volume++) {
+		g_assert(nugu_gain_set_volume(gain, volume) == 0);
+		g_assert(nugu_gain_apply(gain, src, dest, sizeof(src)) ==
+			 sizeof(src));
+
+		g = (int32_t)((float)volume / NUGU_SET_VOLUME_MAX * 65536 +
+			      0.5f);
+		for (i = 0; i < 37; i++)
+			g_assert(dest[i] == (int16_t)((src[i] * g) >> 16));
+	}
+
+	nugu_gain_free(gain);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/gain/default", test_gain_default);
+	g_test_add_func("/gain/format", test_gain_format);
+	g_test_add_func("/gain/ramp", test_gain_ramp);
+	g_test_add_func("/gain/kernel", test_gain_kernel);
+
+	return g_test_run();
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <curl/curl.h>
+
+#include "http2_request.h"
+
+static void test_http2_request_stream(void)
+{
+	HTTP2Request *req;
+	char buf[16];
+
+	req = http2_request_new();
+	g_assert(req != NULL);
+	g_assert(http2_request_set_stream(req) == 0);
+
+	/* Paused while there is no data */
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) ==
+		 CURL_READFUNC_PAUSE);
+
+	/* The resume is needed only once after the pause */
+	g_assert(http2_request_add_stream_data(req, (unsigned char *)"abcd",
+					       4) == 1);
+	g_assert(http2_request_add_stream_data(req, (unsigned char *)"efgh",
+					       4) == 0);
+
+	/* Partial reads */
+	g_assert(http2_request_read_stream_data(req, buf, 3) == 3);
+	g_assert(memcmp(buf, "abc", 3) == 0);
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) == 5);
+	g_assert(memcmp(buf, "defgh", 5) == 0);
+
+	/* Paused again after the data is drained */
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) ==
+		 CURL_READFUNC_PAUSE);
+	g_assert(http2_request_add_stream_data(req, (unsigned char *)"ij",
+					       2) == 1);
+
+	/* The close does not need the resume if not paused */
+	g_assert(http2_request_close_stream(req) == 0);
+
+	/* The data after the close is rejected */
+	g_assert(http2_request_add_stream_data(req, (unsigned char *)"kl",
+					       2) == -1);
+
+	/* The remaining data is sent, and then the end of the body */
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) == 2);
+	g_assert(memcmp(buf, "ij", 2) == 0);
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) == 0);
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) == 0);
+
+	http2_request_unref(req);
+}
+
+static void test_http2_request_stream_close_paused(void)
+{
+	HTTP2Request *req;
+	char buf[16];
+
+	req = http2_request_new();
+	g_assert(req != NULL);
+	g_assert(http2_request_set_stream(req) == 0);
+
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) ==
+		 CURL_READFUNC_PAUSE);
+
+	/* The close needs the resume to finish the paused transfer */
+	g_assert(http2_request_close_stream(req) == 1);
+	g_assert(http2_request_close_stream(req) == 0);
+	g_assert(http2_request_read_stream_data(req, buf, sizeof(buf)) == 0);
+
+	http2_request_unref(req);
+}
+
+static void test_http2_request_not_stream(void)
+{
+	HTTP2Request *req;
+
+	req = http2_request_new();
+	g_assert(req != NULL);
+
+	/* The stream functions are allowed only for the stream request */
+	g_assert(http2_request_add_stream_data(req, (unsigned char *)"ab",
+					       2) == -1);
+	g_assert(http2_request_close_stream(req) == -1);
+
+	http2_request_unref(req);
+}
+
+static void test_http2_request_pool(void)
+{
+	HTTP2Request *req;
+	NuguPoolStats stats;
+
+	req = http2_request_new();
+	g_assert(req != NULL);
+
+	/* The pool is kept while the request is in use */
+	http2_request_pool_deinit();
+	g_assert(http2_request_get_pool_stats(&stats) == 0);
+	g_assert(stats.in_use == 1);
+
+	http2_request_unref(req);
+
+	http2_request_pool_deinit();
+	g_assert(http2_request_get_pool_stats(&stats) == 0);
+	g_assert(stats.allocs == 0 && stats.slabs == 0);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/http2_request/stream", test_http2_request_stream);
+	g_test_add_func("/http2_request/stream_close_paused",
+			test_http2_request_stream_close_paused);
+	g_test_add_func("/http2_request/not_stream",
+			test_http2_request_not_stream);
+	g_test_add_func("/http2_request/pool", test_http2_request_pool);
+
+	return g_test_run();
+}
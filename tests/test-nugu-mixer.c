@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_pcm.h"
+#include "nugu_mixer.h"
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_S16 AUDIO_FORMAT_S16_LE
+#else
+#define FORMAT_S16 AUDIO_FORMAT_S16_BE
+#endif
+
+static int _end_count;
+
+static int dummy_start(NuguPcmDriver *driver, NuguPcm *pcm,
+		       NuguAudioProperty prop)
+{
+	return 0;
+}
+
+static int dummy_stop(NuguPcmDriver *driver, NuguPcm *pcm)
+{
+	return 0;
+}
+
+static struct nugu_pcm_driver_ops dummy_driver_ops = { .start = dummy_start,
+						       .stop = dummy_stop };
+
+static void mixer_end_callback(NuguMixer *mixer, NuguPcm *pcm,
+			       void *userdata)
+{
+	g_assert(pcm == userdata);
+	_end_count++;
+}
+
+static NuguPcm *_pcm_new(NuguPcmDriver *driver, const char *name,
+			 NuguAudioProperty prop)
+{
+	NuguPcm *pcm;
+
+	pcm = nugu_pcm_new(name, driver);
+	g_assert(pcm != NULL);
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	return pcm;
+}
+
+static void test_mixer_default(void)
+{
+	NuguPcmDriver *driver;
+	NuguMixer *mixer;
+	NuguPcm *pcm1;
+	NuguPcm *pcm2;
+	NuguAudioProperty prop;
+	gint16 data1[4] = { 1000, -1000, 30000, -30000 };
+	gint16 data2[4] = { 100, 100, 30000, -30000 };
+	gint16 out[4];
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	prop.format = FORMAT_S16;
+	prop.channel = 1;
+
+	pcm1 = _pcm_new(driver, "pcm1", prop);
+	pcm2 = _pcm_new(driver, "pcm2", prop);
+
+	prop.format = AUDIO_FORMAT_U8;
+	g_assert(nugu_mixer_new(prop) == NULL);
+
+	prop.format = FORMAT_S16;
+	mixer = nugu_mixer_new(prop);
+	g_assert(mixer != NULL);
+	g_assert(nugu_mixer_get_input_count(mixer) == 0);
+
+	/* silence without inputs */
+	memset(out, 1, sizeof(out));
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 0);
+	g_assert(out[0] == 0 && out[3] == 0);
+
+	g_assert(nugu_mixer_add_input(mixer, pcm1) == 0);
+	g_assert(nugu_mixer_add_input(mixer, pcm2) == 0);
+	g_assert(nugu_mixer_add_input(mixer, pcm2) == 0);
+	g_assert(nugu_mixer_get_input_count(mixer) == 2);
+
+	g_assert(nugu_pcm_push_data(pcm1, (char *)data1, sizeof(data1), 0) ==
+		 sizeof(data1));
+	g_assert(nugu_pcm_push_data(pcm2, (char *)data2, sizeof(data2), 0) ==
+		 sizeof(data2));
+
+	/* sum of inputs with saturation */
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 2);
+	g_assert(out[0] == 1100);
+	g_assert(out[1] == -900);
+	g_assert(out[2] == 32767);
+	g_assert(out[3] == -32768);
+
+	/* ducked input (without ramp after clear) */
+	g_assert(nugu_pcm_set_duck_level(pcm2, 50) == 0);
+	nugu_pcm_clear_buffer(pcm2);
+	g_assert(nugu_pcm_push_data(pcm1, (char *)data1, sizeof(data1), 0) ==
+		 sizeof(data1));
+	g_assert(nugu_pcm_push_data(pcm2, (char *)data2, sizeof(data2), 0) ==
+		 sizeof(data2));
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 2);
+	g_assert(out[0] == 1050);
+
+	/* paused input keeps the data */
+	g_assert(nugu_mixer_set_input_paused(mixer, pcm1, 1) == 0);
+	g_assert(nugu_pcm_push_data(pcm1, (char *)data1, sizeof(data1), 0) ==
+		 sizeof(data1));
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 0);
+	g_assert(nugu_pcm_get_data_size(pcm1) == sizeof(data1));
+	g_assert(nugu_mixer_set_input_paused(mixer, pcm1, 0) == 0);
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 1);
+	g_assert(out[0] == 1000);
+
+	g_assert(nugu_mixer_remove_input(mixer, pcm2) == 0);
+	g_assert(nugu_mixer_remove_input(mixer, pcm2) == -1);
+	g_assert(nugu_mixer_get_input_count(mixer) == 1);
+
+	/* end of the input data */
+	nugu_mixer_set_end_callback(mixer, mixer_end_callback, pcm1);
+	g_assert(nugu_pcm_push_data(pcm1, (char *)data1, sizeof(data1), 1) ==
+		 sizeof(data1));
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 1);
+	g_assert(_end_count == 0);
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 0);
+	g_assert(_end_count == 1);
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 0);
+	g_assert(_end_count == 1);
+
+	g_assert(nugu_mixer_remove_input(mixer, pcm1) == 0);
+	nugu_mixer_free(mixer);
+
+	nugu_pcm_free(pcm1);
+	nugu_pcm_free(pcm2);
+	nugu_pcm_driver_free(driver);
+}
+
+static void test_mixer_saturate(void)
+{
+	NuguPcmDriver *driver;
+	NuguMixer *mixer;
+	NuguPcm *pcm1;
+	NuguPcm *pcm2;
+	NuguAudioProperty prop;
+	gint16 data1[37];
+	gint16 data2[37];
+	gint16 out[37];
+	int i;
+
+	/* odd count: the vector loop and the scalar rest */
+	for (i = 0; i < 37; i++) {
+		data1[i] = (gint16)(i * 1789 - 32768);
+		data2[i] = (gint16)(32767 - i * 1500);
+	}
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	prop.format = FORMAT_S16;
+	prop.channel = 1;
+
+	pcm1 = _pcm_new(driver, "pcm1", prop);
+	pcm2 = _pcm_new(driver, "pcm2", prop);
+
+	mixer = nugu_mixer_new(prop);
+	g_assert(mixer != NULL);
+	g_assert(nugu_mixer_add_input(mixer, pcm1) == 0);
+	g_assert(nugu_mixer_add_input(mixer, pcm2) == 0);
+
+	g_assert(nugu_pcm_push_data(pcm1, (char *)data1, sizeof(data1), 0) ==
+		 sizeof(data1));
+	g_assert(nugu_pcm_push_data(pcm2, (char *)data2, sizeof(data2), 0) ==
+		 sizeof(data2));
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 2);
+
+	for (i = 0; i < 37; i++)
+		g_assert(out[i] == CLAMP(data1[i] + data2[i], -32768, 32767));
+
+	g_assert(nugu_mixer_remove_input(mixer, pcm1) == 0);
+	g_assert(nugu_mixer_remove_input(mixer, pcm2) == 0);
+	nugu_mixer_free(mixer);
+
+	nugu_pcm_free(pcm1);
+	nugu_pcm_free(pcm2);
+	nugu_pcm_driver_free(driver);
+}
+
+static void test_mixer_device_delay(void)
+{
+	NuguPcmDriver *driver;
+	NuguMixer *mixer;
+	NuguPcm *pcm1;
+	NuguPcm *pcm2;
+	NuguAudioProperty prop;
+	NuguPcmLatency latency;
+	gint16 data[4] = { 1, 2, 3, 4 };
+	gint16 out[4];
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	prop.format = FORMAT_S16;
+	prop.channel = 1;
+
+	pcm1 = _pcm_new(driver, "pcm1", prop);
+	pcm2 = _pcm_new(driver, "pcm2", prop);
+
+	mixer = nugu_mixer_new(prop);
+	g_assert(mixer != NULL);
+	g_assert(nugu_mixer_add_input(mixer, pcm1) == 0);
+	g_assert(nugu_mixer_add_input(mixer, pcm2) == 0);
+
+	/* The delay of the device is passed to all inputs */
+	g_assert(nugu_mixer_set_device_delay(mixer, 7000) == 0);
+
+	g_assert(nugu_pcm_push_data(pcm1, (char *)data, sizeof(data), 0) ==
+		 sizeof(data));
+	g_assert(nugu_pcm_push_data(pcm2, (char *)data, sizeof(data), 0) ==
+		 sizeof(data));
+	g_assert(nugu_mixer_mix(mixer, out, sizeof(out)) == 2);
+
+	g_assert(nugu_pcm_get_latency(pcm1, &latency) == 0);
+	g_assert(latency.count == 1);
+	g_assert(latency.device_avg == 7000 && latency.device_max == 7000);
+
+	g_assert(nugu_pcm_get_latency(pcm2, &latency) == 0);
+	g_assert(latency.count == 1);
+	g_assert(latency.device_avg == 7000 && latency.device_max == 7000);
+
+	g_assert(nugu_mixer_remove_input(mixer, pcm1) == 0);
+	g_assert(nugu_mixer_remove_input(mixer, pcm2) == 0);
+	nugu_mixer_free(mixer);
+
+	nugu_pcm_free(pcm1);
+	nugu_pcm_free(pcm2);
+	nugu_pcm_driver_free(driver);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/mixer/default", test_mixer_default);
+	g_test_add_func("/mixer/saturate", test_mixer_saturate);
+	g_test_add_func("/mixer/device_delay", test_mixer_device_delay);
+
+	return g_test_run();
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_buffer.h"
+#include "multipart_parser.h"
+
+#define TEST_BOUNDARY "this-is-a-boundary"
+
+/* The second body has the partial end marks and hyphens in the data */
+static const char *_body = "--" TEST_BOUNDARY "\r\n"
+			   "Content-Type: application/json\r\n"
+			   "\r\n"
+			   "{\"directives\":[]}\r\n"
+			   "\r\n"
+			   "--" TEST_BOUNDARY "\r\n"
+			   "Content-Type: application/octet-stream\r\n"
+			   "Content-Length: 13\r\n"
+			   "\r\n"
+			   "a\r\nb\r--\rc\r\n-d\r\n"
+			   "\r\n"
+			   "--" TEST_BOUNDARY "\r\n"
+			   "Content-Type: text/plain\r\n"
+			   "\r\n"
+			   "last\r\n"
+			   "\r\n"
+			   "--" TEST_BOUNDARY "--\r\n";
+
+/* The headers and the bodies found in the data */
+static const char *_parts = "H32:Content-Type: application/json\r\n"
+			   "B17:{\"directives\":[]}"
+			   "H60:Content-Type: application/octet-stream\r\n"
+			   "Content-Length: 13\r\n"
+			   "B13:a\r\nb\r--\rc\r\n-d"
+			   "H26:Content-Type: text/plain\r\n"
+			   "B4:last";
+
+struct parse_result {
+	NuguBuffer *parts;
+	int header_count;
+	int body_count;
+};
+
+static void _on_header(MultipartParser *parser, const char *data,
+		       size_t length, void *userdata)
+{
+	struct parse_result *result = userdata;
+	char prefix[32];
+
+	snprintf(prefix, sizeof(prefix), "H%zu:", length);
+	nugu_buffer_add(result->parts, prefix, strlen(prefix));
+	nugu_buffer_add(result->parts, data, length);
+	result->header_count++;
+}
+
+static void _on_body(MultipartParser *parser, NuguChunkChain *body,
+		     void *userdata)
+{
+	struct parse_result *result = userdata;
+	size_t length = 0;
+	char prefix[32];
+	char *data;
+
+	data = nugu_chunk_chain_flatten(body, &length);
+
+	snprintf(prefix, sizeof(prefix), "B%zu:", length);
+	nugu_buffer_add(result->parts, prefix, strlen(prefix));
+	if (data) {
+		nugu_buffer_add(result->parts, data, length);
+		free(data);
+	}
+	result->body_count++;
+}
+
+static MultipartParser *_parser_new(void)
+{
+	MultipartParser *parser;
+
+	parser = multipart_parser_new();
+	g_assert(parser != NULL);
+
+	multipart_parser_set_boundary(parser, TEST_BOUNDARY,
+				      strlen(TEST_BOUNDARY));
+
+	return parser;
+}
+
+/* Parse the data in pieces which are split at the offsets */
+static void _parse_split(const char *data, size_t length,
+			 const size_t *offsets, int count,
+			 struct parse_result *result)
+{
+	MultipartParser *parser;
+	size_t start = 0;
+	int i;
+
+	result->parts = nugu_buffer_new(0);
+	result->header_count = 0;
+	result->body_count = 0;
+
+	parser = _parser_new();
+
+	for (i = 0; i <= count; i++) {
+		size_t stop = (i < count) ? offsets[i] : length;
+
+		g_assert(multipart_parser_parse(parser, data + start,
+						stop - start, _on_header,
+						_on_body, result) == 0);
+		start = stop;
+	}
+
+	multipart_parser_free(parser);
+}
+
+static void _check_result(struct parse_result *expected,
+			  struct parse_result *result)
+{
+	g_assert_cmpint(result->header_count, ==, expected->header_count);
+	g_assert_cmpint(result->body_count, ==, expected->body_count);
+	g_assert_cmpmem(nugu_buffer_peek(result->parts),
+			nugu_buffer_get_size(result->parts),
+			nugu_buffer_peek(expected->parts),
+			nugu_buffer_get_size(expected->parts));
+
+	nugu_buffer_free(result->parts, TRUE);
+}
+
+static void test_multipart_default(void)
+{
+	struct parse_result result;
+
+	_parse_split(_body, strlen(_body), NULL, 0, &result);
+
+	g_assert_cmpint(result.header_count, ==, 3);
+	g_assert_cmpint(result.body_count, ==, 3);
+	g_assert_cmpmem(nugu_buffer_peek(result.parts),
+			nugu_buffer_get_size(result.parts), _parts,
+			strlen(_parts));
+
+	nugu_buffer_free(result.parts, TRUE);
+}
+
+static void test_multipart_split(void)
+{
+	struct parse_result expected;
+	struct parse_result result;
+	size_t length = strlen(_body);
+	size_t offset;
+
+	_parse_split(_body, length, NULL, 0, &expected);
+
+	/* The boundary, the CRLF and the end marks are split everywhere */
+	for (offset = 1; offset < length; offset++) {
+		_parse_split(_body, length, &offset, 1, &result);
+		_check_result(&expected, &result);
+	}
+
+	nugu_buffer_free(expected.parts, TRUE);
+}
+
+static void test_multipart_bytes(void)
+{
+	struct parse_result expected;
+	struct parse_result result;
+	size_t length = strlen(_body);
+	size_t *offsets;
+	size_t i;
+
+	_parse_split(_body, length, NULL, 0, &expected);
+
+	offsets = g_new0(size_t, length - 1);
+	for (i = 0; i < length - 1; i++)
+		offsets[i] = i + 1;
+
+	/* A byte at a time */
+	_parse_split(_body, length, offsets, (int)(length - 1), &result);
+	_check_result(&expected, &result);
+
+	g_free(offsets);
+	nugu_buffer_free(expected.parts, TRUE);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/multipart/default", test_multipart_default);
+	g_test_add_func("/multipart/split", test_multipart_split);
+	g_test_add_func("/multipart/bytes", test_multipart_bytes);
+
+	return g_test_run();
+}
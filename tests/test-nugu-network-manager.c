@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_config.h"
+#include "nugu_event.h"
+#include "nugu_network_manager.h"
+#include "http2_manage.h"
+
+#define COALESCE_SIZE 8
+#define MAX_REQUESTS 8
+
+/*
+ * Stub of the h2 layer, which records the attachment requests sent by
+ * the network manager.
+ */
+struct _h2_manager {
+	int attachment_stream;
+};
+
+struct sent_request {
+	char parent_msg_id[64];
+	int seq;
+	int is_end;
+	size_t length;
+};
+
+static H2Manager _h2;
+static struct sent_request _sent[MAX_REQUESTS];
+static int _sent_count;
+
+H2Manager *h2manager_new(void)
+{
+	return &_h2;
+}
+
+void h2manager_free(H2Manager *manager)
+{
+}
+
+int h2manager_set_status_callback(H2Manager *manager,
+				  H2ManagerStatusCallback callback,
+				  void *userdata)
+{
+	return 0;
+}
+
+enum h2manager_status h2manager_get_status(H2Manager *manager)
+{
+	return H2_STATUS_CONNECTED;
+}
+
+int h2manager_send_event(H2Manager *manager, const char *name_space,
+			 const char *name, const char *version,
+			 const char *context, const char *msg_id,
+			 const char *dialog_id, const char *json)
+{
+	return 0;
+}
+
+int h2manager_send_event_attachment(H2Manager *manager, const char *name_space,
+				    const char *name, const char *version,
+				    const char *parent_msg_id,
+				    const char *msg_id, const char *dialog_id,
+				    int seq, int is_end, size_t length,
+				    unsigned char *data)
+{
+	struct sent_request *req;
+
+	g_assert(_sent_count < MAX_REQUESTS);
+
+	req = &_sent[_sent_count++];
+	g_strlcpy(req->parent_msg_id, parent_msg_id,
+		  sizeof(req->parent_msg_id));
+	req->seq = seq;
+	req->is_end = is_end;
+	req->length = length;
+
+	return 0;
+}
+
+int h2manager_close_event_attachment(H2Manager *manager,
+				     const char *parent_msg_id)
+{
+	return 0;
+}
+
+int h2manager_is_attachment_stream(H2Manager *manager)
+{
+	return manager->attachment_stream;
+}
+
+int h2manager_connect(H2Manager *manager)
+{
+	return 0;
+}
+
+int h2manager_disconnect(H2Manager *manager)
+{
+	return 0;
+}
+
+void h2manager_deinitialize(void)
+{
+}
+
+static void _setup(const char *delay, int attachment_stream)
+{
+	memset(_sent, 0, sizeof(_sent));
+	_sent_count = 0;
+	_h2.attachment_stream = attachment_stream;
+
+	nugu_config_set(NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_DELAY, delay);
+	nugu_config_set(NUGU_CONFIG_KEY_ATTACHMENT_COALESCE_SIZE,
+			G_STRINGIFY(COALESCE_SIZE));
+
+	g_assert(nugu_network_manager_initialize() == 0);
+	g_assert(nugu_network_manager_connect() == 0);
+}
+
+static void _check_sent(int index, NuguEvent *nev, int seq, int is_end,
+			size_t length)
+{
+	g_assert(index < _sent_count);
+	g_assert_cmpstr(_sent[index].parent_msg_id, ==,
+			nugu_event_peek_msg_id(nev));
+	g_assert(_sent[index].seq == seq);
+	g_assert(_sent[index].is_end == is_end);
+	g_assert(_sent[index].length == length);
+}
+
+static void test_network_manager_coalesce_size(void)
+{
+	NuguEvent *nev;
+
+	_setup("10000", 0);
+
+	nev = nugu_event_new("ASR", "Recognize", "1.0");
+
+	/* Held until the size is reached */
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 4, (unsigned char *)"1234") == 0);
+	g_assert(_sent_count == 0);
+
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 4, (unsigned char *)"5678") == 0);
+	g_assert(_sent_count == 1);
+	_check_sent(0, nev, 0, 0, 8);
+
+	/* The seq is increased once per request */
+	g_assert(nugu_event_get_seq(nev) == 1);
+
+	nugu_event_free(nev);
+	nugu_network_manager_deinitialize();
+}
+
+static void test_network_manager_coalesce_end(void)
+{
+	NuguEvent *nev;
+
+	_setup("10000", 0);
+
+	nev = nugu_event_new("ASR", "Recognize", "1.0");
+
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 2, (unsigned char *)"12") == 0);
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 2, (unsigned char *)"34") == 0);
+	g_assert(_sent_count == 0);
+
+	/* The end is sent with the held data */
+	g_assert(nugu_network_manager_send_event_data(nev, 1, 0, NULL) == 0);
+	g_assert(_sent_count == 1);
+	_check_sent(0, nev, 0, 1, 4);
+	g_assert(nugu_event_get_seq(nev) == 1);
+
+	nugu_event_free(nev);
+	nugu_network_manager_deinitialize();
+}
+
+static void test_network_manager_coalesce_other_event(void)
+{
+	NuguEvent *nev1;
+	NuguEvent *nev2;
+
+	_setup("10000", 0);
+
+	nev1 = nugu_event_new("ASR", "Recognize", "1.0");
+	nev2 = nugu_event_new("ASR", "Recognize", "1.0");
+
+	g_assert(nugu_network_manager_send_event_data(
+			 nev1, 0, 2, (unsigned char *)"12") == 0);
+	g_assert(_sent_count == 0);
+
+	/* The data of another event is sent first */
+	g_assert(nugu_network_manager_send_event_data(
+			 nev2, 0, 2, (unsigned char *)"34") == 0);
+	g_assert(_sent_count == 1);
+	_check_sent(0, nev1, 0, 0, 2);
+
+	g_assert(nugu_network_manager_send_event_data(nev2, 1, 0, NULL) == 0);
+	g_assert(_sent_count == 2);
+	_check_sent(1, nev2, 0, 1, 2);
+
+	g_assert(nugu_event_get_seq(nev1) == 1);
+	g_assert(nugu_event_get_seq(nev2) == 1);
+
+	nugu_event_free(nev1);
+	nugu_event_free(nev2);
+	nugu_network_manager_deinitialize();
+}
+
+static gboolean _quit_loop(gpointer userdata)
+{
+	g_main_loop_quit((GMainLoop *)userdata);
+
+	return FALSE;
+}
+
+static void test_network_manager_coalesce_timer(void)
+{
+	GMainLoop *loop;
+	NuguEvent *nev;
+
+	_setup("10", 0);
+
+	nev = nugu_event_new("ASR", "Recognize", "1.0");
+
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 2, (unsigned char *)"12") == 0);
+	g_assert(_sent_count == 0);
+
+	/* Sent by the timer without the next data */
+	loop = g_main_loop_new(NULL, FALSE);
+	g_timeout_add(100, _quit_loop, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+
+	g_assert(_sent_count == 1);
+	_check_sent(0, nev, 0, 0, 2);
+
+	/* The next data is sent in a new request */
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 1, 2, (unsigned char *)"34") == 0);
+	g_assert(_sent_count == 2);
+	_check_sent(1, nev, 1, 1, 2);
+	g_assert(nugu_event_get_seq(nev) == 2);
+
+	nugu_event_free(nev);
+	nugu_network_manager_deinitialize();
+}
+
+static void test_network_manager_coalesce_stream(void)
+{
+	NuguEvent *nev;
+
+	_setup("10000", 1);
+
+	nev = nugu_event_new("ASR", "Recognize", "1.0");
+
+	/* The attachment stream sends each data immediately */
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 2, (unsigned char *)"12") == 0);
+	g_assert(nugu_network_manager_send_event_data(
+			 nev, 0, 2, (unsigned char *)"34") == 0);
+	g_assert(_sent_count == 2);
+	_check_sent(0, nev, 0, 0, 2);
+	_check_sent(1, nev, 1, 0, 2);
+
+	nugu_event_free(nev);
+	nugu_network_manager_deinitialize();
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	nugu_config_initialize();
+
+	g_test_add_func("/network_manager/coalesce_size",
+			test_network_manager_coalesce_size);
+	g_test_add_func("/network_manager/coalesce_end",
+			test_network_manager_coalesce_end);
+	g_test_add_func("/network_manager/coalesce_other_event",
+			test_network_manager_coalesce_other_event);
+	g_test_add_func("/network_manager/coalesce_timer",
+			test_network_manager_coalesce_timer);
+	g_test_add_func("/network_manager/coalesce_stream",
+			test_network_manager_coalesce_stream);
+
+	return g_test_run();
+}
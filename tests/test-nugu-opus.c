@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_plugin.h"
+#include "nugu_encoder.h"
+#include "nugu_decoder.h"
+
+#ifndef OPUS_PLUGIN_PATH
+#define OPUS_PLUGIN_PATH "../plugins/opus.so"
+#endif
+
+/* record := 4 bytes[len] + 4 bytes[range] + payload */
+#define RECORD_HEADER_SIZE 8
+#define MAX_PAYLOAD 160
+
+/* 1 second of 48 kHz mono in 20 ms frames */
+#define INPUT_SAMPLES 48000
+#define FRAME_COUNT 50
+
+/* The decoder outputs 24 kHz mono */
+#define OUTPUT_FRAME_BYTES (480 * 2)
+
+static void test_opus_roundtrip(void)
+{
+	NuguPlugin *p;
+	NuguEncoderDriver *enc_driver;
+	NuguDecoderDriver *dec_driver;
+	NuguEncoder *enc;
+	NuguDecoder *dec;
+	NuguEncoderOption option;
+	NuguAudioProperty prop;
+	NuguBuffer *encoded;
+	const unsigned char *record;
+	int16_t *input;
+	void *output;
+	size_t output_len;
+	size_t offset;
+	unsigned int len;
+	guint32 seed = 1;
+	int count;
+	int i;
+
+	p = nugu_plugin_new_from_file(OPUS_PLUGIN_PATH);
+	g_assert(p != NULL);
+	g_assert(nugu_plugin_add(p) == 0);
+	nugu_plugin_initialize();
+
+	enc_driver = nugu_encoder_driver_find("opus");
+	g_assert(enc_driver != NULL);
+	dec_driver = nugu_decoder_driver_find("opus");
+	g_assert(dec_driver != NULL);
+
+	/* The noise needs the largest payload */
+	input = g_new(int16_t, INPUT_SAMPLES);
+	for (i = 0; i < INPUT_SAMPLES; i++) {
+		seed = seed * 1103515245 + 12345;
+		input[i] = (int16_t)(seed >> 16);
+	}
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_48K;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	prop.format = AUDIO_FORMAT_S16_LE;
+#else
+	prop.format = AUDIO_FORMAT_S16_BE;
+#endif
+	prop.channel = 1;
+
+	/* The highest bitrate of opus */
+	option.bitrate = 510000;
+	option.complexity = -1;
+	option.frame_time = 20;
+
+	enc = nugu_encoder_new(enc_driver, prop, &option);
+	g_assert(enc != NULL);
+
+	encoded = nugu_buffer_new(0);
+	g_assert(nugu_encoder_encode(enc, input, INPUT_SAMPLES * 2,
+				     encoded) == 0);
+
+	/* Every payload fits in the record which the decoder accepts */
+	record = nugu_buffer_peek(encoded);
+	offset = 0;
+	count = 0;
+	while (offset < nugu_buffer_get_size(encoded)) {
+		len = ((unsigned int)record[offset] << 24) |
+		      ((unsigned int)record[offset + 1] << 16) |
+		      ((unsigned int)record[offset + 2] << 8) |
+		      (unsigned int)record[offset + 3];
+		g_assert(len > 0 && len <= MAX_PAYLOAD);
+
+		offset += RECORD_HEADER_SIZE + len;
+		count++;
+	}
+	g_assert(offset == nugu_buffer_get_size(encoded));
+	g_assert(count == FRAME_COUNT);
+
+	/* All frames are decoded */
+	dec = nugu_decoder_new(dec_driver, NULL);
+	g_assert(dec != NULL);
+
+	output = nugu_decoder_decode(dec, nugu_buffer_peek(encoded),
+				     nugu_buffer_get_size(encoded),
+				     &output_len);
+	g_assert(output != NULL);
+	g_assert(output_len == FRAME_COUNT * OUTPUT_FRAME_BYTES);
+	free(output);
+
+	g_assert(nugu_decoder_free(dec) == 0);
+	g_assert(nugu_encoder_free(enc) == 0);
+	nugu_buffer_free(encoded, TRUE);
+	g_free(input);
+
+	nugu_plugin_deinitialize();
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/opus/roundtrip", test_opus_roundtrip);
+
+	return g_test_run();
+}
@@ -66,6 +66,30 @@ static int dummy_stop(NuguPcmDriver *driver, NuguPcm *pcm)
 static struct nugu_pcm_driver_ops dummy_driver_ops = { .start = dummy_start,
 						       .stop = dummy_stop };
 
+/* The driver reads the pcm while it is running */
+static int _running;
+
+static int running_start(NuguPcmDriver *driver, NuguPcm *pcm,
+			 NuguAudioProperty prop)
+{
+	g_assert(_running == 0);
+	_running = 1;
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_PLAYING);
+	return 0;
+}
+
+static int running_stop(NuguPcmDriver *driver, NuguPcm *pcm)
+{
+	_running = 0;
+	nugu_pcm_emit_status(pcm, MEDIA_STATUS_STOPPED);
+	return 0;
+}
+
+static struct nugu_pcm_driver_ops running_driver_ops = {
+	.start = running_start,
+	.stop = running_stop
+};
+
 static void pcm_status_callback(enum nugu_media_status status, void *userdata)
 {
 	(void)userdata;
@@ -98,6 +122,7 @@ static void test_pcm_default(void)
 	char tmp[20] = {
 		0,
 	};
+	gint16 samples[2] = { 1000, -1000 };
 
 	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
 	g_assert(driver != NULL);
@@ -137,6 +162,17 @@ static void test_pcm_default(void)
 	g_assert_cmpstr(tmp, ==, "abc");
 	g_assert(nugu_pcm_get_data_size(pcm) == 2);
 
+	/* volume is applied to S16_LE samples */
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_pcm_set_volume(pcm, 50) == 0);
+	g_assert(nugu_pcm_push_data(pcm, (char *)samples, sizeof(samples), 0) ==
+		 sizeof(samples));
+	g_assert(nugu_pcm_get_data(pcm, tmp, sizeof(samples)) ==
+		 sizeof(samples));
+	memcpy(samples, tmp, sizeof(samples));
+	g_assert(samples[0] == 500);
+	g_assert(samples[1] == -500);
+
 	CHECK_STATUS(MEDIA_STATUS_STOPPED);
 	g_assert(nugu_pcm_stop(pcm) == 0);
 
@@ -146,6 +182,225 @@ static void test_pcm_default(void)
 	nugu_pcm_driver_remove(driver);
 }
 
+static void test_pcm_ring(void)
+{
+	NuguPcmDriver *driver;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	char *src;
+	char *dest;
+	size_t size = 20000;
+	size_t pos = 0;
+	size_t i;
+	int ret;
+
+	src = malloc(size);
+	dest = malloc(size);
+	g_assert(src != NULL && dest != NULL);
+
+	for (i = 0; i < size; i++)
+		src[i] = (char)(i % 251);
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+	g_assert(nugu_pcm_driver_register(driver) == 0);
+
+	pcm = nugu_pcm_new("ring", driver);
+	g_assert(pcm != NULL);
+
+	/* 8000 bytes per second */
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S8;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+
+	CHECK_EVENT(MEDIA_EVENT_MEDIA_LOADED);
+	CHECK_STATUS(MEDIA_STATUS_PLAYING);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	/* more data than the ring can hold is kept in order */
+	g_assert(nugu_pcm_push_data(pcm, src, 7000, 0) == 7000);
+	g_assert(nugu_pcm_push_data(pcm, src + 7000, size - 7000, 1) ==
+		 (int)(size - 7000));
+	g_assert(nugu_pcm_get_data_size(pcm) == size);
+	g_assert(nugu_pcm_receive_is_last_data(pcm) == 1);
+
+	/* odd read sizes across the wrap-around of the ring */
+	while (pos < size) {
+		ret = nugu_pcm_get_data(pcm, dest + pos, 333);
+		g_assert(ret > 0);
+		pos += ret;
+	}
+	g_assert(nugu_pcm_get_data(pcm, dest, 10) == 0);
+	g_assert(memcmp(src, dest, size) == 0);
+
+	/* cleared data is not returned */
+	g_assert(nugu_pcm_push_data(pcm, src, 5000, 0) == 5000);
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_pcm_get_data_size(pcm) == 0);
+	g_assert(nugu_pcm_receive_is_last_data(pcm) == 0);
+
+	g_assert(nugu_pcm_push_data(pcm, "abcd", 4, 0) == 4);
+	g_assert(nugu_pcm_get_data_size(pcm) == 4);
+	memset(dest, 0, 10);
+	g_assert(nugu_pcm_get_data(pcm, dest, 10) == 4);
+	g_assert(memcmp(dest, "abcd", 4) == 0);
+
+	CHECK_STATUS(MEDIA_STATUS_STOPPED);
+	g_assert(nugu_pcm_stop(pcm) == 0);
+
+	nugu_pcm_free(pcm);
+	nugu_pcm_driver_remove(driver);
+
+	free(src);
+	free(dest);
+}
+
+static void test_pcm_reserve(void)
+{
+	NuguPcmDriver *driver;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	char src[20000];
+	char dest[16];
+	char *space;
+	size_t size = 0;
+
+	memset(src, 0, sizeof(src));
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+
+	pcm = nugu_pcm_new("reserve", driver);
+	g_assert(pcm != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S8;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+
+	/* The ring is not allocated yet */
+	g_assert(nugu_pcm_reserve_data(pcm, &size) == NULL);
+	g_assert(size == 0);
+
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	/* The data written in the ring is visible after the commit */
+	space = nugu_pcm_reserve_data(pcm, &size);
+	g_assert(space != NULL);
+	g_assert(size >= 4096);
+	memcpy(space, "abcd", 4);
+	g_assert(nugu_pcm_get_data_size(pcm) == 0);
+	g_assert(nugu_pcm_commit_data(pcm, 4) == 0);
+	g_assert(nugu_pcm_get_data_size(pcm) == 4);
+
+	/* Cancel the reservation, and commit more than the reserved */
+	g_assert(nugu_pcm_reserve_data(pcm, &size) != NULL);
+	g_assert(nugu_pcm_commit_data(pcm, 0) == 0);
+	g_assert(nugu_pcm_reserve_data(pcm, &size) != NULL);
+	g_assert(nugu_pcm_commit_data(pcm, size + 1) == -1);
+	g_assert(nugu_pcm_get_data_size(pcm) == 4);
+
+	/* Keep the order with the pushed data */
+	g_assert(nugu_pcm_push_data(pcm, "ef", 2, 0) == 2);
+	space = nugu_pcm_reserve_data(pcm, &size);
+	g_assert(space != NULL);
+	memcpy(space, "gh", 2);
+	g_assert(nugu_pcm_commit_data(pcm, 2) == 0);
+	g_assert(nugu_pcm_get_data(pcm, dest, sizeof(dest)) == 8);
+	g_assert(memcmp(dest, "abcdefgh", 8) == 0);
+
+	/* Not available while the overflow data remains */
+	g_assert(nugu_pcm_push_data(pcm, src, sizeof(src), 0) ==
+		 sizeof(src));
+	g_assert(nugu_pcm_reserve_data(pcm, &size) == NULL);
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_pcm_get_data(pcm, dest, sizeof(dest)) == 0);
+	g_assert(nugu_pcm_reserve_data(pcm, &size) != NULL);
+	g_assert(nugu_pcm_commit_data(pcm, 0) == 0);
+
+	/* Not available when the data is converted */
+	prop.format = AUDIO_FORMAT_U8;
+	g_assert(nugu_pcm_set_device_property(pcm, prop) == 0);
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(nugu_pcm_reserve_data(pcm, &size) == NULL);
+
+	g_assert(nugu_pcm_stop(pcm) == 0);
+	nugu_pcm_free(pcm);
+	nugu_pcm_driver_free(driver);
+}
+
+static void test_pcm_resample(void)
+{
+	NuguPcmDriver *driver;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	NuguAudioProperty device;
+	short src[1600];
+	size_t size;
+
+	memset(src, 0, sizeof(src));
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+
+	pcm = nugu_pcm_new("resample", driver);
+	g_assert(pcm != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	prop.format = AUDIO_FORMAT_S16_LE;
+#else
+	prop.format = AUDIO_FORMAT_S16_BE;
+#endif
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+
+	/* device property follows the property if it is not set */
+	g_assert(nugu_pcm_get_device_property(pcm, &device) == 0);
+	g_assert(device.samplerate == AUDIO_SAMPLE_RATE_16K);
+
+	device.samplerate = AUDIO_SAMPLE_RATE_48K;
+	g_assert(nugu_pcm_set_device_property(pcm, device) == 0);
+	g_assert(nugu_pcm_set_resampler_quality(
+			 pcm, NUGU_RESAMPLER_QUALITY_LOW) == 0);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	/* the output of the last samples is delayed until the end */
+	g_assert(nugu_pcm_push_data(pcm, (char *)src, sizeof(src), 0) ==
+		 sizeof(src));
+	size = nugu_pcm_get_data_size(pcm);
+	g_assert(size > 0 && size < sizeof(src) * 3);
+
+	g_assert(nugu_pcm_push_data_done(pcm) == 0);
+	g_assert(nugu_pcm_get_data_size(pcm) == sizeof(src) * 3);
+
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_pcm_push_data(pcm, (char *)src, sizeof(src), 1) ==
+		 sizeof(src));
+	g_assert(nugu_pcm_get_data_size(pcm) == sizeof(src) * 3);
+
+	/* format and channel layout are converted with a part of frame */
+	device.format = AUDIO_FORMAT_S24_BE;
+	device.channel = 2;
+	g_assert(nugu_pcm_set_device_property(pcm, device) == 0);
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(nugu_pcm_push_data(pcm, (char *)src, 3, 0) == 3);
+	g_assert(nugu_pcm_push_data(pcm, (char *)src + 3, sizeof(src) - 3,
+				    1) == sizeof(src) - 3);
+	g_assert(nugu_pcm_get_data_size(pcm) == 1600 * 3 * 3 * 2);
+
+	/* not supported channel layout */
+	prop.channel = 2;
+	device.channel = 3;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+	g_assert(nugu_pcm_set_device_property(pcm, device) == 0);
+	g_assert(nugu_pcm_start(pcm) == -1);
+
+	nugu_pcm_free(pcm);
+	nugu_pcm_driver_free(driver);
+}
+
 static void test_pcm_multiple(void)
 {
 	NuguPcmDriver *driver;
@@ -195,6 +450,207 @@ static void test_pcm_multiple(void)
 	nugu_pcm_driver_remove(driver);
 }
 
+static void test_pcm_prebuffer(void)
+{
+	NuguPcmDriver *driver;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	NuguPcmStats stats;
+	char src[2000];
+	char dest[1000];
+
+	memset(src, 1, sizeof(src));
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+	g_assert(nugu_pcm_driver_register(driver) == 0);
+
+	pcm = nugu_pcm_new("prebuffer", driver);
+	g_assert(pcm != NULL);
+
+	/* 16000 bytes per second: 100 msec is 1600 bytes */
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+	g_assert(nugu_pcm_set_prebuffer_time(pcm, -1) == -1);
+	g_assert(nugu_pcm_set_prebuffer_time(pcm, 100) == 0);
+	g_assert(nugu_pcm_get_prebuffer_time(pcm) == 100);
+
+	CHECK_EVENT(MEDIA_EVENT_MEDIA_LOADED);
+	CHECK_STATUS(MEDIA_STATUS_PLAYING);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	/* Nothing is played until 100 msec is buffered */
+	g_assert(nugu_pcm_push_data(pcm, src, 1000, 0) == 1000);
+	g_assert(nugu_pcm_get_data(pcm, dest, 400) == 0);
+	g_assert(nugu_pcm_get_stats(pcm, &stats) == 0);
+	g_assert(stats.is_buffering == 1);
+	g_assert(stats.buffered_ms == 62);
+	g_assert(stats.silence_frames == 0);
+
+	g_assert(nugu_pcm_push_data(pcm, src, 600, 0) == 600);
+	g_assert(nugu_pcm_get_data(pcm, dest, 1000) == 1000);
+	g_assert(nugu_pcm_get_data(pcm, dest, 1000) == 600);
+
+	/* Underrun: 200 silence frames and re-buffering */
+	g_assert(nugu_pcm_get_stats(pcm, &stats) == 0);
+	g_assert(stats.frames == 800);
+	g_assert(stats.silence_frames == 200);
+	g_assert(stats.underruns == 1);
+	g_assert(stats.is_buffering == 1);
+
+	/* Still one underrun while waiting */
+	g_assert(nugu_pcm_push_data(pcm, src, 1000, 0) == 1000);
+	g_assert(nugu_pcm_get_data(pcm, dest, 400) == 0);
+	g_assert(nugu_pcm_get_stats(pcm, &stats) == 0);
+	g_assert(stats.silence_frames == 400);
+	g_assert(stats.underruns == 1);
+
+	/* The last data is played at once, and the end is not counted */
+	g_assert(nugu_pcm_push_data(pcm, src, 100, 1) == 100);
+	g_assert(nugu_pcm_get_data(pcm, dest, 1000) == 1000);
+	g_assert(nugu_pcm_get_data(pcm, dest, 1000) == 100);
+	g_assert(nugu_pcm_get_data(pcm, dest, 1000) == 0);
+	g_assert(nugu_pcm_get_stats(pcm, &stats) == 0);
+	g_assert(stats.frames == 1350);
+	g_assert(stats.silence_frames == 400);
+	g_assert(stats.underruns == 1);
+	g_assert(stats.is_buffering == 0);
+	g_assert(stats.buffered_ms == 0);
+
+	/* The counters are reset by the start */
+	CHECK_STATUS(MEDIA_STATUS_STOPPED);
+	g_assert(nugu_pcm_stop(pcm) == 0);
+	CHECK_STATUS(MEDIA_STATUS_PLAYING);
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(nugu_pcm_get_stats(pcm, &stats) == 0);
+	g_assert(stats.frames == 0 && stats.underruns == 0);
+
+	CHECK_STATUS(MEDIA_STATUS_STOPPED);
+	g_assert(nugu_pcm_stop(pcm) == 0);
+
+	nugu_pcm_free(pcm);
+	nugu_pcm_driver_remove(driver);
+}
+
+static void test_pcm_latency(void)
+{
+	NuguPcmDriver *driver;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	NuguPcmLatency latency;
+	char src[1000];
+	char dest[1000];
+	unsigned int total;
+	int i;
+
+	memset(src, 1, sizeof(src));
+
+	driver = nugu_pcm_driver_new("dummy", &dummy_driver_ops);
+	g_assert(driver != NULL);
+	g_assert(nugu_pcm_driver_register(driver) == 0);
+
+	pcm = nugu_pcm_new("latency", driver);
+	g_assert(pcm != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+
+	CHECK_EVENT(MEDIA_EVENT_MEDIA_LOADED);
+	CHECK_STATUS(MEDIA_STATUS_PLAYING);
+	g_assert(nugu_pcm_start(pcm) == 0);
+
+	g_assert(nugu_pcm_get_latency(pcm, &latency) == 0);
+	g_assert(latency.count == 0);
+
+	/* A block is measured when its first byte is read */
+	g_assert(nugu_pcm_push_data(pcm, src, 500, 0) == 500);
+	g_assert(nugu_pcm_push_data(pcm, src, 500, 0) == 500);
+	g_usleep(20 * 1000);
+	g_assert(nugu_pcm_set_device_delay(pcm, 5000) == 0);
+	g_assert(nugu_pcm_get_data(pcm, dest, 400) == 400);
+	g_assert(nugu_pcm_get_latency(pcm, &latency) == 0);
+	g_assert(latency.count == 1);
+	g_assert(latency.queue_max >= 20000);
+	g_assert(latency.queue_avg == latency.queue_max);
+	g_assert(latency.device_avg == 5000 && latency.device_max == 5000);
+	g_assert(latency.histogram[0] == 0);
+
+	g_assert(nugu_pcm_get_data(pcm, dest, 400) == 400);
+	g_assert(nugu_pcm_get_latency(pcm, &latency) == 0);
+	g_assert(latency.count == 2);
+
+	total = 0;
+	for (i = 0; i < NUGU_PCM_LATENCY_BUCKETS; i++)
+		total += latency.histogram[i];
+	g_assert(total == 2);
+
+	/* The cleared blocks are not measured */
+	g_assert(nugu_pcm_push_data(pcm, src, 500, 0) == 500);
+	nugu_pcm_clear_buffer(pcm);
+	g_assert(nugu_pcm_push_data(pcm, src, 100, 0) == 100);
+	g_assert(nugu_pcm_get_data(pcm, dest, 1000) == 100);
+	g_assert(nugu_pcm_get_latency(pcm, &latency) == 0);
+	g_assert(latency.count == 3);
+
+	CHECK_STATUS(MEDIA_STATUS_STOPPED);
+	g_assert(nugu_pcm_stop(pcm) == 0);
+
+	nugu_pcm_free(pcm);
+	nugu_pcm_driver_remove(driver);
+}
+
+static void test_pcm_restart(void)
+{
+	NuguPcmDriver *driver;
+	NuguPcm *pcm;
+	NuguAudioProperty prop;
+	char src[100];
+
+	memset(src, 1, sizeof(src));
+
+	driver = nugu_pcm_driver_new("running", &running_driver_ops);
+	g_assert(driver != NULL);
+
+	pcm = nugu_pcm_new("restart", driver);
+	g_assert(pcm != NULL);
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_8K;
+	prop.format = AUDIO_FORMAT_S16_LE;
+	prop.channel = 1;
+	g_assert(nugu_pcm_set_property(pcm, prop) == 0);
+
+	_running = 0;
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(_running == 1);
+	g_assert(nugu_pcm_push_data(pcm, src, sizeof(src), 0) == sizeof(src));
+
+	/* The driver is stopped before the ring is reset */
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(_running == 1);
+	g_assert(nugu_pcm_get_status(pcm) == MEDIA_STATUS_PLAYING);
+	g_assert(nugu_pcm_get_data_size(pcm) == 0);
+
+	g_assert(nugu_pcm_stop(pcm) == 0);
+	g_assert(_running == 0);
+
+	/* The stopped pcm is started without the stop of the driver */
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(nugu_pcm_stop(pcm) == 0);
+
+	/* The playing pcm is freed after the stop of the driver */
+	g_assert(nugu_pcm_start(pcm) == 0);
+	g_assert(_running == 1);
+
+	nugu_pcm_free(pcm);
+	g_assert(_running == 0);
+
+	nugu_pcm_driver_free(driver);
+}
+
 int main(int argc, char *argv[])
 {
 #if !GLIB_CHECK_VERSION(2, 36, 0)
@@ -206,6 +662,12 @@ int main(int argc, char *argv[])
 
 	g_test_add_func("/pcm/default", test_pcm_default);
 	g_test_add_func("/pcm/driver", test_pcm_multiple);
+	g_test_add_func("/pcm/ring", test_pcm_ring);
+	g_test_add_func("/pcm/reserve", test_pcm_reserve);
+	g_test_add_func("/pcm/resample", test_pcm_resample);
+	g_test_add_func("/pcm/prebuffer", test_pcm_prebuffer);
+	g_test_add_func("/pcm/latency", test_pcm_latency);
+	g_test_add_func("/pcm/restart", test_pcm_restart);
 
 	return g_test_run();
 }
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "nugu_pool.h"
+
+struct test_item {
+	int value;
+	char name[20];
+};
+
+static void test_pool_default(void)
+{
+	NuguPool *pool;
+	NuguPoolStats stats;
+	struct test_item *item;
+	struct test_item *item2;
+
+	g_assert(nugu_pool_new(0, 4) == NULL);
+
+	pool = nugu_pool_new(sizeof(struct test_item), 4);
+	g_assert(pool != NULL);
+
+	g_assert(nugu_pool_get_stats(pool, NULL) == -1);
+	g_assert(nugu_pool_get_stats(pool, &stats) == 0);
+	g_assert(stats.slabs == 0);
+	g_assert(stats.in_use == 0);
+
+	item = nugu_pool_alloc(pool);
+	g_assert(item != NULL);
+	g_assert(item->value == 0);
+	item->value = 10;
+
+	item2 = nugu_pool_alloc(pool);
+	g_assert(item2 != NULL);
+	g_assert(item2 != item);
+
+	g_assert(nugu_pool_get_stats(pool, &stats) == 0);
+	g_assert(stats.allocs == 2);
+	g_assert(stats.slabs == 1);
+	g_assert(stats.in_use == 2);
+	g_assert(stats.available == 2);
+
+	/* released object is reused with zero-filled memory */
+	nugu_pool_release(pool, item);
+	item = nugu_pool_alloc(pool);
+	g_assert(item != NULL);
+	g_assert(item->value == 0);
+
+	nugu_pool_release(pool, item);
+	nugu_pool_release(pool, item2);
+
+	g_assert(nugu_pool_get_stats(pool, &stats) == 0);
+	g_assert(stats.allocs == 3);
+	g_assert(stats.releases == 3);
+	g_assert(stats.in_use == 0);
+	g_assert(stats.available == 4);
+	g_assert(stats.high_watermark == 2);
+
+	nugu_pool_free(pool);
+}
+
+static void test_pool_slab(void)
+{
+	NuguPool *pool;
+	NuguPoolStats stats;
+	struct test_item *items[10];
+	int i;
+
+	pool = nugu_pool_new(sizeof(struct test_item), 4);
+	g_assert(pool != NULL);
+
+	for (i = 0; i < 10; i++) {
+		items[i] = nugu_pool_alloc(pool);
+		g_assert(items[i] != NULL);
+		g_assert(((size_t)items[i] % sizeof(void *)) == 0);
+		items[i]->value = i;
+	}
+
+	for (i = 0; i < 10; i++)
+		g_assert(items[i]->value == i);
+
+	g_assert(nugu_pool_get_stats(pool, &stats) == 0);
+	g_assert(stats.slabs == 3);
+	g_assert(stats.in_use == 10);
+	g_assert(stats.available == 2);
+
+	for (i = 0; i < 10; i++)
+		nugu_pool_release(pool, items[i]);
+
+	/* no more slabs are needed in the steady state */
+	for (i = 0; i < 10; i++) {
+		items[i] = nugu_pool_alloc(pool);
+		g_assert(items[i] != NULL);
+	}
+
+	for (i = 0; i < 10; i++)
+		nugu_pool_release(pool, items[i]);
+
+	g_assert(nugu_pool_get_stats(pool, &stats) == 0);
+	g_assert(stats.slabs == 3);
+	g_assert(stats.allocs == 20);
+	g_assert(stats.high_watermark == 10);
+
+	nugu_pool_free(pool);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/pool/default", test_pool_default);
+	g_test_add_func("/pool/slab", test_pool_slab);
+
+	return g_test_run();
+}
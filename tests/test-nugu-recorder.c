@@ -18,6 +18,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <glib.h>
+#include <poll.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #include "nugu_recorder.h"
@@ -94,6 +96,51 @@ static struct nugu_recorder_driver_ops timeout_driver_ops = {
 	.stop = timeout_stop
 };
 
+static int convert_start(NuguRecorderDriver *driver, NuguRecorder *rec,
+			 NuguAudioProperty property)
+{
+	(void)driver;
+	(void)rec;
+
+	g_assert(property.samplerate == AUDIO_SAMPLE_RATE_16K);
+	g_assert(property.format == AUDIO_FORMAT_S16_BE);
+	g_assert(property.channel == 2);
+
+	return 0;
+}
+
+static struct nugu_recorder_driver_ops convert_driver_ops = {
+	.start = convert_start,
+	.stop = timeout_stop
+};
+
+static int _shared_start_count;
+static int _shared_stop_count;
+
+static int shared_start(NuguRecorderDriver *driver, NuguRecorder *rec,
+			NuguAudioProperty property)
+{
+	(void)driver;
+	(void)rec;
+
+	_shared_start_count++;
+	return 0;
+}
+
+static int shared_stop(NuguRecorderDriver *driver, NuguRecorder *rec)
+{
+	(void)driver;
+	(void)rec;
+
+	_shared_stop_count++;
+	return 0;
+}
+
+static struct nugu_recorder_driver_ops shared_driver_ops = {
+	.start = shared_start,
+	.stop = shared_stop
+};
+
 static gint _push_data(void *p)
 {
 	int *count = (int *)p;
@@ -222,6 +269,396 @@ static void test_recorder_timeout(void)
 	nugu_recorder_driver_free(rec_drv);
 }
 
+static void test_recorder_reader(void)
+{
+	NuguRecorderDriver *rec_drv;
+	NuguRecorderReader *kwd;
+	NuguRecorderReader *asr;
+	NuguRecorder *rec;
+	char temp[SET_AUDIO_MAX_FRAMES];
+	int size;
+
+	rec_drv = nugu_recorder_driver_new(DEFAULT_PLUGIN_NAME,
+					   &shared_driver_ops);
+	rec = nugu_recorder_new("rec_shared", rec_drv);
+	g_assert(nugu_recorder_set_frame_size(rec, SET_AUDIO_FRAME_SIZE(2),
+					      SET_AUDIO_MAX_FRAMES) == 0);
+
+	kwd = nugu_recorder_reader_new(rec);
+	g_assert(kwd != NULL);
+	asr = nugu_recorder_reader_new(rec);
+	g_assert(asr != NULL);
+	g_assert(nugu_recorder_reader_get_recorder(kwd) == rec);
+	g_assert(nugu_recorder_reader_is_recording(kwd) == 0);
+
+	/* The first reader opens the stream */
+	g_assert(nugu_recorder_reader_start(kwd) == 0);
+	g_assert(_shared_start_count == 1);
+	g_assert(nugu_recorder_reader_is_recording(kwd) == 1);
+	g_assert(nugu_recorder_reader_is_recording(asr) == 0);
+
+	g_assert(nugu_recorder_push_frame(rec, "ab", 2) == 0);
+
+	/* The second reader shares the stream and starts from now */
+	g_assert(nugu_recorder_reader_start(asr) == 0);
+	g_assert(_shared_start_count == 1);
+	g_assert(nugu_recorder_reader_get_frame_count(asr) == 0);
+
+	g_assert(nugu_recorder_push_frame(rec, "cd", 2) == 0);
+	g_assert(nugu_recorder_reader_get_frame_count(kwd) == 2);
+	g_assert(nugu_recorder_reader_get_frame_count(asr) == 1);
+
+	g_assert(nugu_recorder_reader_get_frame(kwd, temp, &size) == 0);
+	g_assert_cmpmem(temp, size, "ab", 2);
+	g_assert(nugu_recorder_reader_get_frame_timeout(asr, temp, &size,
+							0) == 0);
+	g_assert_cmpmem(temp, size, "cd", 2);
+
+	/* The stream is kept until the last reader is stopped */
+	g_assert(nugu_recorder_reader_stop(kwd) == 0);
+	g_assert(_shared_stop_count == 0);
+	g_assert(nugu_recorder_reader_is_recording(kwd) == 0);
+	g_assert(nugu_recorder_reader_is_recording(asr) == 1);
+
+	g_assert(nugu_recorder_push_frame(rec, "ef", 2) == 0);
+	g_assert(nugu_recorder_reader_get_frame(asr, temp, &size) == 0);
+	g_assert_cmpmem(temp, size, "ef", 2);
+
+	/* Stopped reader returns without waiting */
+	g_assert(nugu_recorder_reader_get_frame_timeout(kwd, temp, &size,
+							0) == 0);
+
+	g_assert(nugu_recorder_reader_stop(asr) == 0);
+	g_assert(_shared_stop_count == 1);
+
+	nugu_recorder_reader_free(kwd);
+	nugu_recorder_reader_free(asr);
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
+static gint _pushing;
+
+/* The audio thread notifies the readers while they are added or freed */
+static void *_pusher(void *data)
+{
+	NuguRecorder *rec = data;
+
+	while (g_atomic_int_get(&_pushing))
+		nugu_recorder_push_frame(rec, "ab", 2);
+
+	return NULL;
+}
+
+static void test_recorder_reader_update(void)
+{
+	NuguRecorderDriver *rec_drv;
+	NuguRecorderReader *reader;
+	NuguRecorder *rec;
+	pthread_t tid;
+	int i;
+
+	rec_drv = nugu_recorder_driver_new(DEFAULT_PLUGIN_NAME,
+					   &shared_driver_ops);
+	rec = nugu_recorder_new("rec_update", rec_drv);
+	g_assert(nugu_recorder_set_frame_size(rec, SET_AUDIO_FRAME_SIZE(2),
+					      SET_AUDIO_MAX_FRAMES) == 0);
+
+	g_atomic_int_set(&_pushing, 1);
+	pthread_create(&tid, NULL, _pusher, rec);
+
+	for (i = 0; i < 1000; i++) {
+		reader = nugu_recorder_reader_new(rec);
+		g_assert(reader != NULL);
+		nugu_recorder_reader_free(reader);
+	}
+
+	g_atomic_int_set(&_pushing, 0);
+	pthread_join(tid, NULL);
+
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
+static void test_recorder_preroll(void)
+{
+	NuguAudioProperty property;
+	NuguRecorderDriver *rec_drv;
+	NuguRecorderReader *kwd;
+	NuguRecorderReader *asr;
+	NuguRecorder *rec;
+	char temp[SET_AUDIO_MAX_FRAMES];
+	int size;
+
+	SET_DEFAULT_AUDIO_PROPERTY(property);
+
+	rec_drv = nugu_recorder_driver_new(DEFAULT_PLUGIN_NAME,
+					   &shared_driver_ops);
+	rec = nugu_recorder_new("rec_preroll", rec_drv);
+	g_assert(nugu_recorder_set_property(rec, property) == 0);
+
+	/* 16K, S16_LE, mono: 32 bytes per 1 ms */
+	g_assert(nugu_recorder_set_frame_size(rec, SET_AUDIO_FRAME_SIZE(2),
+					      SET_AUDIO_MAX_FRAMES) == 0);
+
+	kwd = nugu_recorder_reader_new(rec);
+	asr = nugu_recorder_reader_new(rec);
+	g_assert(nugu_recorder_reader_get_preroll(asr) == 0);
+	g_assert(nugu_recorder_reader_set_preroll(asr, -1) == -1);
+	g_assert(nugu_recorder_reader_set_preroll(asr, 0) == 0);
+
+	/* 128 bytes: 64 frames, limited by the max frames */
+	g_assert(nugu_recorder_reader_set_preroll(asr, 4) == 0);
+	g_assert(nugu_recorder_reader_get_preroll(asr) == 4);
+
+	/* No frames to replay when the stream is opened by the reader */
+	g_assert(nugu_recorder_reader_start(asr) == 0);
+	g_assert(nugu_recorder_reader_get_frame_count(asr) == 0);
+	g_assert(nugu_recorder_reader_stop(asr) == 0);
+
+	g_assert(nugu_recorder_reader_start(kwd) == 0);
+	g_assert(nugu_recorder_push_frame(rec, "0123456789abcdefghij",
+					  20) == 0);
+
+	/* Handoff: the recent frames are replayed to the next reader */
+	g_assert(nugu_recorder_reader_start(asr) == 0);
+	g_assert(nugu_recorder_reader_stop(kwd) == 0);
+	g_assert(nugu_recorder_reader_get_frame_count(asr) ==
+		 SET_AUDIO_MAX_FRAMES);
+	g_assert(nugu_recorder_reader_get_frame(asr, temp, &size) == 0);
+	g_assert_cmpmem(temp, size, "01", 2);
+
+	g_assert(nugu_recorder_reader_stop(asr) == 0);
+
+	nugu_recorder_reader_free(kwd);
+	nugu_recorder_reader_free(asr);
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
+static void test_recorder_peek(void)
+{
+	NuguRecorderDriver *rec_drv;
+	NuguRecorderReader *reader;
+	NuguRecorder *rec;
+	const char *data = NULL;
+	int size;
+
+	rec_drv = nugu_recorder_driver_new(DEFAULT_PLUGIN_NAME,
+					   &shared_driver_ops);
+	rec = nugu_recorder_new("rec_peek", rec_drv);
+	g_assert(nugu_recorder_set_frame_size(rec, SET_AUDIO_FRAME_SIZE(2),
+					      SET_AUDIO_MAX_FRAMES) == 0);
+
+	g_assert(nugu_recorder_start(rec) == 0);
+
+	g_assert(nugu_recorder_peek_frame(rec, &data, &size) == 0);
+	g_assert(size == 0);
+
+	g_assert(nugu_recorder_push_frame(rec, "abcdef", 6) == 0);
+	g_assert(nugu_recorder_peek_frame(rec, &data, &size) == 0);
+	g_assert(size == 2);
+	g_assert_cmpmem(data, size, "ab", 2);
+	g_assert(nugu_recorder_release_frame(rec) == 0);
+
+	g_assert(nugu_recorder_peek_frames(rec, &data, 10) == 2);
+	g_assert_cmpmem(data, 4, "cdef", 4);
+	g_assert(nugu_recorder_release_frames(rec, 2) == 0);
+	g_assert(nugu_recorder_get_frame_count(rec) == 0);
+
+	g_assert(nugu_recorder_stop(rec) == 0);
+
+	reader = nugu_recorder_reader_new(rec);
+	g_assert(nugu_recorder_reader_start(reader) == 0);
+
+	g_assert(nugu_recorder_push_frame(rec, "ghij", 4) == 0);
+	g_assert(nugu_recorder_reader_peek_frame_timeout(reader, &data, &size,
+							 0) == 0);
+	g_assert_cmpmem(data, size, "gh", 2);
+	g_assert(nugu_recorder_reader_release_frame(reader) == 0);
+	g_assert(nugu_recorder_reader_peek_frames(reader, &data, 10) == 1);
+	g_assert_cmpmem(data, 2, "ij", 2);
+	g_assert(nugu_recorder_reader_release_frames(reader, 1) == 0);
+
+	/* Stopped reader returns without a frame */
+	g_assert(nugu_recorder_reader_stop(reader) == 0);
+	g_assert(nugu_recorder_reader_peek_frame_timeout(reader, &data, &size,
+							 0) == 0);
+	g_assert(size == 0);
+
+	nugu_recorder_reader_free(reader);
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
+static int _is_readable(int fd)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+
+	return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+static void test_recorder_fd(void)
+{
+	NuguRecorderDriver *rec_drv;
+	NuguRecorderReader *reader;
+	NuguRecorder *rec;
+	char temp[SET_AUDIO_MAX_FRAMES];
+	uint64_t ev;
+	gint64 begin;
+	int size;
+
+	rec_drv = nugu_recorder_driver_new(DEFAULT_PLUGIN_NAME,
+					   &shared_driver_ops);
+	rec = nugu_recorder_new("rec_fd", rec_drv);
+	g_assert(nugu_recorder_set_frame_size(rec, SET_AUDIO_FRAME_SIZE(2),
+					      SET_AUDIO_MAX_FRAMES) == 0);
+	reader = nugu_recorder_reader_new(rec);
+
+	g_assert(nugu_recorder_get_fd(rec) >= 0);
+	g_assert(nugu_recorder_reader_get_fd(reader) >= 0);
+	g_assert(!_is_readable(nugu_recorder_get_fd(rec)));
+	g_assert(!_is_readable(nugu_recorder_reader_get_fd(reader)));
+
+	g_assert(nugu_recorder_reader_start(reader) == 0);
+
+	/* Pushed frames are notified to the recorder and all readers */
+	g_assert(nugu_recorder_push_frame(rec, "ab", 2) == 0);
+	g_assert(_is_readable(nugu_recorder_get_fd(rec)));
+	g_assert(_is_readable(nugu_recorder_reader_get_fd(reader)));
+
+	g_assert(read(nugu_recorder_get_fd(rec), &ev, sizeof(ev)) ==
+		 sizeof(ev));
+	g_assert(!_is_readable(nugu_recorder_get_fd(rec)));
+
+	/* The wait consumes the notification */
+	g_assert(nugu_recorder_reader_get_frame_timeout(reader, temp, &size,
+							100) == 0);
+	g_assert_cmpmem(temp, size, "ab", 2);
+	g_assert(nugu_recorder_reader_get_frame_timeout(reader, temp, &size,
+							1) == 0);
+	g_assert(size == 0);
+	g_assert(!_is_readable(nugu_recorder_reader_get_fd(reader)));
+
+	/* The timeout is kept regardless of the wall clock */
+	begin = g_get_monotonic_time();
+	g_assert(nugu_recorder_reader_get_frame_timeout(reader, temp, &size,
+							50) == 0);
+	g_assert(size == 0);
+	g_assert(g_get_monotonic_time() - begin >= 50 * 1000);
+
+	/* Stopping the recording wakes up the readers */
+	g_assert(nugu_recorder_reader_stop(reader) == 0);
+	g_assert(_is_readable(nugu_recorder_reader_get_fd(reader)));
+
+	nugu_recorder_reader_free(reader);
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
+static void test_recorder_stats(void)
+{
+	NuguRecorderDriver *rec_drv;
+	NuguRecorderReader *reader;
+	NuguRecorderStats stats;
+	NuguRecorder *rec;
+	char temp[SET_AUDIO_MAX_FRAMES];
+	int size;
+	int i;
+
+	rec_drv = nugu_recorder_driver_new(DEFAULT_PLUGIN_NAME,
+					   &shared_driver_ops);
+	rec = nugu_recorder_new("rec_stats", rec_drv);
+	g_assert(nugu_recorder_set_frame_size(rec, SET_AUDIO_FRAME_SIZE(1),
+					      SET_AUDIO_MAX_FRAMES) == 0);
+	reader = nugu_recorder_reader_new(rec);
+	g_assert(nugu_recorder_reader_start(reader) == 0);
+
+	g_assert(nugu_recorder_get_stats(rec, &stats) == 0);
+	g_assert(stats.frames == 0 && stats.dropped == 0);
+	g_assert(stats.max_frames == SET_AUDIO_MAX_FRAMES);
+
+	/* The reader falls behind by 5 frames */
+	for (i = 0; i < SET_AUDIO_MAX_FRAMES + 5; i++)
+		g_assert(nugu_recorder_push_frame(rec, "a", 1) == 0);
+
+	g_assert(nugu_recorder_reader_get_frame(reader, temp, &size) == 0);
+
+	g_assert(nugu_recorder_reader_get_stats(reader, &stats) == 0);
+	g_assert(stats.frames == SET_AUDIO_MAX_FRAMES + 5);
+	g_assert(stats.dropped == 5);
+	g_assert(stats.overwrites == 1);
+	g_assert(stats.high_watermark == SET_AUDIO_MAX_FRAMES);
+	g_assert(stats.fill_level == SET_AUDIO_MAX_FRAMES - 1);
+
+	/* The recorder statistics include the readers */
+	g_assert(nugu_recorder_get_stats(rec, &stats) == 0);
+	g_assert(stats.frames == SET_AUDIO_MAX_FRAMES + 5);
+	g_assert(stats.dropped == 5);
+	g_assert(stats.high_watermark == SET_AUDIO_MAX_FRAMES);
+
+	g_assert(nugu_recorder_reader_stop(reader) == 0);
+	nugu_recorder_reader_free(reader);
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
+static void test_recorder_convert(void)
+{
+	NuguRecorderDriver *rec_drv;
+	NuguRecorder *rec;
+	NuguAudioProperty property;
+	NuguAudioProperty device;
+	/* stereo big endian frames: (0x0100, 0x0300), (0x1000, -0x1000) */
+	const char frames[8] = { 0x01, 0x00, 0x03, 0x00,
+				 0x10, 0x00, (char)0xF0, 0x00 };
+	int16_t sample;
+	int size;
+
+	SET_DEFAULT_AUDIO_PROPERTY(property);
+	device = property;
+	device.format = AUDIO_FORMAT_S16_BE;
+	device.channel = 2;
+
+	rec_drv = nugu_recorder_driver_new("convert", &convert_driver_ops);
+	rec = nugu_recorder_new("rec_convert", rec_drv);
+
+	g_assert(nugu_recorder_set_frame_size(rec, 2, SET_AUDIO_MAX_FRAMES) ==
+		 0);
+	g_assert(nugu_recorder_set_property(rec, property) == 0);
+	g_assert(nugu_recorder_set_device_property(rec, device) == 0);
+
+	g_assert(nugu_recorder_get_property(rec, &property) == 0);
+	g_assert(property.format == AUDIO_FORMAT_S16_LE);
+	g_assert(nugu_recorder_get_device_property(rec, &property) == 0);
+	g_assert(property.format == AUDIO_FORMAT_S16_BE);
+	g_assert(property.channel == 2);
+
+	g_assert(nugu_recorder_start(rec) == 0);
+
+	/* A part of the device frame is kept until the rest is pushed */
+	g_assert(nugu_recorder_push_frame(rec, frames, 3) == 0);
+	g_assert(nugu_recorder_get_frame_count(rec) == 0);
+	g_assert(nugu_recorder_push_frame(rec, frames + 3, 5) == 0);
+	g_assert(nugu_recorder_get_frame_count(rec) == 2);
+
+	g_assert(nugu_recorder_get_frame(rec, (char *)&sample, &size) == 0);
+	g_assert(size == 2);
+	g_assert(GINT16_FROM_LE(sample) == 0x0200);
+	g_assert(nugu_recorder_get_frame(rec, (char *)&sample, &size) == 0);
+	g_assert(GINT16_FROM_LE(sample) == 0);
+
+	g_assert(nugu_recorder_stop(rec) == 0);
+
+	/* The sample rate is not converted */
+	device.samplerate = AUDIO_SAMPLE_RATE_48K;
+	g_assert(nugu_recorder_set_device_property(rec, device) == 0);
+	g_assert(nugu_recorder_start(rec) == -1);
+
+	nugu_recorder_free(rec);
+	nugu_recorder_driver_free(rec_drv);
+}
+
 int main(int argc, char *argv[])
 {
 #if !GLIB_CHECK_VERSION(2, 36, 0)
@@ -233,5 +670,13 @@ int main(int argc, char *argv[])
 
 	g_test_add_func("/recorder/default", test_recorder_default);
 	g_test_add_func("/recorder/timeout", test_recorder_timeout);
+	g_test_add_func("/recorder/reader", test_recorder_reader);
+	g_test_add_func("/recorder/reader_update",
+			test_recorder_reader_update);
+	g_test_add_func("/recorder/preroll", test_recorder_preroll);
+	g_test_add_func("/recorder/peek", test_recorder_peek);
+	g_test_add_func("/recorder/fd", test_recorder_fd);
+	g_test_add_func("/recorder/stats", test_recorder_stats);
+	g_test_add_func("/recorder/convert", test_recorder_convert);
 	return g_test_run();
 }
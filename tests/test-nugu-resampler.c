@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2019 SK Telecom Co., Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <glib.h>
+
+#include "nugu_resampler.h"
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_S16 AUDIO_FORMAT_S16_LE
+#define FORMAT_FLOAT AUDIO_FORMAT_FLOAT_LE
+#else
+#define FORMAT_S16 AUDIO_FORMAT_S16_BE
+#define FORMAT_FLOAT AUDIO_FORMAT_FLOAT_BE
+#endif
+
+#define INPUT_FRAMES 1600
+
+/* Push the input in chunks of 'chunk' bytes and flush at the end */
+static size_t _convert(NuguResampler *rs, const void *data, size_t size,
+		       size_t chunk, unsigned char *out)
+{
+	const unsigned char *src = data;
+	size_t written = 0;
+	size_t offset;
+	int ret;
+
+	for (offset = 0; offset < size; offset += chunk) {
+		size_t length = MIN(chunk, size - offset);
+		size_t need = nugu_resampler_get_output_size(rs, length);
+
+		ret = nugu_resampler_process(rs, src + offset, length,
+					     out + written, need);
+		g_assert(ret >= 0 && (size_t)ret <= need);
+		written += ret;
+	}
+
+	ret = nugu_resampler_flush(rs, out + written,
+				   nugu_resampler_get_flush_size(rs));
+	g_assert(ret >= 0);
+
+	return written + ret;
+}
+
+static void test_resampler_default(void)
+{
+	NuguResampler *rs;
+	NuguAudioProperty prop;
+	int16_t input[INPUT_FRAMES];
+	int16_t whole[INPUT_FRAMES * 3 + 64];
+	int16_t chunked[INPUT_FRAMES * 3 + 64];
+	size_t size;
+	int i;
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_16K;
+	prop.format = AUDIO_FORMAT_U8;
+	prop.channel = 1;
+	g_assert(nugu_resampler_new(prop, AUDIO_SAMPLE_RATE_48K,
+				    NUGU_RESAMPLER_QUALITY_LOW) == NULL);
+
+	/* 1 kHz sine wave */
+	for (i = 0; i < INPUT_FRAMES; i++)
+		input[i] = (int16_t)(16384 * sin(2 * G_PI * 1000 * i / 16000));
+
+	prop.format = FORMAT_S16;
+	rs = nugu_resampler_new(prop, AUDIO_SAMPLE_RATE_48K,
+				NUGU_RESAMPLER_QUALITY_HIGH);
+	g_assert(rs != NULL);
+
+	size = _convert(rs, input, sizeof(input), sizeof(input),
+			(unsigned char *)whole);
+	g_assert(size == sizeof(input) * 3);
+
+	/* Same output with the odd size chunks (a part of sample) */
+	g_assert(_convert(rs, input, sizeof(input), 333,
+			  (unsigned char *)chunked) == size);
+	g_assert(memcmp(whole, chunked, size) == 0);
+
+	/* The output is the sine wave at 48 kHz (no delay) */
+	for (i = 100; i < INPUT_FRAMES * 3 - 100; i++) {
+		double expect = 16384 * sin(2 * G_PI * 1000 * i / 48000);
+
+		g_assert(fabs(whole[i] - expect) < 100);
+	}
+
+	/* Discard the remaining input */
+	g_assert(nugu_resampler_process(rs, input, 3, chunked,
+					sizeof(chunked)) >= 0);
+	nugu_resampler_reset(rs);
+	g_assert(nugu_resampler_flush(rs, chunked, sizeof(chunked)) == 0);
+
+	/* The output buffer is too small */
+	g_assert(nugu_resampler_process(rs, input, sizeof(input), chunked,
+					10) == -1);
+
+	nugu_resampler_free(rs);
+}
+
+static void test_resampler_down(void)
+{
+	NuguResampler *rs;
+	NuguAudioProperty prop;
+	float input[INPUT_FRAMES * 2];
+	float output[INPUT_FRAMES];
+	size_t size;
+	int i;
+
+	/* DC on the left and silence on the right channel */
+	for (i = 0; i < INPUT_FRAMES; i++) {
+		input[i * 2] = 0.5f;
+		input[i * 2 + 1] = 0.0f;
+	}
+
+	prop.samplerate = AUDIO_SAMPLE_RATE_48K;
+	prop.format = FORMAT_FLOAT;
+	prop.channel = 2;
+	rs = nugu_resampler_new(prop, AUDIO_SAMPLE_RATE_16K,
+				NUGU_RESAMPLER_QUALITY_MEDIUM);
+	g_assert(rs != NULL);
+
+	size = _convert(rs, input, sizeof(input), 1000,
+			(unsigned char *)output);
+	g_assert(size == (INPUT_FRAMES + 2) / 3 * 2 * sizeof(float));
+
+	for (i = 20; i < INPUT_FRAMES / 3 - 20; i++) {
+		g_assert(fabsf(output[i * 2] - 0.5f) < 0.001f);
+		g_assert(output[i * 2 + 1] == 0.0f);
+	}
+
+	nugu_resampler_free(rs);
+
+	/* 22050 Hz -> 48000 Hz */
+	prop.samplerate = AUDIO_SAMPLE_RATE_22K;
+	prop.format = FORMAT_S16;
+	prop.channel = 1;
+	rs = nugu_resampler_new(prop, AUDIO_SAMPLE_RATE_48K,
+				NUGU_RESAMPLER_QUALITY_LOW);
+	g_assert(rs != NULL);
+	g_assert(nugu_resampler_get_output_size(rs, 2205 * 2) >= 4800 * 2);
+	nugu_resampler_free(rs);
+}
+
+int main(int argc, char *argv[])
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+	g_log_set_always_fatal((GLogLevelFlags)G_LOG_FATAL_MASK);
+
+	g_test_add_func("/resampler/default", test_resampler_default);
+	g_test_add_func("/resampler/down", test_resampler_down);
+
+	return g_test_run();
+}
@@ -18,6 +18,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <glib.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include "nugu_ringbuffer.h"
 
@@ -218,6 +220,437 @@ static void test_ringbuffer_resize(void)
 	nugu_ring_buffer_free(buf);
 }
 
+static void test_ringbuffer_spsc(void)
+{
+	NuguRingBuffer *buf;
+	char tmp[10] = {
+		0,
+	};
+	int item = 0;
+
+	/* item size is 2, item max is 5 */
+	buf = nugu_ring_buffer_new_full(2, 5, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+	g_assert(nugu_ring_buffer_get_mode(buf) == NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(nugu_ring_buffer_get_count(buf) == 0);
+	g_assert(nugu_ring_buffer_get_maxcount(buf) == 5);
+
+	/* Fill 11 bytes */
+	g_assert(nugu_ring_buffer_push_data(buf, "12345678901", 11) == -1);
+	g_assert(nugu_ring_buffer_get_count(buf) == 0);
+
+	/* Fill 3 bytes (1 item + 1 byte) */
+	g_assert(nugu_ring_buffer_push_data(buf, "123", 3) == 0);
+	g_assert(nugu_ring_buffer_get_count(buf) == 1);
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(item == 2);
+	g_assert_cmpmem(tmp, 2, "12", 2);
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(item == 0);
+
+	/* Complete the partial item */
+	g_assert(nugu_ring_buffer_push_data(buf, "4", 1) == 0);
+	g_assert(nugu_ring_buffer_get_count(buf) == 1);
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(item == 2);
+	g_assert_cmpmem(tmp, 2, "34", 2);
+
+	/* Overwrite the oldest items */
+	g_assert(nugu_ring_buffer_push_data(buf, "abcdefghij", 10) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "klmn", 4) == 0);
+	g_assert(nugu_ring_buffer_get_count(buf) == 5);
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(item == 2);
+	g_assert_cmpmem(tmp, 2, "ef", 2);
+	g_assert(nugu_ring_buffer_get_count(buf) == 4);
+
+	nugu_ring_buffer_clear_items(buf);
+	g_assert(nugu_ring_buffer_get_count(buf) == 0);
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(item == 0);
+
+	/* resize keeps the mode */
+	g_assert(nugu_ring_buffer_resize(buf, 4, 20) == 0);
+	g_assert(nugu_ring_buffer_get_mode(buf) == NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(nugu_ring_buffer_get_maxcount(buf) == 20);
+	g_assert(nugu_ring_buffer_push_data(buf, "1234567890", 10) == 0);
+	g_assert(nugu_ring_buffer_get_count(buf) == 2);
+
+	nugu_ring_buffer_free(buf);
+}
+
+static void test_ringbuffer_reader(void)
+{
+	NuguRingBuffer *buf;
+	NuguRingBufferReader *reader1;
+	NuguRingBufferReader *reader2;
+	char tmp[10] = {
+		0,
+	};
+	int item = 0;
+
+	buf = nugu_ring_buffer_new(2, 5);
+	g_assert(buf != NULL);
+	g_assert(nugu_ring_buffer_reader_new(buf) == NULL);
+	nugu_ring_buffer_free(buf);
+
+	/* item size is 2, item max is 5 */
+	buf = nugu_ring_buffer_new_full(2, 5, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+
+	/* Items pushed before the reader creation are not visible */
+	g_assert(nugu_ring_buffer_push_data(buf, "ab", 2) == 0);
+
+	reader1 = nugu_ring_buffer_reader_new(buf);
+	g_assert(reader1 != NULL);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 0);
+
+	g_assert(nugu_ring_buffer_push_data(buf, "1234", 4) == 0);
+
+	reader2 = nugu_ring_buffer_reader_new(buf);
+	g_assert(reader2 != NULL);
+
+	g_assert(nugu_ring_buffer_push_data(buf, "56", 2) == 0);
+
+	/* Each reader has its own position */
+	g_assert(nugu_ring_buffer_get_count(buf) == 4);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 3);
+	g_assert(nugu_ring_buffer_reader_get_count(reader2) == 1);
+
+	g_assert(nugu_ring_buffer_reader_read_item(reader2, tmp, &item) == 0);
+	g_assert(item == 2);
+	g_assert_cmpmem(tmp, 2, "56", 2);
+	g_assert(nugu_ring_buffer_reader_read_item(reader2, tmp, &item) == 0);
+	g_assert(item == 0);
+
+	g_assert(nugu_ring_buffer_reader_read_item(reader1, tmp, &item) == 0);
+	g_assert(item == 2);
+	g_assert_cmpmem(tmp, 2, "12", 2);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 2);
+	g_assert(nugu_ring_buffer_get_count(buf) == 4);
+
+	nugu_ring_buffer_reader_clear_items(reader1);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 0);
+
+	/* A slow reader loses the oldest items */
+	g_assert(nugu_ring_buffer_push_data(buf, "abcdefghijkl", 10) == 0);
+	g_assert(nugu_ring_buffer_reader_read_item(reader2, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, 2, "ab", 2);
+	g_assert(nugu_ring_buffer_push_data(buf, "mn", 2) == 0);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 5);
+	g_assert(nugu_ring_buffer_reader_read_item(reader1, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, 2, "cd", 2);
+	g_assert(nugu_ring_buffer_reader_get_count(reader2) == 5);
+	g_assert(nugu_ring_buffer_reader_read_item(reader2, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, 2, "cd", 2);
+
+	/* resize resets all readers */
+	g_assert(nugu_ring_buffer_resize(buf, 4, 5) == 0);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 0);
+	g_assert(nugu_ring_buffer_reader_get_count(reader2) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "1234", 4) == 0);
+	g_assert(nugu_ring_buffer_reader_get_count(reader1) == 1);
+	g_assert(nugu_ring_buffer_reader_get_count(reader2) == 1);
+
+	nugu_ring_buffer_reader_free(reader1);
+	nugu_ring_buffer_reader_free(reader2);
+	nugu_ring_buffer_free(buf);
+}
+
+#define SPSC_TEST_ITEMS 100000
+
+static void *_spsc_producer(void *data)
+{
+	NuguRingBuffer *buf = data;
+	unsigned int i;
+
+	for (i = 0; i < SPSC_TEST_ITEMS; i++) {
+		while (nugu_ring_buffer_get_count(buf) >=
+		       nugu_ring_buffer_get_maxcount(buf))
+			sched_yield();
+
+		g_assert(nugu_ring_buffer_push_data(buf, (char *)&i,
+						    sizeof(i)) == 0);
+	}
+
+	return NULL;
+}
+
+static void test_ringbuffer_spsc_thread(void)
+{
+	NuguRingBuffer *buf;
+	pthread_t tid;
+	unsigned int expected = 0;
+	unsigned int value;
+	int item;
+
+	buf = nugu_ring_buffer_new_full(sizeof(unsigned int), 8,
+					NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+
+	pthread_create(&tid, NULL, _spsc_producer, buf);
+
+	/* No overflow, so every item must be received in order */
+	while (expected < SPSC_TEST_ITEMS) {
+		g_assert(nugu_ring_buffer_read_item(buf, (char *)&value,
+						    &item) == 0);
+		if (item == 0) {
+			sched_yield();
+			continue;
+		}
+
+		g_assert(item == sizeof(unsigned int));
+		g_assert(value == expected);
+		expected++;
+	}
+
+	pthread_join(tid, NULL);
+
+	g_assert(nugu_ring_buffer_get_count(buf) == 0);
+
+	nugu_ring_buffer_free(buf);
+}
+
+static void test_ringbuffer_rewind(void)
+{
+	NuguRingBuffer *buf;
+	NuguRingBufferReader *reader;
+	char tmp[10] = {
+		0,
+	};
+	int item = 0;
+
+	/* item size is 2, item max is 3 */
+	buf = nugu_ring_buffer_new_full(2, 3, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+
+	reader = nugu_ring_buffer_reader_new(buf);
+	g_assert(reader != NULL);
+
+	/* Nothing to replay */
+	g_assert(nugu_ring_buffer_reader_rewind(reader, 2) == 0);
+	g_assert(nugu_ring_buffer_reader_get_count(reader) == 0);
+
+	g_assert(nugu_ring_buffer_push_data(buf, "abcd", 4) == 0);
+	nugu_ring_buffer_reader_clear_items(reader);
+	g_assert(nugu_ring_buffer_reader_get_count(reader) == 0);
+
+	/* Replay the latest item */
+	g_assert(nugu_ring_buffer_reader_rewind(reader, 1) == 1);
+	g_assert(nugu_ring_buffer_reader_read_item(reader, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, item, "cd", 2);
+
+	/* Replay is limited by the kept items */
+	g_assert(nugu_ring_buffer_push_data(buf, "efgh", 4) == 0);
+	g_assert(nugu_ring_buffer_reader_rewind(reader, 10) == 3);
+	g_assert(nugu_ring_buffer_reader_read_item(reader, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, item, "cd", 2);
+	g_assert(nugu_ring_buffer_reader_get_count(reader) == 2);
+
+	/* Cleared items are not replayed */
+	nugu_ring_buffer_clear_items(buf);
+	g_assert(nugu_ring_buffer_reader_rewind(reader, 3) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "ij", 2) == 0);
+	g_assert(nugu_ring_buffer_reader_rewind(reader, 3) == 1);
+	g_assert(nugu_ring_buffer_reader_read_item(reader, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, item, "ij", 2);
+
+	nugu_ring_buffer_reader_free(reader);
+	nugu_ring_buffer_free(buf);
+}
+
+static void test_ringbuffer_peek(void)
+{
+	NuguRingBuffer *buf;
+	const char *items = NULL;
+
+	buf = nugu_ring_buffer_new(2, 3);
+	g_assert(buf != NULL);
+	g_assert(nugu_ring_buffer_peek_items(buf, &items, 1) == -1);
+	g_assert(nugu_ring_buffer_release_items(buf, 1) == -1);
+	nugu_ring_buffer_free(buf);
+
+	/* item size is 2, item max is 3 (4 slots) */
+	buf = nugu_ring_buffer_new_full(2, 3, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+
+	g_assert(nugu_ring_buffer_peek_items(buf, &items, 1) == 0);
+
+	g_assert(nugu_ring_buffer_push_data(buf, "abcdef", 6) == 0);
+	g_assert(nugu_ring_buffer_peek_items(buf, &items, 10) == 3);
+	g_assert_cmpmem(items, 6, "abcdef", 6);
+	g_assert(nugu_ring_buffer_release_items(buf, 2) == 0);
+	g_assert(nugu_ring_buffer_get_count(buf) == 1);
+
+	/* Only the contiguous items are lent */
+	g_assert(nugu_ring_buffer_push_data(buf, "ghij", 4) == 0);
+	g_assert(nugu_ring_buffer_peek_items(buf, &items, 10) == 2);
+	g_assert_cmpmem(items, 4, "efgh", 4);
+	g_assert(nugu_ring_buffer_release_items(buf, 2) == 0);
+	g_assert(nugu_ring_buffer_peek_items(buf, &items, 10) == 1);
+	g_assert_cmpmem(items, 2, "ij", 2);
+
+	/* The lent item is overwritten by the producer */
+	g_assert(nugu_ring_buffer_push_data(buf, "klmnop", 6) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "qr", 2) == 0);
+	g_assert(nugu_ring_buffer_release_items(buf, 1) == -1);
+
+	/* The next peek skips the overwritten items */
+	g_assert(nugu_ring_buffer_peek_items(buf, &items, 1) == 1);
+	g_assert_cmpmem(items, 2, "mn", 2);
+	g_assert(nugu_ring_buffer_release_items(buf, 1) == 0);
+
+	nugu_ring_buffer_free(buf);
+}
+
+static void test_ringbuffer_stats(void)
+{
+	NuguRingBuffer *buf;
+	NuguRingBufferReader *reader;
+	NuguRingBufferStats stats;
+	char tmp[10] = {
+		0,
+	};
+	int item = 0;
+
+	/* item size is 2, item max is 3 */
+	buf = nugu_ring_buffer_new(2, 3);
+	g_assert(buf != NULL);
+
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "abc", 3) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "def", 3) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "ghij", 4) == 0);
+
+	g_assert(nugu_ring_buffer_get_stats(buf, &stats) == 0);
+	g_assert(stats.pushed == 5);
+	g_assert(stats.overwrites > 0);
+	g_assert(stats.dropped > 0);
+	g_assert(stats.underruns == 0);
+	g_assert(stats.high_watermark == 3);
+	g_assert(stats.count == 3);
+	g_assert(stats.max_items == 3);
+
+	nugu_ring_buffer_free(buf);
+
+	buf = nugu_ring_buffer_new_full(2, 3, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+	reader = nugu_ring_buffer_reader_new(buf);
+	g_assert(reader != NULL);
+
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+	g_assert(nugu_ring_buffer_push_data(buf, "abcd", 4) == 0);
+	g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+
+	/* 5 items are pushed while the reader holds 3 items at most */
+	g_assert(nugu_ring_buffer_push_data(buf, "efghij", 6) == 0);
+	g_assert(nugu_ring_buffer_reader_read_item(reader, tmp, &item) == 0);
+	g_assert_cmpmem(tmp, item, "ef", 2);
+
+	g_assert(nugu_ring_buffer_reader_get_stats(reader, &stats) == 0);
+	g_assert(stats.pushed == 5);
+	g_assert(stats.dropped == 2);
+	g_assert(stats.overwrites == 1);
+	g_assert(stats.underruns == 0);
+	g_assert(stats.high_watermark == 3);
+	g_assert(stats.count == 2);
+
+	/* The default reader keeps its own statistics */
+	g_assert(nugu_ring_buffer_get_stats(buf, &stats) == 0);
+	g_assert(stats.pushed == 5);
+	g_assert(stats.dropped == 1);
+	g_assert(stats.overwrites == 1);
+	g_assert(stats.underruns == 0);
+	g_assert(stats.high_watermark == 3);
+	g_assert(stats.count == 3);
+
+	/* resize resets the statistics */
+	g_assert(nugu_ring_buffer_resize(buf, 4, 3) == 0);
+	g_assert(nugu_ring_buffer_get_stats(buf, &stats) == 0);
+	g_assert(stats.pushed == 0 && stats.dropped == 0);
+	g_assert(stats.high_watermark == 0);
+
+	nugu_ring_buffer_reader_free(reader);
+	nugu_ring_buffer_free(buf);
+}
+
+static int read_size(NuguRingBuffer *buf, NuguRingBufferReader *reader)
+{
+	char tmp[10];
+	int item = 0;
+
+	if (reader)
+		g_assert(nugu_ring_buffer_reader_read_item(reader, tmp,
+							   &item) == 0);
+	else
+		g_assert(nugu_ring_buffer_read_item(buf, tmp, &item) == 0);
+
+	return item;
+}
+
+static unsigned int get_underruns(NuguRingBuffer *buf,
+				  NuguRingBufferReader *reader)
+{
+	NuguRingBufferStats stats;
+
+	if (reader)
+		g_assert(nugu_ring_buffer_reader_get_stats(reader, &stats) ==
+			 0);
+	else
+		g_assert(nugu_ring_buffer_get_stats(buf, &stats) == 0);
+
+	return stats.underruns;
+}
+
+static void check_underrun(NuguRingBuffer *buf, NuguRingBufferReader *reader)
+{
+	int i;
+
+	/* The reads before the first data are not underruns */
+	for (i = 0; i < 3; i++)
+		g_assert(read_size(buf, reader) == 0);
+	g_assert(get_underruns(buf, reader) == 0);
+
+	/* The retries on the empty buffer are one underrun */
+	g_assert(nugu_ring_buffer_push_data(buf, "abcd", 4) == 0);
+	g_assert(read_size(buf, reader) == 2);
+	g_assert(read_size(buf, reader) == 2);
+	for (i = 0; i < 3; i++)
+		g_assert(read_size(buf, reader) == 0);
+	g_assert(get_underruns(buf, reader) == 1);
+
+	/* The next gap is counted again */
+	g_assert(nugu_ring_buffer_push_data(buf, "ef", 2) == 0);
+	g_assert(read_size(buf, reader) == 2);
+	g_assert(read_size(buf, reader) == 0);
+	g_assert(read_size(buf, reader) == 0);
+	g_assert(get_underruns(buf, reader) == 2);
+}
+
+static void test_ringbuffer_underrun(void)
+{
+	NuguRingBuffer *buf;
+	NuguRingBufferReader *reader;
+
+	buf = nugu_ring_buffer_new(2, 3);
+	g_assert(buf != NULL);
+	check_underrun(buf, NULL);
+	nugu_ring_buffer_free(buf);
+
+	buf = nugu_ring_buffer_new_full(2, 3, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+	check_underrun(buf, NULL);
+	nugu_ring_buffer_free(buf);
+
+	buf = nugu_ring_buffer_new_full(2, 3, NUGU_RING_BUFFER_MODE_SPSC);
+	g_assert(buf != NULL);
+	reader = nugu_ring_buffer_reader_new(buf);
+	g_assert(reader != NULL);
+	check_underrun(buf, reader);
+	nugu_ring_buffer_reader_free(reader);
+	nugu_ring_buffer_free(buf);
+}
+
 int main(int argc, char *argv[])
 {
 #if !GLIB_CHECK_VERSION(2, 36, 0)
@@ -231,6 +664,13 @@ int main(int argc, char *argv[])
 	g_test_add_func("/buffer/item", test_ringbuffer_item);
 	g_test_add_func("/buffer/ring", test_ringbuffer_ring);
 	g_test_add_func("/buffer/resize", test_ringbuffer_resize);
+	g_test_add_func("/buffer/spsc", test_ringbuffer_spsc);
+	g_test_add_func("/buffer/spsc_thread", test_ringbuffer_spsc_thread);
+	g_test_add_func("/buffer/reader", test_ringbuffer_reader);
+	g_test_add_func("/buffer/rewind", test_ringbuffer_rewind);
+	g_test_add_func("/buffer/peek", test_ringbuffer_peek);
+	g_test_add_func("/buffer/stats", test_ringbuffer_stats);
+	g_test_add_func("/buffer/underrun", test_ringbuffer_underrun);
 
 	return g_test_run();
 }